@@ -0,0 +1,195 @@
+#include "AdapterSelection.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+AdapterInfo describe(WGPUAdapter adapter) {
+    AdapterInfo info;
+    info.adapter = adapter;
+    wgpu::AdapterProperties properties = {};
+    info.adapter.getProperties(&properties);
+    info.name = properties.name ? properties.name : "";
+    info.driver = properties.driverDescription ? properties.driverDescription : "";
+    info.type = properties.adapterType;
+    info.backend = properties.backendType;
+    info.vendorID = properties.vendorID;
+    info.deviceID = properties.deviceID;
+    return info;
+}
+
+// First adapter of the given type, or -1
+int firstOfType(const std::vector<AdapterInfo>& adapters, const std::vector<int>& candidates, WGPUAdapterType type) {
+    for (int i : candidates) {
+        if (adapters[i].type == type) return i;
+    }
+    return -1;
+}
+
+} // namespace
+
+std::vector<AdapterInfo> AdapterSelection::enumerate(wgpu::Instance instance) {
+    // No options: every backend wgpu was built with
+    size_t count = wgpuInstanceEnumerateAdapters(instance, nullptr, nullptr);
+    std::vector<WGPUAdapter> handles(count);
+    if (count > 0) count = wgpuInstanceEnumerateAdapters(instance, nullptr, handles.data());
+    std::vector<AdapterInfo> adapters;
+    adapters.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        adapters.push_back(describe(handles[i]));
+    }
+    return adapters;
+}
+
+void AdapterSelection::release(std::vector<AdapterInfo>& adapters) {
+    for (AdapterInfo& info : adapters) {
+        if (info.adapter) info.adapter.release();
+        info.adapter = nullptr;
+    }
+    adapters.clear();
+}
+
+int AdapterSelection::select(std::vector<AdapterInfo>& adapters, const Policy& policy) {
+    std::vector<int> candidates;
+    bool hasHardware = false;
+    for (int i = 0; i < static_cast<int>(adapters.size()); ++i) {
+        const AdapterInfo& info = adapters[i];
+        if (policy.backend != WGPUBackendType_Null && info.backend != policy.backend) continue;
+        if (policy.compatibleSurface && !isSurfaceCompatible(info, policy.compatibleSurface)) continue;
+        candidates.push_back(i);
+        hasHardware = hasHardware || info.type != WGPUAdapterType_CPU;
+    }
+    if (!policy.allowCpu && hasHardware) {
+        candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&](int i) {
+            return adapters[i].type == WGPUAdapterType_CPU;
+        }), candidates.end());
+    }
+    if (candidates.empty()) return -1;
+
+    switch (policy.preference) {
+    case AdapterPreference::Default:
+        break;
+    case AdapterPreference::Discrete:
+        for (WGPUAdapterType type : { WGPUAdapterType_DiscreteGPU, WGPUAdapterType_IntegratedGPU }) {
+            int i = firstOfType(adapters, candidates, type);
+            if (i >= 0) return i;
+        }
+        break;
+    case AdapterPreference::Integrated:
+        for (WGPUAdapterType type : { WGPUAdapterType_IntegratedGPU, WGPUAdapterType_DiscreteGPU }) {
+            int i = firstOfType(adapters, candidates, type);
+            if (i >= 0) return i;
+        }
+        break;
+    case AdapterPreference::LowestLatency: {
+        int best = -1;
+        for (int i : candidates) {
+            adapters[i].latencyMs = measureLatency(adapters[i].adapter);
+            if (adapters[i].latencyMs < 0.0) continue;
+            if (best < 0 || adapters[i].latencyMs < adapters[best].latencyMs) best = i;
+        }
+        if (best >= 0) return best;
+        break;
+    }
+    }
+    return candidates.front();
+}
+
+double AdapterSelection::measureLatency(wgpu::Adapter adapter, uint32_t iterations) {
+    using Clock = std::chrono::steady_clock;
+    wgpu::DeviceDescriptor deviceDesc = {};
+    deviceDesc.label = "Latency probe";
+    deviceDesc.requiredFeaturesCount = 0;
+    deviceDesc.requiredLimits = nullptr;
+    deviceDesc.defaultQueue.nextInChain = nullptr;
+    deviceDesc.defaultQueue.label = "Latency probe queue";
+    wgpu::Device device = adapter.requestDevice(deviceDesc);
+    if (!device) return -1.0;
+    wgpu::Queue queue = device.getQueue();
+
+    std::vector<double> roundTripMs;
+    roundTripMs.reserve(iterations);
+    // The first submit also pays for the lazy initialization of the queue
+    for (uint32_t i = 0; i < iterations + 1; ++i) {
+        wgpu::CommandEncoderDescriptor encoderDesc = {};
+        encoderDesc.label = "Latency probe";
+        wgpu::CommandEncoder encoder = device.createCommandEncoder(encoderDesc);
+        wgpu::CommandBufferDescriptor cmdBufferDescriptor = {};
+        cmdBufferDescriptor.label = "Latency probe";
+        wgpu::CommandBuffer command = encoder.finish(cmdBufferDescriptor);
+        encoder.release();
+
+        auto start = Clock::now();
+        queue.submit(1, &command);
+        while (!wgpuDevicePoll(device, true, nullptr)) {}
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        command.release();
+        if (i > 0) roundTripMs.push_back(ms);
+    }
+
+    queue.release();
+    device.release();
+    if (roundTripMs.empty()) return -1.0;
+    std::nth_element(roundTripMs.begin(), roundTripMs.begin() + roundTripMs.size() / 2, roundTripMs.end());
+    return roundTripMs[roundTripMs.size() / 2];
+}
+
+bool AdapterSelection::isSurfaceCompatible(const AdapterInfo& info, wgpu::Surface surface) {
+    // Counts only: the arrays are left null
+    WGPUSurfaceCapabilities capabilities = {};
+    wgpuSurfaceGetCapabilities(surface, info.adapter, &capabilities);
+    return capabilities.formatCount > 0;
+}
+
+const char* AdapterSelection::typeName(WGPUAdapterType type) {
+    switch (type) {
+    case WGPUAdapterType_DiscreteGPU: return "discrete";
+    case WGPUAdapterType_IntegratedGPU: return "integrated";
+    case WGPUAdapterType_CPU: return "cpu";
+    default: return "unknown";
+    }
+}
+
+const char* AdapterSelection::backendName(WGPUBackendType backend) {
+    switch (backend) {
+    case WGPUBackendType_Null: return "any";
+    case WGPUBackendType_WebGPU: return "webgpu";
+    case WGPUBackendType_D3D11: return "d3d11";
+    case WGPUBackendType_D3D12: return "d3d12";
+    case WGPUBackendType_Metal: return "metal";
+    case WGPUBackendType_Vulkan: return "vulkan";
+    case WGPUBackendType_OpenGL: return "opengl";
+    case WGPUBackendType_OpenGLES: return "opengles";
+    default: return "unknown";
+    }
+}
+
+bool AdapterSelection::parsePreference(const char* name, AdapterPreference& preference) {
+    const std::pair<const char*, AdapterPreference> names[] = {
+        { "default", AdapterPreference::Default },
+        { "discrete", AdapterPreference::Discrete },
+        { "integrated", AdapterPreference::Integrated },
+        { "latency", AdapterPreference::LowestLatency },
+    };
+    for (const auto& entry : names) {
+        if (std::strcmp(name, entry.first) == 0) {
+            preference = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AdapterSelection::parseBackend(const char* name, WGPUBackendType& backend) {
+    for (WGPUBackendType candidate : { WGPUBackendType_Null, WGPUBackendType_D3D11, WGPUBackendType_D3D12, WGPUBackendType_Metal,
+        WGPUBackendType_Vulkan, WGPUBackendType_OpenGL, WGPUBackendType_OpenGLES }) {
+        if (std::strcmp(name, backendName(candidate)) == 0) {
+            backend = candidate;
+            return true;
+        }
+    }
+    return false;
+}
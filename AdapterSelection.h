@@ -0,0 +1,73 @@
+#pragma once
+
+#include <webgpu/webgpu.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class AdapterPreference {
+    // Whatever wgpuInstanceRequestAdapter would have picked: the first one
+    Default,
+    Discrete,
+    Integrated,
+    // Shortest round trip of an empty submit, measured on a throwaway device
+    LowestLatency,
+};
+
+struct AdapterInfo {
+    wgpu::Adapter adapter = nullptr;
+    std::string name;
+    std::string driver;
+    WGPUAdapterType type = WGPUAdapterType_Unknown;
+    WGPUBackendType backend = WGPUBackendType_Null;
+    uint32_t vendorID = 0;
+    uint32_t deviceID = 0;
+    // Median submit round trip, negative until measured
+    double latencyMs = -1.0;
+};
+
+/**
+ * Every adapter of the instance (wgpuInstanceEnumerateAdapters) rather than
+ * the single one requestAdapter returns, and a policy to pick among them.
+ */
+class AdapterSelection {
+public:
+    struct Policy {
+        AdapterPreference preference = AdapterPreference::Default;
+        // Only adapters of this backend; any when Null
+        WGPUBackendType backend = WGPUBackendType_Null;
+        // Software adapters (llvmpipe, WARP) are only picked when nothing
+        // else is left, unless this is set
+        bool allowCpu = false;
+        // Only adapters that can present to it, if not null
+        wgpu::Surface compatibleSurface = nullptr;
+    };
+
+    /**
+     * The caller owns the adapters: see release().
+     */
+    static std::vector<AdapterInfo> enumerate(wgpu::Instance instance);
+    static void release(std::vector<AdapterInfo>& adapters);
+
+    /**
+     * Index of the adapter the policy picks, or -1 when none passes its
+     * filters. Fills in latencyMs of the candidates for LowestLatency.
+     */
+    static int select(std::vector<AdapterInfo>& adapters, const Policy& policy);
+
+    /**
+     * Median time, in ms, from submitting an empty command buffer to the
+     * device reporting it done, on a device opened for the occasion.
+     * Negative if no device could be opened.
+     */
+    static double measureLatency(wgpu::Adapter adapter, uint32_t iterations = 16);
+
+    static bool isSurfaceCompatible(const AdapterInfo& info, wgpu::Surface surface);
+
+    static const char* typeName(WGPUAdapterType type);
+    static const char* backendName(WGPUBackendType backend);
+    // "default", "discrete", "integrated" or "latency"
+    static bool parsePreference(const char* name, AdapterPreference& preference);
+    // "vulkan", "metal", "d3d12", "d3d11", "opengl", "opengles" or "any"
+    static bool parseBackend(const char* name, WGPUBackendType& backend);
+};
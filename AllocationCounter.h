@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Counts the allocations made with operator new, which AllocationCounter.cpp
+ * replaces for the whole program: linking it in is what turns counting on.
+ * Each thread counts its own, with a plain thread-local increment, so the
+ * counts of the frame loop are not blurred by the logger or the driver
+ * threads.
+ */
+class AllocationCounter {
+public:
+    /**
+     * Allocations made by the calling thread so far.
+     */
+    static uint64_t threadCount();
+};
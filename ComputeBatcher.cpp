@@ -0,0 +1,165 @@
+#include "ComputeBatcher.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <utility>
+
+ComputeBatcher::ComputeBatcher(ComputeContext& context)
+    : ComputeBatcher(context, Options())
+{}
+
+ComputeBatcher::ComputeBatcher(ComputeContext& context, const Options& options)
+    : m_context(context)
+    , m_options(options)
+{
+    assert(options.maxJobsPerSubmit > 0);
+}
+
+ComputeBatcher::~ComputeBatcher() {
+    wait();
+}
+
+std::future<bool> ComputeBatcher::enqueue(Kernel& kernel, const KernelArgs& args, uint32_t invocationCount) {
+    Job job;
+    job.kernel = &kernel;
+    job.args = args;
+    // Not through Kernel::dispatch(pass, args), whose single cached bind
+    // group would be replaced on every job of a batch
+    if (m_context.hasGpu()) job.bindGroup = kernel.createBindGroup(args);
+    job.invocationCount = invocationCount;
+    job.label = kernel.label();
+    std::future<bool> future = job.done.get_future();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending.push_back(std::move(job));
+    return future;
+}
+
+std::future<bool> ComputeBatcher::enqueueStep(std::string label, std::function<bool(wgpu::ComputePassEncoder pass)> encode, std::function<bool()> runCpu) {
+    Job job;
+    job.label = std::move(label);
+    job.encode = std::move(encode);
+    job.runCpu = std::move(runCpu);
+    std::future<bool> future = job.done.get_future();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending.push_back(std::move(job));
+    return future;
+}
+
+size_t ComputeBatcher::pendingJobCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending.size();
+}
+
+size_t ComputeBatcher::flush() {
+    std::vector<Job> jobs;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        jobs.swap(m_pending);
+    }
+    if (jobs.empty()) return 0;
+
+    // Jobs are independent, so group them by kernel to switch pipelines once
+    // per kernel rather than once per job
+    std::stable_sort(jobs.begin(), jobs.end(), [](const Job& a, const Job& b) {
+        return std::less<Kernel*>()(a.kernel, b.kernel);
+    });
+    for (size_t begin = 0; begin < jobs.size(); begin += m_options.maxJobsPerSubmit) {
+        size_t end = std::min(begin + m_options.maxJobsPerSubmit, jobs.size());
+        if (m_context.hasGpu()) {
+            submitBatch(jobs.begin() + begin, jobs.begin() + end);
+        }
+        else {
+            runBatchCpu(jobs.begin() + begin, jobs.begin() + end);
+        }
+        ++m_submitCount;
+    }
+    return jobs.size();
+}
+
+void ComputeBatcher::runBatchCpu(std::vector<Job>::iterator begin, std::vector<Job>::iterator end) {
+    for (auto job = begin; job != end; ++job) {
+        bool ok = true;
+        if (job->kernel) {
+            job->kernel->runReference(job->args, job->invocationCount);
+        }
+        else {
+            assert(job->runCpu);
+            ok = job->runCpu();
+        }
+        if (!ok) std::cerr << "ComputeBatcher: job " << job->label << " failed" << std::endl;
+        job->done.set_value(ok);
+    }
+}
+
+void ComputeBatcher::submitBatch(std::vector<Job>::iterator begin, std::vector<Job>::iterator end) {
+    auto submit = std::make_unique<Submit>();
+
+    wgpu::CommandEncoder encoder = m_context.createEncoder("Compute batch");
+    wgpu::ComputePassDescriptor computePassDesc;
+    computePassDesc.label = "Compute batch";
+    computePassDesc.timestampWriteCount = 0;
+    computePassDesc.timestampWrites = nullptr;
+    wgpu::ComputePassEncoder pass = encoder.beginComputePass(computePassDesc);
+    for (auto job = begin; job != end; ++job) {
+        if (job->kernel) {
+            job->kernel->dispatch(pass, job->bindGroup, job->invocationCount);
+        }
+        else if (!job->encode(pass)) {
+            std::cerr << "ComputeBatcher: job " << job->label << " failed" << std::endl;
+            submit->ok = false;
+        }
+        submit->promises.push_back(std::move(job->done));
+    }
+    pass.end();
+    pass.release();
+    // The pass holds on to the bind groups it used
+    for (auto job = begin; job != end; ++job) {
+        if (job->bindGroup) job->bindGroup.release();
+    }
+
+    wgpu::CommandBufferDescriptor cmdBufferDescriptor = {};
+    cmdBufferDescriptor.label = "Compute batch command buffer";
+    wgpu::CommandBuffer command = encoder.finish(cmdBufferDescriptor);
+    encoder.release();
+    WGPUCommandBuffer rawCommand = command;
+    submit->index = wgpuQueueSubmitForIndex(m_context.queue(), 1, &rawCommand);
+    command.release();
+
+    // Called from a later device poll, once the submit is done
+    Submit* submitPtr = submit.get();
+    submit->workDoneCallback = m_context.queue().onSubmittedWorkDone([submitPtr](wgpu::QueueWorkDoneStatus status) {
+        if (status != wgpu::QueueWorkDoneStatus::Success) submitPtr->ok = false;
+        submitPtr->done = true;
+    });
+    m_inFlight.push_back(std::move(submit));
+}
+
+void ComputeBatcher::resolveDoneSubmits() {
+    auto done = std::stable_partition(m_inFlight.begin(), m_inFlight.end(), [](const std::unique_ptr<Submit>& submit) {
+        return !submit->done;
+    });
+    for (auto it = done; it != m_inFlight.end(); ++it) {
+        for (std::promise<bool>& promise : (*it)->promises) promise.set_value((*it)->ok);
+    }
+    m_inFlight.erase(done, m_inFlight.end());
+}
+
+void ComputeBatcher::poll() {
+    if (!m_context.hasGpu()) return;
+    m_context.poll();
+    resolveDoneSubmits();
+}
+
+void ComputeBatcher::wait() {
+    flush();
+    if (!m_context.hasGpu()) return;
+    // Block on each submission index in turn
+    for (const std::unique_ptr<Submit>& submit : m_inFlight) {
+        WGPUWrappedSubmissionIndex wrappedIndex = {};
+        wrappedIndex.queue = m_context.queue();
+        wrappedIndex.submissionIndex = submit->index;
+        while (!submit->done) wgpuDevicePoll(m_context.device(), true, &wrappedIndex);
+    }
+    resolveDoneSubmits();
+}
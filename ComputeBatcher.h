@@ -0,0 +1,116 @@
+#pragma once
+
+#include "ComputeRuntime.h"
+
+#include <webgpu/webgpu.hpp>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Queue of small independent compute jobs, recorded together so that the
+ * cost of a submit (and of beginning a pass) is paid once per batch rather
+ * than once per job.
+ *
+ * Any thread may enqueue jobs and wait on their futures. The thread that
+ * owns the device calls flush(), which records the pending jobs grouped by
+ * kernel into one pass per submit (at most maxJobsPerSubmit jobs each), and
+ * poll() or wait(), which resolve the futures of the submits the GPU has
+ * finished. Each submit is tracked by its submission index, so futures
+ * resolve as soon as their own submit is done, not when the queue is idle.
+ *
+ * Jobs of a batch may run in any order and concurrently: a job must not
+ * read what another job of the same batch writes.
+ *
+ * In CPU mode flush() runs the jobs (their CPU reference), in the same
+ * batches, and resolves their futures right away.
+ */
+class ComputeBatcher {
+public:
+    struct Options {
+        uint32_t maxJobsPerSubmit = 4096;
+    };
+
+    explicit ComputeBatcher(ComputeContext& context);
+    ComputeBatcher(ComputeContext& context, const Options& options);
+    /**
+     * Flushes and waits for every job.
+     */
+    ~ComputeBatcher();
+    ComputeBatcher(const ComputeBatcher&) = delete;
+    ComputeBatcher& operator=(const ComputeBatcher&) = delete;
+
+    /**
+     * Dispatch kernel on at least invocationCount invocations. The future is
+     * true once the GPU has run the job, false if its batch failed. Kernel
+     * and arrays are borrowed until then. The bind group of the job is
+     * created here, on the calling thread.
+     */
+    std::future<bool> enqueue(Kernel& kernel, const KernelArgs& args, uint32_t invocationCount);
+
+    /**
+     * Any other job, like ComputeChain::addStep: encode records it in the
+     * pass (GPU mode), runCpu runs it on host memory (CPU mode).
+     */
+    std::future<bool> enqueueStep(std::string label, std::function<bool(wgpu::ComputePassEncoder pass)> encode, std::function<bool()> runCpu);
+
+    /**
+     * Record and submit the pending jobs (device thread only). Returns the
+     * number of jobs flushed.
+     */
+    size_t flush();
+
+    /**
+     * Resolve the futures of the finished submits, without blocking (device
+     * thread only).
+     */
+    void poll();
+
+    /**
+     * Flush, then block until every job is done (device thread only).
+     */
+    void wait();
+
+    size_t pendingJobCount() const;
+    size_t inFlightSubmitCount() const { return m_inFlight.size(); }
+    // Batches flushed so far
+    uint64_t submitCount() const { return m_submitCount; }
+
+private:
+    struct Job {
+        Kernel* kernel = nullptr;
+        KernelArgs args;
+        // Of args, GPU mode only
+        wgpu::BindGroup bindGroup = nullptr;
+        uint32_t invocationCount = 0;
+        std::string label;
+        std::function<bool(wgpu::ComputePassEncoder)> encode;
+        std::function<bool()> runCpu;
+        std::promise<bool> done;
+    };
+
+    struct Submit {
+        WGPUSubmissionIndex index = 0;
+        std::vector<std::promise<bool>> promises;
+        // Set by the work done callback, from a device poll
+        bool done = false;
+        bool ok = true;
+        std::unique_ptr<wgpu::QueueWorkDoneCallback> workDoneCallback;
+    };
+
+    void submitBatch(std::vector<Job>::iterator begin, std::vector<Job>::iterator end);
+    void runBatchCpu(std::vector<Job>::iterator begin, std::vector<Job>::iterator end);
+    void resolveDoneSubmits();
+
+private:
+    ComputeContext& m_context;
+    Options m_options;
+    mutable std::mutex m_mutex;
+    std::vector<Job> m_pending;
+    std::vector<std::unique_ptr<Submit>> m_inFlight;
+    uint64_t m_submitCount = 0;
+};
@@ -0,0 +1,200 @@
+#include "ComputeChain.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <utility>
+
+namespace {
+
+const char* dispatchArgsSource = R"(
+struct Params {
+	countIndex: u32,
+	argsIndex: u32,
+	workgroupSize: u32,
+	maxWorkgroupsPerDimension: u32,
+}
+
+override workgroupSize: u32 = 1u;
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var<storage, read> counts: array<u32>;
+@group(0) @binding(2) var<storage, read_write> args: array<u32>;
+
+@compute @workgroup_size(workgroupSize)
+fn main() {
+	let count = counts[params.countIndex];
+	let groupCount = (count + params.workgroupSize - 1u) / params.workgroupSize;
+	if (groupCount <= params.maxWorkgroupsPerDimension) {
+		args[params.argsIndex] = groupCount;
+		args[params.argsIndex + 1u] = 1u;
+	} else {
+		args[params.argsIndex] = params.maxWorkgroupsPerDimension;
+		args[params.argsIndex + 1u] = (groupCount + params.maxWorkgroupsPerDimension - 1u) / params.maxWorkgroupsPerDimension;
+	}
+	args[params.argsIndex + 2u] = 1u;
+}
+)";
+
+} // namespace
+
+ComputeChain::ComputeChain(ComputeContext& context, std::string label)
+    : m_context(context)
+    , m_label(std::move(label))
+{}
+
+ComputeChain::~ComputeChain() {
+    for (Stage& stage : m_stages) {
+        if (stage.bindGroup) stage.bindGroup.release();
+    }
+}
+
+Kernel& ComputeChain::dispatchArgsKernel() {
+    if (!m_dispatchArgsKernel) {
+        KernelDesc desc;
+        desc.label = "Dispatch arguments";
+        desc.source = dispatchArgsSource;
+        desc.workgroupSize = 1;
+        desc.bindings = { KernelBinding::Uniform, KernelBinding::ReadOnlyStorage, KernelBinding::Storage };
+        m_dispatchArgsKernel = std::make_unique<Kernel>(m_context, desc);
+    }
+    return *m_dispatchArgsKernel;
+}
+
+void ComputeChain::add(Kernel& kernel, const KernelArgs& args, uint32_t invocationCount) {
+    Stage stage;
+    stage.kind = StageKind::Direct;
+    stage.label = kernel.label();
+    stage.kernel = &kernel;
+    stage.args = args;
+    stage.invocationCount = invocationCount;
+    if (m_context.hasGpu()) stage.bindGroup = kernel.createBindGroup(args);
+    m_stages.push_back(std::move(stage));
+}
+
+void ComputeChain::addIndirect(Kernel& kernel, const KernelArgs& args, GpuArray<uint32_t>& indirectArgs, uint64_t offset) {
+    assert(offset % 4 == 0 && offset + 3 * sizeof(uint32_t) <= indirectArgs.byteSize());
+    Stage stage;
+    stage.kind = StageKind::Indirect;
+    stage.label = kernel.label();
+    stage.kernel = &kernel;
+    stage.args = args;
+    stage.indirectArgs = &indirectArgs;
+    stage.offset = offset;
+    if (m_context.hasGpu()) stage.bindGroup = kernel.createBindGroup(args);
+    m_stages.push_back(std::move(stage));
+}
+
+void ComputeChain::addDispatchArgs(GpuArray<uint32_t>& counts, uint32_t countIndex, GpuArray<uint32_t>& indirectArgs, uint64_t offset, uint32_t workgroupSize) {
+    assert(countIndex < counts.size());
+    assert(&counts != &indirectArgs);
+    assert(offset % 4 == 0 && offset + 3 * sizeof(uint32_t) <= indirectArgs.byteSize());
+    assert(workgroupSize > 0);
+
+    Stage stage;
+    stage.kind = StageKind::DispatchArgs;
+    stage.label = "Dispatch arguments";
+    stage.indirectArgs = &indirectArgs;
+    stage.offset = offset;
+    stage.args = { &counts };
+
+    DispatchArgsParams params = {};
+    params.countIndex = countIndex;
+    params.argsIndex = static_cast<uint32_t>(offset / sizeof(uint32_t));
+    params.workgroupSize = workgroupSize;
+    params.maxWorkgroupsPerDimension = m_context.maxWorkgroupsPerDimension();
+    stage.params = std::make_unique<GpuArray<DispatchArgsParams>>(m_context, 1, WGPUBufferUsage_Uniform);
+    stage.params->upload(&params, 1);
+    if (m_context.hasGpu()) {
+        stage.bindGroup = dispatchArgsKernel().createBindGroup({ stage.params.get(), &counts, &indirectArgs });
+    }
+    m_stages.push_back(std::move(stage));
+}
+
+void ComputeChain::addStep(std::string label, std::function<bool(wgpu::ComputePassEncoder pass)> encode, std::function<bool()> runCpu) {
+    Stage stage;
+    stage.kind = StageKind::Step;
+    stage.label = std::move(label);
+    stage.encode = std::move(encode);
+    stage.runCpu = std::move(runCpu);
+    m_stages.push_back(std::move(stage));
+}
+
+bool ComputeChain::encode(wgpu::ComputePassEncoder pass) {
+    assert(m_context.hasGpu());
+    for (Stage& stage : m_stages) {
+        switch (stage.kind) {
+        case StageKind::Direct:
+            stage.kernel->dispatch(pass, stage.bindGroup, stage.invocationCount);
+            break;
+        case StageKind::Indirect:
+            stage.kernel->dispatchIndirect(pass, stage.bindGroup, stage.indirectArgs->buffer(), stage.offset);
+            break;
+        case StageKind::DispatchArgs:
+            dispatchArgsKernel().dispatch(pass, stage.bindGroup, 1);
+            break;
+        case StageKind::Step:
+            if (!stage.encode(pass)) {
+                std::cerr << m_label << ": stage " << stage.label << " failed" << std::endl;
+                return false;
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+bool ComputeChain::runStageCpu(Stage& stage) {
+    switch (stage.kind) {
+    case StageKind::Direct:
+        stage.kernel->runReference(stage.args, stage.invocationCount);
+        return true;
+    case StageKind::Indirect: {
+        // As many invocations as the GPU would run
+        const uint32_t* groups = stage.indirectArgs->host() + stage.offset / sizeof(uint32_t);
+        uint64_t invocationCount = uint64_t(groups[0]) * groups[1] * groups[2] * stage.kernel->workgroupSize();
+        if (invocationCount > UINT32_MAX) return false;
+        stage.kernel->runReference(stage.args, static_cast<uint32_t>(invocationCount));
+        return true;
+    }
+    case StageKind::DispatchArgs: {
+        const DispatchArgsParams& params = *stage.params->host();
+        uint32_t count = static_cast<GpuArray<uint32_t>*>(stage.args[0])->host()[params.countIndex];
+        uint32_t groupCount = (count + params.workgroupSize - 1) / params.workgroupSize;
+        uint32_t maxGroups = params.maxWorkgroupsPerDimension;
+        uint32_t* args = stage.indirectArgs->host() + params.argsIndex;
+        args[0] = std::min(groupCount, maxGroups);
+        args[1] = groupCount <= maxGroups ? 1 : (groupCount + maxGroups - 1) / maxGroups;
+        args[2] = 1;
+        return true;
+    }
+    case StageKind::Step:
+        assert(stage.runCpu);
+        return stage.runCpu();
+    }
+    return false;
+}
+
+bool ComputeChain::run() {
+    if (!m_context.hasGpu()) {
+        for (Stage& stage : m_stages) {
+            if (!runStageCpu(stage)) {
+                std::cerr << m_label << ": stage " << stage.label << " failed" << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    wgpu::CommandEncoder encoder = m_context.createEncoder(m_label.c_str());
+    wgpu::ComputePassDescriptor computePassDesc;
+    computePassDesc.label = m_label.c_str();
+    computePassDesc.timestampWriteCount = 0;
+    computePassDesc.timestampWrites = nullptr;
+    wgpu::ComputePassEncoder pass = encoder.beginComputePass(computePassDesc);
+    bool ok = encode(pass);
+    pass.end();
+    pass.release();
+    m_context.submit(encoder);
+    return ok;
+}
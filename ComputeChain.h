@@ -0,0 +1,111 @@
+#pragma once
+
+#include "ComputeRuntime.h"
+
+#include <webgpu/webgpu.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * A fixed sequence of compute stages recorded in a single pass, where a
+ * stage can take its workgroup counts from a buffer written by an earlier
+ * one (dispatchWorkgroupsIndirect). Multi-stage algorithms such as
+ * cull -> compact -> sort -> draw then run without waiting for the GPU
+ * between stages, nor reading any count back.
+ *
+ * In CPU mode, run() is the reference executor: stages run in order on
+ * host memory, and indirect stages read their workgroup counts from the
+ * host copy of the arguments array, so the chain computes the same results
+ * with or without a GPU.
+ *
+ * Kernels and arrays are borrowed and must outlive the chain. Bind groups
+ * are created once when stages are added.
+ */
+class ComputeChain {
+public:
+    explicit ComputeChain(ComputeContext& context, std::string label = "Compute chain");
+    ~ComputeChain();
+    ComputeChain(const ComputeChain&) = delete;
+    ComputeChain& operator=(const ComputeChain&) = delete;
+
+    /**
+     * Dispatch kernel on at least invocationCount invocations.
+     */
+    void add(Kernel& kernel, const KernelArgs& args, uint32_t invocationCount);
+
+    /**
+     * Dispatch kernel with the workgroup counts (x, y, z) found at byte
+     * offset of indirectArgs, which needs the Indirect usage.
+     */
+    void addIndirect(Kernel& kernel, const KernelArgs& args, GpuArray<uint32_t>& indirectArgs, uint64_t offset);
+
+    /**
+     * Write at byte offset of indirectArgs the workgroup counts to run one
+     * invocation per item of the count found at counts[countIndex], in
+     * workgroups of workgroupSize (split over two dimensions like
+     * Kernel::workgroupCount). counts and indirectArgs must be different
+     * arrays: both are bound as storage in the same dispatch.
+     */
+    void addDispatchArgs(GpuArray<uint32_t>& counts, uint32_t countIndex, GpuArray<uint32_t>& indirectArgs, uint64_t offset, uint32_t workgroupSize);
+
+    /**
+     * Any other stage, e.g. StreamCompaction or RadixSort: encode records it
+     * in the pass (GPU mode), runCpu runs it on host memory (CPU mode). Both
+     * return false on failure, which stops the chain.
+     */
+    void addStep(std::string label, std::function<bool(wgpu::ComputePassEncoder pass)> encode, std::function<bool()> runCpu);
+
+    /**
+     * Record every stage in order (GPU mode).
+     */
+    bool encode(wgpu::ComputePassEncoder pass);
+
+    /**
+     * Encode and submit in GPU mode (without waiting), or run the CPU
+     * reference executor.
+     */
+    bool run();
+
+    size_t stageCount() const { return m_stages.size(); }
+
+private:
+    enum class StageKind {
+        Direct,
+        Indirect,
+        DispatchArgs,
+        Step,
+    };
+
+    struct DispatchArgsParams {
+        uint32_t countIndex;
+        uint32_t argsIndex;
+        uint32_t workgroupSize;
+        uint32_t maxWorkgroupsPerDimension;
+    };
+
+    struct Stage {
+        StageKind kind = StageKind::Direct;
+        std::string label;
+        Kernel* kernel = nullptr;
+        KernelArgs args;
+        uint32_t invocationCount = 0;
+        GpuArray<uint32_t>* indirectArgs = nullptr;
+        uint64_t offset = 0;
+        std::unique_ptr<GpuArray<DispatchArgsParams>> params;
+        std::function<bool(wgpu::ComputePassEncoder)> encode;
+        std::function<bool()> runCpu;
+        wgpu::BindGroup bindGroup = nullptr;
+    };
+
+    bool runStageCpu(Stage& stage);
+    Kernel& dispatchArgsKernel();
+
+private:
+    ComputeContext& m_context;
+    std::string m_label;
+    std::vector<Stage> m_stages;
+    std::unique_ptr<Kernel> m_dispatchArgsKernel;
+};
@@ -0,0 +1,560 @@
+#include "ComputeKernels.h"
+
+#include "ComputeBatcher.h"
+#include "ComputeChain.h"
+#include "ImageProcessing.h"
+#include "MatrixMultiply.h"
+#include "ParticleSystem.h"
+#include "PrefixScan.h"
+#include "RadixSort.h"
+#include "Reduction.h"
+#include "StreamCompaction.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <utility>
+
+namespace {
+
+const char* saxpySource = R"(
+struct Params {
+	a: f32,
+	count: u32,
+}
+
+override workgroupSize: u32 = 64u;
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var<storage, read> x: array<f32>;
+@group(0) @binding(2) var<storage, read_write> y: array<f32>;
+
+@compute @workgroup_size(workgroupSize)
+fn main(@builtin(global_invocation_id) id: vec3<u32>, @builtin(num_workgroups) groups: vec3<u32>) {
+	let i = id.x + id.y * groups.x * workgroupSize;
+	if (i >= params.count) {
+		return;
+	}
+	y[i] = params.a * x[i] + y[i];
+}
+)";
+
+void saxpyReference(const KernelArgs& args, uint32_t invocationCount) {
+    const SaxpyParams& params = *static_cast<const GpuArray<SaxpyParams>*>(args[0])->host();
+    const float* x = static_cast<const GpuArray<float>*>(args[1])->host();
+    float* y = static_cast<GpuArray<float>*>(args[2])->host();
+    uint32_t count = std::min(invocationCount, params.count);
+    for (uint32_t i = 0; i < count; ++i) {
+        y[i] = params.a * x[i] + y[i];
+    }
+}
+
+// Doubles the first counts[3] elements of data, e.g. after a compaction
+const char* doubleCountedSource = R"(
+override workgroupSize: u32 = 64u;
+
+@group(0) @binding(0) var<storage, read> counts: array<u32>;
+@group(0) @binding(1) var<storage, read_write> data: array<u32>;
+
+@compute @workgroup_size(workgroupSize)
+fn main(@builtin(global_invocation_id) id: vec3<u32>, @builtin(num_workgroups) groups: vec3<u32>) {
+	let i = id.x + id.y * groups.x * workgroupSize;
+	if (i >= counts[3]) {
+		return;
+	}
+	data[i] = 2u * data[i];
+}
+)";
+
+void doubleCountedReference(const KernelArgs& args, uint32_t invocationCount) {
+    const uint32_t* counts = static_cast<const GpuArray<uint32_t>*>(args[0])->host();
+    uint32_t* data = static_cast<GpuArray<uint32_t>*>(args[1])->host();
+    for (uint32_t i = 0; i < invocationCount && i < counts[3]; ++i) {
+        data[i] = 2 * data[i];
+    }
+}
+
+bool report(const char* name, bool ok) {
+    std::cout << "Compute check " << name << ": " << (ok ? "ok" : "MISMATCH") << std::endl;
+    return ok;
+}
+
+/**
+ * Run the same work on the GPU context, then on a CPU only one, into
+ * results[0] and results[1]. Stops as soon as run() returns false.
+ */
+template <typename Result, typename Run>
+bool runOnBoth(ComputeContext& gpu, Result (&results)[2], Run&& run) {
+    ComputeContext cpu;
+    ComputeContext* contexts[2] = { &gpu, &cpu };
+    for (int c = 0; c < 2; ++c) {
+        if (!run(*contexts[c], results[c])) return false;
+    }
+    return true;
+}
+
+/**
+ * runOnBoth(), reported under name: a mismatch if run() fails on either
+ * side or if match(result, expected) is false for either result. expected
+ * comes from a plain implementation (the standard library, naive loops),
+ * so that a bug shared by the GPU kernel and its CPU fallback still shows.
+ */
+template <typename Result, typename Run, typename Match>
+bool checkAgainst(const char* name, ComputeContext& gpu, const Result& expected, Run&& run, Match&& match) {
+    Result results[2];
+    if (!runOnBoth(gpu, results, run)) return report(name, false);
+    return report(name, match(results[0], expected) && match(results[1], expected));
+}
+
+template <typename Result, typename Run>
+bool checkAgainst(const char* name, ComputeContext& gpu, const Result& expected, Run&& run) {
+    return checkAgainst(name, gpu, expected, run, [](const Result& a, const Result& b) { return a == b; });
+}
+
+/**
+ * runOnBoth(), reported under name, when there is no plain implementation
+ * to compare with: a mismatch if run() fails on either side or if
+ * match(gpuResult, cpuResult) is false.
+ */
+template <typename Result, typename Run, typename Match>
+bool checkOnBoth(const char* name, ComputeContext& gpu, Run&& run, Match&& match) {
+    Result results[2];
+    if (!runOnBoth(gpu, results, run)) return report(name, false);
+    return report(name, match(results[0], results[1]));
+}
+
+bool nearlyEqual(const std::vector<float>& a, const std::vector<float>& b, float tolerance) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::abs(a[i] - b[i]) > tolerance) return false;
+    }
+    return true;
+}
+
+bool checkSaxpy(ComputeContext& gpu, std::mt19937& rng) {
+    constexpr uint32_t count = 100000;
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    std::vector<float> x(count), y(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        x[i] = distribution(rng);
+        y[i] = distribution(rng);
+    }
+    SaxpyParams params = { 2.5f, count, {0, 0} };
+    std::vector<float> expected(count);
+    std::transform(x.begin(), x.end(), y.begin(), expected.begin(), [&](float xi, float yi) { return params.a * xi + yi; });
+
+    return checkAgainst("saxpy", gpu, expected, [&](ComputeContext& context, std::vector<float>& result) {
+        GpuArray<SaxpyParams> paramsArray(context, 1, WGPUBufferUsage_Uniform);
+        GpuArray<float> xArray(context, count);
+        GpuArray<float> yArray(context, count);
+        paramsArray.upload(&params, 1);
+        xArray.upload(x);
+        yArray.upload(y);
+        Kernel kernel(context, saxpyKernelDesc());
+        kernel.run({ &paramsArray, &xArray, &yArray }, count);
+        result = yArray.download();
+        return true;
+    }, [](const std::vector<float>& result, const std::vector<float>& expected) {
+        // The GPU may use a fused multiply-add
+        return nearlyEqual(result, expected, 1e-5f);
+    });
+}
+
+template <typename T>
+bool checkPrefixScan(ComputeContext& gpu, std::mt19937& rng, ScanElement element, ScanKind kind, const char* name) {
+    // Enough for three levels. Small integer values keep f32 sums exact, so
+    // that both sides can be compared exactly whatever the summation order.
+    constexpr uint32_t count = 3000000;
+    std::uniform_int_distribution<uint32_t> distribution(0, 3);
+    std::vector<T> input(count);
+    for (T& value : input) value = static_cast<T>(distribution(rng));
+    std::vector<T> expected(count);
+    if (kind == ScanKind::Exclusive) std::exclusive_scan(input.begin(), input.end(), expected.begin(), T(0));
+    else std::inclusive_scan(input.begin(), input.end(), expected.begin());
+
+    return checkAgainst(name, gpu, expected, [&](ComputeContext& context, std::vector<T>& result) {
+        GpuArray<T> inputArray(context, count);
+        GpuArray<T> outputArray(context, count);
+        inputArray.upload(input);
+        PrefixScan scan(context, element);
+        if (!scan.run(inputArray, outputArray, count, kind)) return false;
+        result = outputArray.download();
+        return true;
+    });
+}
+
+template <typename K>
+bool checkRadixSort(ComputeContext& gpu, std::mt19937_64& rng, SortKeyType keyType, const char* name) {
+    constexpr uint32_t count = 1000000;
+    // Few distinct keys, so that stability is checked through the values
+    std::uniform_int_distribution<K> distribution(0, std::numeric_limits<K>::max() / 1000 * 999);
+    std::vector<K> keys(count);
+    std::vector<uint32_t> values(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        keys[i] = distribution(rng) / 1000 * 1000;
+        values[i] = i;
+    }
+
+    using Sorted = std::pair<std::vector<K>, std::vector<uint32_t>>;
+    Sorted expected = { keys, values };
+    std::stable_sort(expected.second.begin(), expected.second.end(), [&](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+    for (uint32_t i = 0; i < count; ++i) expected.first[i] = keys[expected.second[i]];
+
+    return checkAgainst(name, gpu, expected, [&](ComputeContext& context, Sorted& result) {
+        GpuArray<K> keyArray(context, count);
+        GpuArray<uint32_t> valueArray(context, count);
+        keyArray.upload(keys);
+        valueArray.upload(values);
+        RadixSort sort(context, keyType);
+        if (!sort.run(keyArray, &valueArray, count)) return false;
+        result = { keyArray.download(), valueArray.download() };
+        return true;
+    });
+}
+
+template <typename T>
+bool checkReductions(ComputeContext& gpu, std::mt19937& rng, ReduceElement element, const char* name) {
+    // Not a multiple of the tile size, and two levels of partials. Values
+    // are small integers, so that f32 sums are exact in any order.
+    constexpr uint32_t count = 5000001;
+    std::uniform_int_distribution<uint32_t> distribution(0, 3);
+    std::vector<T> input(count);
+    for (T& value : input) value = static_cast<T>(distribution(rng));
+    input[count / 3] = T(7);
+    input[count / 2] = T(7);
+
+    // Value of each operation, and index of the ArgMax (the first largest)
+    using Results = std::vector<std::pair<double, uint32_t>>;
+    auto maxElement = std::max_element(input.begin(), input.end());
+    Results expected = {
+        { std::accumulate(input.begin(), input.end(), 0.0), 0 },
+        { *std::min_element(input.begin(), input.end()), 0 },
+        { *maxElement, 0 },
+        { *maxElement, static_cast<uint32_t>(maxElement - input.begin()) },
+    };
+
+    return checkAgainst(name, gpu, expected, [&](ComputeContext& context, Results& results) {
+        GpuArray<T> array(context, count);
+        array.upload(input);
+        for (ReduceOp op : { ReduceOp::Sum, ReduceOp::Min, ReduceOp::Max, ReduceOp::ArgMax }) {
+            Reduction reduction(context, element, op);
+            ReduceResult result = reduction.reduce(array, count);
+            results.emplace_back(result.value, op == ReduceOp::ArgMax ? result.index : 0);
+        }
+        return true;
+    });
+}
+
+bool checkMatrixMultiply(ComputeContext& gpu, std::mt19937& rng, MatmulPrecision precision, const char* name) {
+    // Not multiples of any tile size
+    constexpr uint32_t m = 197;
+    constexpr uint32_t n = 301;
+    constexpr uint32_t k = 123;
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    std::vector<float> a(m * k), b(k * n);
+    for (float& value : a) value = distribution(rng);
+    for (float& value : b) value = distribution(rng);
+
+    // Naive product, of the inputs as rounded to f16 for the f16 kernels
+    std::vector<float> aUsed = a, bUsed = b;
+    if (precision == MatmulPrecision::F16) {
+        aUsed = MatrixMultiply::unpackHalves(MatrixMultiply::packHalves(a).data(), a.size());
+        bUsed = MatrixMultiply::unpackHalves(MatrixMultiply::packHalves(b).data(), b.size());
+    }
+    std::vector<float> expected(m * n);
+    for (uint32_t row = 0; row < m; ++row) {
+        for (uint32_t col = 0; col < n; ++col) {
+            float sum = 0.0f;
+            for (uint32_t i = 0; i < k; ++i) sum += aUsed[row * k + i] * bUsed[i * n + col];
+            expected[row * n + col] = sum;
+        }
+    }
+
+    return checkAgainst(name, gpu, expected, [&](ComputeContext& context, std::vector<float>& result) {
+        GpuArray<float> cArray(context, m * n);
+        MatrixMultiply matmul(context, precision);
+        if (precision == MatmulPrecision::F32) {
+            GpuArray<float> aArray(context, a.size());
+            GpuArray<float> bArray(context, b.size());
+            aArray.upload(a);
+            bArray.upload(b);
+            matmul.run(aArray, bArray, cArray, m, n, k);
+        }
+        else {
+            std::vector<uint32_t> aHalves = MatrixMultiply::packHalves(a);
+            std::vector<uint32_t> bHalves = MatrixMultiply::packHalves(b);
+            GpuArray<uint32_t> aArray(context, aHalves.size());
+            GpuArray<uint32_t> bArray(context, bHalves.size());
+            aArray.upload(aHalves);
+            bArray.upload(bHalves);
+            matmul.run(aArray, bArray, cArray, m, n, k);
+        }
+        result = cArray.download();
+        return true;
+    }, [](const std::vector<float>& result, const std::vector<float>& expected) {
+        // Same inputs on both sides, only the order of the additions differs
+        return nearlyEqual(result, expected, 1e-3f);
+    });
+}
+
+bool checkStreamCompaction(ComputeContext& gpu, std::mt19937& rng) {
+    constexpr uint32_t count = 1000003;
+    std::vector<uint32_t> input(count);
+    for (uint32_t& value : input) value = rng();
+
+    CompactionDesc desc;
+    desc.predicate = "value % 3u == 0u";
+    desc.cpuPredicate = [](const void* element, uint32_t) { return *static_cast<const uint32_t*>(element) % 3 == 0; };
+
+    // Sorted compacted elements, and their count in the indirect arguments
+    using Compacted = std::pair<std::vector<uint32_t>, uint32_t>;
+    Compacted expected;
+    std::copy_if(input.begin(), input.end(), std::back_inserter(expected.first), [](uint32_t value) { return value % 3 == 0; });
+    std::sort(expected.first.begin(), expected.first.end());
+    expected.second = static_cast<uint32_t>(expected.first.size());
+
+    return checkAgainst("stream compaction", gpu, expected, [&](ComputeContext& context, Compacted& result) {
+        GpuArray<uint32_t> inputArray(context, count);
+        GpuArray<uint32_t> outputArray(context, count);
+        inputArray.upload(input);
+        StreamCompaction compaction(context, desc);
+        if (!compaction.run(inputArray, outputArray, count)) return false;
+        std::vector<uint32_t> args = compaction.args().download();
+        // The draw arguments carry the same count
+        if (args[5] != args[3]) return false;
+        result.second = args[3];
+        result.first = outputArray.download();
+        result.first.resize(result.second);
+        // The GPU does not keep the order
+        std::sort(result.first.begin(), result.first.end());
+        return true;
+    });
+}
+
+// compact -> dispatch arguments -> indirect dispatch, with no readback in
+// between, on the GPU and with the CPU reference executor
+bool checkComputeChain(ComputeContext& gpu, std::mt19937& rng) {
+    constexpr uint32_t count = 300007;
+    std::vector<uint32_t> input(count);
+    for (uint32_t& value : input) value = rng() >> 4;
+
+    CompactionDesc compactionDesc;
+    compactionDesc.predicate = "(value & 3u) == 0u";
+    compactionDesc.cpuPredicate = [](const void* element, uint32_t) { return (*static_cast<const uint32_t*>(element) & 3) == 0; };
+
+    KernelDesc doubleDesc;
+    doubleDesc.label = "Double counted";
+    doubleDesc.source = doubleCountedSource;
+    doubleDesc.bindings = { KernelBinding::ReadOnlyStorage, KernelBinding::Storage };
+    doubleDesc.cpuReference = doubleCountedReference;
+
+    std::vector<uint32_t> expected;
+    for (uint32_t value : input) {
+        if ((value & 3) == 0) expected.push_back(2 * value);
+    }
+    std::sort(expected.begin(), expected.end());
+
+    return checkAgainst("compute chain", gpu, expected, [&](ComputeContext& context, std::vector<uint32_t>& result) {
+        GpuArray<uint32_t> inputArray(context, count);
+        GpuArray<uint32_t> outputArray(context, count);
+        GpuArray<uint32_t> dispatchArgs(context, 3, WGPUBufferUsage_Indirect);
+        inputArray.upload(input);
+        StreamCompaction compaction(context, compactionDesc);
+        Kernel doubleKernel(context, doubleDesc);
+
+        ComputeChain chain(context, "Compute chain check");
+        chain.addStep("Compaction", [&](wgpu::ComputePassEncoder pass) {
+            return compaction.encode(pass, inputArray, outputArray, count);
+        }, [&]() {
+            return compaction.run(inputArray, outputArray, count);
+        });
+        chain.addDispatchArgs(compaction.args(), 3, dispatchArgs, 0, doubleKernel.workgroupSize());
+        chain.addIndirect(doubleKernel, { &compaction.args(), &outputArray }, dispatchArgs, 0);
+        if (!chain.run()) return false;
+
+        result = outputArray.download();
+        result.resize(compaction.readCount());
+        std::sort(result.begin(), result.end());
+        return true;
+    });
+}
+
+bool checkParticles(ComputeContext& gpu) {
+    // dt and lifetimes are multiples of 1/64 s, so particles die on the same
+    // update on both sides and the counts match exactly. The capacity is not
+    // reached: which emitted particles would get the last slots depends on
+    // scheduling on the GPU.
+    ParticleSystem::Options options;
+    options.capacity = 100000;
+    options.emitPerSecond = 64 * 600;
+    constexpr float dt = 1.0f / 64.0f;
+    constexpr int updateCount = 200;
+
+    using Particles = std::vector<ParticleSystem::Particle>;
+    return checkOnBoth<Particles>("particles", gpu, [&](ComputeContext& context, Particles& result) {
+        ParticleSystem particles(context, options);
+        for (int i = 0; i < updateCount; ++i) {
+            if (!particles.update(dt)) return false;
+        }
+        result = particles.readParticles();
+        return true;
+    }, [](const Particles& gpuResult, const Particles& cpuResult) {
+        if (gpuResult.size() != cpuResult.size() || cpuResult.empty()) return false;
+        // Both in draw order, i.e. by decreasing depth
+        for (size_t i = 0; i < gpuResult.size(); ++i) {
+            if (std::abs(gpuResult[i].position[2] - cpuResult[i].position[2]) > 1e-4f) return false;
+        }
+        return true;
+    });
+}
+
+// Sizes that are not multiples of the tiles, shrinking and enlarging
+bool checkImageProcessing(ComputeContext& gpu, std::mt19937& rng) {
+    constexpr uint32_t width = 97;
+    constexpr uint32_t height = 61;
+    constexpr uint32_t layerCount = 3;
+    std::vector<uint8_t> pixels(size_t(width) * height * 4 * layerCount);
+    for (uint8_t& value : pixels) value = static_cast<uint8_t>(rng());
+    const std::vector<float> sharpen = { 0, -1, 0, -1, 5, -1, 0, -1, 0 };
+
+    enum Operation { Blur, Convolution, ShrinkLanczos, EnlargeLanczos, ShrinkBilinear, OperationCount };
+    const char* names[OperationCount] = { "image blur", "image convolution", "image shrink lanczos", "image enlarge lanczos", "image shrink bilinear" };
+    const uint32_t dstSizes[OperationCount][2] = { { width, height }, { width, height }, { 40, 23 }, { 150, 70 }, { 40, 23 } };
+
+    // One check per operation, from the same run
+    using Images = std::array<std::vector<uint8_t>, OperationCount>;
+    int failed = OperationCount;
+    Images results[2];
+    bool ran = runOnBoth(gpu, results, [&](ComputeContext& context, Images& images) {
+        ImageBatch src(context, width, height, layerCount);
+        for (uint32_t layer = 0; layer < layerCount; ++layer) {
+            src.upload(layer, pixels.data() + layer * src.layerByteSize());
+        }
+        ImageProcessor processor(context);
+        for (int op = 0; op < OperationCount; ++op) {
+            ImageBatch dst(context, dstSizes[op][0], dstSizes[op][1], layerCount);
+            bool ok = false;
+            switch (op) {
+            case Blur: ok = processor.blur(src, dst, 2.5f); break;
+            case Convolution: ok = processor.convolve(src, dst, sharpen, 3); break;
+            case ShrinkLanczos: case EnlargeLanczos: ok = processor.resize(src, dst, ResizeFilter::Lanczos3); break;
+            case ShrinkBilinear: ok = processor.resize(src, dst, ResizeFilter::Bilinear); break;
+            }
+            if (!ok) {
+                failed = op;
+                return false;
+            }
+            for (uint32_t layer = 0; layer < layerCount; ++layer) {
+                std::vector<uint8_t> result = dst.download(layer);
+                images[op].insert(images[op].end(), result.begin(), result.end());
+            }
+        }
+        return true;
+    });
+    if (!ran) return report(names[failed], false);
+
+    // The GPU rounds its intermediates to f16
+    bool ok = true;
+    for (int op = 0; op < OperationCount; ++op) {
+        bool match = results[0][op].size() == results[1][op].size();
+        for (size_t i = 0; match && i < results[0][op].size(); ++i) {
+            match = std::abs(int(results[0][op][i]) - int(results[1][op][i])) <= 1;
+        }
+        ok = report(names[op], match) && ok;
+    }
+    return ok;
+}
+
+// Many small saxpy jobs enqueued from several threads, in a few submits
+bool checkComputeBatcher(ComputeContext& gpu, std::mt19937& rng) {
+    constexpr uint32_t count = 1000;
+    constexpr uint32_t jobCount = 512;
+    constexpr uint32_t threadCount = 4;
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    std::vector<float> x(count), y(count * jobCount);
+    for (float& value : x) value = distribution(rng);
+    for (float& value : y) value = distribution(rng);
+
+    ComputeBatcher::Options options;
+    options.maxJobsPerSubmit = 200;
+    SaxpyParams params = { 0.5f, count, {0, 0} };
+    std::vector<float> expected(y.size());
+    for (size_t i = 0; i < y.size(); ++i) expected[i] = params.a * x[i % count] + y[i];
+
+    return checkAgainst("compute batcher", gpu, expected, [&](ComputeContext& context, std::vector<float>& result) {
+        GpuArray<SaxpyParams> paramsArray(context, 1, WGPUBufferUsage_Uniform);
+        GpuArray<float> xArray(context, count);
+        paramsArray.upload(&params, 1);
+        xArray.upload(x);
+        std::vector<std::unique_ptr<GpuArray<float>>> yArrays;
+        for (uint32_t job = 0; job < jobCount; ++job) {
+            yArrays.push_back(std::make_unique<GpuArray<float>>(context, count));
+            yArrays.back()->upload(y.data() + job * count, count);
+        }
+        Kernel kernel(context, saxpyKernelDesc());
+        ComputeBatcher batcher(context, options);
+
+        std::vector<std::future<bool>> futures(jobCount);
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&, t]() {
+                for (uint32_t job = t; job < jobCount; job += threadCount) {
+                    futures[job] = batcher.enqueue(kernel, { &paramsArray, &xArray, yArrays[job].get() }, count);
+                }
+            });
+        }
+        for (std::thread& thread : threads) thread.join();
+        batcher.wait();
+        if (batcher.submitCount() != (jobCount + options.maxJobsPerSubmit - 1) / options.maxJobsPerSubmit) return false;
+        for (std::future<bool>& future : futures) {
+            if (!future.get()) return false;
+        }
+        for (auto& yArray : yArrays) {
+            std::vector<float> yResult = yArray->download();
+            result.insert(result.end(), yResult.begin(), yResult.end());
+        }
+        return true;
+    }, [](const std::vector<float>& result, const std::vector<float>& expected) {
+        return nearlyEqual(result, expected, 1e-5f);
+    });
+}
+
+} // namespace
+
+KernelDesc saxpyKernelDesc() {
+    KernelDesc desc;
+    desc.label = "saxpy";
+    desc.source = saxpySource;
+    desc.bindings = { KernelBinding::Uniform, KernelBinding::ReadOnlyStorage, KernelBinding::Storage };
+    desc.cpuReference = saxpyReference;
+    return desc;
+}
+
+bool checkComputeKernels(ComputeContext& gpu) {
+    std::mt19937 rng(42);
+    bool ok = true;
+    ok = checkSaxpy(gpu, rng) && ok;
+    ok = checkPrefixScan<uint32_t>(gpu, rng, ScanElement::U32, ScanKind::Exclusive, "exclusive scan u32") && ok;
+    ok = checkPrefixScan<uint32_t>(gpu, rng, ScanElement::U32, ScanKind::Inclusive, "inclusive scan u32") && ok;
+    ok = checkPrefixScan<float>(gpu, rng, ScanElement::F32, ScanKind::Exclusive, "exclusive scan f32") && ok;
+    ok = checkPrefixScan<float>(gpu, rng, ScanElement::F32, ScanKind::Inclusive, "inclusive scan f32") && ok;
+    std::mt19937_64 rng64(42);
+    ok = checkRadixSort<uint32_t>(gpu, rng64, SortKeyType::U32, "radix sort u32") && ok;
+    ok = checkRadixSort<uint64_t>(gpu, rng64, SortKeyType::U64, "radix sort u64") && ok;
+    ok = checkReductions<uint32_t>(gpu, rng, ReduceElement::U32, "reductions u32") && ok;
+    ok = checkReductions<float>(gpu, rng, ReduceElement::F32, "reductions f32") && ok;
+    ok = checkMatrixMultiply(gpu, rng, MatmulPrecision::F32, "matrix multiply f32") && ok;
+    ok = checkMatrixMultiply(gpu, rng, MatmulPrecision::F16, "matrix multiply f16") && ok;
+    ok = checkStreamCompaction(gpu, rng) && ok;
+    ok = checkComputeChain(gpu, rng) && ok;
+    ok = checkParticles(gpu) && ok;
+    ok = checkImageProcessing(gpu, rng) && ok;
+    ok = checkComputeBatcher(gpu, rng) && ok;
+    return ok;
+}
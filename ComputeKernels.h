@@ -0,0 +1,30 @@
+#pragma once
+
+#include "ComputeRuntime.h"
+
+#include <cstdint>
+
+/**
+ * Kernels built on the compute runtime, each with its WGSL source and CPU
+ * reference.
+ */
+
+struct SaxpyParams {
+    float a;
+    uint32_t count;
+    uint32_t _pad[2];
+};
+
+/**
+ * y = a * x + y
+ * Arguments: params (GpuArray<SaxpyParams>, uniform), x (GpuArray<float>),
+ * y (GpuArray<float>).
+ */
+KernelDesc saxpyKernelDesc();
+
+/**
+ * Run every kernel on the GPU context and on the CPU with the same random
+ * inputs, and compare the results. Prints one line per kernel and returns
+ * false if any of them differs.
+ */
+bool checkComputeKernels(ComputeContext& gpu);
@@ -0,0 +1,371 @@
+#include "ComputeRuntime.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <iostream>
+
+namespace {
+
+// GpuArrayBase::id()
+std::atomic<uint64_t> nextArrayId{ 1 };
+
+uint64_t alignTo(uint64_t size, uint64_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+// ComputeContext
+
+ComputeContext::ComputeContext()
+    : m_device(nullptr)
+    , m_queue(nullptr)
+{}
+
+ComputeContext::ComputeContext(wgpu::Device device, wgpu::Queue queue)
+    : m_device(device)
+    , m_queue(queue)
+{
+    wgpu::SupportedLimits supportedLimits;
+    if (device.getLimits(&supportedLimits)) {
+        m_maxWorkgroupsPerDimension = supportedLimits.limits.maxComputeWorkgroupsPerDimension;
+        m_maxStorageBufferBindingSize = supportedLimits.limits.maxStorageBufferBindingSize;
+        m_maxComputeInvocationsPerWorkgroup = supportedLimits.limits.maxComputeInvocationsPerWorkgroup;
+        m_maxComputeWorkgroupStorageSize = supportedLimits.limits.maxComputeWorkgroupStorageSize;
+    }
+}
+
+ComputeContext::~ComputeContext() {
+    wait();
+}
+
+wgpu::CommandEncoder ComputeContext::createEncoder(const char* label) {
+    wgpu::CommandEncoderDescriptor commandEncoderDesc = {};
+    commandEncoderDesc.label = label;
+    return m_device.createCommandEncoder(commandEncoderDesc);
+}
+
+void ComputeContext::submit(wgpu::CommandEncoder encoder) {
+    wgpu::CommandBufferDescriptor cmdBufferDescriptor = {};
+    cmdBufferDescriptor.label = "Compute command buffer";
+    wgpu::CommandBuffer command = encoder.finish(cmdBufferDescriptor);
+    encoder.release();
+    m_queue.submit(1, &command);
+    command.release();
+}
+
+void ComputeContext::wait() {
+    if (!hasGpu()) return;
+    while (!wgpuDevicePoll(m_device, true, nullptr)) {}
+    // Map callbacks run from the poll that follows the end of the copy
+    while (!m_readbacks.empty()) {
+        wgpuDevicePoll(m_device, true, nullptr);
+        releaseDoneReadbacks();
+    }
+}
+
+void ComputeContext::poll() {
+    if (!hasGpu()) return;
+    wgpuDevicePoll(m_device, false, nullptr);
+    releaseDoneReadbacks();
+}
+
+void ComputeContext::readAsync(wgpu::Buffer buffer, uint64_t offset, uint64_t size, ReadbackCallback callback) {
+    assert(hasGpu());
+    auto readback = std::make_unique<Readback>();
+    readback->size = size;
+    readback->callback = std::move(callback);
+
+    wgpu::BufferDescriptor bufferDesc;
+    bufferDesc.label = "Readback";
+    bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::MapRead;
+    bufferDesc.size = alignTo(size, 4);
+    bufferDesc.mappedAtCreation = false;
+    readback->staging = m_device.createBuffer(bufferDesc);
+
+    wgpu::CommandEncoder encoder = createEncoder("Readback");
+    encoder.copyBufferToBuffer(buffer, offset, readback->staging, 0, bufferDesc.size);
+    submit(encoder);
+
+    Readback* pending = readback.get();
+    readback->mapCallback = pending->staging.mapAsync(wgpu::MapMode::Read, 0, bufferDesc.size, [pending](wgpu::BufferMapAsyncStatus status) {
+        if (status == wgpu::BufferMapAsyncStatus::Success) {
+            pending->callback(pending->staging.getConstMappedRange(0, pending->size));
+            pending->staging.unmap();
+        }
+        else {
+            std::cerr << "Could not map readback buffer: status " << status << std::endl;
+            pending->callback(nullptr);
+        }
+        pending->done = true;
+    });
+    m_readbacks.push_back(std::move(readback));
+}
+
+void ComputeContext::releaseDoneReadbacks() {
+    // Not from the map callback itself, which is owned by the readback
+    auto done = std::partition(m_readbacks.begin(), m_readbacks.end(),
+        [](const std::unique_ptr<Readback>& readback) { return !readback->done; });
+    for (auto it = done; it != m_readbacks.end(); ++it) {
+        (*it)->staging.destroy();
+        (*it)->staging.release();
+    }
+    m_readbacks.erase(done, m_readbacks.end());
+}
+
+// GpuArrayBase
+
+GpuArrayBase::GpuArrayBase(ComputeContext& context, size_t size, size_t elementSize, WGPUBufferUsageFlags extraUsage)
+    : m_context(context)
+    , m_id(nextArrayId++)
+    , m_size(size)
+    , m_elementSize(elementSize)
+{
+    if (!context.hasGpu()) {
+        m_host.resize(size * elementSize);
+        return;
+    }
+
+    wgpu::BufferDescriptor bufferDesc;
+    bufferDesc.label = "GpuArray";
+    bufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc | wgpu::BufferUsage::CopyDst | extraUsage;
+    // Also makes small arrays usable as uniforms
+    bufferDesc.size = alignTo(std::max<uint64_t>(size * elementSize, 16), 16);
+    bufferDesc.mappedAtCreation = false;
+    m_buffer = context.device().createBuffer(bufferDesc);
+}
+
+GpuArrayBase::~GpuArrayBase() {
+    if (m_buffer) {
+        m_buffer.destroy();
+        m_buffer.release();
+    }
+}
+
+void GpuArrayBase::uploadBytes(const void* data, size_t byteOffset, size_t byteCount) {
+    assert(byteOffset + byteCount <= byteSize());
+    if (!m_context.hasGpu()) {
+        std::memcpy(m_host.data() + byteOffset, data, byteCount);
+        return;
+    }
+    m_context.queue().writeBuffer(m_buffer, byteOffset, data, byteCount);
+}
+
+void GpuArrayBase::downloadBytes(void* data, size_t byteOffset, size_t byteCount) const {
+    assert(byteOffset + byteCount <= byteSize());
+    if (!m_context.hasGpu()) {
+        std::memcpy(data, m_host.data() + byteOffset, byteCount);
+        return;
+    }
+
+    wgpu::Device device = m_context.device();
+    wgpu::BufferDescriptor bufferDesc;
+    bufferDesc.label = "GpuArray readback";
+    bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::MapRead;
+    bufferDesc.size = alignTo(byteCount, 4);
+    bufferDesc.mappedAtCreation = false;
+    wgpu::Buffer staging = device.createBuffer(bufferDesc);
+
+    wgpu::CommandEncoder encoder = m_context.createEncoder("GpuArray readback");
+    encoder.copyBufferToBuffer(m_buffer, byteOffset, staging, 0, bufferDesc.size);
+    m_context.submit(encoder);
+
+    struct MapState {
+        bool done = false;
+        WGPUBufferMapAsyncStatus status = WGPUBufferMapAsyncStatus_Unknown;
+    };
+    MapState state;
+    auto onMapped = [](WGPUBufferMapAsyncStatus status, void* pUserData) {
+        MapState& state = *reinterpret_cast<MapState*>(pUserData);
+        state.status = status;
+        state.done = true;
+    };
+    wgpuBufferMapAsync(staging, wgpu::MapMode::Read, 0, bufferDesc.size, onMapped, (void*)&state);
+    while (!state.done) {
+        wgpuDevicePoll(device, true, nullptr);
+    }
+
+    if (state.status == WGPUBufferMapAsyncStatus_Success) {
+        std::memcpy(data, staging.getConstMappedRange(0, bufferDesc.size), byteCount);
+        staging.unmap();
+    }
+    else {
+        std::cerr << "Could not map GpuArray readback buffer: status " << state.status << std::endl;
+    }
+    staging.destroy();
+    staging.release();
+}
+
+// Kernel
+
+Kernel::Kernel(ComputeContext& context, const KernelDesc& desc)
+    : m_context(context)
+    , m_desc(desc)
+{
+    if (!context.hasGpu()) return;
+    wgpu::Device device = context.device();
+
+    wgpu::ShaderModuleWGSLDescriptor shaderCodeDesc;
+    shaderCodeDesc.chain.next = nullptr;
+    shaderCodeDesc.chain.sType = wgpu::SType::ShaderModuleWGSLDescriptor;
+    shaderCodeDesc.code = m_desc.source.c_str();
+    wgpu::ShaderModuleDescriptor shaderDesc;
+    shaderDesc.nextInChain = &shaderCodeDesc.chain;
+    shaderDesc.label = m_desc.label.c_str();
+    shaderDesc.hintCount = 0;
+    shaderDesc.hints = nullptr;
+    m_shaderModule = device.createShaderModule(shaderDesc);
+
+    std::vector<wgpu::BindGroupLayoutEntry> bindingLayouts(m_desc.bindings.size(), wgpu::Default);
+    for (uint32_t i = 0; i < bindingLayouts.size(); ++i) {
+        bindingLayouts[i].binding = i;
+        bindingLayouts[i].visibility = wgpu::ShaderStage::Compute;
+        switch (m_desc.bindings[i]) {
+        case KernelBinding::ReadOnlyStorage:
+            bindingLayouts[i].buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+            break;
+        case KernelBinding::Storage:
+            bindingLayouts[i].buffer.type = wgpu::BufferBindingType::Storage;
+            break;
+        case KernelBinding::Uniform:
+            bindingLayouts[i].buffer.type = wgpu::BufferBindingType::Uniform;
+            break;
+        }
+    }
+    wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc;
+    bindGroupLayoutDesc.label = m_desc.label.c_str();
+    bindGroupLayoutDesc.entryCount = static_cast<uint32_t>(bindingLayouts.size());
+    bindGroupLayoutDesc.entries = bindingLayouts.data();
+    m_bindGroupLayout = device.createBindGroupLayout(bindGroupLayoutDesc);
+
+    wgpu::PipelineLayoutDescriptor pipelineLayoutDesc;
+    pipelineLayoutDesc.label = m_desc.label.c_str();
+    pipelineLayoutDesc.bindGroupLayoutCount = 1;
+    pipelineLayoutDesc.bindGroupLayouts = reinterpret_cast<WGPUBindGroupLayout*>(&m_bindGroupLayout);
+    m_pipelineLayout = device.createPipelineLayout(pipelineLayoutDesc);
+
+    std::vector<wgpu::ConstantEntry> constants;
+    wgpu::ConstantEntry workgroupSizeConstant;
+    workgroupSizeConstant.key = "workgroupSize";
+    workgroupSizeConstant.value = m_desc.workgroupSize;
+    constants.push_back(workgroupSizeConstant);
+    for (const auto& constant : m_desc.constants) {
+        wgpu::ConstantEntry entry;
+        entry.key = constant.first.c_str();
+        entry.value = constant.second;
+        constants.push_back(entry);
+    }
+
+    wgpu::ComputePipelineDescriptor pipelineDesc;
+    pipelineDesc.label = m_desc.label.c_str();
+    pipelineDesc.layout = m_pipelineLayout;
+    pipelineDesc.compute.module = m_shaderModule;
+    pipelineDesc.compute.entryPoint = m_desc.entryPoint.c_str();
+    pipelineDesc.compute.constantCount = static_cast<uint32_t>(constants.size());
+    pipelineDesc.compute.constants = constants.data();
+    m_pipeline = device.createComputePipeline(pipelineDesc);
+}
+
+Kernel::~Kernel() {
+    if (!m_context.hasGpu()) return;
+    if (m_bindGroup) m_bindGroup.release();
+    m_pipeline.release();
+    m_pipelineLayout.release();
+    m_bindGroupLayout.release();
+    m_shaderModule.release();
+}
+
+std::pair<uint32_t, uint32_t> Kernel::workgroupCount(uint32_t invocationCount) const {
+    uint32_t groups = (invocationCount + m_desc.workgroupSize - 1) / m_desc.workgroupSize;
+    uint32_t maxGroups = m_context.maxWorkgroupsPerDimension();
+    if (groups <= maxGroups) return { std::max(groups, 1u), 1 };
+    return { maxGroups, (groups + maxGroups - 1) / maxGroups };
+}
+
+wgpu::BindGroup Kernel::createBindGroup(const KernelArgs& args) const {
+    assert(args.size() == m_desc.bindings.size());
+    std::vector<wgpu::BindGroupEntry> bindings(args.size(), wgpu::Default);
+    for (uint32_t i = 0; i < args.size(); ++i) {
+        bindings[i].binding = i;
+        bindings[i].buffer = args[i]->buffer();
+        bindings[i].offset = 0;
+        bindings[i].size = args[i]->buffer().getSize();
+    }
+    wgpu::BindGroupDescriptor bindGroupDesc;
+    bindGroupDesc.label = m_desc.label.c_str();
+    bindGroupDesc.layout = m_bindGroupLayout;
+    bindGroupDesc.entryCount = static_cast<uint32_t>(bindings.size());
+    bindGroupDesc.entries = bindings.data();
+    return m_context.device().createBindGroup(bindGroupDesc);
+}
+
+void Kernel::bind(wgpu::ComputePassEncoder pass, const KernelArgs& args) {
+    bool changed = m_boundArrays.size() != args.size() || !m_bindGroup;
+    for (size_t i = 0; i < args.size() && !changed; ++i) {
+        changed = m_boundArrays[i] != args[i]->id();
+    }
+
+    if (changed) {
+        if (m_bindGroup) m_bindGroup.release();
+        m_bindGroup = createBindGroup(args);
+        m_boundArrays.resize(args.size());
+        for (size_t i = 0; i < args.size(); ++i) {
+            m_boundArrays[i] = args[i]->id();
+        }
+    }
+
+    pass.setPipeline(m_pipeline);
+    pass.setBindGroup(0, m_bindGroup, 0, nullptr);
+}
+
+void Kernel::dispatch(wgpu::ComputePassEncoder pass, const KernelArgs& args, uint32_t invocationCount) {
+    assert(m_context.hasGpu());
+    bind(pass, args);
+    auto groups = workgroupCount(invocationCount);
+    pass.dispatchWorkgroups(groups.first, groups.second, 1);
+}
+
+void Kernel::dispatch(wgpu::ComputePassEncoder pass, wgpu::BindGroup bindGroup, uint32_t invocationCount) {
+    assert(m_context.hasGpu());
+    pass.setPipeline(m_pipeline);
+    pass.setBindGroup(0, bindGroup, 0, nullptr);
+    auto groups = workgroupCount(invocationCount);
+    pass.dispatchWorkgroups(groups.first, groups.second, 1);
+}
+
+void Kernel::dispatchIndirect(wgpu::ComputePassEncoder pass, const KernelArgs& args, wgpu::Buffer indirectBuffer, uint64_t offset) {
+    assert(m_context.hasGpu());
+    bind(pass, args);
+    pass.dispatchWorkgroupsIndirect(indirectBuffer, offset);
+}
+
+void Kernel::dispatchIndirect(wgpu::ComputePassEncoder pass, wgpu::BindGroup bindGroup, wgpu::Buffer indirectBuffer, uint64_t offset) {
+    assert(m_context.hasGpu());
+    pass.setPipeline(m_pipeline);
+    pass.setBindGroup(0, bindGroup, 0, nullptr);
+    pass.dispatchWorkgroupsIndirect(indirectBuffer, offset);
+}
+
+void Kernel::run(const KernelArgs& args, uint32_t invocationCount) {
+    if (!m_context.hasGpu()) {
+        runReference(args, invocationCount);
+        return;
+    }
+
+    wgpu::CommandEncoder encoder = m_context.createEncoder(m_desc.label.c_str());
+    wgpu::ComputePassDescriptor computePassDesc;
+    computePassDesc.label = m_desc.label.c_str();
+    computePassDesc.timestampWriteCount = 0;
+    computePassDesc.timestampWrites = nullptr;
+    wgpu::ComputePassEncoder pass = encoder.beginComputePass(computePassDesc);
+    dispatch(pass, args, invocationCount);
+    pass.end();
+    pass.release();
+    m_context.submit(encoder);
+}
+
+void Kernel::runReference(const KernelArgs& args, uint32_t invocationCount) const {
+    assert(m_desc.cpuReference);
+    m_desc.cpuReference(args, invocationCount);
+}
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <webgpu/webgpu.hpp>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Small runtime to run data-parallel work with compute shaders.
+ *
+ *  - ComputeContext: the device and queue, or nothing at all. Without a
+ *    device, kernels run their CPU reference implementation instead, so the
+ *    same code (and its results) can be checked on machines without a GPU.
+ *  - GpuArray<T>: a typed storage buffer (or plain host memory in CPU mode).
+ *  - Kernel: a compute pipeline and its bind group layout, plus the CPU
+ *    reference of the same computation.
+ *
+ * Kernel sources must declare `override workgroupSize: u32;` and use it in
+ * @workgroup_size, and compute their linear index as
+ *     id.x + id.y * groups.x * workgroupSize
+ * (id = global_invocation_id, groups = num_workgroups) because large
+ * dispatches are split over two dimensions.
+ */
+class ComputeContext {
+public:
+    /**
+     * CPU only context.
+     */
+    ComputeContext();
+    ComputeContext(wgpu::Device device, wgpu::Queue queue);
+    /**
+     * Waits for pending readbacks.
+     */
+    ~ComputeContext();
+    ComputeContext(const ComputeContext&) = delete;
+    ComputeContext& operator=(const ComputeContext&) = delete;
+
+    bool hasGpu() const { return m_device != nullptr; }
+    wgpu::Device device() const { return m_device; }
+    wgpu::Queue queue() const { return m_queue; }
+    uint32_t maxWorkgroupsPerDimension() const { return m_maxWorkgroupsPerDimension; }
+    // Largest array a kernel can bind, in bytes
+    uint64_t maxStorageBufferBindingSize() const { return m_maxStorageBufferBindingSize; }
+    uint32_t maxComputeInvocationsPerWorkgroup() const { return m_maxComputeInvocationsPerWorkgroup; }
+    uint32_t maxComputeWorkgroupStorageSize() const { return m_maxComputeWorkgroupStorageSize; }
+
+    wgpu::CommandEncoder createEncoder(const char* label);
+    /**
+     * Finish, submit and release the encoder.
+     */
+    void submit(wgpu::CommandEncoder encoder);
+    /**
+     * Block until all submitted work is done, and all readbacks called back.
+     */
+    void wait();
+    /**
+     * Call back the readbacks that are done, without blocking.
+     */
+    void poll();
+
+    using ReadbackCallback = std::function<void(const void* data)>;
+    /**
+     * Copy size bytes of the buffer (which needs CopySrc usage) once the
+     * work submitted so far is done, and call back with them (or nullptr if
+     * mapping failed) from a later poll() or wait(). In CPU mode there is
+     * nothing to read back from.
+     */
+    void readAsync(wgpu::Buffer buffer, uint64_t offset, uint64_t size, ReadbackCallback callback);
+    size_t pendingReadbackCount() const { return m_readbacks.size(); }
+
+private:
+    struct Readback {
+        wgpu::Buffer staging = nullptr;
+        uint64_t size = 0;
+        ReadbackCallback callback;
+        std::unique_ptr<wgpu::BufferMapCallback> mapCallback;
+        bool done = false;
+    };
+
+    void releaseDoneReadbacks();
+
+private:
+    wgpu::Device m_device;
+    wgpu::Queue m_queue;
+    uint32_t m_maxWorkgroupsPerDimension = 65535;
+    uint64_t m_maxStorageBufferBindingSize = UINT64_MAX;
+    uint32_t m_maxComputeInvocationsPerWorkgroup = 256;
+    uint32_t m_maxComputeWorkgroupStorageSize = 16384;
+    std::vector<std::unique_ptr<Readback>> m_readbacks;
+};
+
+/**
+ * Untyped part of GpuArray, which is what kernels bind.
+ */
+class GpuArrayBase {
+public:
+    GpuArrayBase(const GpuArrayBase&) = delete;
+    GpuArrayBase& operator=(const GpuArrayBase&) = delete;
+    virtual ~GpuArrayBase();
+
+    size_t size() const { return m_size; }
+    size_t byteSize() const { return m_size * m_elementSize; }
+    ComputeContext& context() const { return m_context; }
+
+    /**
+     * Unique for the process, unlike the buffer handle whose address a new
+     * array may get once this one is destroyed: what caches of bind groups
+     * compare.
+     */
+    uint64_t id() const { return m_id; }
+
+    /**
+     * GPU mode only. Storage | CopySrc | CopyDst usage, plus extra usages
+     * given at creation.
+     */
+    wgpu::Buffer buffer() const { return m_buffer; }
+
+    /**
+     * CPU mode only.
+     */
+    void* hostData() { return m_host.data(); }
+    const void* hostData() const { return m_host.data(); }
+
+protected:
+    GpuArrayBase(ComputeContext& context, size_t size, size_t elementSize, WGPUBufferUsageFlags extraUsage);
+
+    void uploadBytes(const void* data, size_t byteOffset, size_t byteCount);
+    void downloadBytes(void* data, size_t byteOffset, size_t byteCount) const;
+
+private:
+    ComputeContext& m_context;
+    uint64_t m_id;
+    size_t m_size;
+    size_t m_elementSize;
+    wgpu::Buffer m_buffer = nullptr;
+    std::vector<uint8_t> m_host;
+};
+
+template <typename T>
+class GpuArray : public GpuArrayBase {
+public:
+    static_assert(std::is_trivially_copyable<T>::value, "GpuArray elements are copied bytewise");
+    static_assert(sizeof(T) % 4 == 0, "WebGPU buffer copies work on multiples of 4 bytes");
+
+    GpuArray(ComputeContext& context, size_t size, WGPUBufferUsageFlags extraUsage = WGPUBufferUsage_None)
+        : GpuArrayBase(context, size, sizeof(T), extraUsage)
+    {}
+
+    void upload(const T* data, size_t count, size_t offset = 0) {
+        uploadBytes(data, offset * sizeof(T), count * sizeof(T));
+    }
+    void upload(const std::vector<T>& data) { upload(data.data(), data.size()); }
+
+    /**
+     * Blocking read back. In GPU mode this waits for all submitted work.
+     */
+    std::vector<T> download() const {
+        std::vector<T> result(size());
+        downloadBytes(result.data(), 0, byteSize());
+        return result;
+    }
+
+    // CPU mode only
+    T* host() { return reinterpret_cast<T*>(hostData()); }
+    const T* host() const { return reinterpret_cast<const T*>(hostData()); }
+};
+
+enum class KernelBinding {
+    ReadOnlyStorage,
+    Storage,
+    Uniform,
+};
+
+using KernelArgs = std::vector<GpuArrayBase*>;
+
+/**
+ * CPU version of a kernel: must produce the same results as the shader for
+ * the given arguments (in host memory) and invocation count.
+ */
+using CpuKernel = std::function<void(const KernelArgs& args, uint32_t invocationCount)>;
+
+struct KernelDesc {
+    std::string label;
+    std::string source;
+    std::string entryPoint = "main";
+    uint32_t workgroupSize = 64;
+    // One entry per @binding of @group(0), in binding order
+    std::vector<KernelBinding> bindings;
+    // Extra pipeline-overridable constants
+    std::vector<std::pair<std::string, double>> constants;
+    CpuKernel cpuReference;
+};
+
+class Kernel {
+public:
+    Kernel(ComputeContext& context, const KernelDesc& desc);
+    ~Kernel();
+    Kernel(const Kernel&) = delete;
+    Kernel& operator=(const Kernel&) = delete;
+
+    /**
+     * Record a dispatch of at least invocationCount invocations (GPU mode).
+     */
+    void dispatch(wgpu::ComputePassEncoder pass, const KernelArgs& args, uint32_t invocationCount);
+    /**
+     * Same with a bind group from createBindGroup(), for callers that
+     * dispatch the same kernel on several sets of arguments.
+     */
+    void dispatch(wgpu::ComputePassEncoder pass, wgpu::BindGroup bindGroup, uint32_t invocationCount);
+
+    /**
+     * Dispatch with workgroup counts read by the GPU from indirectBuffer
+     * (three u32 at offset, a multiple of 4), e.g. written by a previous
+     * kernel. The buffer needs the Indirect usage.
+     */
+    void dispatchIndirect(wgpu::ComputePassEncoder pass, const KernelArgs& args, wgpu::Buffer indirectBuffer, uint64_t offset);
+    void dispatchIndirect(wgpu::ComputePassEncoder pass, wgpu::BindGroup bindGroup, wgpu::Buffer indirectBuffer, uint64_t offset);
+
+    /**
+     * Run on its own: encode, dispatch and submit in GPU mode, or call the
+     * CPU reference. Does not wait for the GPU.
+     */
+    void run(const KernelArgs& args, uint32_t invocationCount);
+
+    /**
+     * Always run the CPU reference, whatever the context (args must then be
+     * CPU mode arrays).
+     */
+    void runReference(const KernelArgs& args, uint32_t invocationCount) const;
+
+    uint32_t workgroupSize() const { return m_desc.workgroupSize; }
+    const std::string& label() const { return m_desc.label; }
+
+    /**
+     * Workgroup counts (x, y) covering invocationCount invocations.
+     */
+    std::pair<uint32_t, uint32_t> workgroupCount(uint32_t invocationCount) const;
+
+    /**
+     * Bind the arguments at @group(0), reusing the previous bind group when
+     * they did not change.
+     */
+    void bind(wgpu::ComputePassEncoder pass, const KernelArgs& args);
+
+    /**
+     * Bind group for the arguments, owned by the caller.
+     */
+    wgpu::BindGroup createBindGroup(const KernelArgs& args) const;
+
+private:
+    ComputeContext& m_context;
+    KernelDesc m_desc;
+    wgpu::ShaderModule m_shaderModule = nullptr;
+    wgpu::BindGroupLayout m_bindGroupLayout = nullptr;
+    wgpu::PipelineLayout m_pipelineLayout = nullptr;
+    wgpu::ComputePipeline m_pipeline = nullptr;
+
+    // GpuArrayBase::id() of the arguments of m_bindGroup
+    std::vector<uint64_t> m_boundArrays;
+    wgpu::BindGroup m_bindGroup = nullptr;
+};
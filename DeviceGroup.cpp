@@ -0,0 +1,115 @@
+#include "DeviceGroup.h"
+
+#include "DeviceProfile.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <thread>
+
+namespace {
+
+void onDeviceError(WGPUErrorType type, char const* message, void* userdata) {
+    const char* name = static_cast<const char*>(userdata);
+    Log::writef(LogLevel::Error, "device", "Uncaptured device error on %s: type %d (%s)", name, static_cast<int>(type), message ? message : "");
+}
+
+} // namespace
+
+DeviceGroup::~DeviceGroup() {
+    release();
+}
+
+size_t DeviceGroup::open(const std::vector<AdapterInfo>& adapters) {
+    assert(m_members.empty());
+    for (const AdapterInfo& info : adapters) {
+        m_members.push_back(std::make_unique<Member>());
+        m_members.back()->info = info;
+        m_members.back()->info.adapter = nullptr;
+    }
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < adapters.size(); ++i) {
+        threads.emplace_back([&member = *m_members[i], adapter = adapters[i].adapter]() mutable {
+            // Everything the adapter allows, as for the benchmark device
+            wgpu::RequiredLimits requiredLimits = DeviceProfile::probe(adapter).requiredLimits();
+            wgpu::DeviceDescriptor deviceDesc = {};
+            deviceDesc.label = "Device group member";
+            deviceDesc.requiredFeaturesCount = 0;
+            deviceDesc.requiredLimits = &requiredLimits;
+            deviceDesc.defaultQueue.nextInChain = nullptr;
+            deviceDesc.defaultQueue.label = "Device group queue";
+            member.device = adapter.requestDevice(deviceDesc);
+            if (!member.device) return;
+            wgpuDeviceSetUncapturedErrorCallback(member.device, onDeviceError, const_cast<char*>(member.info.name.c_str()));
+            member.queue = member.device.getQueue();
+            member.context = std::make_unique<ComputeContext>(member.device, member.queue);
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    m_members.erase(std::remove_if(m_members.begin(), m_members.end(), [](const std::unique_ptr<Member>& member) {
+        if (member->device) return false;
+        Log::writef(LogLevel::Warn, "app", "Could not open a device on %s, leaving it out of the group", member->info.name.c_str());
+        return true;
+    }), m_members.end());
+    return m_members.size();
+}
+
+void DeviceGroup::release() {
+    for (auto& member : m_members) {
+        // Waits for its readbacks
+        member->context.reset();
+        member->queue.release();
+        member->device.release();
+    }
+    m_members.clear();
+}
+
+double DeviceGroup::share(size_t device) const {
+    double total = 0.0;
+    for (const auto& member : m_members) {
+        // Until every device was measured, all get the same
+        if (member->weight <= 0.0) return 1.0 / m_members.size();
+        total += member->weight;
+    }
+    return m_members[device]->weight / total;
+}
+
+void DeviceGroup::split(size_t count, size_t granularity, const Work& work) {
+    using Clock = std::chrono::steady_clock;
+    assert(granularity > 0);
+    if (m_members.empty() || count == 0) return;
+
+    const size_t units = (count + granularity - 1) / granularity;
+    std::vector<size_t> bounds(m_members.size() + 1, 0);
+    double cumulativeShare = 0.0;
+    for (size_t i = 0; i < m_members.size(); ++i) {
+        cumulativeShare += share(i);
+        size_t unit = i + 1 == m_members.size() ? units : static_cast<size_t>(cumulativeShare * units + 0.5);
+        bounds[i + 1] = std::max(bounds[i], std::min(unit * granularity, count));
+    }
+
+    std::vector<double> elapsedMs(m_members.size(), 0.0);
+    auto runSlice = [&](size_t i) {
+        auto start = Clock::now();
+        work(i, *m_members[i]->context, bounds[i], bounds[i + 1]);
+        elapsedMs[i] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < m_members.size(); ++i) {
+        if (bounds[i + 1] > bounds[i]) threads.emplace_back(runSlice, i);
+    }
+    if (bounds[1] > bounds[0]) runSlice(0);
+    for (std::thread& thread : threads) thread.join();
+
+    for (size_t i = 0; i < m_members.size(); ++i) {
+        size_t items = bounds[i + 1] - bounds[i];
+        if (items == 0) continue;
+        Member& member = *m_members[i];
+        member.itemsPerMs = items / std::max(elapsedMs[i], 1e-3);
+        // Smoothed, so that one slow call (a pipeline compiled on first
+        // use) does not starve the device for the next ones
+        member.weight = member.weight <= 0.0 ? member.itemsPerMs : 0.5 * member.weight + 0.5 * member.itemsPerMs;
+    }
+}
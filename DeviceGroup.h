@@ -0,0 +1,76 @@
+#pragma once
+
+#include "AdapterSelection.h"
+#include "ComputeRuntime.h"
+
+#include <webgpu/webgpu.hpp>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * One device and ComputeContext per adapter, to split a batch of
+ * independent items across several GPUs.
+ *
+ * split() hands each device a contiguous slice sized after the throughput
+ * it showed in the previous calls (equal slices at first), and runs the
+ * slices on one thread per device so that the devices overlap. Each
+ * ComputeContext is only ever used by one thread at a time.
+ */
+class DeviceGroup {
+public:
+    DeviceGroup() = default;
+    ~DeviceGroup();
+    DeviceGroup(const DeviceGroup&) = delete;
+    DeviceGroup& operator=(const DeviceGroup&) = delete;
+
+    /**
+     * Open a device on each adapter, all at the same time. Adapters whose
+     * device request fails are left out; returns how many are in the group.
+     */
+    size_t open(const std::vector<AdapterInfo>& adapters);
+    void release();
+
+    size_t size() const { return m_members.size(); }
+    ComputeContext& context(size_t device) { return *m_members[device]->context; }
+    // The adapter handle is not kept
+    const AdapterInfo& info(size_t device) const { return m_members[device]->info; }
+
+    /**
+     * Fraction of the items the device gets in the next split().
+     */
+    double share(size_t device) const;
+
+    /**
+     * Items per ms measured in the last split() the device took part in,
+     * 0 before that.
+     */
+    double throughput(size_t device) const { return m_members[device]->itemsPerMs; }
+
+    using Work = std::function<void(size_t device, ComputeContext& context, size_t begin, size_t end)>;
+
+    /**
+     * Call work for each device with a non-empty slice of [0, count), each
+     * on its own thread, and wait for all of them. Slice bounds are
+     * multiples of granularity (but for the end of the last one). work must
+     * wait for its GPU results before it returns, for the timings to mean
+     * anything.
+     */
+    void split(size_t count, size_t granularity, const Work& work);
+
+private:
+    struct Member {
+        AdapterInfo info;
+        wgpu::Device device = nullptr;
+        wgpu::Queue queue = nullptr;
+        std::unique_ptr<ComputeContext> context;
+        // Smoothed items per ms
+        double weight = 0.0;
+        double itemsPerMs = 0.0;
+    };
+
+private:
+    // Not moved once opened: the error callbacks point to them
+    std::vector<std::unique_ptr<Member>> m_members;
+};
@@ -0,0 +1,203 @@
+#include "DeviceProfile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+struct LimitField {
+    const char* name;
+    size_t offset;
+    bool is64;
+};
+
+#define LIMIT_FIELD(name, type) { #name, offsetof(WGPULimits, name), sizeof(type) == 8 }
+
+// Every field of WGPULimits, by name so that the cache survives a reordering
+const LimitField limitFields[] = {
+    LIMIT_FIELD(maxTextureDimension1D, uint32_t),
+    LIMIT_FIELD(maxTextureDimension2D, uint32_t),
+    LIMIT_FIELD(maxTextureDimension3D, uint32_t),
+    LIMIT_FIELD(maxTextureArrayLayers, uint32_t),
+    LIMIT_FIELD(maxBindGroups, uint32_t),
+    LIMIT_FIELD(maxBindingsPerBindGroup, uint32_t),
+    LIMIT_FIELD(maxDynamicUniformBuffersPerPipelineLayout, uint32_t),
+    LIMIT_FIELD(maxDynamicStorageBuffersPerPipelineLayout, uint32_t),
+    LIMIT_FIELD(maxSampledTexturesPerShaderStage, uint32_t),
+    LIMIT_FIELD(maxSamplersPerShaderStage, uint32_t),
+    LIMIT_FIELD(maxStorageBuffersPerShaderStage, uint32_t),
+    LIMIT_FIELD(maxStorageTexturesPerShaderStage, uint32_t),
+    LIMIT_FIELD(maxUniformBuffersPerShaderStage, uint32_t),
+    LIMIT_FIELD(maxUniformBufferBindingSize, uint64_t),
+    LIMIT_FIELD(maxStorageBufferBindingSize, uint64_t),
+    LIMIT_FIELD(minUniformBufferOffsetAlignment, uint32_t),
+    LIMIT_FIELD(minStorageBufferOffsetAlignment, uint32_t),
+    LIMIT_FIELD(maxVertexBuffers, uint32_t),
+    LIMIT_FIELD(maxBufferSize, uint64_t),
+    LIMIT_FIELD(maxVertexAttributes, uint32_t),
+    LIMIT_FIELD(maxVertexBufferArrayStride, uint32_t),
+    LIMIT_FIELD(maxInterStageShaderComponents, uint32_t),
+    LIMIT_FIELD(maxInterStageShaderVariables, uint32_t),
+    LIMIT_FIELD(maxColorAttachments, uint32_t),
+    LIMIT_FIELD(maxColorAttachmentBytesPerSample, uint32_t),
+    LIMIT_FIELD(maxComputeWorkgroupStorageSize, uint32_t),
+    LIMIT_FIELD(maxComputeInvocationsPerWorkgroup, uint32_t),
+    LIMIT_FIELD(maxComputeWorkgroupSizeX, uint32_t),
+    LIMIT_FIELD(maxComputeWorkgroupSizeY, uint32_t),
+    LIMIT_FIELD(maxComputeWorkgroupSizeZ, uint32_t),
+    LIMIT_FIELD(maxComputeWorkgroupsPerDimension, uint32_t),
+};
+
+#undef LIMIT_FIELD
+
+uint64_t readLimit(const WGPULimits& limits, const LimitField& field) {
+    const char* base = reinterpret_cast<const char*>(&limits) + field.offset;
+    return field.is64 ? *reinterpret_cast<const uint64_t*>(base) : *reinterpret_cast<const uint32_t*>(base);
+}
+
+void writeLimit(WGPULimits& limits, const LimitField& field, uint64_t value) {
+    char* base = reinterpret_cast<char*>(&limits) + field.offset;
+    if (field.is64) *reinterpret_cast<uint64_t*>(base) = value;
+    else *reinterpret_cast<uint32_t*>(base) = static_cast<uint32_t>(value);
+}
+
+bool parseNumber(const std::string& text, uint64_t& value) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    value = std::strtoull(text.c_str(), &end, 10);
+    return *end == '\0';
+}
+
+} // namespace
+
+std::string DeviceProfile::adapterKey(wgpu::Adapter adapter) {
+    wgpu::AdapterProperties properties = {};
+    adapter.getProperties(&properties);
+    std::ostringstream key;
+    key << std::hex << properties.vendorID << ":" << properties.deviceID << std::dec
+        << ":" << static_cast<int>(properties.backendType)
+        << ":" << (properties.name ? properties.name : "")
+        << ":" << (properties.driverDescription ? properties.driverDescription : "");
+    // The caches are whitespace separated
+    std::string result = key.str();
+    std::replace_if(result.begin(), result.end(), [](char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; }, '_');
+    return result;
+}
+
+DeviceProfile DeviceProfile::probe(wgpu::Adapter adapter) {
+    DeviceProfile profile;
+    profile.m_key = adapterKey(adapter);
+    size_t featureCount = wgpuAdapterEnumerateFeatures(adapter, nullptr);
+    profile.m_features.resize(featureCount);
+    wgpuAdapterEnumerateFeatures(adapter, profile.m_features.data());
+    std::sort(profile.m_features.begin(), profile.m_features.end());
+    wgpu::SupportedLimits supportedLimits = {};
+    if (adapter.getLimits(&supportedLimits)) {
+        profile.m_limits = supportedLimits.limits;
+    }
+    else {
+        std::cerr << "Could not get the adapter limits" << std::endl;
+    }
+    return profile;
+}
+
+DeviceProfile DeviceProfile::load(wgpu::Adapter adapter, const std::string& cachePath) {
+    const std::string key = adapterKey(adapter);
+    std::ifstream file(cachePath);
+    std::string line;
+    while (std::getline(file, line)) {
+        DeviceProfile profile;
+        if (line.compare(0, key.size() + 1, key + " ") == 0 && profile.parse(line)) {
+            profile.m_cached = true;
+            return profile;
+        }
+    }
+    file.close();
+
+    DeviceProfile profile = probe(adapter);
+    profile.save(cachePath);
+    return profile;
+}
+
+bool DeviceProfile::save(const std::string& cachePath) const {
+    std::vector<std::string> lines;
+    {
+        std::ifstream file(cachePath);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.compare(0, m_key.size() + 1, m_key + " ") != 0) lines.push_back(line);
+        }
+    }
+    lines.push_back(serialize());
+
+    std::ofstream file(cachePath);
+    if (!file) {
+        std::cerr << "Could not write device profile cache " << cachePath << std::endl;
+        return false;
+    }
+    for (const std::string& line : lines) file << line << "\n";
+    return static_cast<bool>(file);
+}
+
+bool DeviceProfile::hasFeature(WGPUFeatureName feature) const {
+    return std::binary_search(m_features.begin(), m_features.end(), feature);
+}
+
+wgpu::RequiredLimits DeviceProfile::requiredLimits() const {
+    wgpu::RequiredLimits requiredLimits = wgpu::Default;
+    requiredLimits.limits = m_limits;
+    return requiredLimits;
+}
+
+// <key> features=<n>,<n>,... <limit>=<value>...
+std::string DeviceProfile::serialize() const {
+    std::ostringstream line;
+    line << m_key << " features=";
+    for (size_t i = 0; i < m_features.size(); ++i) {
+        line << (i > 0 ? "," : "") << static_cast<uint32_t>(m_features[i]);
+    }
+    for (const LimitField& field : limitFields) {
+        line << " " << field.name << "=" << readLimit(m_limits, field);
+    }
+    return line.str();
+}
+
+bool DeviceProfile::parse(const std::string& line) {
+    std::istringstream tokens(line);
+    std::string token;
+    if (!(tokens >> m_key)) return false;
+    size_t limitCount = 0;
+    bool hasFeatures = false;
+    while (tokens >> token) {
+        size_t equals = token.find('=');
+        if (equals == std::string::npos) return false;
+        const std::string name = token.substr(0, equals);
+        const std::string value = token.substr(equals + 1);
+        if (name == "features") {
+            std::istringstream list(value);
+            std::string feature;
+            uint64_t number = 0;
+            while (std::getline(list, feature, ',')) {
+                if (!parseNumber(feature, number)) return false;
+                m_features.push_back(static_cast<WGPUFeatureName>(number));
+            }
+            hasFeatures = true;
+            continue;
+        }
+        for (const LimitField& field : limitFields) {
+            if (name != field.name) continue;
+            uint64_t number = 0;
+            if (!parseNumber(value, number)) return false;
+            writeLimit(m_limits, field, number);
+            ++limitCount;
+        }
+    }
+    std::sort(m_features.begin(), m_features.end());
+    // A line written by a build with other limits is probed again
+    return hasFeatures && limitCount == sizeof(limitFields) / sizeof(limitFields[0]);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <webgpu/webgpu.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * Features and limits of an adapter, probed once and then read back from a
+ * small text file, one line per adapter (and driver), on later starts.
+ *
+ * The device is requested with the profile's limits rather than the
+ * defaults, so that the compute kernels get the largest buffers and
+ * workgroups the adapter allows, and code paths that depend on a feature
+ * can be chosen before the device exists.
+ */
+class DeviceProfile {
+public:
+    /**
+     * Identifies the adapter and its driver, e.g. for cache keys.
+     */
+    static std::string adapterKey(wgpu::Adapter adapter);
+
+    /**
+     * Query the adapter.
+     */
+    static DeviceProfile probe(wgpu::Adapter adapter);
+
+    /**
+     * The profile cached in cachePath for this adapter, or a fresh probe
+     * (then saved to the cache).
+     */
+    static DeviceProfile load(wgpu::Adapter adapter, const std::string& cachePath = "device_profile.txt");
+
+    /**
+     * Replace this adapter's line in the cache.
+     */
+    bool save(const std::string& cachePath) const;
+
+    const std::string& key() const { return m_key; }
+    const std::vector<WGPUFeatureName>& features() const { return m_features; }
+    const WGPULimits& limits() const { return m_limits; }
+    bool hasFeature(WGPUFeatureName feature) const;
+    // Whether it was read from the cache rather than probed
+    bool cached() const { return m_cached; }
+
+    /**
+     * Everything the adapter supports, to pass as DeviceDescriptor::requiredLimits.
+     */
+    wgpu::RequiredLimits requiredLimits() const;
+
+private:
+    bool parse(const std::string& line);
+    std::string serialize() const;
+
+private:
+    std::string m_key;
+    std::vector<WGPUFeatureName> m_features;
+    WGPULimits m_limits = {};
+    bool m_cached = false;
+};
@@ -0,0 +1,69 @@
+#include "DrawList.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+DrawList::DrawList() {
+    // Index 0 is "none" for bind groups and vertex buffers, and a pipeline
+    // placeholder so that indices are the same for all three tables
+    m_pipelines.push_back(nullptr);
+    m_bindGroups.push_back(nullptr);
+    m_vertexBuffers.push_back({ nullptr, 0 });
+}
+
+uint32_t DrawList::addPipeline(wgpu::RenderPipeline pipeline) {
+    assert(m_pipelines.size() < MaxPipelines);
+    m_pipelines.push_back(pipeline);
+    return static_cast<uint32_t>(m_pipelines.size() - 1);
+}
+
+uint32_t DrawList::addBindGroup(wgpu::BindGroup bindGroup) {
+    assert(m_bindGroups.size() < MaxBindGroups);
+    m_bindGroups.push_back(bindGroup);
+    return static_cast<uint32_t>(m_bindGroups.size() - 1);
+}
+
+uint32_t DrawList::addVertexBuffer(wgpu::Buffer buffer, uint64_t size) {
+    assert(m_vertexBuffers.size() < MaxVertexBuffers);
+    m_vertexBuffers.push_back({ buffer, size });
+    return static_cast<uint32_t>(m_vertexBuffers.size() - 1);
+}
+
+void DrawList::clear() {
+    m_draws.clear();
+    m_order.clear();
+    m_sorted = true;
+    m_stats = {};
+}
+
+void DrawList::add(const Draw& draw) {
+    assert(draw.pass < MaxPasses);
+    assert(draw.pipeline > 0 && draw.pipeline < m_pipelines.size());
+    assert(draw.bindGroup < m_bindGroups.size());
+    assert(draw.vertexBuffer < m_vertexBuffers.size());
+    m_order.push_back({ packKey(draw), static_cast<uint32_t>(m_draws.size()) });
+    m_draws.push_back(draw);
+    m_sorted = false;
+    ++m_stats.drawCount;
+}
+
+void DrawList::sort() {
+    auto start = std::chrono::steady_clock::now();
+    radixSortDraws(m_order, m_sortScratch);
+    auto end = std::chrono::steady_clock::now();
+    m_stats.sortTimeMs = std::chrono::duration<double, std::milli>(end - start).count();
+    m_sorted = true;
+}
+
+uint64_t DrawList::packKey(const Draw& draw) {
+    constexpr uint32_t depthBits = 26;
+    constexpr uint32_t depthMax = (1u << depthBits) - 1;
+    float depth = std::min(std::max(draw.depth, 0.0f), 1.0f);
+    uint64_t quantizedDepth = static_cast<uint64_t>(depth * depthMax);
+    return (uint64_t(draw.pass) << 60)
+        | (uint64_t(draw.pipeline) << 50)
+        | (uint64_t(draw.bindGroup) << 38)
+        | (uint64_t(draw.vertexBuffer) << 26)
+        | quantizedDepth;
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "DrawSort.h"
+
+#include <webgpu/webgpu.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Collects the draws of a frame, sorts them on a packed 64-bit key and
+ * encodes them so that setPipeline, setBindGroup and setVertexBuffer are
+ * only issued when the state actually changes from one draw to the next.
+ *
+ * Key layout, most significant first:
+ *   pass (4 bits) | pipeline (10) | bind group (12) | vertex buffer (12) | depth (26)
+ * so draws are grouped by the most expensive state change first, and front
+ * to back within identical state (for early depth rejection).
+ *
+ * Pipelines, bind groups and vertex buffers are registered once and then
+ * referred to by index; index 0 means "none" for bind groups and vertex
+ * buffers. The list does not own these objects.
+ */
+class DrawList {
+public:
+    static constexpr uint32_t MaxPasses = 1 << 4;
+    static constexpr uint32_t MaxPipelines = 1 << 10;
+    static constexpr uint32_t MaxBindGroups = 1 << 12;
+    static constexpr uint32_t MaxVertexBuffers = 1 << 12;
+
+    struct Draw {
+        uint32_t pass = 0;
+        uint32_t pipeline = 0;
+        // Bound at group 0
+        uint32_t bindGroup = 0;
+        // Bound at slot 0, whole buffer
+        uint32_t vertexBuffer = 0;
+        // In [0, 1], smaller is drawn first
+        float depth = 0.0f;
+        uint32_t vertexCount = 0;
+        uint32_t instanceCount = 1;
+        uint32_t firstVertex = 0;
+        uint32_t firstInstance = 0;
+    };
+
+    struct Stats {
+        uint32_t drawCount = 0;
+        // State changes actually encoded
+        uint32_t pipelineChanges = 0;
+        uint32_t bindGroupChanges = 0;
+        uint32_t vertexBufferChanges = 0;
+        // State calls a naive encoder (one set call per state per draw)
+        // would have issued and that were skipped
+        uint32_t redundantCallsEliminated = 0;
+        double sortTimeMs = 0.0;
+    };
+
+    DrawList();
+
+    uint32_t addPipeline(wgpu::RenderPipeline pipeline);
+    uint32_t addBindGroup(wgpu::BindGroup bindGroup);
+    uint32_t addVertexBuffer(wgpu::Buffer buffer, uint64_t size);
+
+    /**
+     * Remove all draws, but keep registered state objects.
+     */
+    void clear();
+    void add(const Draw& draw);
+    void sort();
+
+    /**
+     * Record the draws of one pass. Encoder is wgpu::RenderPassEncoder, or
+     * anything with the same set/draw methods (e.g. a counting encoder in
+     * benchmarks). Stats accumulate over the passes until clear().
+     */
+    template <typename Encoder>
+    void encode(Encoder& encoder, uint32_t pass);
+
+    static uint64_t packKey(const Draw& draw);
+
+    size_t size() const { return m_draws.size(); }
+    // The i-th draw in sorted order
+    const Draw& sortedDraw(size_t i) const { return m_draws[m_order[i].index]; }
+    const Stats& stats() const { return m_stats; }
+
+private:
+    struct VertexBuffer {
+        wgpu::Buffer buffer;
+        uint64_t size;
+    };
+
+    std::vector<wgpu::RenderPipeline> m_pipelines;
+    std::vector<wgpu::BindGroup> m_bindGroups;
+    std::vector<VertexBuffer> m_vertexBuffers;
+
+    std::vector<Draw> m_draws;
+    std::vector<SortedDraw> m_order;
+    std::vector<SortedDraw> m_sortScratch;
+    bool m_sorted = true;
+    Stats m_stats;
+};
+
+template <typename Encoder>
+void DrawList::encode(Encoder& encoder, uint32_t pass) {
+    if (!m_sorted) sort();
+
+    // The order is sorted by pass first, so the pass is a contiguous range
+    auto first = std::lower_bound(m_order.begin(), m_order.end(), uint64_t(pass) << 60,
+        [](const SortedDraw& draw, uint64_t key) { return draw.key < key; });
+    size_t begin = static_cast<size_t>(first - m_order.begin());
+
+    constexpr uint32_t None = UINT32_MAX;
+    uint32_t currentPipeline = None;
+    uint32_t currentBindGroup = None;
+    uint32_t currentVertexBuffer = None;
+
+    for (size_t i = begin; i < m_order.size(); ++i) {
+        const Draw& draw = m_draws[m_order[i].index];
+        if (draw.pass != pass) break;
+
+        uint32_t naiveCalls = 1 + (draw.bindGroup ? 1 : 0) + (draw.vertexBuffer ? 1 : 0);
+        uint32_t calls = 0;
+        if (draw.pipeline != currentPipeline) {
+            encoder.setPipeline(m_pipelines[draw.pipeline]);
+            currentPipeline = draw.pipeline;
+            ++m_stats.pipelineChanges;
+            ++calls;
+        }
+        if (draw.bindGroup && draw.bindGroup != currentBindGroup) {
+            encoder.setBindGroup(0, m_bindGroups[draw.bindGroup], 0, nullptr);
+            currentBindGroup = draw.bindGroup;
+            ++m_stats.bindGroupChanges;
+            ++calls;
+        }
+        if (draw.vertexBuffer && draw.vertexBuffer != currentVertexBuffer) {
+            const VertexBuffer& vertexBuffer = m_vertexBuffers[draw.vertexBuffer];
+            encoder.setVertexBuffer(0, vertexBuffer.buffer, 0, vertexBuffer.size);
+            currentVertexBuffer = draw.vertexBuffer;
+            ++m_stats.vertexBufferChanges;
+            ++calls;
+        }
+        m_stats.redundantCallsEliminated += naiveCalls - calls;
+
+        encoder.draw(draw.vertexCount, draw.instanceCount, draw.firstVertex, draw.firstInstance);
+    }
+}
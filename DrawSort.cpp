@@ -0,0 +1,40 @@
+#include "DrawSort.h"
+
+#include <cstddef>
+#include <utility>
+
+void radixSortDraws(std::vector<SortedDraw>& draws, std::vector<SortedDraw>& scratch) {
+    constexpr int digitCount = 8;
+    const size_t n = draws.size();
+    if (n < 2) return;
+    scratch.resize(n);
+
+    // All histograms in a single pass over the keys
+    uint32_t histograms[digitCount][256] = {};
+    for (const SortedDraw& draw : draws) {
+        for (int d = 0; d < digitCount; ++d) {
+            ++histograms[d][(draw.key >> (8 * d)) & 0xff];
+        }
+    }
+
+    std::vector<SortedDraw>* source = &draws;
+    std::vector<SortedDraw>* destination = &scratch;
+    for (int d = 0; d < digitCount; ++d) {
+        uint32_t* histogram = histograms[d];
+        // Every key has the same digit: this pass would not move anything
+        if (histogram[((*source)[0].key >> (8 * d)) & 0xff] == n) continue;
+
+        uint32_t offset = 0;
+        for (int i = 0; i < 256; ++i) {
+            uint32_t count = histogram[i];
+            histogram[i] = offset;
+            offset += count;
+        }
+        for (const SortedDraw& draw : *source) {
+            (*destination)[histogram[(draw.key >> (8 * d)) & 0xff]++] = draw;
+        }
+        std::swap(source, destination);
+    }
+
+    if (source != &draws) draws.swap(scratch);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * A draw reduced to what is needed to order it: a 64-bit key (higher bits
+ * sort first, see DrawList::packKey) and the index of the draw in the
+ * caller's own list.
+ */
+struct SortedDraw {
+    uint64_t key;
+    uint32_t index;
+};
+
+/**
+ * Sort draws by increasing key with an LSD radix sort on 8-bit digits.
+ * Digits that are the same for every draw are skipped, so keys that only
+ * use a few bits are cheap. scratch is resized as needed and can be kept
+ * from one frame to the next to avoid allocations.
+ */
+void radixSortDraws(std::vector<SortedDraw>& draws, std::vector<SortedDraw>& scratch);
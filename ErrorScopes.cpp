@@ -0,0 +1,103 @@
+#include "ErrorScopes.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cassert>
+
+struct ErrorScopes::Pending {
+    uint64_t frame = 0;
+    const char* path[MaxDepth] = {};
+    uint32_t depth = 0;
+    bool done = false;
+    WGPUErrorType type = WGPUErrorType_NoError;
+    std::string message;
+};
+
+ErrorScopes::ErrorScopes(wgpu::Device device, uint32_t maxPendingScopes)
+    : m_device(device)
+{
+    assert(maxPendingScopes > 0);
+    for (uint32_t i = 0; i < maxPendingScopes; ++i) {
+        m_pool.push_back(std::make_unique<Pending>());
+        m_free.push_back(m_pool.back().get());
+    }
+}
+
+ErrorScopes::~ErrorScopes() {
+    assert(m_depth == 0);
+    if (!m_waiting.empty()) {
+        wgpuDevicePoll(m_device, true, nullptr);
+        collect();
+    }
+    // Results that never came would write into freed records
+    for (Pending* pending : m_waiting) {
+        auto it = std::find_if(m_pool.begin(), m_pool.end(), [pending](const std::unique_ptr<Pending>& p) { return p.get() == pending; });
+        if (it != m_pool.end()) it->release();
+    }
+}
+
+bool ErrorScopes::push(const char* label) {
+    if (!m_enabled) return false;
+    if (m_depth == MaxDepth || m_free.empty()) {
+        ++m_skippedScopeCount;
+        return false;
+    }
+    Pending* pending = m_free.back();
+    m_free.pop_back();
+    pending->path[0] = label;
+    m_stack[m_depth++] = pending;
+    wgpuDevicePushErrorScope(m_device, WGPUErrorFilter_Validation);
+    return true;
+}
+
+void ErrorScopes::pop() {
+    assert(m_depth > 0);
+    Pending* pending = m_stack[--m_depth];
+    // The scope's own label was kept in path[0] since push()
+    const char* label = pending->path[0];
+    for (uint32_t i = 0; i < m_depth; ++i) pending->path[i] = m_stack[i]->path[0];
+    pending->path[m_depth] = label;
+    pending->depth = m_depth + 1;
+    pending->frame = m_frame;
+    pending->done = false;
+    pending->type = WGPUErrorType_NoError;
+    pending->message.clear();
+    m_waiting.push_back(pending);
+    ++m_scopeCount;
+    wgpuDevicePopErrorScope(m_device, onPop, pending);
+}
+
+void ErrorScopes::onPop(WGPUErrorType type, char const* message, void* userdata) {
+    Pending* pending = static_cast<Pending*>(userdata);
+    pending->type = type;
+    if (type != WGPUErrorType_NoError && message) pending->message = message;
+    pending->done = true;
+}
+
+size_t ErrorScopes::collect() {
+    size_t errorCount = 0;
+    auto done = std::stable_partition(m_waiting.begin(), m_waiting.end(), [](const Pending* pending) {
+        return !pending->done;
+    });
+    for (auto it = done; it != m_waiting.end(); ++it) {
+        Pending* pending = *it;
+        if (pending->type != WGPUErrorType_NoError) {
+            Error error;
+            error.frame = pending->frame;
+            error.type = pending->type;
+            for (uint32_t i = 0; i < pending->depth; ++i) {
+                if (i > 0) error.scope += " / ";
+                error.scope += pending->path[i];
+            }
+            error.message = std::move(pending->message);
+            Log::writef(LogLevel::Error, "validation", "frame %llu, %s: %s",
+                (unsigned long long)error.frame, error.scope.c_str(), error.message.c_str());
+            m_errors.push_back(std::move(error));
+            ++errorCount;
+        }
+        m_free.push_back(pending);
+    }
+    m_waiting.erase(done, m_waiting.end());
+    return errorCount;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <webgpu/webgpu.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Validation mode: wraps phases of the frame in labelled validation error
+ * scopes, and reports the errors with the labels of the scopes they were
+ * raised in ("frame 12: Render graph / main: ...") instead of leaving them to
+ * the uncaptured error callback.
+ *
+ * pop() never waits for the result: the callback of each scope fills a
+ * record from a fixed pool, and collect() logs the records that completed
+ * since the last call. No std::function and no allocation but for the
+ * message of an actual error.
+ *
+ * Scopes are opened with ERROR_SCOPE(scopes, "label"), which does nothing
+ * while disabled and is compiled out without VALIDATION_SCOPES_ENABLED.
+ * Labels must outlive the scope results: string literals, or
+ * Trace::intern().
+ */
+class ErrorScopes {
+public:
+    struct Error {
+        uint64_t frame = 0;
+        WGPUErrorType type = WGPUErrorType_NoError;
+        // Labels of the enclosing scopes, outermost first, joined by " / "
+        std::string scope;
+        std::string message;
+    };
+
+    static constexpr uint32_t MaxDepth = 8;
+
+    explicit ErrorScopes(wgpu::Device device, uint32_t maxPendingScopes = 256);
+    ~ErrorScopes();
+    ErrorScopes(const ErrorScopes&) = delete;
+    ErrorScopes& operator=(const ErrorScopes&) = delete;
+
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool enabled() const { return m_enabled; }
+
+    /**
+     * Frame number reported with the errors of the scopes popped from now on.
+     */
+    void setFrame(uint64_t frame) { m_frame = frame; }
+
+    /**
+     * Returns false, and pushes nothing, when disabled or when too many
+     * scopes are waiting for their result; pop() only if it returned true.
+     */
+    bool push(const char* label);
+    void pop();
+
+    /**
+     * Log the errors of the scopes that completed; returns how many.
+     */
+    size_t collect();
+
+    // Every error collected so far
+    const std::vector<Error>& errors() const { return m_errors; }
+    uint64_t scopeCount() const { return m_scopeCount; }
+    uint64_t skippedScopeCount() const { return m_skippedScopeCount; }
+
+private:
+    struct Pending;
+
+    static void onPop(WGPUErrorType type, char const* message, void* userdata);
+
+private:
+    wgpu::Device m_device;
+    bool m_enabled = false;
+    uint64_t m_frame = 0;
+    // Open scopes, innermost last
+    Pending* m_stack[MaxDepth] = {};
+    uint32_t m_depth = 0;
+    std::vector<std::unique_ptr<Pending>> m_pool;
+    std::vector<Pending*> m_free;
+    std::vector<Pending*> m_waiting;
+    std::vector<Error> m_errors;
+    uint64_t m_scopeCount = 0;
+    uint64_t m_skippedScopeCount = 0;
+};
+
+class ErrorScope {
+public:
+    ErrorScope(ErrorScopes* scopes, const char* label)
+        : m_scopes(scopes && scopes->push(label) ? scopes : nullptr)
+    {}
+    ~ErrorScope() {
+        if (m_scopes) m_scopes->pop();
+    }
+    ErrorScope(const ErrorScope&) = delete;
+    ErrorScope& operator=(const ErrorScope&) = delete;
+
+private:
+    ErrorScopes* m_scopes;
+};
+
+#define ERROR_SCOPE_CONCAT_(a, b) a##b
+#define ERROR_SCOPE_CONCAT(a, b) ERROR_SCOPE_CONCAT_(a, b)
+
+#ifdef VALIDATION_SCOPES_ENABLED
+#define ERROR_SCOPE(scopes, label) ErrorScope ERROR_SCOPE_CONCAT(errorScope, __LINE__)(scopes, label)
+#else
+#define ERROR_SCOPE(scopes, label) do {} while (false)
+#endif
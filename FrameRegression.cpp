@@ -0,0 +1,216 @@
+#include "FrameRegression.h"
+
+#include "AllocationCounter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+// MAD times this estimates the standard deviation of normal samples
+constexpr double madScale = 1.4826;
+
+double median(std::vector<double> values) {
+    if (values.empty()) return 0.0;
+    const size_t middle = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + middle, values.end());
+    double result = values[middle];
+    if (values.size() % 2 == 0) {
+        result = 0.5 * (result + *std::max_element(values.begin(), values.begin() + middle));
+    }
+    return result;
+}
+
+double medianAbsoluteDeviation(const std::vector<double>& values, double center) {
+    std::vector<double> deviations(values.size());
+    for (size_t i = 0; i < values.size(); ++i) deviations[i] = std::abs(values[i] - center);
+    return median(std::move(deviations));
+}
+
+const char* configurationPrefix = "configuration ";
+
+// <medianUs> <madUs> <medianAllocations> <madAllocations> <frames> <name>
+bool parsePhase(const std::string& line, FrameRegression::PhaseSummary& phase) {
+    std::istringstream tokens(line);
+    if (!(tokens >> phase.medianUs >> phase.madUs >> phase.medianAllocations >> phase.madAllocations >> phase.frames)) return false;
+    std::getline(tokens >> std::ws, phase.name);
+    return !phase.name.empty();
+}
+
+} // namespace
+
+FrameRegression::FrameRegression(const std::string& configuration, uint32_t frameCount, const Options& options)
+    : m_configuration(configuration)
+    , m_frameCount(frameCount)
+    , m_options(options)
+{
+    // Phases are added on the first frame: keep the later ones free of
+    // allocations, since they are counted
+    m_phases.reserve(32);
+}
+
+size_t FrameRegression::phase(const char* name) {
+    for (size_t i = 0; i < m_phases.size(); ++i) {
+        if (m_phases[i].name == name || std::strcmp(m_phases[i].name, name) == 0) return i;
+    }
+    Phase phase;
+    phase.name = name;
+    phase.lastFrame = UINT64_MAX;
+    phase.us.reserve(m_frameCount);
+    phase.allocations.reserve(m_frameCount);
+    m_phases.push_back(std::move(phase));
+    return m_phases.size() - 1;
+}
+
+void FrameRegression::addSample(size_t index, uint64_t elapsedNs, uint64_t allocations) {
+    if (m_frame < m_options.warmupFrames) return;
+    Phase& phase = m_phases[index];
+    const double us = elapsedNs * 1e-3;
+    // A phase that runs several times in a frame counts once, with the sum
+    if (phase.lastFrame == m_frame && !phase.us.empty()) {
+        phase.us.back() += us;
+        phase.allocations.back() += static_cast<double>(allocations);
+        return;
+    }
+    phase.lastFrame = m_frame;
+    phase.us.push_back(us);
+    phase.allocations.push_back(static_cast<double>(allocations));
+}
+
+std::vector<FrameRegression::PhaseSummary> FrameRegression::summarize() const {
+    std::vector<PhaseSummary> summaries;
+    for (const Phase& phase : m_phases) {
+        if (phase.us.empty()) continue;
+        PhaseSummary summary;
+        summary.name = phase.name;
+        summary.frames = static_cast<uint32_t>(phase.us.size());
+        summary.medianUs = median(phase.us);
+        summary.madUs = medianAbsoluteDeviation(phase.us, summary.medianUs);
+        summary.medianAllocations = median(phase.allocations);
+        summary.madAllocations = medianAbsoluteDeviation(phase.allocations, summary.medianAllocations);
+        summaries.push_back(summary);
+    }
+    return summaries;
+}
+
+void FrameRegression::print(std::ostream& out) const {
+    out << "Frame phases (median, MAD) after " << m_options.warmupFrames << " warmup frames:" << std::endl;
+    for (const PhaseSummary& phase : summarize()) {
+        out << "  " << phase.name << ": " << phase.medianUs << " us +- " << phase.madUs
+            << ", " << phase.medianAllocations << " allocations +- " << phase.madAllocations
+            << " (" << phase.frames << " frames)" << std::endl;
+    }
+}
+
+bool FrameRegression::save(const std::string& baselinePath) const {
+    std::vector<PhaseSummary> summaries = summarize();
+    if (summaries.empty()) {
+        std::cerr << "No frame after the warmup, not writing a baseline" << std::endl;
+        return false;
+    }
+    std::ofstream file(baselinePath);
+    if (!file) {
+        std::cerr << "Could not write frame time baseline " << baselinePath << std::endl;
+        return false;
+    }
+    file << configurationPrefix << m_configuration << "\n";
+    for (const PhaseSummary& phase : summaries) {
+        file << phase.medianUs << " " << phase.madUs << " " << phase.medianAllocations << " "
+            << phase.madAllocations << " " << phase.frames << " " << phase.name << "\n";
+    }
+    return static_cast<bool>(file);
+}
+
+bool FrameRegression::compare(const std::string& baselinePath, std::ostream& out) const {
+    std::ifstream file(baselinePath);
+    if (!file) {
+        std::cerr << "No frame time baseline at " << baselinePath << ", record one with --update-baseline" << std::endl;
+        return false;
+    }
+    std::string line;
+    std::getline(file, line);
+    if (line.compare(0, std::strlen(configurationPrefix), configurationPrefix) != 0) {
+        std::cerr << baselinePath << " is not a frame time baseline" << std::endl;
+        return false;
+    }
+    const std::string configuration = line.substr(std::strlen(configurationPrefix));
+    if (configuration != m_configuration) {
+        std::cerr << "The baseline " << baselinePath << " was recorded with another configuration:" << std::endl
+            << "  baseline: " << configuration << std::endl
+            << "  this run: " << m_configuration << std::endl;
+        return false;
+    }
+    std::vector<PhaseSummary> baseline;
+    while (std::getline(file, line)) {
+        if (line.empty()) continue;
+        PhaseSummary phase;
+        if (!parsePhase(line, phase)) {
+            std::cerr << "Could not parse baseline line: " << line << std::endl;
+            return false;
+        }
+        baseline.push_back(phase);
+    }
+
+    const std::vector<PhaseSummary> current = summarize();
+    if (current.empty()) {
+        std::cerr << "No frame after the warmup to compare with the baseline" << std::endl;
+        return false;
+    }
+    bool passed = true;
+    out << "Frame phases against " << baselinePath << " (median, allowed difference):" << std::endl;
+    for (const PhaseSummary& phase : current) {
+        auto found = std::find_if(baseline.begin(), baseline.end(), [&](const PhaseSummary& b) { return b.name == phase.name; });
+        if (found == baseline.end()) {
+            out << "  " << phase.name << ": " << phase.medianUs << " us, " << phase.medianAllocations
+                << " allocations, not in the baseline" << std::endl;
+            continue;
+        }
+        const PhaseSummary& reference = *found;
+        const double allowedUs = std::max({
+            m_options.tolerance * madScale * std::hypot(phase.madUs, reference.madUs),
+            m_options.minRelative * reference.medianUs,
+            m_options.minMicroseconds,
+        });
+        const double allowedAllocations = m_options.tolerance * madScale * std::hypot(phase.madAllocations, reference.madAllocations);
+        const bool slower = phase.medianUs > reference.medianUs + allowedUs;
+        const bool faster = phase.medianUs < reference.medianUs - allowedUs;
+        const bool moreAllocations = phase.medianAllocations > reference.medianAllocations + allowedAllocations;
+        const bool fewerAllocations = phase.medianAllocations < reference.medianAllocations - allowedAllocations;
+        out << "  " << phase.name << ": " << phase.medianUs << " us (baseline " << reference.medianUs
+            << " +- " << allowedUs << "), " << phase.medianAllocations << " allocations (baseline "
+            << reference.medianAllocations << " +- " << allowedAllocations << ")";
+        if (slower) out << " SLOWER";
+        if (moreAllocations) out << " MORE ALLOCATIONS";
+        // Not a failure, but the baseline no longer catches a return to
+        // the old numbers
+        if (faster || fewerAllocations) out << " improved, consider --update-baseline";
+        out << std::endl;
+        passed = passed && !slower && !moreAllocations;
+    }
+    for (const PhaseSummary& reference : baseline) {
+        auto found = std::find_if(current.begin(), current.end(), [&](const PhaseSummary& c) { return c.name == reference.name; });
+        if (found == current.end()) out << "  " << reference.name << ": in the baseline, did not run" << std::endl;
+    }
+    out << (passed ? "No frame time regression" : "Frame time REGRESSION") << std::endl;
+    return passed;
+}
+
+FramePhase::FramePhase(FrameRegression* recorder, const char* name)
+    : m_recorder(recorder)
+{
+    if (!m_recorder) return;
+    m_phase = m_recorder->phase(name);
+    m_allocations = AllocationCounter::threadCount();
+    m_begin = std::chrono::steady_clock::now();
+}
+
+FramePhase::~FramePhase() {
+    if (!m_recorder) return;
+    auto elapsed = std::chrono::steady_clock::now() - m_begin;
+    const uint64_t allocations = AllocationCounter::threadCount() - m_allocations;
+    m_recorder->addSample(m_phase, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), allocations);
+}
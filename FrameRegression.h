@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ * Frame time regression harness (--baseline): records the CPU time and the
+ * allocations (see AllocationCounter) of each phase of the frame loop, scoped
+ * with FRAME_PHASE(recorder, "name"), and compares their medians with those
+ * of a baseline file recorded by an earlier run of the same configuration.
+ *
+ * A phase regresses when its median time exceeds the baseline median by more
+ * than `tolerance` times the MADs of both runs (scaled to standard
+ * deviations), and by more than minRelative and minMicroseconds, so that
+ * timer noise on short phases does not fail the run. Allocation counts are
+ * compared the same way without the floors: in a deterministic run their
+ * MAD is 0, and one more allocation per frame is a regression.
+ *
+ * Phase names must outlive the recorder: string literals, or
+ * Trace::intern(). Only the thread that runs the frame loop records.
+ */
+class FrameRegression {
+public:
+    struct Options {
+        // Left out of the statistics: pipeline and texture creation, first
+        // uses of the pools...
+        uint32_t warmupFrames = 30;
+        double tolerance = 4.0;
+        double minRelative = 0.05;
+        double minMicroseconds = 20.0;
+    };
+
+    struct PhaseSummary {
+        std::string name;
+        uint32_t frames = 0;
+        double medianUs = 0.0;
+        double madUs = 0.0;
+        double medianAllocations = 0.0;
+        double madAllocations = 0.0;
+    };
+
+    /**
+     * configuration describes what the timings depend on (scene options,
+     * frame count, adapter...): it is written to the baseline, and a baseline
+     * of another configuration is not compared with.
+     */
+    FrameRegression(const std::string& configuration, uint32_t frameCount, const Options& options);
+
+    /**
+     * Frame the phases ending from now on belong to.
+     */
+    void setFrame(uint64_t frame) { m_frame = frame; }
+
+    /**
+     * Index of the phase, added on first use.
+     */
+    size_t phase(const char* name);
+    void addSample(size_t phase, uint64_t elapsedNs, uint64_t allocations);
+
+    /**
+     * Median and MAD of each phase, in the order they first ran.
+     */
+    std::vector<PhaseSummary> summarize() const;
+    void print(std::ostream& out) const;
+
+    bool save(const std::string& baselinePath) const;
+    /**
+     * Print each phase next to its baseline. Returns false if any regressed,
+     * or if there is no baseline for this configuration at that path.
+     */
+    bool compare(const std::string& baselinePath, std::ostream& out) const;
+
+private:
+    struct Phase {
+        const char* name = nullptr;
+        uint64_t lastFrame = 0;
+        // One entry per frame after the warmup
+        std::vector<double> us;
+        std::vector<double> allocations;
+    };
+
+    std::string m_configuration;
+    uint32_t m_frameCount;
+    Options m_options;
+    uint64_t m_frame = 0;
+    std::vector<Phase> m_phases;
+};
+
+class FramePhase {
+public:
+    FramePhase(FrameRegression* recorder, const char* name);
+    ~FramePhase();
+    FramePhase(const FramePhase&) = delete;
+    FramePhase& operator=(const FramePhase&) = delete;
+
+private:
+    FrameRegression* m_recorder;
+    size_t m_phase = 0;
+    std::chrono::steady_clock::time_point m_begin;
+    uint64_t m_allocations = 0;
+};
+
+#define FRAME_PHASE_CONCAT_(a, b) a##b
+#define FRAME_PHASE_CONCAT(a, b) FRAME_PHASE_CONCAT_(a, b)
+
+// Does nothing when recorder is null
+#define FRAME_PHASE(recorder, name) FramePhase FRAME_PHASE_CONCAT(framePhase, __LINE__)(recorder, name)
@@ -0,0 +1,53 @@
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <iostream>
+
+FrameStats::FrameStats(size_t historySize)
+    : m_history(historySize, 0.0f)
+{}
+
+void FrameStats::tick() {
+    auto now = std::chrono::steady_clock::now();
+    if (m_started) {
+        float ms = std::chrono::duration<float, std::milli>(now - m_lastTick).count();
+        m_history[m_next] = ms;
+        m_next = (m_next + 1) % m_history.size();
+        m_size = std::min(m_size + 1, m_history.size());
+        m_sumMs += ms;
+        m_minMs = m_frameCount == 0 ? ms : std::min(m_minMs, ms);
+        m_maxMs = m_frameCount == 0 ? ms : std::max(m_maxMs, ms);
+        ++m_frameCount;
+    }
+    m_started = true;
+    m_lastTick = now;
+}
+
+double FrameStats::meanMs() const {
+    return m_frameCount == 0 ? 0.0 : m_sumMs / m_frameCount;
+}
+
+double FrameStats::minMs() const {
+    return m_minMs;
+}
+
+double FrameStats::maxMs() const {
+    return m_maxMs;
+}
+
+std::vector<float> FrameStats::history() const {
+    std::vector<float> result;
+    result.reserve(m_size);
+    size_t first = (m_next + m_history.size() - m_size) % m_history.size();
+    for (size_t i = 0; i < m_size; ++i) {
+        result.push_back(m_history[(first + i) % m_history.size()]);
+    }
+    return result;
+}
+
+void FrameStats::print(std::ostream& out, const char* label) const {
+    out << label << ": " << m_frameCount << " frames"
+        << ", mean " << meanMs() << " ms"
+        << ", min " << minMs() << " ms"
+        << ", max " << maxMs() << " ms" << std::endl;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+/**
+ * Measures the time between consecutive frames, to compare the cost of
+ * rendering options (anti-aliasing mode...): running statistics over all
+ * frames, and a short history of the last ones for the overlay chart.
+ */
+class FrameStats {
+public:
+    static constexpr size_t DefaultHistorySize = 240;
+
+    explicit FrameStats(size_t historySize = DefaultHistorySize);
+
+    /**
+     * Call once per frame, e.g. right after present().
+     */
+    void tick();
+
+    uint64_t frameCount() const { return m_frameCount; }
+
+    // Statistics over all frames so far, in milliseconds, without a scan
+    double meanMs() const;
+    double minMs() const;
+    double maxMs() const;
+
+    /**
+     * The last historySize frame times, from oldest to newest.
+     */
+    std::vector<float> history() const;
+
+    void print(std::ostream& out, const char* label) const;
+
+private:
+    std::chrono::steady_clock::time_point m_lastTick;
+    bool m_started = false;
+    uint64_t m_frameCount = 0;
+    double m_sumMs = 0.0;
+    float m_minMs = 0.0f;
+    float m_maxMs = 0.0f;
+    std::vector<float> m_history;
+    size_t m_next = 0;
+    size_t m_size = 0;
+};
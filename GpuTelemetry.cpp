@@ -0,0 +1,178 @@
+#include "GpuTelemetry.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+namespace {
+
+uint64_t hubCount(const WGPUHubReport& hub, GpuTelemetry::Counter counter) {
+    switch (counter) {
+    case GpuTelemetry::Buffers: return hub.buffers.numOccupied;
+    case GpuTelemetry::Textures: return hub.textures.numOccupied;
+    case GpuTelemetry::TextureViews: return hub.textureViews.numOccupied;
+    case GpuTelemetry::Samplers: return hub.samplers.numOccupied;
+    case GpuTelemetry::BindGroups: return hub.bindGroups.numOccupied;
+    case GpuTelemetry::BindGroupLayouts: return hub.bindGroupLayouts.numOccupied;
+    case GpuTelemetry::PipelineLayouts: return hub.pipelineLayouts.numOccupied;
+    case GpuTelemetry::ShaderModules: return hub.shaderModules.numOccupied;
+    case GpuTelemetry::RenderPipelines: return hub.renderPipelines.numOccupied;
+    case GpuTelemetry::ComputePipelines: return hub.computePipelines.numOccupied;
+    case GpuTelemetry::CommandBuffers: return hub.commandBuffers.numOccupied;
+    case GpuTelemetry::RenderBundles: return hub.renderBundles.numOccupied;
+    case GpuTelemetry::QuerySets: return hub.querySets.numOccupied;
+    case GpuTelemetry::CounterCount: break;
+    }
+    return 0;
+}
+
+bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+GpuTelemetry::GpuTelemetry(wgpu::Instance instance, const Options& options)
+    : m_instance(instance)
+    , m_options(options)
+    , m_start(std::chrono::steady_clock::now())
+    , m_recentSamples(std::max<size_t>(options.growthSamples + 1, 2))
+{
+    if (!options.outputPath.empty() && options.format == Format::JsonLines) {
+        m_jsonLines.open(options.outputPath, std::ios::app);
+        if (!m_jsonLines) std::cerr << "GpuTelemetry: cannot write " << options.outputPath << std::endl;
+    }
+}
+
+bool GpuTelemetry::tick() {
+    bool due = m_options.sampleInterval > 0 && m_frameCount % m_options.sampleInterval == 0;
+    if (due) sample();
+    ++m_frameCount;
+    return due;
+}
+
+const GpuTelemetry::Sample& GpuTelemetry::sample() {
+    WGPUGlobalReport report = {};
+    wgpuGenerateReport(m_instance, &report);
+
+    Sample sample;
+    sample.frame = m_frameCount;
+    sample.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    // Only the hub of the backend in use has objects
+    for (const WGPUHubReport* hub : { &report.vulkan, &report.metal, &report.dx12, &report.dx11, &report.gl }) {
+        for (int counter = 0; counter < CounterCount; ++counter) {
+            sample.counts[counter] += hubCount(*hub, static_cast<Counter>(counter));
+        }
+    }
+    if (m_sampleCount == 0) m_firstSample = sample;
+    m_recentSamples[m_next] = sample;
+    m_next = (m_next + 1) % m_recentSamples.size();
+    ++m_sampleCount;
+
+    write(sample);
+    checkGrowth();
+    return lastSample();
+}
+
+const GpuTelemetry::Sample& GpuTelemetry::recentSample(size_t age) const {
+    assert(age < m_sampleCount && age < m_recentSamples.size());
+    return m_recentSamples[(m_next + m_recentSamples.size() - 1 - age) % m_recentSamples.size()];
+}
+
+void GpuTelemetry::write(const Sample& sample) {
+    if (m_options.outputPath.empty()) return;
+
+    if (m_options.format == Format::JsonLines) {
+        if (!m_jsonLines) return;
+        m_jsonLines << "{\"frame\":" << sample.frame << ",\"seconds\":" << sample.seconds;
+        for (int counter = 0; counter < CounterCount; ++counter) {
+            m_jsonLines << ",\"" << counterName(static_cast<Counter>(counter)) << "\":" << sample.counts[counter];
+        }
+        m_jsonLines << "}" << std::endl;
+        return;
+    }
+
+    std::ofstream file(m_options.outputPath, std::ios::trunc);
+    if (!file) {
+        std::cerr << "GpuTelemetry: cannot write " << m_options.outputPath << std::endl;
+        return;
+    }
+    file << "# HELP wgpu_objects Live wgpu objects, by kind\n";
+    file << "# TYPE wgpu_objects gauge\n";
+    for (int counter = 0; counter < CounterCount; ++counter) {
+        file << "wgpu_objects{kind=\"" << counterName(static_cast<Counter>(counter)) << "\"} " << sample.counts[counter] << "\n";
+    }
+    file << "# HELP wgpu_telemetry_frame Frame of the last sample\n";
+    file << "# TYPE wgpu_telemetry_frame counter\n";
+    file << "wgpu_telemetry_frame " << sample.frame << "\n";
+}
+
+void GpuTelemetry::checkGrowth() {
+    if (m_sampleCount < 2) return;
+    const Sample& previous = recentSample(1);
+    const Sample& last = lastSample();
+    for (int counter = 0; counter < CounterCount; ++counter) {
+        if (last.counts[counter] <= previous.counts[counter]) {
+            m_growth[counter] = 0;
+            continue;
+        }
+        // Warn once per streak
+        if (++m_growth[counter] == m_options.growthSamples) {
+            const Sample& first = recentSample(m_options.growthSamples);
+            std::cerr << "GpuTelemetry: " << counterName(static_cast<Counter>(counter))
+                << " grew over " << m_options.growthSamples << " samples in a row ("
+                << first.counts[counter] << " at frame " << first.frame << ", "
+                << last.counts[counter] << " at frame " << last.frame << "), is something leaking?" << std::endl;
+        }
+    }
+}
+
+std::vector<GpuTelemetry::Counter> GpuTelemetry::growingCounters() const {
+    std::vector<Counter> counters;
+    for (int counter = 0; counter < CounterCount; ++counter) {
+        if (m_options.growthSamples > 0 && m_growth[counter] >= m_options.growthSamples) {
+            counters.push_back(static_cast<Counter>(counter));
+        }
+    }
+    return counters;
+}
+
+const char* GpuTelemetry::counterName(Counter counter) {
+    switch (counter) {
+    case Buffers: return "buffers";
+    case Textures: return "textures";
+    case TextureViews: return "texture_views";
+    case Samplers: return "samplers";
+    case BindGroups: return "bind_groups";
+    case BindGroupLayouts: return "bind_group_layouts";
+    case PipelineLayouts: return "pipeline_layouts";
+    case ShaderModules: return "shader_modules";
+    case RenderPipelines: return "render_pipelines";
+    case ComputePipelines: return "compute_pipelines";
+    case CommandBuffers: return "command_buffers";
+    case RenderBundles: return "render_bundles";
+    case QuerySets: return "query_sets";
+    case CounterCount: break;
+    }
+    return "unknown";
+}
+
+GpuTelemetry::Format GpuTelemetry::formatForPath(const std::string& path) {
+    return endsWith(path, ".prom") ? Format::Prometheus : Format::JsonLines;
+}
+
+void GpuTelemetry::print(std::ostream& out) const {
+    if (m_sampleCount == 0) return;
+    const Sample& first = m_firstSample;
+    const Sample& last = lastSample();
+    out << "wgpu objects at frame " << last.frame << ":";
+    for (int counter = 0; counter < CounterCount; ++counter) {
+        if (last.counts[counter] == 0 && first.counts[counter] == 0) continue;
+        out << " " << counterName(static_cast<Counter>(counter)) << " " << last.counts[counter];
+        if (last.counts[counter] != first.counts[counter]) {
+            out << " (" << (last.counts[counter] > first.counts[counter] ? "+" : "")
+                << static_cast<int64_t>(last.counts[counter] - first.counts[counter]) << " since frame " << first.frame << ")";
+        }
+    }
+    out << std::endl;
+}
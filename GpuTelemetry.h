@@ -0,0 +1,115 @@
+#pragma once
+
+#include <webgpu/webgpu.hpp>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ * Samples the number of live wgpu objects of each kind (wgpuGenerateReport)
+ * every few frames, exports them as a time series, and warns when a count
+ * keeps growing: objects created every frame and never released are the
+ * usual leaks of a render loop.
+ *
+ * The report counts objects, not the memory behind them: a leaked buffer
+ * shows up as a growing buffer count, whatever its size.
+ */
+class GpuTelemetry {
+public:
+    enum Counter {
+        Buffers,
+        Textures,
+        TextureViews,
+        Samplers,
+        BindGroups,
+        BindGroupLayouts,
+        PipelineLayouts,
+        ShaderModules,
+        RenderPipelines,
+        ComputePipelines,
+        CommandBuffers,
+        RenderBundles,
+        QuerySets,
+        CounterCount,
+    };
+
+    enum class Format {
+        // One JSON object per sample and line, appended
+        JsonLines,
+        // Prometheus text exposition of the last sample, rewritten each time
+        Prometheus,
+    };
+
+    struct Options {
+        uint32_t sampleInterval = 60;
+        // Nothing is written if empty
+        std::string outputPath;
+        Format format = Format::JsonLines;
+        // Warn when a count grew over this many consecutive samples
+        uint32_t growthSamples = 8;
+    };
+
+    struct Sample {
+        uint64_t frame = 0;
+        double seconds = 0.0;
+        std::array<uint64_t, CounterCount> counts = {};
+    };
+
+    GpuTelemetry(wgpu::Instance instance, const Options& options);
+
+    /**
+     * Call once per frame; samples every options.sampleInterval frames.
+     * Returns true when it sampled.
+     */
+    bool tick();
+
+    /**
+     * Take a sample now.
+     */
+    const Sample& sample();
+
+    // Samples taken so far; only the first and the last few are kept
+    uint64_t sampleCount() const { return m_sampleCount; }
+    // Need sampleCount() > 0
+    const Sample& firstSample() const { return m_firstSample; }
+    const Sample& lastSample() const { return recentSample(0); }
+    uint64_t frameCount() const { return m_frameCount; }
+
+    /**
+     * Counters that grew over the last options.growthSamples samples.
+     */
+    std::vector<Counter> growingCounters() const;
+
+    static const char* counterName(Counter counter);
+
+    /**
+     * Prometheus for a .prom path, JSON lines otherwise.
+     */
+    static Format formatForPath(const std::string& path);
+
+    void print(std::ostream& out) const;
+
+private:
+    void write(const Sample& sample);
+    void checkGrowth();
+    // The sample taken age samples before the last one
+    const Sample& recentSample(size_t age) const;
+
+private:
+    wgpu::Instance m_instance;
+    Options m_options;
+    std::chrono::steady_clock::time_point m_start;
+    uint64_t m_frameCount = 0;
+    uint64_t m_sampleCount = 0;
+    Sample m_firstSample;
+    // Ring of the last samples, enough for checkGrowth()
+    std::vector<Sample> m_recentSamples;
+    size_t m_next = 0;
+    // Consecutive samples each counter grew over
+    std::array<uint32_t, CounterCount> m_growth = {};
+    std::ofstream m_jsonLines;
+};
@@ -0,0 +1,132 @@
+#include "GpuTimeline.h"
+
+#include "Trace.h"
+
+#include <algorithm>
+#include <iostream>
+
+GpuTimeline::GpuTimeline(wgpu::Device device, wgpu::Queue queue, uint32_t maxMarksPerFrame)
+    : m_device(device)
+    , m_queue(queue)
+    , m_context(device, queue)
+    , m_capacity(maxMarksPerFrame + 1)
+{
+    m_supported = device.hasFeature(wgpu::FeatureName::TimestampQuery);
+    if (!m_supported) return;
+
+    wgpu::QuerySetDescriptor querySetDesc;
+    querySetDesc.label = "GPU timeline";
+    querySetDesc.type = wgpu::QueryType::Timestamp;
+    querySetDesc.count = m_capacity;
+    querySetDesc.pipelineStatistics = nullptr;
+    querySetDesc.pipelineStatisticsCount = 0;
+    m_querySet = device.createQuerySet(querySetDesc);
+
+    wgpu::BufferDescriptor bufferDesc;
+    bufferDesc.label = "GPU timeline timestamps";
+    bufferDesc.usage = wgpu::BufferUsage::QueryResolve | wgpu::BufferUsage::CopySrc;
+    bufferDesc.size = m_capacity * sizeof(uint64_t);
+    bufferDesc.mappedAtCreation = false;
+    m_resolveBuffer = device.createBuffer(bufferDesc);
+
+    bufferDesc.label = "GPU timeline readback";
+    bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::MapRead;
+    for (Readback& readback : m_readbacks) readback.buffer = device.createBuffer(bufferDesc);
+}
+
+GpuTimeline::~GpuTimeline() {
+    if (!m_supported) return;
+    // Pending readbacks call back into this object
+    for (const Readback& readback : m_readbacks) {
+        while (readback.pending) wgpuDevicePoll(m_device, true, nullptr);
+    }
+    for (Readback& readback : m_readbacks) {
+        readback.buffer.destroy();
+        readback.buffer.release();
+    }
+    m_resolveBuffer.destroy();
+    m_resolveBuffer.release();
+    m_querySet.destroy();
+    m_querySet.release();
+}
+
+bool GpuTimeline::active() const {
+    return m_supported && (m_enabled || Trace::enabled());
+}
+
+void GpuTimeline::beginFrame() {
+    m_names.clear();
+    m_frameBegin = Trace::now();
+    if (m_supported) m_context.poll();
+}
+
+void GpuTimeline::mark(wgpu::CommandEncoder encoder, const char* name) {
+    // The last query is the end of the frame
+    if (!active() || m_names.size() + 1 >= m_capacity) return;
+
+    WGPUComputePassTimestampWrite timestampWrite = {};
+    timestampWrite.querySet = m_querySet;
+    timestampWrite.queryIndex = static_cast<uint32_t>(m_names.size());
+    timestampWrite.location = WGPUComputePassTimestampLocation_Beginning;
+    wgpu::ComputePassDescriptor computePassDesc;
+    computePassDesc.label = name;
+    computePassDesc.timestampWriteCount = 1;
+    computePassDesc.timestampWrites = &timestampWrite;
+    wgpu::ComputePassEncoder pass = encoder.beginComputePass(computePassDesc);
+    pass.end();
+    pass.release();
+    m_names.push_back(name);
+}
+
+void GpuTimeline::endFrame() {
+    if (!active() || m_names.empty()) return;
+    Readback& readback = m_readbacks[m_nextReadback];
+    if (readback.pending) return;
+
+    const uint32_t queryCount = static_cast<uint32_t>(m_names.size()) + 1;
+    wgpu::CommandEncoder encoder = m_context.createEncoder("GPU timeline");
+    WGPUComputePassTimestampWrite timestampWrite = {};
+    timestampWrite.querySet = m_querySet;
+    timestampWrite.queryIndex = queryCount - 1;
+    timestampWrite.location = WGPUComputePassTimestampLocation_Beginning;
+    wgpu::ComputePassDescriptor computePassDesc;
+    computePassDesc.label = "GPU timeline end";
+    computePassDesc.timestampWriteCount = 1;
+    computePassDesc.timestampWrites = &timestampWrite;
+    wgpu::ComputePassEncoder pass = encoder.beginComputePass(computePassDesc);
+    pass.end();
+    pass.release();
+    const uint64_t byteSize = queryCount * sizeof(uint64_t);
+    encoder.resolveQuerySet(m_querySet, 0, queryCount, m_resolveBuffer, 0);
+    encoder.copyBufferToBuffer(m_resolveBuffer, 0, readback.buffer, 0, byteSize);
+    m_context.submit(encoder);
+
+    // Nothing of the frame was recorded before beginFrame(), so the GPU
+    // cannot have started it earlier
+    readback.frameBegin = m_frameBegin;
+    readback.names = m_names;
+    readback.pending = true;
+    readback.mapCallback = readback.buffer.mapAsync(wgpu::MapMode::Read, 0, byteSize, [this, &readback, byteSize](wgpu::BufferMapAsyncStatus status) {
+        if (status == wgpu::BufferMapAsyncStatus::Success) {
+            readTimestamps(readback, static_cast<const uint64_t*>(readback.buffer.getConstMappedRange(0, byteSize)));
+            readback.buffer.unmap();
+        }
+        else {
+            std::cerr << "Could not map GPU timeline readback buffer: status " << status << std::endl;
+        }
+        readback.pending = false;
+    });
+    m_nextReadback = (m_nextReadback + 1) % ReadbackCount;
+}
+
+void GpuTimeline::readTimestamps(const Readback& readback, const uint64_t* timestamps) {
+    const std::vector<const char*>& names = readback.names;
+    m_offset = std::max(m_offset, static_cast<int64_t>(readback.frameBegin) - static_cast<int64_t>(timestamps[0]));
+    m_lastFrameZones.clear();
+    for (size_t i = 0; i < names.size(); ++i) {
+        // Zero length zones are passes that did nothing on the GPU
+        if (timestamps[i + 1] <= timestamps[i]) continue;
+        m_lastFrameZones.push_back({ names[i], (timestamps[i + 1] - timestamps[i]) * 1e-6 });
+        if (Trace::enabled()) Trace::addGpuZone(names[i], timestamps[i] + m_offset, timestamps[i + 1] + m_offset);
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "ComputeRuntime.h"
+
+#include <webgpu/webgpu.hpp>
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * GPU side of Trace: timestamps written between the passes of a frame,
+ * read back asynchronously and added to the trace as GPU zones, each from
+ * one mark() to the next.
+ *
+ * A mark is an empty compute pass that writes a timestamp when it begins,
+ * so it can go between passes recorded by anyone (render graph passes,
+ * PostAntiAliasing...). Needs the TimestampQuery feature on the device;
+ * without it, or when neither the trace is started nor setEnabled(true)
+ * was called, every call does nothing.
+ *
+ * Timestamps are copied to one of ReadbackCount persistent buffers in the
+ * same encoder as their resolve; a frame is not read back when all of them
+ * are still in flight.
+ *
+ * Timestamps are taken to be in nanoseconds, and GPU zones are placed on
+ * the CPU clock so that no frame starts on the GPU before its beginFrame():
+ * the offset between the clocks is approximate, durations are not.
+ */
+class GpuTimeline {
+public:
+    struct Zone {
+        const char* name = nullptr;
+        double ms = 0.0;
+    };
+
+    static constexpr uint32_t ReadbackCount = 3;
+
+    GpuTimeline(wgpu::Device device, wgpu::Queue queue, uint32_t maxMarksPerFrame = 32);
+    ~GpuTimeline();
+    GpuTimeline(const GpuTimeline&) = delete;
+    GpuTimeline& operator=(const GpuTimeline&) = delete;
+
+    bool active() const;
+
+    /**
+     * Record even when the trace is not started, e.g. for an overlay.
+     */
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+
+    /**
+     * Zones of the last frame read back.
+     */
+    const std::vector<Zone>& lastFrameZones() const { return m_lastFrameZones; }
+
+    /**
+     * Collect the timestamps of previous frames that are ready.
+     */
+    void beginFrame();
+
+    /**
+     * The zone name starts here, and ends at the next mark.
+     */
+    void mark(wgpu::CommandEncoder encoder, const char* name);
+
+    /**
+     * Close the last zone and read the timestamps of the frame back, once
+     * everything of the frame has been submitted.
+     */
+    void endFrame();
+
+private:
+    struct Readback {
+        wgpu::Buffer buffer = nullptr;
+        std::unique_ptr<wgpu::BufferMapCallback> mapCallback;
+        bool pending = false;
+        // Of the frame being read back
+        std::vector<const char*> names;
+        uint64_t frameBegin = 0;
+    };
+
+    void readTimestamps(const Readback& readback, const uint64_t* timestamps);
+
+private:
+    wgpu::Device m_device;
+    wgpu::Queue m_queue;
+    ComputeContext m_context;
+    uint32_t m_capacity;
+    bool m_supported = false;
+    bool m_enabled = false;
+    wgpu::QuerySet m_querySet = nullptr;
+    wgpu::Buffer m_resolveBuffer = nullptr;
+    std::array<Readback, ReadbackCount> m_readbacks;
+    uint32_t m_nextReadback = 0;
+    std::vector<const char*> m_names;
+    uint64_t m_frameBegin = 0;
+    std::vector<Zone> m_lastFrameZones;
+    // Added to GPU timestamps to get CPU times
+    int64_t m_offset = INT64_MIN;
+};
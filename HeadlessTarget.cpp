@@ -0,0 +1,39 @@
+#include "HeadlessTarget.h"
+
+HeadlessTarget::HeadlessTarget(wgpu::Device device, uint32_t width, uint32_t height, wgpu::TextureFormat format)
+    : m_format(format)
+{
+    wgpu::TextureDescriptor textureDesc;
+    textureDesc.label = "Headless backbuffer";
+    textureDesc.dimension = wgpu::TextureDimension::_2D;
+    textureDesc.size = { width, height, 1 };
+    textureDesc.format = format;
+    textureDesc.mipLevelCount = 1;
+    textureDesc.sampleCount = 1;
+    // CopySrc to read frames back, as with a screenshot
+    textureDesc.usage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::CopySrc;
+    textureDesc.viewFormatCount = 0;
+    textureDesc.viewFormats = nullptr;
+    m_texture = device.createTexture(textureDesc);
+}
+
+HeadlessTarget::~HeadlessTarget() {
+    if (m_texture) {
+        m_texture.destroy();
+        m_texture.release();
+    }
+}
+
+wgpu::TextureView HeadlessTarget::getCurrentTextureView() {
+    if (!m_texture) return nullptr;
+    wgpu::TextureViewDescriptor viewDesc;
+    viewDesc.label = "Headless backbuffer view";
+    viewDesc.format = m_format;
+    viewDesc.dimension = wgpu::TextureViewDimension::_2D;
+    viewDesc.baseMipLevel = 0;
+    viewDesc.mipLevelCount = 1;
+    viewDesc.baseArrayLayer = 0;
+    viewDesc.arrayLayerCount = 1;
+    viewDesc.aspect = wgpu::TextureAspect::All;
+    return m_texture.createView(viewDesc);
+}
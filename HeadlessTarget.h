@@ -0,0 +1,33 @@
+#pragma once
+
+#include <webgpu/webgpu.hpp>
+#include <cstdint>
+
+/**
+ * Stands in for the surface and its swap chain when running without a
+ * window (--headless): frames are rendered into an offscreen texture of the
+ * same size and format, and presenting does nothing. Since nothing needs
+ * glfwGetWGPUSurface, this runs on machines without a display or a GPU
+ * (with the mock backend).
+ */
+class HeadlessTarget {
+public:
+    HeadlessTarget(wgpu::Device device, uint32_t width, uint32_t height, wgpu::TextureFormat format);
+    ~HeadlessTarget();
+    HeadlessTarget(const HeadlessTarget&) = delete;
+    HeadlessTarget& operator=(const HeadlessTarget&) = delete;
+
+    /**
+     * Same contract as SwapChain::getCurrentTextureView(): a new view, that
+     * the caller releases once the frame is encoded.
+     */
+    wgpu::TextureView getCurrentTextureView();
+    void present() { ++m_presentCount; }
+
+    uint64_t presentCount() const { return m_presentCount; }
+
+private:
+    wgpu::Texture m_texture = nullptr;
+    wgpu::TextureFormat m_format;
+    uint64_t m_presentCount = 0;
+};
@@ -0,0 +1,817 @@
+#include "ImageProcessing.h"
+
+#include "Parallel.h"
+#include "SimdLanes.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+
+// OUTPUT_FORMAT is replaced by the format of dst
+const char* imageSource = R"(
+struct Params {
+	srcSize: vec2<i32>,
+	dstSize: vec2<i32>,
+	// Unit step along a separable pass, (1, 0) or (0, 1)
+	direction: vec2<i32>,
+	radius: i32,
+	// Source pixels per destination pixel
+	scale: vec2f,
+}
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var src: texture_2d_array<f32>;
+@group(0) @binding(2) var dst: texture_storage_2d_array<OUTPUT_FORMAT, write>;
+@group(0) @binding(3) var<storage, read> weights: array<f32>;
+
+// ImageProcessor::BlurSegment, MaxBlurRadius, Tile and MaxConvolutionSize
+const segment = 256;
+const maxBlurRadius = 32;
+const tile = 16;
+const maxConvolutionRadius = 7;
+
+var<workgroup> line: array<vec4f, 320>; // segment + 2 * maxBlurRadius
+var<workgroup> block: array<vec4f, 900>; // (tile + 2 * maxConvolutionRadius)^2
+
+fn loadClamped(p: vec2<i32>, layer: i32) -> vec4f {
+	return textureLoad(src, clamp(p, vec2<i32>(0), params.srcSize - vec2<i32>(1)), layer, 0);
+}
+
+// One pass of a separable blur: each workgroup filters a segment of a row
+// (or column), from the segment and its borders loaded once
+@compute @workgroup_size(256)
+fn blur(@builtin(local_invocation_index) localIndex: u32, @builtin(workgroup_id) group: vec3<u32>) {
+	let along = params.direction;
+	let lineOrigin = (vec2<i32>(1) - along) * i32(group.y);
+	let start = i32(group.x) * segment;
+	let layer = i32(group.z);
+	let r = params.radius;
+	for (var i = i32(localIndex); i < segment + 2 * r; i = i + segment) {
+		line[i] = loadClamped(lineOrigin + along * (start + i - r), layer);
+	}
+	workgroupBarrier();
+
+	let p = lineOrigin + along * (start + i32(localIndex));
+	if (any(p >= params.dstSize)) {
+		return;
+	}
+	var sum = vec4f(0.0);
+	for (var k = 0; k <= 2 * r; k = k + 1) {
+		sum = sum + weights[k] * line[i32(localIndex) + k];
+	}
+	textureStore(dst, p, layer, sum);
+}
+
+@compute @workgroup_size(16, 16)
+fn convolve(
+	@builtin(local_invocation_id) local: vec3<u32>,
+	@builtin(local_invocation_index) localIndex: u32,
+	@builtin(workgroup_id) group: vec3<u32>
+) {
+	let r = params.radius;
+	let side = tile + 2 * r;
+	let corner = vec2<i32>(group.xy) * tile;
+	let layer = i32(group.z);
+	for (var i = i32(localIndex); i < side * side; i = i + tile * tile) {
+		block[i] = loadClamped(corner - vec2<i32>(r) + vec2<i32>(i % side, i / side), layer);
+	}
+	workgroupBarrier();
+
+	let p = corner + vec2<i32>(local.xy);
+	if (any(p >= params.dstSize)) {
+		return;
+	}
+	let size = 2 * r + 1;
+	var sum = vec4f(0.0);
+	for (var j = 0; j < size; j = j + 1) {
+		for (var i = 0; i < size; i = i + 1) {
+			sum = sum + weights[j * size + i] * block[(i32(local.y) + j) * side + i32(local.x) + i];
+		}
+	}
+	textureStore(dst, p, layer, sum);
+}
+
+fn lanczos(x: f32) -> f32 {
+	if (abs(x) < 1e-6) {
+		return 1.0;
+	}
+	if (abs(x) >= 3.0) {
+		return 0.0;
+	}
+	let px = 3.14159265 * x;
+	return 3.0 * sin(px) * sin(px / 3.0) / (px * px);
+}
+
+// One pass of a separable Lanczos resize. Not tiled: the number of taps
+// depends on the scale.
+@compute @workgroup_size(16, 16)
+fn resizeLanczos(@builtin(global_invocation_id) id: vec3<u32>) {
+	let p = vec2<i32>(id.xy);
+	let layer = i32(id.z);
+	if (any(p >= params.dstSize)) {
+		return;
+	}
+	let along = params.direction;
+	let scale = dot(params.scale, vec2f(along));
+	let center = (f32(dot(p, along)) + 0.5) * scale - 0.5;
+	let filterScale = max(scale, 1.0);
+	let support = 3.0 * filterScale;
+	let first = i32(ceil(center - support));
+	let last = i32(floor(center + support));
+	let lineOrigin = p * (vec2<i32>(1) - along);
+	var sum = vec4f(0.0);
+	var total = 0.0;
+	for (var i = first; i <= last; i = i + 1) {
+		let w = lanczos((f32(i) - center) / filterScale);
+		sum = sum + w * loadClamped(lineOrigin + along * i, layer);
+		total = total + w;
+	}
+	textureStore(dst, p, layer, sum / total);
+}
+
+@compute @workgroup_size(16, 16)
+fn resizeBilinear(@builtin(global_invocation_id) id: vec3<u32>) {
+	let p = vec2<i32>(id.xy);
+	let layer = i32(id.z);
+	if (any(p >= params.dstSize)) {
+		return;
+	}
+	let s = max((vec2f(p) + 0.5) * params.scale - 0.5, vec2f(0.0));
+	let p0 = vec2<i32>(floor(s));
+	let f = s - floor(s);
+	let top = loadClamped(p0, layer) * (1.0 - f.x) + loadClamped(p0 + vec2<i32>(1, 0), layer) * f.x;
+	let bottom = loadClamped(p0 + vec2<i32>(0, 1), layer) * (1.0 - f.x) + loadClamped(p0 + vec2<i32>(1, 1), layer) * f.x;
+	textureStore(dst, p, layer, top * (1.0 - f.y) + bottom * f.y);
+}
+)";
+
+void replaceAll(std::string& source, const std::string& placeholder, const std::string& text) {
+    for (size_t pos = source.find(placeholder); pos != std::string::npos; pos = source.find(placeholder, pos)) {
+        source.replace(pos, placeholder.size(), text);
+        pos += text.size();
+    }
+}
+
+uint32_t divideRoundingUp(uint32_t a, uint32_t b) {
+    return (a + b - 1) / b;
+}
+
+// The four channels of a pixel, in one SSE2 register when available
+struct Pixel {
+#ifdef COMPUTE_SSE2
+    using L = Lanes<float>;
+    L::V v;
+
+    static Pixel zero() { return { L::broadcast(0.0f) }; }
+    static Pixel load(const float* p) { return { L::load(p) }; }
+    void store(float* p) const { L::store(p, v); }
+    void addScaled(const Pixel& p, float w) { v = L::add(v, L::mul(p.v, L::broadcast(w))); }
+    void scale(float w) { v = L::mul(v, L::broadcast(w)); }
+#else
+    float v[4];
+
+    static Pixel zero() { return { { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+    static Pixel load(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+    void store(float* p) const { std::memcpy(p, v, sizeof(v)); }
+    void addScaled(const Pixel& p, float w) { for (int c = 0; c < 4; ++c) v[c] += p.v[c] * w; }
+    void scale(float w) { for (int c = 0; c < 4; ++c) v[c] *= w; }
+#endif
+};
+
+// Rows are the unit of work of the CPU passes
+constexpr size_t minRowsPerChunk = 16;
+
+std::vector<float> toFloat(const uint8_t* pixels, size_t pixelCount) {
+    std::vector<float> result(pixelCount * 4);
+    parallelChunks(pixelCount * 4, 1 << 18, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) result[i] = pixels[i] / 255.0f;
+    });
+    return result;
+}
+
+void toBytes(const float* values, uint8_t* pixels, size_t pixelCount) {
+    parallelChunks(pixelCount * 4, 1 << 18, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            float value = std::min(std::max(values[i], 0.0f), 1.0f);
+            pixels[i] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+        }
+    });
+}
+
+int clampIndex(int i, int size) {
+    return std::min(std::max(i, 0), size - 1);
+}
+
+// Weights of the source pixels, starting at first, that make one output
+// pixel of a separable pass
+struct Taps {
+    int first = 0;
+    std::vector<float> weights;
+};
+
+float lanczos(float x) {
+    if (std::abs(x) < 1e-6f) return 1.0f;
+    if (std::abs(x) >= 3.0f) return 0.0f;
+    const float px = 3.14159265f * x;
+    return 3.0f * std::sin(px) * std::sin(px / 3.0f) / (px * px);
+}
+
+std::vector<Taps> lanczosTaps(uint32_t srcSize, uint32_t dstSize) {
+    const float scale = float(srcSize) / float(dstSize);
+    const float filterScale = std::max(scale, 1.0f);
+    const float support = 3.0f * filterScale;
+    std::vector<Taps> taps(dstSize);
+    for (uint32_t o = 0; o < dstSize; ++o) {
+        const float center = (float(o) + 0.5f) * scale - 0.5f;
+        const int first = static_cast<int>(std::ceil(center - support));
+        const int last = static_cast<int>(std::floor(center + support));
+        float total = 0.0f;
+        taps[o].first = first;
+        for (int i = first; i <= last; ++i) {
+            float w = lanczos((float(i) - center) / filterScale);
+            taps[o].weights.push_back(w);
+            total += w;
+        }
+        for (float& w : taps[o].weights) w /= total;
+    }
+    return taps;
+}
+
+std::vector<Taps> blurTaps(uint32_t size, const std::vector<float>& weights) {
+    const int radius = static_cast<int>(weights.size() / 2);
+    std::vector<Taps> taps(size);
+    for (uint32_t o = 0; o < size; ++o) {
+        taps[o].first = static_cast<int>(o) - radius;
+        taps[o].weights = weights;
+    }
+    return taps;
+}
+
+// in: layerCount images of srcWidth x height, out: of taps.size() x height
+void filterRows(const float* in, uint32_t srcWidth, uint32_t height, uint32_t layerCount, const std::vector<Taps>& taps, float* out) {
+    const uint32_t dstWidth = static_cast<uint32_t>(taps.size());
+    parallelChunks(size_t(layerCount) * height, minRowsPerChunk, [&](size_t, size_t begin, size_t end) {
+        for (size_t row = begin; row < end; ++row) {
+            const float* inRow = in + row * srcWidth * 4;
+            float* outRow = out + row * dstWidth * 4;
+            for (uint32_t x = 0; x < dstWidth; ++x) {
+                const Taps& t = taps[x];
+                Pixel sum = Pixel::zero();
+                for (size_t k = 0; k < t.weights.size(); ++k) {
+                    int sx = clampIndex(t.first + static_cast<int>(k), static_cast<int>(srcWidth));
+                    sum.addScaled(Pixel::load(inRow + sx * 4), t.weights[k]);
+                }
+                sum.store(outRow + x * 4);
+            }
+        }
+    });
+}
+
+// in: layerCount images of width x srcHeight, out: of width x taps.size()
+void filterColumns(const float* in, uint32_t width, uint32_t srcHeight, uint32_t layerCount, const std::vector<Taps>& taps, float* out) {
+    const uint32_t dstHeight = static_cast<uint32_t>(taps.size());
+    parallelChunks(size_t(layerCount) * dstHeight, minRowsPerChunk, [&](size_t, size_t begin, size_t end) {
+        for (size_t row = begin; row < end; ++row) {
+            const size_t layer = row / dstHeight;
+            const Taps& t = taps[row % dstHeight];
+            const float* inLayer = in + layer * width * srcHeight * 4;
+            float* outRow = out + row * width * 4;
+            // Row by row of the source, so that memory is read in order
+            for (uint32_t x = 0; x < width; ++x) Pixel::zero().store(outRow + x * 4);
+            for (size_t k = 0; k < t.weights.size(); ++k) {
+                int sy = clampIndex(t.first + static_cast<int>(k), static_cast<int>(srcHeight));
+                const float* inRow = inLayer + size_t(sy) * width * 4;
+                for (uint32_t x = 0; x < width; ++x) {
+                    Pixel sum = Pixel::load(outRow + x * 4);
+                    sum.addScaled(Pixel::load(inRow + x * 4), t.weights[k]);
+                    sum.store(outRow + x * 4);
+                }
+            }
+        }
+    });
+}
+
+} // namespace
+
+// ImageBatch
+
+ImageBatch::ImageBatch(ComputeContext& context, uint32_t width, uint32_t height, uint32_t layerCount)
+    : m_context(context)
+    , m_width(width)
+    , m_height(height)
+    , m_layerCount(layerCount)
+{
+    assert(width > 0 && height > 0 && layerCount > 0);
+    if (!context.hasGpu()) {
+        m_host.resize(layerCount * layerByteSize());
+        return;
+    }
+
+    wgpu::TextureDescriptor textureDesc;
+    textureDesc.label = "Image batch";
+    textureDesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::StorageBinding
+        | wgpu::TextureUsage::CopySrc | wgpu::TextureUsage::CopyDst;
+    textureDesc.dimension = wgpu::TextureDimension::_2D;
+    textureDesc.size = { width, height, layerCount };
+    textureDesc.format = wgpu::TextureFormat::RGBA8Unorm;
+    textureDesc.mipLevelCount = 1;
+    textureDesc.sampleCount = 1;
+    textureDesc.viewFormatCount = 0;
+    textureDesc.viewFormats = nullptr;
+    m_texture = context.device().createTexture(textureDesc);
+
+    wgpu::TextureViewDescriptor viewDesc;
+    viewDesc.label = "Image batch view";
+    viewDesc.format = wgpu::TextureFormat::RGBA8Unorm;
+    viewDesc.dimension = wgpu::TextureViewDimension::_2DArray;
+    viewDesc.baseMipLevel = 0;
+    viewDesc.mipLevelCount = 1;
+    viewDesc.baseArrayLayer = 0;
+    viewDesc.arrayLayerCount = layerCount;
+    viewDesc.aspect = wgpu::TextureAspect::All;
+    m_view = m_texture.createView(viewDesc);
+}
+
+ImageBatch::~ImageBatch() {
+    if (!m_texture) return;
+    m_view.release();
+    m_texture.destroy();
+    m_texture.release();
+}
+
+void ImageBatch::upload(uint32_t layer, const uint8_t* pixels) {
+    assert(layer < m_layerCount);
+    if (!m_context.hasGpu()) {
+        std::memcpy(hostLayer(layer), pixels, layerByteSize());
+        return;
+    }
+
+    wgpu::ImageCopyTexture destination = wgpu::Default;
+    destination.texture = m_texture;
+    destination.mipLevel = 0;
+    destination.origin = { 0, 0, layer };
+    destination.aspect = wgpu::TextureAspect::All;
+    wgpu::TextureDataLayout layout = wgpu::Default;
+    layout.offset = 0;
+    layout.bytesPerRow = m_width * 4;
+    layout.rowsPerImage = m_height;
+    m_context.queue().writeTexture(destination, pixels, layerByteSize(), layout, { m_width, m_height, 1 });
+}
+
+std::vector<uint8_t> ImageBatch::download(uint32_t layer) const {
+    assert(layer < m_layerCount);
+    std::vector<uint8_t> pixels(layerByteSize());
+    if (!m_context.hasGpu()) {
+        std::memcpy(pixels.data(), hostLayer(layer), layerByteSize());
+        return pixels;
+    }
+
+    // Buffer copies of textures need rows aligned to 256 bytes
+    const uint32_t rowBytes = m_width * 4;
+    const uint32_t paddedRowBytes = (rowBytes + 255) / 256 * 256;
+    wgpu::BufferDescriptor bufferDesc;
+    bufferDesc.label = "Image batch readback";
+    bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::CopySrc;
+    bufferDesc.size = uint64_t(paddedRowBytes) * m_height;
+    bufferDesc.mappedAtCreation = false;
+    wgpu::Buffer buffer = m_context.device().createBuffer(bufferDesc);
+
+    wgpu::ImageCopyTexture source = wgpu::Default;
+    source.texture = m_texture;
+    source.mipLevel = 0;
+    source.origin = { 0, 0, layer };
+    source.aspect = wgpu::TextureAspect::All;
+    wgpu::ImageCopyBuffer destination = wgpu::Default;
+    destination.buffer = buffer;
+    destination.layout.offset = 0;
+    destination.layout.bytesPerRow = paddedRowBytes;
+    destination.layout.rowsPerImage = m_height;
+    wgpu::CommandEncoder encoder = m_context.createEncoder("Image batch readback");
+    encoder.copyTextureToBuffer(source, destination, { m_width, m_height, 1 });
+    m_context.submit(encoder);
+
+    m_context.readAsync(buffer, 0, bufferDesc.size, [&](const void* data) {
+        if (!data) return;
+        for (uint32_t y = 0; y < m_height; ++y) {
+            std::memcpy(pixels.data() + size_t(y) * rowBytes, static_cast<const uint8_t*>(data) + size_t(y) * paddedRowBytes, rowBytes);
+        }
+    });
+    m_context.wait();
+    buffer.destroy();
+    buffer.release();
+    return pixels;
+}
+
+// ImageProcessor
+
+ImageProcessor::ImageProcessor(ComputeContext& context)
+    : m_context(context)
+{
+    if (!context.hasGpu()) return;
+    for (auto& params : m_params) {
+        params = std::make_unique<GpuArray<Params>>(context, 1, WGPUBufferUsage_Uniform);
+    }
+    m_blurWeights = std::make_unique<GpuArray<float>>(context, 2 * MaxBlurRadius + 1);
+    m_convolutionWeights = std::make_unique<GpuArray<float>>(context, MaxConvolutionSize * MaxConvolutionSize);
+    createPipelines();
+}
+
+ImageProcessor::~ImageProcessor() {
+    if (!m_context.hasGpu()) return;
+    releaseScratch(m_blurScratch);
+    releaseScratch(m_resizeScratch);
+    for (wgpu::ComputePipeline pipeline : { m_blurToScratch, m_blurToImage, m_convolve, m_lanczosToScratch, m_lanczosToImage, m_bilinear }) {
+        pipeline.release();
+    }
+    for (int output = 0; output < OutputCount; ++output) {
+        m_pipelineLayouts[output].release();
+        m_bindGroupLayouts[output].release();
+        m_shaderModules[output].release();
+    }
+}
+
+void ImageProcessor::createPipelines() {
+    wgpu::Device device = m_context.device();
+    const char* formatNames[OutputCount] = { "rgba8unorm", "rgba16float" };
+    const wgpu::TextureFormat formats[OutputCount] = { wgpu::TextureFormat::RGBA8Unorm, wgpu::TextureFormat::RGBA16Float };
+
+    for (int output = 0; output < OutputCount; ++output) {
+        std::string source = imageSource;
+        replaceAll(source, "OUTPUT_FORMAT", formatNames[output]);
+        wgpu::ShaderModuleWGSLDescriptor shaderCodeDesc;
+        shaderCodeDesc.chain.next = nullptr;
+        shaderCodeDesc.chain.sType = wgpu::SType::ShaderModuleWGSLDescriptor;
+        shaderCodeDesc.code = source.c_str();
+        wgpu::ShaderModuleDescriptor shaderDesc;
+        shaderDesc.nextInChain = &shaderCodeDesc.chain;
+        shaderDesc.label = "Image processing shader";
+        shaderDesc.hintCount = 0;
+        shaderDesc.hints = nullptr;
+        m_shaderModules[output] = device.createShaderModule(shaderDesc);
+
+        std::vector<wgpu::BindGroupLayoutEntry> bindingLayouts(4, wgpu::Default);
+        for (uint32_t i = 0; i < bindingLayouts.size(); ++i) {
+            bindingLayouts[i].binding = i;
+            bindingLayouts[i].visibility = wgpu::ShaderStage::Compute;
+        }
+        bindingLayouts[0].buffer.type = wgpu::BufferBindingType::Uniform;
+        // Read with textureLoad, so RGBA16F scratch textures work as well
+        bindingLayouts[1].texture.sampleType = wgpu::TextureSampleType::UnfilterableFloat;
+        bindingLayouts[1].texture.viewDimension = wgpu::TextureViewDimension::_2DArray;
+        bindingLayouts[2].storageTexture.access = wgpu::StorageTextureAccess::WriteOnly;
+        bindingLayouts[2].storageTexture.format = formats[output];
+        bindingLayouts[2].storageTexture.viewDimension = wgpu::TextureViewDimension::_2DArray;
+        bindingLayouts[3].buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+        wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc;
+        bindGroupLayoutDesc.label = "Image processing bind group layout";
+        bindGroupLayoutDesc.entryCount = static_cast<uint32_t>(bindingLayouts.size());
+        bindGroupLayoutDesc.entries = bindingLayouts.data();
+        m_bindGroupLayouts[output] = device.createBindGroupLayout(bindGroupLayoutDesc);
+
+        wgpu::PipelineLayoutDescriptor pipelineLayoutDesc;
+        pipelineLayoutDesc.label = "Image processing pipeline layout";
+        pipelineLayoutDesc.bindGroupLayoutCount = 1;
+        pipelineLayoutDesc.bindGroupLayouts = reinterpret_cast<WGPUBindGroupLayout*>(&m_bindGroupLayouts[output]);
+        m_pipelineLayouts[output] = device.createPipelineLayout(pipelineLayoutDesc);
+    }
+
+    m_blurToScratch = createPipeline(OutputRgba16Float, "blur", "Blur rows");
+    m_blurToImage = createPipeline(OutputRgba8, "blur", "Blur columns");
+    m_convolve = createPipeline(OutputRgba8, "convolve", "Convolution");
+    m_lanczosToScratch = createPipeline(OutputRgba16Float, "resizeLanczos", "Lanczos resize rows");
+    m_lanczosToImage = createPipeline(OutputRgba8, "resizeLanczos", "Lanczos resize columns");
+    m_bilinear = createPipeline(OutputRgba8, "resizeBilinear", "Bilinear resize");
+}
+
+wgpu::ComputePipeline ImageProcessor::createPipeline(Output output, const char* entryPoint, const char* label) {
+    wgpu::ComputePipelineDescriptor pipelineDesc;
+    pipelineDesc.label = label;
+    pipelineDesc.layout = m_pipelineLayouts[output];
+    pipelineDesc.compute.module = m_shaderModules[output];
+    pipelineDesc.compute.entryPoint = entryPoint;
+    pipelineDesc.compute.constantCount = 0;
+    pipelineDesc.compute.constants = nullptr;
+    return m_context.device().createComputePipeline(pipelineDesc);
+}
+
+void ImageProcessor::ensureScratch(Scratch& scratch, uint32_t width, uint32_t height, uint32_t layerCount) {
+    if (scratch.texture && scratch.width == width && scratch.height == height && scratch.layerCount == layerCount) return;
+    releaseScratch(scratch);
+
+    wgpu::TextureDescriptor textureDesc;
+    textureDesc.label = "Image processing scratch";
+    textureDesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::StorageBinding;
+    textureDesc.dimension = wgpu::TextureDimension::_2D;
+    textureDesc.size = { width, height, layerCount };
+    textureDesc.format = wgpu::TextureFormat::RGBA16Float;
+    textureDesc.mipLevelCount = 1;
+    textureDesc.sampleCount = 1;
+    textureDesc.viewFormatCount = 0;
+    textureDesc.viewFormats = nullptr;
+    scratch.texture = m_context.device().createTexture(textureDesc);
+
+    wgpu::TextureViewDescriptor viewDesc;
+    viewDesc.label = "Image processing scratch view";
+    viewDesc.format = wgpu::TextureFormat::RGBA16Float;
+    viewDesc.dimension = wgpu::TextureViewDimension::_2DArray;
+    viewDesc.baseMipLevel = 0;
+    viewDesc.mipLevelCount = 1;
+    viewDesc.baseArrayLayer = 0;
+    viewDesc.arrayLayerCount = layerCount;
+    viewDesc.aspect = wgpu::TextureAspect::All;
+    scratch.view = scratch.texture.createView(viewDesc);
+    scratch.width = width;
+    scratch.height = height;
+    scratch.layerCount = layerCount;
+}
+
+void ImageProcessor::releaseScratch(Scratch& scratch) {
+    if (!scratch.texture) return;
+    scratch.view.release();
+    scratch.texture.destroy();
+    scratch.texture.release();
+    scratch = Scratch();
+}
+
+void ImageProcessor::dispatch(wgpu::ComputePassEncoder pass, Stage stage, wgpu::ComputePipeline pipeline, Output output,
+    wgpu::TextureView src, wgpu::TextureView dst, GpuArray<float>& weights, uint32_t x, uint32_t y, uint32_t z)
+{
+    std::vector<wgpu::BindGroupEntry> bindings(4, wgpu::Default);
+    for (uint32_t i = 0; i < bindings.size(); ++i) bindings[i].binding = i;
+    bindings[0].buffer = m_params[stage]->buffer();
+    bindings[0].offset = 0;
+    bindings[0].size = m_params[stage]->buffer().getSize();
+    bindings[1].textureView = src;
+    bindings[2].textureView = dst;
+    bindings[3].buffer = weights.buffer();
+    bindings[3].offset = 0;
+    bindings[3].size = weights.buffer().getSize();
+    wgpu::BindGroupDescriptor bindGroupDesc;
+    bindGroupDesc.label = "Image processing bind group";
+    bindGroupDesc.layout = m_bindGroupLayouts[output];
+    bindGroupDesc.entryCount = static_cast<uint32_t>(bindings.size());
+    bindGroupDesc.entries = bindings.data();
+    // Views change with every batch, and the pass keeps what it uses alive
+    wgpu::BindGroup bindGroup = m_context.device().createBindGroup(bindGroupDesc);
+
+    pass.setPipeline(pipeline);
+    pass.setBindGroup(0, bindGroup, 0, nullptr);
+    pass.dispatchWorkgroups(x, y, z);
+    bindGroup.release();
+}
+
+bool ImageProcessor::checkBatches(const char* operation, const ImageBatch& src, const ImageBatch& dst, bool sameSize) const {
+    if (src.layerCount() != dst.layerCount()) {
+        std::cerr << "ImageProcessor: " << operation << " of " << src.layerCount() << " images into " << dst.layerCount() << std::endl;
+        return false;
+    }
+    if (sameSize && (src.width() != dst.width() || src.height() != dst.height())) {
+        std::cerr << "ImageProcessor: " << operation << " needs images of the same size" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ImageProcessor::encodeBlur(wgpu::ComputePassEncoder pass, ImageBatch& src, ImageBatch& dst, float sigma) {
+    assert(m_context.hasGpu());
+    if (!checkBatches("blur", src, dst, true)) return false;
+
+    std::vector<float> weights = gaussianWeights(sigma);
+    m_blurWeights->upload(weights.data(), weights.size());
+    ensureScratch(m_blurScratch, src.width(), src.height(), src.layerCount());
+
+    const int32_t width = static_cast<int32_t>(src.width());
+    const int32_t height = static_cast<int32_t>(src.height());
+    Params params = {};
+    params.srcSize[0] = params.dstSize[0] = width;
+    params.srcSize[1] = params.dstSize[1] = height;
+    params.radius = static_cast<int32_t>(weights.size() / 2);
+    params.direction[0] = 1;
+    m_params[BlurRows]->upload(&params, 1);
+    params.direction[0] = 0;
+    params.direction[1] = 1;
+    m_params[BlurColumns]->upload(&params, 1);
+
+    dispatch(pass, BlurRows, m_blurToScratch, OutputRgba16Float, src.view(), m_blurScratch.view, *m_blurWeights,
+        divideRoundingUp(src.width(), BlurSegment), src.height(), src.layerCount());
+    dispatch(pass, BlurColumns, m_blurToImage, OutputRgba8, m_blurScratch.view, dst.view(), *m_blurWeights,
+        divideRoundingUp(src.height(), BlurSegment), src.width(), src.layerCount());
+    return true;
+}
+
+bool ImageProcessor::encodeConvolve(wgpu::ComputePassEncoder pass, ImageBatch& src, ImageBatch& dst, const std::vector<float>& weights, uint32_t size) {
+    assert(m_context.hasGpu());
+    assert(size % 2 == 1 && size <= MaxConvolutionSize && weights.size() == size * size);
+    if (!checkBatches("convolution", src, dst, true)) return false;
+
+    m_convolutionWeights->upload(weights.data(), weights.size());
+    Params params = {};
+    params.srcSize[0] = params.dstSize[0] = static_cast<int32_t>(src.width());
+    params.srcSize[1] = params.dstSize[1] = static_cast<int32_t>(src.height());
+    params.radius = static_cast<int32_t>(size / 2);
+    m_params[Convolution]->upload(&params, 1);
+
+    dispatch(pass, Convolution, m_convolve, OutputRgba8, src.view(), dst.view(), *m_convolutionWeights,
+        divideRoundingUp(src.width(), Tile), divideRoundingUp(src.height(), Tile), src.layerCount());
+    return true;
+}
+
+bool ImageProcessor::encodeResize(wgpu::ComputePassEncoder pass, ImageBatch& src, ImageBatch& dst, ResizeFilter filter) {
+    assert(m_context.hasGpu());
+    if (!checkBatches("resize", src, dst, false)) return false;
+
+    Params params = {};
+    params.srcSize[0] = static_cast<int32_t>(src.width());
+    params.srcSize[1] = static_cast<int32_t>(src.height());
+    params.scale[0] = float(src.width()) / float(dst.width());
+    params.scale[1] = float(src.height()) / float(dst.height());
+
+    if (filter == ResizeFilter::Bilinear) {
+        params.dstSize[0] = static_cast<int32_t>(dst.width());
+        params.dstSize[1] = static_cast<int32_t>(dst.height());
+        m_params[Bilinear]->upload(&params, 1);
+        dispatch(pass, Bilinear, m_bilinear, OutputRgba8, src.view(), dst.view(), *m_blurWeights,
+            divideRoundingUp(dst.width(), Tile), divideRoundingUp(dst.height(), Tile), src.layerCount());
+        return true;
+    }
+
+    // Rows first, into dst.width() x src.height()
+    ensureScratch(m_resizeScratch, dst.width(), src.height(), src.layerCount());
+    params.dstSize[0] = static_cast<int32_t>(dst.width());
+    params.dstSize[1] = static_cast<int32_t>(src.height());
+    params.direction[0] = 1;
+    m_params[LanczosRows]->upload(&params, 1);
+    params.srcSize[0] = static_cast<int32_t>(dst.width());
+    params.dstSize[1] = static_cast<int32_t>(dst.height());
+    params.direction[0] = 0;
+    params.direction[1] = 1;
+    m_params[LanczosColumns]->upload(&params, 1);
+
+    dispatch(pass, LanczosRows, m_lanczosToScratch, OutputRgba16Float, src.view(), m_resizeScratch.view, *m_blurWeights,
+        divideRoundingUp(dst.width(), Tile), divideRoundingUp(src.height(), Tile), src.layerCount());
+    dispatch(pass, LanczosColumns, m_lanczosToImage, OutputRgba8, m_resizeScratch.view, dst.view(), *m_blurWeights,
+        divideRoundingUp(dst.width(), Tile), divideRoundingUp(dst.height(), Tile), src.layerCount());
+    return true;
+}
+
+bool ImageProcessor::blur(ImageBatch& src, ImageBatch& dst, float sigma) {
+    if (!m_context.hasGpu()) {
+        if (!checkBatches("blur", src, dst, true)) return false;
+        blurCpu(src.hostLayer(0), dst.hostLayer(0), src.width(), src.height(), src.layerCount(), sigma);
+        return true;
+    }
+
+    wgpu::CommandEncoder encoder = m_context.createEncoder("Blur");
+    wgpu::ComputePassDescriptor computePassDesc;
+    computePassDesc.label = "Blur";
+    computePassDesc.timestampWriteCount = 0;
+    computePassDesc.timestampWrites = nullptr;
+    wgpu::ComputePassEncoder pass = encoder.beginComputePass(computePassDesc);
+    bool ok = encodeBlur(pass, src, dst, sigma);
+    pass.end();
+    pass.release();
+    m_context.submit(encoder);
+    return ok;
+}
+
+bool ImageProcessor::convolve(ImageBatch& src, ImageBatch& dst, const std::vector<float>& weights, uint32_t size) {
+    if (!m_context.hasGpu()) {
+        if (!checkBatches("convolution", src, dst, true)) return false;
+        convolveCpu(src.hostLayer(0), dst.hostLayer(0), src.width(), src.height(), src.layerCount(), weights, size);
+        return true;
+    }
+
+    wgpu::CommandEncoder encoder = m_context.createEncoder("Convolution");
+    wgpu::ComputePassDescriptor computePassDesc;
+    computePassDesc.label = "Convolution";
+    computePassDesc.timestampWriteCount = 0;
+    computePassDesc.timestampWrites = nullptr;
+    wgpu::ComputePassEncoder pass = encoder.beginComputePass(computePassDesc);
+    bool ok = encodeConvolve(pass, src, dst, weights, size);
+    pass.end();
+    pass.release();
+    m_context.submit(encoder);
+    return ok;
+}
+
+bool ImageProcessor::resize(ImageBatch& src, ImageBatch& dst, ResizeFilter filter) {
+    if (!m_context.hasGpu()) {
+        if (!checkBatches("resize", src, dst, false)) return false;
+        resizeCpu(src.hostLayer(0), src.width(), src.height(), dst.hostLayer(0), dst.width(), dst.height(), src.layerCount(), filter);
+        return true;
+    }
+
+    wgpu::CommandEncoder encoder = m_context.createEncoder("Resize");
+    wgpu::ComputePassDescriptor computePassDesc;
+    computePassDesc.label = "Resize";
+    computePassDesc.timestampWriteCount = 0;
+    computePassDesc.timestampWrites = nullptr;
+    wgpu::ComputePassEncoder pass = encoder.beginComputePass(computePassDesc);
+    bool ok = encodeResize(pass, src, dst, filter);
+    pass.end();
+    pass.release();
+    m_context.submit(encoder);
+    return ok;
+}
+
+std::vector<float> ImageProcessor::gaussianWeights(float sigma) {
+    const int radius = std::min(static_cast<int>(std::ceil(3.0f * std::max(sigma, 0.0f))), static_cast<int>(MaxBlurRadius));
+    std::vector<float> weights(2 * radius + 1);
+    if (radius == 0) {
+        weights[0] = 1.0f;
+        return weights;
+    }
+    float total = 0.0f;
+    for (int i = -radius; i <= radius; ++i) {
+        weights[i + radius] = std::exp(-0.5f * float(i * i) / (sigma * sigma));
+        total += weights[i + radius];
+    }
+    for (float& w : weights) w /= total;
+    return weights;
+}
+
+void ImageProcessor::blurCpu(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, uint32_t layerCount, float sigma) {
+    const size_t pixelCount = size_t(width) * height * layerCount;
+    const std::vector<float> weights = gaussianWeights(sigma);
+    std::vector<float> in = toFloat(src, pixelCount);
+    std::vector<float> rows(pixelCount * 4);
+    filterRows(in.data(), width, height, layerCount, blurTaps(width, weights), rows.data());
+    filterColumns(rows.data(), width, height, layerCount, blurTaps(height, weights), in.data());
+    toBytes(in.data(), dst, pixelCount);
+}
+
+void ImageProcessor::convolveCpu(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, uint32_t layerCount, const std::vector<float>& weights, uint32_t size) {
+    assert(size % 2 == 1 && weights.size() == size * size);
+    const size_t pixelCount = size_t(width) * height * layerCount;
+    const int radius = static_cast<int>(size / 2);
+    std::vector<float> in = toFloat(src, pixelCount);
+    std::vector<float> out(pixelCount * 4);
+    parallelChunks(size_t(layerCount) * height, minRowsPerChunk, [&](size_t, size_t begin, size_t end) {
+        for (size_t row = begin; row < end; ++row) {
+            const float* inLayer = in.data() + (row / height) * width * height * 4;
+            const int y = static_cast<int>(row % height);
+            for (uint32_t x = 0; x < width; ++x) {
+                Pixel sum = Pixel::zero();
+                for (int j = 0; j < int(size); ++j) {
+                    const float* inRow = inLayer + size_t(clampIndex(y + j - radius, int(height))) * width * 4;
+                    for (int i = 0; i < int(size); ++i) {
+                        int sx = clampIndex(int(x) + i - radius, int(width));
+                        sum.addScaled(Pixel::load(inRow + sx * 4), weights[j * size + i]);
+                    }
+                }
+                sum.store(out.data() + (row * width + x) * 4);
+            }
+        }
+    });
+    toBytes(out.data(), dst, pixelCount);
+}
+
+void ImageProcessor::resizeCpu(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, uint32_t dstWidth, uint32_t dstHeight, uint32_t layerCount, ResizeFilter filter) {
+    std::vector<float> in = toFloat(src, size_t(srcWidth) * srcHeight * layerCount);
+    const size_t dstPixelCount = size_t(dstWidth) * dstHeight * layerCount;
+    std::vector<float> out(dstPixelCount * 4);
+
+    if (filter == ResizeFilter::Lanczos3) {
+        std::vector<float> rows(size_t(dstWidth) * srcHeight * layerCount * 4);
+        filterRows(in.data(), srcWidth, srcHeight, layerCount, lanczosTaps(srcWidth, dstWidth), rows.data());
+        filterColumns(rows.data(), dstWidth, srcHeight, layerCount, lanczosTaps(srcHeight, dstHeight), out.data());
+        toBytes(out.data(), dst, dstPixelCount);
+        return;
+    }
+
+    const float scaleX = float(srcWidth) / float(dstWidth);
+    const float scaleY = float(srcHeight) / float(dstHeight);
+    parallelChunks(size_t(layerCount) * dstHeight, minRowsPerChunk, [&](size_t, size_t begin, size_t end) {
+        for (size_t row = begin; row < end; ++row) {
+            const float* inLayer = in.data() + (row / dstHeight) * srcWidth * srcHeight * 4;
+            const float sy = std::max((float(row % dstHeight) + 0.5f) * scaleY - 0.5f, 0.0f);
+            const int y0 = static_cast<int>(std::floor(sy));
+            const float fy = sy - std::floor(sy);
+            const float* row0 = inLayer + size_t(clampIndex(y0, int(srcHeight))) * srcWidth * 4;
+            const float* row1 = inLayer + size_t(clampIndex(y0 + 1, int(srcHeight))) * srcWidth * 4;
+            for (uint32_t x = 0; x < dstWidth; ++x) {
+                const float sx = std::max((float(x) + 0.5f) * scaleX - 0.5f, 0.0f);
+                const int x0 = static_cast<int>(std::floor(sx));
+                const float fx = sx - std::floor(sx);
+                const int ix0 = clampIndex(x0, int(srcWidth)) * 4;
+                const int ix1 = clampIndex(x0 + 1, int(srcWidth)) * 4;
+                Pixel top = Pixel::zero();
+                top.addScaled(Pixel::load(row0 + ix0), 1.0f - fx);
+                top.addScaled(Pixel::load(row0 + ix1), fx);
+                Pixel bottom = Pixel::zero();
+                bottom.addScaled(Pixel::load(row1 + ix0), 1.0f - fx);
+                bottom.addScaled(Pixel::load(row1 + ix1), fx);
+                Pixel result = Pixel::zero();
+                result.addScaled(top, 1.0f - fy);
+                result.addScaled(bottom, fy);
+                result.store(out.data() + (row * dstWidth + x) * 4);
+            }
+        }
+    });
+    toBytes(out.data(), dst, dstPixelCount);
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "ComputeRuntime.h"
+
+#include <webgpu/webgpu.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Same-sized RGBA8 images processed together: the layers of a 2D array
+ * texture on the GPU (TextureBinding and StorageBinding usage, so it can be
+ * read or written by ImageProcessor), or host memory in CPU mode. At most
+ * maxTextureArrayLayers (256 by default) layers.
+ */
+class ImageBatch {
+public:
+    ImageBatch(ComputeContext& context, uint32_t width, uint32_t height, uint32_t layerCount);
+    ~ImageBatch();
+    ImageBatch(const ImageBatch&) = delete;
+    ImageBatch& operator=(const ImageBatch&) = delete;
+
+    uint32_t width() const { return m_width; }
+    uint32_t height() const { return m_height; }
+    uint32_t layerCount() const { return m_layerCount; }
+    size_t layerByteSize() const { return size_t(m_width) * m_height * 4; }
+    ComputeContext& context() const { return m_context; }
+
+    /**
+     * Tightly packed rows of width RGBA8 pixels.
+     */
+    void upload(uint32_t layer, const uint8_t* pixels);
+    /**
+     * Blocking read back. In GPU mode this waits for all submitted work.
+     */
+    std::vector<uint8_t> download(uint32_t layer) const;
+
+    // GPU mode only; the view covers all the layers
+    wgpu::Texture texture() const { return m_texture; }
+    wgpu::TextureView view() const { return m_view; }
+
+    // CPU mode only
+    uint8_t* hostLayer(uint32_t layer) { return m_host.data() + layer * layerByteSize(); }
+    const uint8_t* hostLayer(uint32_t layer) const { return m_host.data() + layer * layerByteSize(); }
+
+private:
+    ComputeContext& m_context;
+    uint32_t m_width;
+    uint32_t m_height;
+    uint32_t m_layerCount;
+    wgpu::Texture m_texture = nullptr;
+    wgpu::TextureView m_view = nullptr;
+    std::vector<uint8_t> m_host;
+};
+
+enum class ResizeFilter {
+    // 2x2 taps whatever the scale: fast, but aliases when shrinking a lot
+    Bilinear,
+    // Separable windowed sinc, widened by the scale when shrinking
+    Lanczos3,
+};
+
+/**
+ * Blur, convolution and resize of every layer of an ImageBatch at once, one
+ * dispatch per pass with the layer as the z workgroup index. Edges are
+ * clamped.
+ *
+ * Blurs and convolutions are tiled: each workgroup loads its block of
+ * pixels plus the borders the filter needs into workgroup memory once, and
+ * filters from there. Separable operations (blur, Lanczos resize) go
+ * through an RGBA16F scratch texture between their two passes.
+ *
+ * In CPU mode the same calls run on host memory with the same arithmetic,
+ * four channels at a time with SSE2, over multiple threads. Results match
+ * the GPU within one unit of the 8-bit output.
+ *
+ * The parameters of each kind of operation are uploaded when it is encoded,
+ * so encode at most one of each per submit.
+ */
+class ImageProcessor {
+public:
+    // Pixels filtered by each workgroup of a blur pass
+    static constexpr uint32_t BlurSegment = 256;
+    static constexpr uint32_t MaxBlurRadius = 32;
+    // Side of the pixel blocks of convolutions and resizes
+    static constexpr uint32_t Tile = 16;
+    static constexpr uint32_t MaxConvolutionSize = 15;
+
+    explicit ImageProcessor(ComputeContext& context);
+    ~ImageProcessor();
+    ImageProcessor(const ImageProcessor&) = delete;
+    ImageProcessor& operator=(const ImageProcessor&) = delete;
+
+    /**
+     * Gaussian blur, with a radius of ceil(3 sigma) (at most MaxBlurRadius).
+     * dst must have the size and layer count of src.
+     */
+    bool encodeBlur(wgpu::ComputePassEncoder pass, ImageBatch& src, ImageBatch& dst, float sigma);
+
+    /**
+     * size x size convolution (size odd, at most MaxConvolutionSize) with
+     * row-major weights. dst must have the size and layer count of src.
+     */
+    bool encodeConvolve(wgpu::ComputePassEncoder pass, ImageBatch& src, ImageBatch& dst, const std::vector<float>& weights, uint32_t size);
+
+    /**
+     * Resize every layer of src to the size of dst.
+     */
+    bool encodeResize(wgpu::ComputePassEncoder pass, ImageBatch& src, ImageBatch& dst, ResizeFilter filter);
+
+    /**
+     * On their own: encode and submit in GPU mode (without waiting), or run
+     * on the CPU.
+     */
+    bool blur(ImageBatch& src, ImageBatch& dst, float sigma);
+    bool convolve(ImageBatch& src, ImageBatch& dst, const std::vector<float>& weights, uint32_t size);
+    bool resize(ImageBatch& src, ImageBatch& dst, ResizeFilter filter);
+
+    /**
+     * Normalized weights of the blur, 2 radius + 1 of them.
+     */
+    static std::vector<float> gaussianWeights(float sigma);
+
+    /**
+     * The CPU fallbacks, usable on any memory: layerCount tightly packed
+     * RGBA8 images.
+     */
+    static void blurCpu(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, uint32_t layerCount, float sigma);
+    static void convolveCpu(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, uint32_t layerCount, const std::vector<float>& weights, uint32_t size);
+    static void resizeCpu(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, uint32_t dstWidth, uint32_t dstHeight, uint32_t layerCount, ResizeFilter filter);
+
+private:
+    // Must match struct Params in the shader
+    struct Params {
+        int32_t srcSize[2];
+        int32_t dstSize[2];
+        int32_t direction[2];
+        int32_t radius;
+        int32_t _pad0;
+        float scale[2];
+        uint32_t _pad[2];
+    };
+
+    // One uniform buffer each, see above
+    enum Stage {
+        BlurRows,
+        BlurColumns,
+        Convolution,
+        LanczosRows,
+        LanczosColumns,
+        Bilinear,
+        StageCount,
+    };
+
+    struct Scratch {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t layerCount = 0;
+        wgpu::Texture texture = nullptr;
+        wgpu::TextureView view = nullptr;
+    };
+
+    // Which output format a pipeline writes
+    enum Output {
+        OutputRgba8,
+        OutputRgba16Float,
+        OutputCount,
+    };
+
+    void createPipelines();
+    wgpu::ComputePipeline createPipeline(Output output, const char* entryPoint, const char* label);
+    void ensureScratch(Scratch& scratch, uint32_t width, uint32_t height, uint32_t layerCount);
+    void releaseScratch(Scratch& scratch);
+    void dispatch(wgpu::ComputePassEncoder pass, Stage stage, wgpu::ComputePipeline pipeline, Output output,
+        wgpu::TextureView src, wgpu::TextureView dst, GpuArray<float>& weights, uint32_t x, uint32_t y, uint32_t z);
+    bool checkBatches(const char* operation, const ImageBatch& src, const ImageBatch& dst, bool sameSize) const;
+
+private:
+    ComputeContext& m_context;
+    wgpu::ShaderModule m_shaderModules[OutputCount] = { nullptr, nullptr };
+    wgpu::BindGroupLayout m_bindGroupLayouts[OutputCount] = { nullptr, nullptr };
+    wgpu::PipelineLayout m_pipelineLayouts[OutputCount] = { nullptr, nullptr };
+    wgpu::ComputePipeline m_blurToScratch = nullptr;
+    wgpu::ComputePipeline m_blurToImage = nullptr;
+    wgpu::ComputePipeline m_convolve = nullptr;
+    wgpu::ComputePipeline m_lanczosToScratch = nullptr;
+    wgpu::ComputePipeline m_lanczosToImage = nullptr;
+    wgpu::ComputePipeline m_bilinear = nullptr;
+
+    std::unique_ptr<GpuArray<Params>> m_params[StageCount];
+    std::unique_ptr<GpuArray<float>> m_blurWeights;
+    std::unique_ptr<GpuArray<float>> m_convolutionWeights;
+    Scratch m_blurScratch;
+    Scratch m_resizeScratch;
+};
@@ -0,0 +1,248 @@
+#include "Log.h"
+
+#include <webgpu/webgpu.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// Longer messages are truncated
+constexpr size_t MessageSize = 488;
+
+struct Slot {
+    // Vyukov's bounded queue: equals the position when the slot is free for
+    // it, position + 1 once written
+    std::atomic<uint64_t> sequence{ 0 };
+    LogLevel level = LogLevel::Info;
+    const char* source = "";
+    uint64_t timeNs = 0;
+    char text[MessageSize];
+};
+
+struct LogState {
+    std::atomic<uint32_t> level{ static_cast<uint32_t>(LogLevel::Info) };
+    std::atomic<bool> running{ false };
+    std::unique_ptr<Slot[]> slots;
+    uint64_t mask = 0;
+    std::atomic<uint64_t> enqueuePos{ 0 };
+    // Only touched by the background thread, and by stop() once it joined
+    uint64_t dequeuePos = 0;
+    std::atomic<uint64_t> dropped{ 0 };
+
+    // Guards the output, and the background thread's sleep
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    bool stopping = false;
+    std::thread thread;
+    std::ofstream file;
+    std::ostream* out = &std::clog;
+    uint32_t flushIntervalMs = 1;
+    std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+};
+
+LogState& state() {
+    // Never destroyed, so that threads still running at exit can log
+    static LogState* s = new LogState();
+    return *s;
+}
+
+uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - state().origin).count();
+}
+
+void writeLine(std::ostream& out, LogLevel level, const char* source, uint64_t timeNs, const char* text) {
+    char prefix[64];
+    std::snprintf(prefix, sizeof(prefix), "[%9.3f] %c ", timeNs * 1e-9, std::toupper(Log::levelName(level)[0]));
+    out << prefix << source << ": " << text << '\n';
+}
+
+// Claim a slot; null when the ring is full
+Slot* beginWrite(LogState& s, uint64_t& pos) {
+    pos = s.enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = s.slots[pos & s.mask];
+        uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(pos);
+        if (diff == 0) {
+            if (s.enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return &slot;
+        }
+        else if (diff < 0) {
+            return nullptr;
+        }
+        else {
+            pos = s.enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void endWrite(Slot& slot, uint64_t pos) {
+    slot.sequence.store(pos + 1, std::memory_order_release);
+}
+
+// Write out every message ready; returns how many
+size_t drain(LogState& s) {
+    size_t count = 0;
+    for (;;) {
+        Slot& slot = s.slots[s.dequeuePos & s.mask];
+        if (slot.sequence.load(std::memory_order_acquire) != s.dequeuePos + 1) break;
+        writeLine(*s.out, slot.level, slot.source, slot.timeNs, slot.text);
+        slot.sequence.store(s.dequeuePos + s.mask + 1, std::memory_order_release);
+        ++s.dequeuePos;
+        ++count;
+    }
+    if (count > 0) s.out->flush();
+    return count;
+}
+
+void flushLoop() {
+    LogState& s = state();
+    std::unique_lock<std::mutex> lock(s.mutex);
+    while (!s.stopping) {
+        drain(s);
+        s.wakeUp.wait_for(lock, std::chrono::milliseconds(s.flushIntervalMs));
+    }
+    drain(s);
+}
+
+void onWgpuLog(WGPULogLevel level, char const* message, void*) {
+    Log::write(static_cast<LogLevel>(level), "wgpu", message ? message : "");
+}
+
+} // namespace
+
+bool Log::start(const Options& options) {
+    LogState& s = state();
+    assert(!s.running);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!options.path.empty()) {
+        s.file.open(options.path);
+        if (!s.file) {
+            std::cerr << "Log: cannot write " << options.path << std::endl;
+            return false;
+        }
+        s.out = &s.file;
+    }
+
+    uint64_t capacity = 2;
+    while (capacity < options.capacity) capacity *= 2;
+    s.slots = std::make_unique<Slot[]>(capacity);
+    for (uint64_t i = 0; i < capacity; ++i) s.slots[i].sequence.store(i, std::memory_order_relaxed);
+    s.mask = capacity - 1;
+    s.enqueuePos = 0;
+    s.dequeuePos = 0;
+    s.dropped = 0;
+    s.flushIntervalMs = std::max(options.flushIntervalMs, 1u);
+    s.stopping = false;
+    setLevel(options.level);
+
+    s.thread = std::thread(flushLoop);
+    s.running.store(true, std::memory_order_release);
+    return true;
+}
+
+void Log::stop() {
+    LogState& s = state();
+    if (!s.running.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.stopping = true;
+    }
+    s.wakeUp.notify_one();
+    s.thread.join();
+
+    std::lock_guard<std::mutex> lock(s.mutex);
+    // Writers that were claiming slots as the log stopped
+    drain(s);
+    uint64_t dropped = s.dropped.load();
+    if (dropped > 0) *s.out << "Log: " << dropped << " messages dropped, the ring was full" << std::endl;
+    if (s.file.is_open()) s.file.close();
+    s.out = &std::clog;
+}
+
+void Log::setLevel(LogLevel level) {
+    state().level.store(static_cast<uint32_t>(level), std::memory_order_relaxed);
+    wgpuSetLogLevel(static_cast<WGPULogLevel>(level));
+}
+
+LogLevel Log::level() {
+    return static_cast<LogLevel>(state().level.load(std::memory_order_relaxed));
+}
+
+void Log::installWgpuCallback() {
+    wgpuSetLogCallback(onWgpuLog, nullptr);
+    wgpuSetLogLevel(static_cast<WGPULogLevel>(level()));
+}
+
+void Log::write(LogLevel level, const char* source, const char* message) {
+    writef(level, source, "%s", message);
+}
+
+void Log::writef(LogLevel level, const char* source, const char* format, ...) {
+    if (!enabled(level)) return;
+    LogState& s = state();
+    va_list args;
+    va_start(args, format);
+
+    if (!s.running.load(std::memory_order_acquire)) {
+        char text[MessageSize];
+        std::vsnprintf(text, sizeof(text), format, args);
+        va_end(args);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        writeLine(*s.out, level, source, nowNs(), text);
+        s.out->flush();
+        return;
+    }
+
+    uint64_t pos = 0;
+    Slot* slot = beginWrite(s, pos);
+    if (!slot) {
+        va_end(args);
+        s.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    slot->level = level;
+    slot->source = source;
+    slot->timeNs = nowNs();
+    std::vsnprintf(slot->text, sizeof(slot->text), format, args);
+    va_end(args);
+    endWrite(*slot, pos);
+}
+
+uint64_t Log::droppedCount() {
+    return state().dropped.load(std::memory_order_relaxed);
+}
+
+const char* Log::levelName(LogLevel level) {
+    switch (level) {
+    case LogLevel::Off: return "off";
+    case LogLevel::Error: return "error";
+    case LogLevel::Warn: return "warn";
+    case LogLevel::Info: return "info";
+    case LogLevel::Debug: return "debug";
+    case LogLevel::Trace: return "trace";
+    }
+    return "?";
+}
+
+bool Log::parseLevel(const char* name, LogLevel& level) {
+    for (LogLevel candidate : { LogLevel::Off, LogLevel::Error, LogLevel::Warn, LogLevel::Info, LogLevel::Debug, LogLevel::Trace }) {
+        if (std::strcmp(name, levelName(candidate)) == 0) {
+            level = candidate;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Same values as WGPULogLevel, so that driver messages keep their level.
+ */
+enum class LogLevel : uint32_t {
+    Off = 0,
+    Error = 1,
+    Warn = 2,
+    Info = 3,
+    Debug = 4,
+    Trace = 5,
+};
+
+/**
+ * Asynchronous log for the app, the device callbacks and the driver
+ * (wgpuSetLogCallback).
+ *
+ * Once started, write() formats into a slot of a fixed ring buffer shared by
+ * all threads and returns: no lock, no allocation, no I/O. A background
+ * thread writes the slots out. When the ring is full, messages are dropped
+ * and counted rather than making the caller wait. Before start() and after
+ * stop(), messages are written synchronously.
+ *
+ * Messages below the level are filtered out before any formatting, and the
+ * same level is given to wgpuSetLogLevel. Sources must outlive the log
+ * (string literals).
+ */
+class Log {
+public:
+    struct Options {
+        LogLevel level = LogLevel::Info;
+        // Number of messages in flight, rounded up to a power of two
+        uint32_t capacity = 1024;
+        // std::clog if empty
+        std::string path;
+        // How often the background thread looks for messages. It writes
+        // out everything that arrived meanwhile in one go: a longer interval
+        // means fewer wakeups but larger bursts, which land on whichever
+        // frame they preempt when cores are scarce
+        uint32_t flushIntervalMs = 1;
+    };
+
+    static bool start(const Options& options);
+
+    /**
+     * Write the remaining messages and stop the background thread.
+     */
+    static void stop();
+
+    static void setLevel(LogLevel level);
+    static LogLevel level();
+    static bool enabled(LogLevel level) { return level != LogLevel::Off && level <= Log::level(); }
+
+    /**
+     * Route the driver messages here, at the current level.
+     */
+    static void installWgpuCallback();
+
+    static void write(LogLevel level, const char* source, const char* message);
+    static void writef(LogLevel level, const char* source, const char* format, ...)
+#if defined(__GNUC__) || defined(__clang__)
+        __attribute__((format(printf, 3, 4)))
+#endif
+        ;
+
+    /**
+     * Messages lost to a full ring since start().
+     */
+    static uint64_t droppedCount();
+
+    static const char* levelName(LogLevel level);
+
+    /**
+     * "error", "warn", "info", "debug", "trace" or "off"; false otherwise.
+     */
+    static bool parseLevel(const char* name, LogLevel& level);
+};
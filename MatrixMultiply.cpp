@@ -0,0 +1,428 @@
+#include "MatrixMultiply.h"
+
+#include "DeviceProfile.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// STORAGE and LOAD_A/LOAD_B depend on the precision
+const char* matmulSource = R"(
+struct Params {
+	m: u32,
+	n: u32,
+	k: u32,
+}
+
+override workgroupSize: u32 = 256u;
+override tileM: u32 = 64u;
+override tileN: u32 = 64u;
+override tileK: u32 = 16u;
+override threadM: u32 = 4u;
+override threadN: u32 = 4u;
+// MatmulConfig::MaxThreadTile
+const maxThreadTile = 8u;
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var<storage, read> a: array<STORAGE>;
+@group(0) @binding(2) var<storage, read> b: array<STORAGE>;
+@group(0) @binding(3) var<storage, read_write> c: array<f32>;
+
+var<workgroup> tileA: array<f32, tileM * tileK>;
+var<workgroup> tileB: array<f32, tileK * tileN>;
+
+fn loadA(index: u32) -> f32 {
+	LOAD_A
+}
+
+fn loadB(index: u32) -> f32 {
+	LOAD_B
+}
+
+@compute @workgroup_size(workgroupSize)
+fn main(
+	@builtin(local_invocation_index) localIndex: u32,
+	@builtin(workgroup_id) workgroupId: vec3<u32>
+) {
+	let threadsN = tileN / threadN;
+	let threadRow = localIndex / threadsN;
+	let threadCol = localIndex % threadsN;
+	let rowBase = workgroupId.y * tileM;
+	let colBase = workgroupId.x * tileN;
+
+	// Loops are bounded by overrides, so they unroll once specialized and
+	// the accumulators stay in registers
+	var sums: array<f32, 64>;
+	var bValues: array<f32, 8>;
+	for (var k0 = 0u; k0 < params.k; k0 = k0 + tileK) {
+		// Cooperative loads of the tiles, zero padded at the edges
+		for (var i = localIndex; i < tileM * tileK; i = i + workgroupSize) {
+			let row = rowBase + i / tileK;
+			let col = k0 + i % tileK;
+			var value = 0.0;
+			if (row < params.m && col < params.k) {
+				value = loadA(row * params.k + col);
+			}
+			tileA[i] = value;
+		}
+		for (var i = localIndex; i < tileK * tileN; i = i + workgroupSize) {
+			let row = k0 + i / tileN;
+			let col = colBase + i % tileN;
+			var value = 0.0;
+			if (row < params.k && col < params.n) {
+				value = loadB(row * params.n + col);
+			}
+			tileB[i] = value;
+		}
+		workgroupBarrier();
+
+		for (var kk = 0u; kk < tileK; kk = kk + 1u) {
+			for (var j = 0u; j < threadN; j = j + 1u) {
+				bValues[j] = tileB[kk * tileN + threadCol * threadN + j];
+			}
+			for (var i = 0u; i < threadM; i = i + 1u) {
+				let aValue = tileA[(threadRow * threadM + i) * tileK + kk];
+				for (var j = 0u; j < threadN; j = j + 1u) {
+					sums[i * maxThreadTile + j] = fma(aValue, bValues[j], sums[i * maxThreadTile + j]);
+				}
+			}
+		}
+		workgroupBarrier();
+	}
+
+	for (var i = 0u; i < threadM; i = i + 1u) {
+		let row = rowBase + threadRow * threadM + i;
+		for (var j = 0u; j < threadN; j = j + 1u) {
+			let col = colBase + threadCol * threadN + j;
+			if (row < params.m && col < params.n) {
+				c[row * params.n + col] = sums[i * maxThreadTile + j];
+			}
+		}
+	}
+}
+)";
+
+void replaceAll(std::string& source, const std::string& placeholder, const std::string& text) {
+    for (size_t pos = source.find(placeholder); pos != std::string::npos; pos = source.find(placeholder, pos)) {
+        source.replace(pos, placeholder.size(), text);
+        pos += text.size();
+    }
+}
+
+std::string matmulSourceFor(MatmulPrecision precision) {
+    std::string source = matmulSource;
+    if (precision == MatmulPrecision::F32) {
+        replaceAll(source, "STORAGE", "f32");
+        replaceAll(source, "LOAD_A", "return a[index];");
+        replaceAll(source, "LOAD_B", "return b[index];");
+    }
+    else {
+        replaceAll(source, "STORAGE", "u32");
+        replaceAll(source, "LOAD_A", "return unpack2x16float(a[index / 2u])[index % 2u];");
+        replaceAll(source, "LOAD_B", "return unpack2x16float(b[index / 2u])[index % 2u];");
+    }
+    return source;
+}
+
+// IEEE half conversions, round to nearest even
+uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if (((bits >> 23) & 0xff) == 0xff) {
+        // Inf or NaN
+        return static_cast<uint16_t>(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+    }
+    if (exponent >= 31) return static_cast<uint16_t>(sign | 0x7c00);
+    if (exponent <= 0) {
+        if (exponent < -10) return static_cast<uint16_t>(sign);
+        // Subnormal half
+        mantissa |= 0x800000;
+        uint32_t shift = static_cast<uint32_t>(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1))) ++half;
+        return static_cast<uint16_t>(sign | half);
+    }
+    uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1fff;
+    // A carry into the exponent is the right result, up to infinity
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) ++half;
+    return static_cast<uint16_t>(sign | half);
+}
+
+float halfToFloat(uint16_t half) {
+    uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1f;
+    uint32_t mantissa = half & 0x3ff;
+    uint32_t bits;
+    if (exponent == 0x1f) {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else if (exponent != 0) {
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+    else if (mantissa == 0) {
+        bits = sign;
+    }
+    else {
+        // Subnormal half, normal float
+        exponent = 127 - 15 + 1;
+        while ((mantissa & 0x400) == 0) {
+            mantissa <<= 1;
+            --exponent;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+    }
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// c[i][j0..j1) += a[i][k] * b[k][j0..j1) over a block of rows, k and columns
+void multiplyBlock(const float* a, const float* b, float* c, uint32_t n, uint32_t k,
+    uint32_t i0, uint32_t i1, uint32_t k0, uint32_t k1, uint32_t j0, uint32_t j1)
+{
+    for (uint32_t i = i0; i < i1; ++i) {
+        float* cRow = c + size_t(i) * n;
+        for (uint32_t kk = k0; kk < k1; ++kk) {
+            const float aValue = a[size_t(i) * k + kk];
+            const float* bRow = b + size_t(kk) * n;
+            uint32_t j = j0;
+#if defined(__AVX2__)
+            const __m256 aValues = _mm256_set1_ps(aValue);
+            for (; j + 8 <= j1; j += 8) {
+                __m256 bValues = _mm256_loadu_ps(bRow + j);
+                __m256 cValues = _mm256_loadu_ps(cRow + j);
+#if defined(__FMA__)
+                cValues = _mm256_fmadd_ps(aValues, bValues, cValues);
+#else
+                cValues = _mm256_add_ps(cValues, _mm256_mul_ps(aValues, bValues));
+#endif
+                _mm256_storeu_ps(cRow + j, cValues);
+            }
+#endif
+            for (; j < j1; ++j) {
+                cRow[j] += aValue * bRow[j];
+            }
+        }
+    }
+}
+
+} // namespace
+
+// MatmulConfig
+
+bool MatmulConfig::isValid(const ComputeContext& context) const {
+    return threadM > 0 && threadN > 0 && threadM <= MaxThreadTile && threadN <= MaxThreadTile
+        && tileM % threadM == 0 && tileN % threadN == 0 && tileK > 0
+        && workgroupSize() <= context.maxComputeInvocationsPerWorkgroup()
+        && workgroupStorageSize() <= context.maxComputeWorkgroupStorageSize();
+}
+
+std::string MatmulConfig::name() const {
+    std::ostringstream name;
+    name << tileM << "x" << tileN << "x" << tileK << "/" << threadM << "x" << threadN;
+    return name.str();
+}
+
+// MatrixMultiply
+
+MatrixMultiply::MatrixMultiply(ComputeContext& context, MatmulPrecision precision)
+    : MatrixMultiply(context, precision, MatmulConfig{})
+{}
+
+MatrixMultiply::MatrixMultiply(ComputeContext& context, MatmulPrecision precision, const MatmulConfig& config)
+    : m_context(context)
+    , m_precision(precision)
+    , m_config(config)
+{
+    assert(config.isValid(context));
+    if (!context.hasGpu()) return;
+
+    KernelDesc desc;
+    desc.label = precision == MatmulPrecision::F32 ? "Matrix multiply f32" : "Matrix multiply f16";
+    desc.source = matmulSourceFor(precision);
+    desc.workgroupSize = config.workgroupSize();
+    desc.bindings = { KernelBinding::Uniform, KernelBinding::ReadOnlyStorage, KernelBinding::ReadOnlyStorage, KernelBinding::Storage };
+    desc.constants = {
+        { "tileM", config.tileM },
+        { "tileN", config.tileN },
+        { "tileK", config.tileK },
+        { "threadM", config.threadM },
+        { "threadN", config.threadN },
+    };
+    m_kernel = std::make_unique<Kernel>(context, desc);
+    m_params = std::make_unique<GpuArray<Params>>(context, 1, WGPUBufferUsage_Uniform);
+}
+
+void MatrixMultiply::encode(wgpu::ComputePassEncoder pass, GpuArrayBase& a, GpuArrayBase& b, GpuArrayBase& c, uint32_t m, uint32_t n, uint32_t k) {
+    assert(m_context.hasGpu());
+    Params params = { m, n, k, 0 };
+    m_params->upload(&params, 1);
+    m_kernel->bind(pass, { m_params.get(), &a, &b, &c });
+    pass.dispatchWorkgroups((n + m_config.tileN - 1) / m_config.tileN, (m + m_config.tileM - 1) / m_config.tileM, 1);
+}
+
+void MatrixMultiply::run(GpuArrayBase& a, GpuArrayBase& b, GpuArrayBase& c, uint32_t m, uint32_t n, uint32_t k) {
+    if (!m_context.hasGpu()) {
+        float* cData = static_cast<float*>(c.hostData());
+        if (m_precision == MatmulPrecision::F32) {
+            multiplyCpu(static_cast<const float*>(a.hostData()), static_cast<const float*>(b.hostData()), cData, m, n, k);
+        }
+        else {
+            std::vector<float> aValues = unpackHalves(static_cast<const uint32_t*>(a.hostData()), size_t(m) * k);
+            std::vector<float> bValues = unpackHalves(static_cast<const uint32_t*>(b.hostData()), size_t(k) * n);
+            multiplyCpu(aValues.data(), bValues.data(), cData, m, n, k);
+        }
+        return;
+    }
+
+    wgpu::CommandEncoder encoder = m_context.createEncoder("Matrix multiply");
+    wgpu::ComputePassDescriptor computePassDesc;
+    computePassDesc.label = "Matrix multiply";
+    computePassDesc.timestampWriteCount = 0;
+    computePassDesc.timestampWrites = nullptr;
+    wgpu::ComputePassEncoder pass = encoder.beginComputePass(computePassDesc);
+    encode(pass, a, b, c, m, n, k);
+    pass.end();
+    pass.release();
+    m_context.submit(encoder);
+}
+
+void MatrixMultiply::multiplyCpu(const float* a, const float* b, float* c, uint32_t m, uint32_t n, uint32_t k) {
+    // Blocks of B (blockK x blockN floats) stay in the L2 cache while a
+    // block of rows of A goes over them
+    constexpr uint32_t blockM = 32;
+    constexpr uint32_t blockN = 256;
+    constexpr uint32_t blockK = 128;
+
+    std::fill(c, c + size_t(m) * n, 0.0f);
+    const uint32_t rowBlocks = (m + blockM - 1) / blockM;
+    parallelChunks(rowBlocks, 1, [&](size_t, size_t begin, size_t end) {
+        for (uint32_t i0 = static_cast<uint32_t>(begin) * blockM; i0 < std::min<uint32_t>(static_cast<uint32_t>(end) * blockM, m); i0 += blockM) {
+            uint32_t i1 = std::min(i0 + blockM, m);
+            for (uint32_t j0 = 0; j0 < n; j0 += blockN) {
+                uint32_t j1 = std::min(j0 + blockN, n);
+                for (uint32_t k0 = 0; k0 < k; k0 += blockK) {
+                    multiplyBlock(a, b, c, n, k, i0, i1, k0, std::min(k0 + blockK, k), j0, j1);
+                }
+            }
+        }
+    });
+}
+
+std::vector<uint32_t> MatrixMultiply::packHalves(const std::vector<float>& values) {
+    std::vector<uint32_t> words((values.size() + 1) / 2, 0);
+    for (size_t i = 0; i < values.size(); ++i) {
+        words[i / 2] |= static_cast<uint32_t>(floatToHalf(values[i])) << (16 * (i % 2));
+    }
+    return words;
+}
+
+std::vector<float> MatrixMultiply::unpackHalves(const uint32_t* words, size_t count) {
+    std::vector<float> values(count);
+    for (size_t i = 0; i < count; ++i) {
+        values[i] = halfToFloat(static_cast<uint16_t>(words[i / 2] >> (16 * (i % 2))));
+    }
+    return values;
+}
+
+std::vector<MatmulConfig> MatrixMultiply::candidateConfigs() {
+    return {
+        { 64, 64, 16, 4, 4 },
+        { 64, 64, 8, 4, 4 },
+        { 32, 32, 16, 2, 2 },
+        { 32, 64, 16, 2, 4 },
+        { 128, 64, 16, 8, 4 },
+        { 128, 128, 8, 8, 8 },
+        { 64, 128, 8, 4, 8 },
+    };
+}
+
+// MatmulAutotuner
+
+MatmulAutotuner::MatmulAutotuner(std::string cachePath)
+    : m_cachePath(std::move(cachePath))
+{}
+
+std::string MatmulAutotuner::adapterKey(wgpu::Adapter adapter) {
+    return DeviceProfile::adapterKey(adapter);
+}
+
+bool MatmulAutotuner::load(const std::string& key, MatmulConfig& config) const {
+    std::ifstream file(m_cachePath);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string lineKey;
+        MatmulConfig lineConfig;
+        if (fields >> lineKey >> lineConfig.tileM >> lineConfig.tileN >> lineConfig.tileK >> lineConfig.threadM >> lineConfig.threadN
+            && lineKey == key) {
+            config = lineConfig;
+            return true;
+        }
+    }
+    return false;
+}
+
+void MatmulAutotuner::save(const std::string& key, const MatmulConfig& config) const {
+    std::ofstream file(m_cachePath, std::ios::app);
+    if (!file) {
+        std::cerr << "Could not write matmul autotuning cache " << m_cachePath << std::endl;
+        return;
+    }
+    file << key << " " << config.tileM << " " << config.tileN << " " << config.tileK
+        << " " << config.threadM << " " << config.threadN << "\n";
+}
+
+MatmulConfig MatmulAutotuner::tune(ComputeContext& context, const std::string& adapterKey, MatmulPrecision precision, uint32_t n) {
+    const std::string key = adapterKey + (precision == MatmulPrecision::F32 ? ":f32" : ":f16");
+    MatmulConfig best;
+    if (!context.hasGpu() || load(key, best)) return best;
+
+    const size_t inputSize = precision == MatmulPrecision::F32 ? size_t(n) * n : (size_t(n) * n + 1) / 2;
+    GpuArray<uint32_t> a(context, inputSize);
+    GpuArray<uint32_t> b(context, inputSize);
+    GpuArray<float> c(context, size_t(n) * n);
+
+    using Clock = std::chrono::steady_clock;
+    double bestMs = 1e30;
+    for (const MatmulConfig& config : MatrixMultiply::candidateConfigs()) {
+        if (!config.isValid(context)) continue;
+        MatrixMultiply matmul(context, precision, config);
+        // Warm up, which also compiles the pipeline
+        matmul.run(a, b, c, n, n, n);
+        context.wait();
+
+        constexpr int iterations = 5;
+        auto start = Clock::now();
+        for (int i = 0; i < iterations; ++i) matmul.run(a, b, c, n, n, n);
+        context.wait();
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+        std::cout << "Matmul autotuning: " << config.name() << " " << ms << " ms" << std::endl;
+        if (ms < bestMs) {
+            bestMs = ms;
+            best = config;
+        }
+    }
+
+    std::cout << "Matmul autotuning: picked " << best.name() << " for " << key << std::endl;
+    save(key, best);
+    return best;
+}
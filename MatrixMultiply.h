@@ -0,0 +1,113 @@
+#pragma once
+
+#include "ComputeRuntime.h"
+
+#include <webgpu/webgpu.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class MatmulPrecision {
+    // GpuArray<float> inputs
+    F32,
+    // GpuArray<uint32_t> inputs, two halves per word (see packHalves).
+    // Halves the memory traffic; products are accumulated in f32. This does
+    // not need the ShaderF16 feature.
+    F16,
+};
+
+/**
+ * Tiling of the GPU kernel: each workgroup computes a tileM x tileN block of
+ * C, walking K by tileK, and each invocation a threadM x threadN block of
+ * it. The kernel specializes on these through pipeline-overridable
+ * constants.
+ */
+struct MatmulConfig {
+    uint32_t tileM = 64;
+    uint32_t tileN = 64;
+    uint32_t tileK = 16;
+    uint32_t threadM = 4;
+    uint32_t threadN = 4;
+
+    static constexpr uint32_t MaxThreadTile = 8;
+
+    uint32_t workgroupSize() const { return (tileM / threadM) * (tileN / threadN); }
+    // Bytes of workgroup memory used by the tiles of A and B
+    uint32_t workgroupStorageSize() const { return (tileM * tileK + tileK * tileN) * 4; }
+    bool isValid(const ComputeContext& context) const;
+    std::string name() const;
+};
+
+/**
+ * C = A * B with A (m x k), B (k x n) and C (m x n) row-major. C is always
+ * f32.
+ *
+ * In CPU mode, run() multiplies with a cache-blocked multithreaded loop,
+ * using AVX2 (and FMA) when the build enables them (COMPUTE_AVX2 in CMake).
+ */
+class MatrixMultiply {
+public:
+    MatrixMultiply(ComputeContext& context, MatmulPrecision precision);
+    MatrixMultiply(ComputeContext& context, MatmulPrecision precision, const MatmulConfig& config);
+
+    void encode(wgpu::ComputePassEncoder pass, GpuArrayBase& a, GpuArrayBase& b, GpuArrayBase& c, uint32_t m, uint32_t n, uint32_t k);
+    void run(GpuArrayBase& a, GpuArrayBase& b, GpuArrayBase& c, uint32_t m, uint32_t n, uint32_t k);
+
+    const MatmulConfig& config() const { return m_config; }
+    MatmulPrecision precision() const { return m_precision; }
+
+    static void multiplyCpu(const float* a, const float* b, float* c, uint32_t m, uint32_t n, uint32_t k);
+
+    // f16 storage helpers: element i is the low half of word i / 2 when i
+    // is even, the high half otherwise
+    static std::vector<uint32_t> packHalves(const std::vector<float>& values);
+    static std::vector<float> unpackHalves(const uint32_t* words, size_t count);
+
+    /**
+     * Tile configurations worth trying on any adapter.
+     */
+    static std::vector<MatmulConfig> candidateConfigs();
+
+private:
+    struct Params {
+        uint32_t m;
+        uint32_t n;
+        uint32_t k;
+        uint32_t _pad;
+    };
+
+    ComputeContext& m_context;
+    MatmulPrecision m_precision;
+    MatmulConfig m_config;
+    std::unique_ptr<Kernel> m_kernel;
+    std::unique_ptr<GpuArray<Params>> m_params;
+};
+
+/**
+ * Picks the fastest MatmulConfig for an adapter by timing the candidates,
+ * and remembers the choice in a small text file so that it is only done
+ * once per adapter (and driver).
+ */
+class MatmulAutotuner {
+public:
+    explicit MatmulAutotuner(std::string cachePath = "matmul_autotune.txt");
+
+    /**
+     * Identifies the adapter and its driver, e.g. for cache keys.
+     */
+    static std::string adapterKey(wgpu::Adapter adapter);
+
+    /**
+     * The cached choice for this adapter, or the result of timing every
+     * valid candidate on an n x n x n product (then saved to the cache).
+     */
+    MatmulConfig tune(ComputeContext& context, const std::string& adapterKey, MatmulPrecision precision, uint32_t n = 1024);
+
+private:
+    bool load(const std::string& key, MatmulConfig& config) const;
+    void save(const std::string& key, const MatmulConfig& config) const;
+
+private:
+    std::string m_cachePath;
+};
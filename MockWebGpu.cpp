@@ -0,0 +1,1333 @@
+#include "MockWebGpu.h"
+
+#include <webgpu/webgpu.h>
+#include <webgpu/wgpu.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+enum class ObjectType : uint32_t {
+    Adapter,
+    BindGroup,
+    BindGroupLayout,
+    Buffer,
+    CommandBuffer,
+    CommandEncoder,
+    ComputePassEncoder,
+    ComputePipeline,
+    Device,
+    Instance,
+    PipelineLayout,
+    QuerySet,
+    Queue,
+    RenderBundle,
+    RenderBundleEncoder,
+    RenderPassEncoder,
+    RenderPipeline,
+    Sampler,
+    ShaderModule,
+    Surface,
+    SwapChain,
+    Texture,
+    TextureView,
+    Count,
+};
+
+struct CallCounter {
+    const char* function = "";
+    std::atomic<uint64_t> count{ 0 };
+    CallCounter* next = nullptr;
+};
+
+struct DeviceShared;
+
+struct MockState {
+    MockState() {
+        for (std::atomic<int64_t>& count : liveObjects) count.store(0, std::memory_order_relaxed);
+    }
+
+    // Lock-free list, one counter per entry point that was called
+    std::atomic<CallCounter*> counters{ nullptr };
+    std::atomic<uint64_t> totalCalls{ 0 };
+    std::atomic<bool> recording{ false };
+    std::atomic<int64_t> liveObjects[static_cast<size_t>(ObjectType::Count)];
+
+    // Guards the rest
+    std::mutex mutex;
+    std::vector<const char*> recorded;
+    // For wgpuInstanceProcessEvents, which polls every device
+    std::vector<std::weak_ptr<DeviceShared>> devices;
+    WGPULogCallback logCallback = nullptr;
+    void* logUserdata = nullptr;
+    WGPULogLevel logLevel = WGPULogLevel_Warn;
+};
+
+MockState& state() {
+    // Never destroyed: objects may still be released after main returns
+    static MockState* s = new MockState();
+    return *s;
+}
+
+CallCounter* registerCounter(const char* function) {
+    MockState& s = state();
+    CallCounter* counter = new CallCounter();
+    counter->function = function;
+    counter->next = s.counters.load(std::memory_order_relaxed);
+    while (!s.counters.compare_exchange_weak(counter->next, counter, std::memory_order_release, std::memory_order_relaxed)) {}
+    return counter;
+}
+
+void recordCall(CallCounter& counter) {
+    MockState& s = state();
+    counter.count.fetch_add(1, std::memory_order_relaxed);
+    s.totalCalls.fetch_add(1, std::memory_order_relaxed);
+    if (s.recording.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.recorded.push_back(counter.function);
+    }
+}
+
+// First line of every entry point
+#define MOCK_CALL() \
+    static CallCounter* const mockCallCounter = registerCounter(__func__); \
+    recordCall(*mockCallCounter)
+
+struct MockObject {
+    explicit MockObject(ObjectType type)
+        : type(type)
+    {
+        state().liveObjects[static_cast<size_t>(type)].fetch_add(1, std::memory_order_relaxed);
+    }
+    virtual ~MockObject() {
+        state().liveObjects[static_cast<size_t>(type)].fetch_sub(1, std::memory_order_relaxed);
+    }
+    MockObject(const MockObject&) = delete;
+    MockObject& operator=(const MockObject&) = delete;
+
+    ObjectType type;
+    std::atomic<uint32_t> refCount{ 1 };
+    std::string label;
+};
+
+template <typename T>
+T* addRef(T* object) {
+    if (object) object->refCount.fetch_add(1, std::memory_order_relaxed);
+    return object;
+}
+
+void releaseRef(MockObject* object) {
+    if (object && object->refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) delete object;
+}
+
+template <typename Descriptor>
+void setLabel(MockObject* object, const Descriptor* descriptor) {
+    if (descriptor && descriptor->label) object->label = descriptor->label;
+}
+
+// What a device shares with its queue, buffers and encoders, which may
+// outlive it
+struct DeviceShared {
+    struct Scope {
+        WGPUErrorFilter filter = WGPUErrorFilter_Validation;
+        WGPUErrorType type = WGPUErrorType_NoError;
+        std::string message;
+    };
+
+    std::mutex mutex;
+    std::vector<std::function<void()>> pending;
+    std::vector<Scope> scopes;
+    WGPUErrorCallback uncapturedError = nullptr;
+    void* uncapturedUserdata = nullptr;
+
+    void defer(std::function<void()> callback) {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(std::move(callback));
+    }
+
+    // Run the deferred callbacks, and those they defer in turn
+    void runPending() {
+        for (;;) {
+            std::vector<std::function<void()>> callbacks;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                callbacks.swap(pending);
+            }
+            if (callbacks.empty()) return;
+            for (auto& callback : callbacks) callback();
+        }
+    }
+
+    // To the innermost scope with a matching filter, as a device would
+    void raise(WGPUErrorType type, const std::string& message) {
+        WGPUErrorCallback callback = nullptr;
+        void* userdata = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+                bool matches = (it->filter == WGPUErrorFilter_Validation && type == WGPUErrorType_Validation)
+                    || (it->filter == WGPUErrorFilter_OutOfMemory && type == WGPUErrorType_OutOfMemory)
+                    || (it->filter == WGPUErrorFilter_Internal && type == WGPUErrorType_Internal);
+                if (!matches) continue;
+                if (it->type == WGPUErrorType_NoError) {
+                    it->type = type;
+                    it->message = message;
+                }
+                return;
+            }
+            callback = uncapturedError;
+            userdata = uncapturedUserdata;
+        }
+        if (callback) callback(type, message.c_str(), userdata);
+    }
+};
+
+WGPULimits adapterLimits() {
+    // A desktop GPU
+    WGPULimits limits = {};
+    limits.maxTextureDimension1D = 16384;
+    limits.maxTextureDimension2D = 16384;
+    limits.maxTextureDimension3D = 2048;
+    limits.maxTextureArrayLayers = 2048;
+    limits.maxBindGroups = 8;
+    limits.maxBindingsPerBindGroup = 1000;
+    limits.maxDynamicUniformBuffersPerPipelineLayout = 16;
+    limits.maxDynamicStorageBuffersPerPipelineLayout = 8;
+    limits.maxSampledTexturesPerShaderStage = 128;
+    limits.maxSamplersPerShaderStage = 16;
+    limits.maxStorageBuffersPerShaderStage = 64;
+    limits.maxStorageTexturesPerShaderStage = 16;
+    limits.maxUniformBuffersPerShaderStage = 16;
+    limits.maxUniformBufferBindingSize = 65536;
+    limits.maxStorageBufferBindingSize = uint64_t(1) << 30;
+    limits.minUniformBufferOffsetAlignment = 256;
+    limits.minStorageBufferOffsetAlignment = 256;
+    limits.maxVertexBuffers = 16;
+    limits.maxBufferSize = uint64_t(1) << 30;
+    limits.maxVertexAttributes = 32;
+    limits.maxVertexBufferArrayStride = 2048;
+    limits.maxInterStageShaderComponents = 128;
+    limits.maxInterStageShaderVariables = 32;
+    limits.maxColorAttachments = 8;
+    limits.maxColorAttachmentBytesPerSample = 64;
+    limits.maxComputeWorkgroupStorageSize = 32768;
+    limits.maxComputeInvocationsPerWorkgroup = 1024;
+    limits.maxComputeWorkgroupSizeX = 1024;
+    limits.maxComputeWorkgroupSizeY = 1024;
+    limits.maxComputeWorkgroupSizeZ = 64;
+    limits.maxComputeWorkgroupsPerDimension = 65535;
+    return limits;
+}
+
+const WGPUFeatureName adapterFeatures[] = { WGPUFeatureName_TimestampQuery };
+
+struct Command {
+    enum class Kind {
+        CopyBuffer,
+        ClearBuffer,
+    };
+    Kind kind = Kind::CopyBuffer;
+    WGPUBuffer source = nullptr;
+    uint64_t sourceOffset = 0;
+    WGPUBuffer destination = nullptr;
+    uint64_t destinationOffset = 0;
+    uint64_t size = 0;
+};
+
+void releaseCommands(std::vector<Command>& commands);
+
+} // namespace
+
+#define MOCK_PLAIN_OBJECT(Name) \
+    struct WGPU##Name##Impl : MockObject { \
+        WGPU##Name##Impl() : MockObject(ObjectType::Name) {} \
+    }
+
+MOCK_PLAIN_OBJECT(Instance);
+MOCK_PLAIN_OBJECT(Adapter);
+MOCK_PLAIN_OBJECT(Surface);
+MOCK_PLAIN_OBJECT(BindGroup);
+MOCK_PLAIN_OBJECT(BindGroupLayout);
+MOCK_PLAIN_OBJECT(PipelineLayout);
+MOCK_PLAIN_OBJECT(ShaderModule);
+MOCK_PLAIN_OBJECT(ComputePipeline);
+MOCK_PLAIN_OBJECT(RenderPipeline);
+MOCK_PLAIN_OBJECT(Sampler);
+MOCK_PLAIN_OBJECT(TextureView);
+MOCK_PLAIN_OBJECT(RenderBundle);
+MOCK_PLAIN_OBJECT(RenderBundleEncoder);
+MOCK_PLAIN_OBJECT(ComputePassEncoder);
+MOCK_PLAIN_OBJECT(RenderPassEncoder);
+
+#undef MOCK_PLAIN_OBJECT
+
+struct WGPUQueueImpl : MockObject {
+    WGPUQueueImpl() : MockObject(ObjectType::Queue) {}
+    std::shared_ptr<DeviceShared> shared;
+    uint64_t submissionIndex = 0;
+};
+
+struct WGPUDeviceImpl : MockObject {
+    WGPUDeviceImpl() : MockObject(ObjectType::Device) {}
+    ~WGPUDeviceImpl() override { releaseRef(queue); }
+    std::shared_ptr<DeviceShared> shared = std::make_shared<DeviceShared>();
+    WGPUQueue queue = nullptr;
+    WGPULimits limits = {};
+    std::vector<WGPUFeatureName> features;
+};
+
+struct WGPUBufferImpl : MockObject {
+    WGPUBufferImpl() : MockObject(ObjectType::Buffer) {}
+    std::shared_ptr<DeviceShared> shared;
+    uint64_t size = 0;
+    WGPUBufferUsageFlags usage = WGPUBufferUsage_None;
+    std::vector<uint8_t> data;
+    WGPUBufferMapState mapState = WGPUBufferMapState_Unmapped;
+    bool destroyed = false;
+};
+
+struct WGPUTextureImpl : MockObject {
+    WGPUTextureImpl() : MockObject(ObjectType::Texture) {}
+    WGPUTextureUsageFlags usage = WGPUTextureUsage_None;
+    WGPUTextureDimension dimension = WGPUTextureDimension_2D;
+    WGPUExtent3D size = {};
+    WGPUTextureFormat format = WGPUTextureFormat_Undefined;
+    uint32_t mipLevelCount = 1;
+    uint32_t sampleCount = 1;
+};
+
+struct WGPUQuerySetImpl : MockObject {
+    WGPUQuerySetImpl() : MockObject(ObjectType::QuerySet) {}
+    WGPUQueryType queryType = WGPUQueryType_Occlusion;
+    uint32_t count = 0;
+};
+
+struct WGPUCommandEncoderImpl : MockObject {
+    WGPUCommandEncoderImpl() : MockObject(ObjectType::CommandEncoder) {}
+    ~WGPUCommandEncoderImpl() override { releaseCommands(commands); }
+    std::shared_ptr<DeviceShared> shared;
+    std::vector<Command> commands;
+};
+
+struct WGPUCommandBufferImpl : MockObject {
+    WGPUCommandBufferImpl() : MockObject(ObjectType::CommandBuffer) {}
+    ~WGPUCommandBufferImpl() override { releaseCommands(commands); }
+    std::vector<Command> commands;
+};
+
+struct WGPUSwapChainImpl : MockObject {
+    WGPUSwapChainImpl() : MockObject(ObjectType::SwapChain) {}
+    WGPUTextureFormat format = WGPUTextureFormat_Undefined;
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
+
+namespace {
+
+void releaseCommands(std::vector<Command>& commands) {
+    for (Command& command : commands) {
+        releaseRef(command.source);
+        releaseRef(command.destination);
+    }
+    commands.clear();
+}
+
+bool inRange(WGPUBuffer buffer, uint64_t offset, uint64_t size) {
+    return !buffer->destroyed && offset <= buffer->size && size <= buffer->size - offset;
+}
+
+void execute(DeviceShared& shared, const Command& command) {
+    switch (command.kind) {
+    case Command::Kind::CopyBuffer:
+        if (!inRange(command.source, command.sourceOffset, command.size) || !inRange(command.destination, command.destinationOffset, command.size)) {
+            shared.raise(WGPUErrorType_Validation, "copyBufferToBuffer out of the bounds of a buffer");
+            return;
+        }
+        if (command.size > 0) {
+            std::memmove(command.destination->data.data() + command.destinationOffset, command.source->data.data() + command.sourceOffset, command.size);
+        }
+        break;
+    case Command::Kind::ClearBuffer:
+        if (!inRange(command.destination, command.destinationOffset, command.size)) {
+            shared.raise(WGPUErrorType_Validation, "clearBuffer out of the bounds of the buffer");
+            return;
+        }
+        if (command.size > 0) {
+            std::memset(command.destination->data.data() + command.destinationOffset, 0, command.size);
+        }
+        break;
+    }
+}
+
+uint64_t submit(WGPUQueue queue, uint32_t commandCount, WGPUCommandBuffer const* commands) {
+    for (uint32_t i = 0; i < commandCount; ++i) {
+        for (const Command& command : commands[i]->commands) execute(*queue->shared, command);
+    }
+    return ++queue->submissionIndex;
+}
+
+void pollAllDevices() {
+    std::vector<std::shared_ptr<DeviceShared>> devices;
+    {
+        MockState& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.devices.erase(std::remove_if(s.devices.begin(), s.devices.end(), [](const std::weak_ptr<DeviceShared>& device) {
+            return device.expired();
+        }), s.devices.end());
+        for (const std::weak_ptr<DeviceShared>& device : s.devices) {
+            if (std::shared_ptr<DeviceShared> locked = device.lock()) devices.push_back(std::move(locked));
+        }
+    }
+    for (auto& device : devices) device->runPending();
+}
+
+void fillStorageReport(WGPUStorageReport& report, ObjectType type) {
+    report.numOccupied = static_cast<size_t>(std::max<int64_t>(state().liveObjects[static_cast<size_t>(type)].load(std::memory_order_relaxed), 0));
+}
+
+} // namespace
+
+extern "C" {
+
+// Reference counting and labels, the same for every object
+
+#define MOCK_REFCOUNTED(Name) \
+    void wgpu##Name##Reference(WGPU##Name object) { MOCK_CALL(); addRef(object); } \
+    void wgpu##Name##Release(WGPU##Name object) { MOCK_CALL(); releaseRef(object); }
+
+#define MOCK_LABELLED(Name) \
+    void wgpu##Name##SetLabel(WGPU##Name object, char const* label) { MOCK_CALL(); object->label = label ? label : ""; }
+
+MOCK_REFCOUNTED(Adapter)
+MOCK_REFCOUNTED(BindGroup)
+MOCK_REFCOUNTED(BindGroupLayout)
+MOCK_REFCOUNTED(Buffer)
+MOCK_REFCOUNTED(CommandBuffer)
+MOCK_REFCOUNTED(CommandEncoder)
+MOCK_REFCOUNTED(ComputePassEncoder)
+MOCK_REFCOUNTED(ComputePipeline)
+MOCK_REFCOUNTED(Device)
+MOCK_REFCOUNTED(Instance)
+MOCK_REFCOUNTED(PipelineLayout)
+MOCK_REFCOUNTED(QuerySet)
+MOCK_REFCOUNTED(Queue)
+MOCK_REFCOUNTED(RenderBundle)
+MOCK_REFCOUNTED(RenderBundleEncoder)
+MOCK_REFCOUNTED(RenderPassEncoder)
+MOCK_REFCOUNTED(RenderPipeline)
+MOCK_REFCOUNTED(Sampler)
+MOCK_REFCOUNTED(ShaderModule)
+MOCK_REFCOUNTED(Surface)
+MOCK_REFCOUNTED(SwapChain)
+MOCK_REFCOUNTED(Texture)
+MOCK_REFCOUNTED(TextureView)
+
+MOCK_LABELLED(BindGroup)
+MOCK_LABELLED(BindGroupLayout)
+MOCK_LABELLED(Buffer)
+MOCK_LABELLED(CommandBuffer)
+MOCK_LABELLED(CommandEncoder)
+MOCK_LABELLED(ComputePassEncoder)
+MOCK_LABELLED(ComputePipeline)
+MOCK_LABELLED(Device)
+MOCK_LABELLED(PipelineLayout)
+MOCK_LABELLED(QuerySet)
+MOCK_LABELLED(Queue)
+MOCK_LABELLED(RenderBundleEncoder)
+MOCK_LABELLED(RenderPassEncoder)
+MOCK_LABELLED(RenderPipeline)
+MOCK_LABELLED(Sampler)
+MOCK_LABELLED(ShaderModule)
+MOCK_LABELLED(Texture)
+MOCK_LABELLED(TextureView)
+
+#undef MOCK_REFCOUNTED
+#undef MOCK_LABELLED
+
+// Instance and adapter
+
+WGPUInstance wgpuCreateInstance(WGPUInstanceDescriptor const*) {
+    MOCK_CALL();
+    return new WGPUInstanceImpl();
+}
+
+WGPUProc wgpuGetProcAddress(WGPUDevice, char const*) {
+    MOCK_CALL();
+    return nullptr;
+}
+
+WGPUSurface wgpuInstanceCreateSurface(WGPUInstance, WGPUSurfaceDescriptor const* descriptor) {
+    MOCK_CALL();
+    WGPUSurface surface = new WGPUSurfaceImpl();
+    setLabel(surface, descriptor);
+    return surface;
+}
+
+void wgpuInstanceProcessEvents(WGPUInstance) {
+    MOCK_CALL();
+    pollAllDevices();
+}
+
+void wgpuInstanceRequestAdapter(WGPUInstance, WGPURequestAdapterOptions const*, WGPURequestAdapterCallback callback, void* userdata) {
+    MOCK_CALL();
+    callback(WGPURequestAdapterStatus_Success, new WGPUAdapterImpl(), nullptr, userdata);
+}
+
+size_t wgpuInstanceEnumerateAdapters(WGPUInstance, WGPUInstanceEnumerateAdapterOptions const*, WGPUAdapter* adapters) {
+    MOCK_CALL();
+    if (adapters) adapters[0] = new WGPUAdapterImpl();
+    return 1;
+}
+
+size_t wgpuAdapterEnumerateFeatures(WGPUAdapter, WGPUFeatureName* features) {
+    MOCK_CALL();
+    const size_t count = sizeof(adapterFeatures) / sizeof(adapterFeatures[0]);
+    if (features) std::copy(adapterFeatures, adapterFeatures + count, features);
+    return count;
+}
+
+bool wgpuAdapterGetLimits(WGPUAdapter, WGPUSupportedLimits* limits) {
+    MOCK_CALL();
+    limits->limits = adapterLimits();
+    return true;
+}
+
+void wgpuAdapterGetProperties(WGPUAdapter, WGPUAdapterProperties* properties) {
+    MOCK_CALL();
+    properties->vendorID = 0;
+    properties->vendorName = "";
+    properties->architecture = "";
+    properties->deviceID = 0;
+    properties->name = "Mock adapter";
+    properties->driverDescription = "MockWebGpu";
+    properties->adapterType = WGPUAdapterType_CPU;
+    properties->backendType = WGPUBackendType_Null;
+}
+
+bool wgpuAdapterHasFeature(WGPUAdapter, WGPUFeatureName feature) {
+    MOCK_CALL();
+    return std::find(std::begin(adapterFeatures), std::end(adapterFeatures), feature) != std::end(adapterFeatures);
+}
+
+void wgpuAdapterRequestDevice(WGPUAdapter, WGPUDeviceDescriptor const* descriptor, WGPURequestDeviceCallback callback, void* userdata) {
+    MOCK_CALL();
+    WGPUDevice device = new WGPUDeviceImpl();
+    setLabel(device, descriptor);
+    // Whatever was required, the device gets everything the adapter has
+    device->limits = adapterLimits();
+    if (descriptor && descriptor->requiredFeaturesCount > 0) {
+        device->features.assign(descriptor->requiredFeatures, descriptor->requiredFeatures + descriptor->requiredFeaturesCount);
+    }
+    device->queue = new WGPUQueueImpl();
+    device->queue->shared = device->shared;
+    {
+        MockState& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.devices.push_back(device->shared);
+    }
+    callback(WGPURequestDeviceStatus_Success, device, nullptr, userdata);
+}
+
+// Device
+
+WGPUBindGroup wgpuDeviceCreateBindGroup(WGPUDevice, WGPUBindGroupDescriptor const* descriptor) {
+    MOCK_CALL();
+    WGPUBindGroup bindGroup = new WGPUBindGroupImpl();
+    setLabel(bindGroup, descriptor);
+    return bindGroup;
+}
+
+WGPUBindGroupLayout wgpuDeviceCreateBindGroupLayout(WGPUDevice, WGPUBindGroupLayoutDescriptor const* descriptor) {
+    MOCK_CALL();
+    WGPUBindGroupLayout layout = new WGPUBindGroupLayoutImpl();
+    setLabel(layout, descriptor);
+    return layout;
+}
+
+WGPUBuffer wgpuDeviceCreateBuffer(WGPUDevice device, WGPUBufferDescriptor const* descriptor) {
+    MOCK_CALL();
+    WGPUBuffer buffer = new WGPUBufferImpl();
+    setLabel(buffer, descriptor);
+    buffer->shared = device->shared;
+    buffer->usage = descriptor->usage;
+    if (descriptor->size > device->limits.maxBufferSize) {
+        // An invalid buffer, as a device would return
+        buffer->destroyed = true;
+        device->shared->raise(WGPUErrorType_Validation, "Buffer size is larger than maxBufferSize");
+        return buffer;
+    }
+    buffer->size = descriptor->size;
+    buffer->data.resize(static_cast<size_t>(descriptor->size));
+    if (descriptor->mappedAtCreation) buffer->mapState = WGPUBufferMapState_Mapped;
+    return buffer;
+}
+
+WGPUCommandEncoder wgpuDeviceCreateCommandEncoder(WGPUDevice device, WGPUCommandEncoderDescriptor const* descriptor) {
+    MOCK_CALL();
+    WGPUCommandEncoder encoder = new WGPUCommandEncoderImpl();
+    setLabel(encoder, descriptor);
+    encoder->shared = device->shared;
+    return encoder;
+}
+
+WGPUComputePipeline wgpuDeviceCreateComputePipeline(WGPUDevice, WGPUComputePipelineDescriptor const* descriptor) {
+    MOCK_CALL();
+    WGPUComputePipeline pipeline = new WGPUComputePipelineImpl();
+    setLabel(pipeline, descriptor);
+    return pipeline;
+}
+
+void wgpuDeviceCreateComputePipelineAsync(WGPUDevice, WGPUComputePipelineDescriptor const* descriptor, WGPUCreateComputePipelineAsyncCallback callback, void* userdata) {
+    MOCK_CALL();
+    WGPUComputePipeline pipeline = new WGPUComputePipelineImpl();
+    setLabel(pipeline, descriptor);
+    callback(WGPUCreatePipelineAsyncStatus_Success, pipeline, nullptr, userdata);
+}
+
+WGPUPipelineLayout wgpuDeviceCreatePipelineLayout(WGPUDevice, WGPUPipelineLayoutDescriptor const* descriptor) {
+    MOCK_CALL();
+    WGPUPipelineLayout layout = new WGPUPipelineLayoutImpl();
+    setLabel(layout, descriptor);
+    return layout;
+}
+
+WGPUQuerySet wgpuDeviceCreateQuerySet(WGPUDevice, WGPUQuerySetDescriptor const* descriptor) {
+    MOCK_CALL();
+    WGPUQuerySet querySet = new WGPUQuerySetImpl();
+    setLabel(querySet, descriptor);
+    querySet->queryType = descriptor->type;
+    querySet->count = descriptor->count;
+    return querySet;
+}
+
+WGPURenderBundleEncoder wgpuDeviceCreateRenderBundleEncoder(WGPUDevice, WGPURenderBundleEncoderDescriptor const* descriptor) {
+    MOCK_CALL();
+    WGPURenderBundleEncoder encoder = new WGPURenderBundleEncoderImpl();
+    setLabel(encoder, descriptor);
+    return encoder;
+}
+
+WGPURenderPipeline wgpuDeviceCreateRenderPipeline(WGPUDevice, WGPURenderPipelineDescriptor const* descriptor) {
+    MOCK_CALL();
+    WGPURenderPipeline pipeline = new WGPURenderPipelineImpl();
+    setLabel(pipeline, descriptor);
+    return pipeline;
+}
+
+void wgpuDeviceCreateRenderPipelineAsync(WGPUDevice, WGPURenderPipelineDescriptor const* descriptor, WGPUCreateRenderPipelineAsyncCallback callback, void* userdata) {
+    MOCK_CALL();
+    WGPURenderPipeline pipeline = new WGPURenderPipelineImpl();
+    setLabel(pipeline, descriptor);
+    callback(WGPUCreatePipelineAsyncStatus_Success, pipeline, nullptr, userdata);
+}
+
+WGPUSampler wgpuDeviceCreateSampler(WGPUDevice, WGPUSamplerDescriptor const* descriptor) {
+    MOCK_CALL();
+    WGPUSampler sampler = new WGPUSamplerImpl();
+    setLabel(sampler, descriptor);
+    return sampler;
+}
+
+WGPUShaderModule wgpuDeviceCreateShaderModule(WGPUDevice, WGPUShaderModuleDescriptor const* descriptor) {
+    MOCK_CALL();
+    WGPUShaderModule module = new WGPUShaderModuleImpl();
+    setLabel(module, descriptor);
+    return module;
+}
+
+WGPUSwapChain wgpuDeviceCreateSwapChain(WGPUDevice, WGPUSurface, WGPUSwapChainDescriptor const* descriptor) {
+    MOCK_CALL();
+    WGPUSwapChain swapChain = new WGPUSwapChainImpl();
+    setLabel(swapChain, descriptor);
+    swapChain->format = descriptor->format;
+    swapChain->width = descriptor->width;
+    swapChain->height = descriptor->height;
+    return swapChain;
+}
+
+WGPUTexture wgpuDeviceCreateTexture(WGPUDevice, WGPUTextureDescriptor const* descriptor) {
+    MOCK_CALL();
+    WGPUTexture texture = new WGPUTextureImpl();
+    setLabel(texture, descriptor);
+    texture->usage = descriptor->usage;
+    texture->dimension = descriptor->dimension;
+    texture->size = descriptor->size;
+    texture->format = descriptor->format;
+    texture->mipLevelCount = descriptor->mipLevelCount;
+    texture->sampleCount = descriptor->sampleCount;
+    return texture;
+}
+
+void wgpuDeviceDestroy(WGPUDevice) {
+    MOCK_CALL();
+}
+
+size_t wgpuDeviceEnumerateFeatures(WGPUDevice device, WGPUFeatureName* features) {
+    MOCK_CALL();
+    if (features) std::copy(device->features.begin(), device->features.end(), features);
+    return device->features.size();
+}
+
+bool wgpuDeviceGetLimits(WGPUDevice device, WGPUSupportedLimits* limits) {
+    MOCK_CALL();
+    limits->limits = device->limits;
+    return true;
+}
+
+WGPUQueue wgpuDeviceGetQueue(WGPUDevice device) {
+    MOCK_CALL();
+    return addRef(device->queue);
+}
+
+bool wgpuDeviceHasFeature(WGPUDevice device, WGPUFeatureName feature) {
+    MOCK_CALL();
+    return std::find(device->features.begin(), device->features.end(), feature) != device->features.end();
+}
+
+void wgpuDevicePopErrorScope(WGPUDevice device, WGPUErrorCallback callback, void* userdata) {
+    MOCK_CALL();
+    DeviceShared::Scope scope;
+    {
+        std::lock_guard<std::mutex> lock(device->shared->mutex);
+        if (device->shared->scopes.empty()) {
+            scope.type = WGPUErrorType_Unknown;
+            scope.message = "No error scope to pop";
+        }
+        else {
+            scope = std::move(device->shared->scopes.back());
+            device->shared->scopes.pop_back();
+        }
+    }
+    callback(scope.type, scope.message.c_str(), userdata);
+}
+
+void wgpuDevicePushErrorScope(WGPUDevice device, WGPUErrorFilter filter) {
+    MOCK_CALL();
+    std::lock_guard<std::mutex> lock(device->shared->mutex);
+    device->shared->scopes.emplace_back();
+    device->shared->scopes.back().filter = filter;
+}
+
+void wgpuDeviceSetUncapturedErrorCallback(WGPUDevice device, WGPUErrorCallback callback, void* userdata) {
+    MOCK_CALL();
+    std::lock_guard<std::mutex> lock(device->shared->mutex);
+    device->shared->uncapturedError = callback;
+    device->shared->uncapturedUserdata = userdata;
+}
+
+bool wgpuDevicePoll(WGPUDevice device, bool, WGPUWrappedSubmissionIndex const*) {
+    MOCK_CALL();
+    device->shared->runPending();
+    // Work is done as soon as it is submitted
+    return true;
+}
+
+// Buffer
+
+void wgpuBufferDestroy(WGPUBuffer buffer) {
+    MOCK_CALL();
+    buffer->destroyed = true;
+    buffer->mapState = WGPUBufferMapState_Unmapped;
+    std::vector<uint8_t>().swap(buffer->data);
+}
+
+void const* wgpuBufferGetConstMappedRange(WGPUBuffer buffer, size_t offset, size_t) {
+    MOCK_CALL();
+    if (buffer->mapState != WGPUBufferMapState_Mapped || offset > buffer->size) return nullptr;
+    return buffer->data.data() + offset;
+}
+
+WGPUBufferMapState wgpuBufferGetMapState(WGPUBuffer buffer) {
+    MOCK_CALL();
+    return buffer->mapState;
+}
+
+void* wgpuBufferGetMappedRange(WGPUBuffer buffer, size_t offset, size_t) {
+    MOCK_CALL();
+    if (buffer->mapState != WGPUBufferMapState_Mapped || offset > buffer->size) return nullptr;
+    return buffer->data.data() + offset;
+}
+
+uint64_t wgpuBufferGetSize(WGPUBuffer buffer) {
+    MOCK_CALL();
+    return buffer->size;
+}
+
+WGPUBufferUsage wgpuBufferGetUsage(WGPUBuffer buffer) {
+    MOCK_CALL();
+    return static_cast<WGPUBufferUsage>(buffer->usage);
+}
+
+void wgpuBufferMapAsync(WGPUBuffer buffer, WGPUMapModeFlags, size_t offset, size_t size, WGPUBufferMapCallback callback, void* userdata) {
+    MOCK_CALL();
+    if (size == WGPU_WHOLE_MAP_SIZE && offset <= buffer->size) size = static_cast<size_t>(buffer->size - offset);
+    WGPUBufferMapAsyncStatus error = WGPUBufferMapAsyncStatus_Success;
+    if (buffer->destroyed) error = WGPUBufferMapAsyncStatus_DestroyedBeforeCallback;
+    else if (buffer->mapState != WGPUBufferMapState_Unmapped) error = WGPUBufferMapAsyncStatus_MappingAlreadyPending;
+    else if (!inRange(buffer, offset, size)) error = WGPUBufferMapAsyncStatus_OffsetOutOfRange;
+    if (error != WGPUBufferMapAsyncStatus_Success) {
+        buffer->shared->defer([callback, userdata, error]() { callback(error, userdata); });
+        return;
+    }
+    buffer->mapState = WGPUBufferMapState_Pending;
+    addRef(buffer);
+    buffer->shared->defer([buffer, callback, userdata]() {
+        WGPUBufferMapAsyncStatus status = WGPUBufferMapAsyncStatus_Success;
+        if (buffer->destroyed) status = WGPUBufferMapAsyncStatus_DestroyedBeforeCallback;
+        else if (buffer->mapState != WGPUBufferMapState_Pending) status = WGPUBufferMapAsyncStatus_UnmappedBeforeCallback;
+        else buffer->mapState = WGPUBufferMapState_Mapped;
+        callback(status, userdata);
+        releaseRef(buffer);
+    });
+}
+
+void wgpuBufferUnmap(WGPUBuffer buffer) {
+    MOCK_CALL();
+    buffer->mapState = WGPUBufferMapState_Unmapped;
+}
+
+// Command encoder
+
+WGPUComputePassEncoder wgpuCommandEncoderBeginComputePass(WGPUCommandEncoder, WGPUComputePassDescriptor const* descriptor) {
+    MOCK_CALL();
+    WGPUComputePassEncoder pass = new WGPUComputePassEncoderImpl();
+    setLabel(pass, descriptor);
+    return pass;
+}
+
+WGPURenderPassEncoder wgpuCommandEncoderBeginRenderPass(WGPUCommandEncoder, WGPURenderPassDescriptor const* descriptor) {
+    MOCK_CALL();
+    WGPURenderPassEncoder pass = new WGPURenderPassEncoderImpl();
+    setLabel(pass, descriptor);
+    return pass;
+}
+
+void wgpuCommandEncoderClearBuffer(WGPUCommandEncoder commandEncoder, WGPUBuffer buffer, uint64_t offset, uint64_t size) {
+    MOCK_CALL();
+    Command command;
+    command.kind = Command::Kind::ClearBuffer;
+    command.destination = addRef(buffer);
+    command.destinationOffset = offset;
+    command.size = size == WGPU_WHOLE_SIZE && offset <= buffer->size ? buffer->size - offset : size;
+    commandEncoder->commands.push_back(command);
+}
+
+void wgpuCommandEncoderCopyBufferToBuffer(WGPUCommandEncoder commandEncoder, WGPUBuffer source, uint64_t sourceOffset, WGPUBuffer destination, uint64_t destinationOffset, uint64_t size) {
+    MOCK_CALL();
+    Command command;
+    command.kind = Command::Kind::CopyBuffer;
+    command.source = addRef(source);
+    command.sourceOffset = sourceOffset;
+    command.destination = addRef(destination);
+    command.destinationOffset = destinationOffset;
+    command.size = size;
+    commandEncoder->commands.push_back(command);
+}
+
+// Textures have no contents
+void wgpuCommandEncoderCopyBufferToTexture(WGPUCommandEncoder, WGPUImageCopyBuffer const*, WGPUImageCopyTexture const*, WGPUExtent3D const*) {
+    MOCK_CALL();
+}
+
+void wgpuCommandEncoderCopyTextureToBuffer(WGPUCommandEncoder, WGPUImageCopyTexture const*, WGPUImageCopyBuffer const*, WGPUExtent3D const*) {
+    MOCK_CALL();
+}
+
+void wgpuCommandEncoderCopyTextureToTexture(WGPUCommandEncoder, WGPUImageCopyTexture const*, WGPUImageCopyTexture const*, WGPUExtent3D const*) {
+    MOCK_CALL();
+}
+
+WGPUCommandBuffer wgpuCommandEncoderFinish(WGPUCommandEncoder commandEncoder, WGPUCommandBufferDescriptor const* descriptor) {
+    MOCK_CALL();
+    WGPUCommandBuffer commandBuffer = new WGPUCommandBufferImpl();
+    setLabel(commandBuffer, descriptor);
+    commandBuffer->commands.swap(commandEncoder->commands);
+    return commandBuffer;
+}
+
+void wgpuCommandEncoderInsertDebugMarker(WGPUCommandEncoder, char const*) {
+    MOCK_CALL();
+}
+
+void wgpuCommandEncoderPopDebugGroup(WGPUCommandEncoder) {
+    MOCK_CALL();
+}
+
+void wgpuCommandEncoderPushDebugGroup(WGPUCommandEncoder, char const*) {
+    MOCK_CALL();
+}
+
+void wgpuCommandEncoderResolveQuerySet(WGPUCommandEncoder commandEncoder, WGPUQuerySet, uint32_t, uint32_t queryCount, WGPUBuffer destination, uint64_t destinationOffset) {
+    MOCK_CALL();
+    // Every query reads as 0
+    Command command;
+    command.kind = Command::Kind::ClearBuffer;
+    command.destination = addRef(destination);
+    command.destinationOffset = destinationOffset;
+    command.size = uint64_t(queryCount) * sizeof(uint64_t);
+    commandEncoder->commands.push_back(command);
+}
+
+void wgpuCommandEncoderWriteTimestamp(WGPUCommandEncoder, WGPUQuerySet, uint32_t) {
+    MOCK_CALL();
+}
+
+// Compute pass: recorded, never run
+
+void wgpuComputePassEncoderBeginPipelineStatisticsQuery(WGPUComputePassEncoder, WGPUQuerySet, uint32_t) {
+    MOCK_CALL();
+}
+
+void wgpuComputePassEncoderDispatchWorkgroups(WGPUComputePassEncoder, uint32_t, uint32_t, uint32_t) {
+    MOCK_CALL();
+}
+
+void wgpuComputePassEncoderDispatchWorkgroupsIndirect(WGPUComputePassEncoder, WGPUBuffer, uint64_t) {
+    MOCK_CALL();
+}
+
+void wgpuComputePassEncoderEnd(WGPUComputePassEncoder) {
+    MOCK_CALL();
+}
+
+void wgpuComputePassEncoderEndPipelineStatisticsQuery(WGPUComputePassEncoder) {
+    MOCK_CALL();
+}
+
+void wgpuComputePassEncoderInsertDebugMarker(WGPUComputePassEncoder, char const*) {
+    MOCK_CALL();
+}
+
+void wgpuComputePassEncoderPopDebugGroup(WGPUComputePassEncoder) {
+    MOCK_CALL();
+}
+
+void wgpuComputePassEncoderPushDebugGroup(WGPUComputePassEncoder, char const*) {
+    MOCK_CALL();
+}
+
+void wgpuComputePassEncoderSetBindGroup(WGPUComputePassEncoder, uint32_t, WGPUBindGroup, uint32_t, uint32_t const*) {
+    MOCK_CALL();
+}
+
+void wgpuComputePassEncoderSetPipeline(WGPUComputePassEncoder, WGPUComputePipeline) {
+    MOCK_CALL();
+}
+
+// Pipelines
+
+WGPUBindGroupLayout wgpuComputePipelineGetBindGroupLayout(WGPUComputePipeline, uint32_t) {
+    MOCK_CALL();
+    return new WGPUBindGroupLayoutImpl();
+}
+
+WGPUBindGroupLayout wgpuRenderPipelineGetBindGroupLayout(WGPURenderPipeline, uint32_t) {
+    MOCK_CALL();
+    return new WGPUBindGroupLayoutImpl();
+}
+
+void wgpuShaderModuleGetCompilationInfo(WGPUShaderModule, WGPUCompilationInfoCallback callback, void* userdata) {
+    MOCK_CALL();
+    WGPUCompilationInfo info = {};
+    callback(WGPUCompilationInfoRequestStatus_Success, &info, userdata);
+}
+
+// Query set
+
+void wgpuQuerySetDestroy(WGPUQuerySet) {
+    MOCK_CALL();
+}
+
+uint32_t wgpuQuerySetGetCount(WGPUQuerySet querySet) {
+    MOCK_CALL();
+    return querySet->count;
+}
+
+WGPUQueryType wgpuQuerySetGetType(WGPUQuerySet querySet) {
+    MOCK_CALL();
+    return querySet->queryType;
+}
+
+// Queue
+
+void wgpuQueueOnSubmittedWorkDone(WGPUQueue queue, WGPUQueueWorkDoneCallback callback, void* userdata) {
+    MOCK_CALL();
+    queue->shared->defer([callback, userdata]() { callback(WGPUQueueWorkDoneStatus_Success, userdata); });
+}
+
+void wgpuQueueSubmit(WGPUQueue queue, uint32_t commandCount, WGPUCommandBuffer const* commands) {
+    MOCK_CALL();
+    submit(queue, commandCount, commands);
+}
+
+WGPUSubmissionIndex wgpuQueueSubmitForIndex(WGPUQueue queue, uint32_t commandCount, WGPUCommandBuffer const* commands) {
+    MOCK_CALL();
+    return submit(queue, commandCount, commands);
+}
+
+void wgpuQueueWriteBuffer(WGPUQueue queue, WGPUBuffer buffer, uint64_t bufferOffset, void const* data, size_t size) {
+    MOCK_CALL();
+    if (!inRange(buffer, bufferOffset, size)) {
+        queue->shared->raise(WGPUErrorType_Validation, "writeBuffer out of the bounds of the buffer");
+        return;
+    }
+    if (size > 0) std::memcpy(buffer->data.data() + bufferOffset, data, size);
+}
+
+void wgpuQueueWriteTexture(WGPUQueue, WGPUImageCopyTexture const*, void const*, size_t, WGPUTextureDataLayout const*, WGPUExtent3D const*) {
+    MOCK_CALL();
+}
+
+// Render bundle encoder: recorded, never run
+
+void wgpuRenderBundleEncoderDraw(WGPURenderBundleEncoder, uint32_t, uint32_t, uint32_t, uint32_t) {
+    MOCK_CALL();
+}
+
+void wgpuRenderBundleEncoderDrawIndexed(WGPURenderBundleEncoder, uint32_t, uint32_t, uint32_t, int32_t, uint32_t) {
+    MOCK_CALL();
+}
+
+void wgpuRenderBundleEncoderDrawIndexedIndirect(WGPURenderBundleEncoder, WGPUBuffer, uint64_t) {
+    MOCK_CALL();
+}
+
+void wgpuRenderBundleEncoderDrawIndirect(WGPURenderBundleEncoder, WGPUBuffer, uint64_t) {
+    MOCK_CALL();
+}
+
+WGPURenderBundle wgpuRenderBundleEncoderFinish(WGPURenderBundleEncoder, WGPURenderBundleDescriptor const* descriptor) {
+    MOCK_CALL();
+    WGPURenderBundle bundle = new WGPURenderBundleImpl();
+    setLabel(bundle, descriptor);
+    return bundle;
+}
+
+void wgpuRenderBundleEncoderInsertDebugMarker(WGPURenderBundleEncoder, char const*) {
+    MOCK_CALL();
+}
+
+void wgpuRenderBundleEncoderPopDebugGroup(WGPURenderBundleEncoder) {
+    MOCK_CALL();
+}
+
+void wgpuRenderBundleEncoderPushDebugGroup(WGPURenderBundleEncoder, char const*) {
+    MOCK_CALL();
+}
+
+void wgpuRenderBundleEncoderSetBindGroup(WGPURenderBundleEncoder, uint32_t, WGPUBindGroup, uint32_t, uint32_t const*) {
+    MOCK_CALL();
+}
+
+void wgpuRenderBundleEncoderSetIndexBuffer(WGPURenderBundleEncoder, WGPUBuffer, WGPUIndexFormat, uint64_t, uint64_t) {
+    MOCK_CALL();
+}
+
+void wgpuRenderBundleEncoderSetPipeline(WGPURenderBundleEncoder, WGPURenderPipeline) {
+    MOCK_CALL();
+}
+
+void wgpuRenderBundleEncoderSetVertexBuffer(WGPURenderBundleEncoder, uint32_t, WGPUBuffer, uint64_t, uint64_t) {
+    MOCK_CALL();
+}
+
+// Render pass: recorded, never run
+
+void wgpuRenderPassEncoderBeginOcclusionQuery(WGPURenderPassEncoder, uint32_t) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderBeginPipelineStatisticsQuery(WGPURenderPassEncoder, WGPUQuerySet, uint32_t) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderDraw(WGPURenderPassEncoder, uint32_t, uint32_t, uint32_t, uint32_t) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderDrawIndexed(WGPURenderPassEncoder, uint32_t, uint32_t, uint32_t, int32_t, uint32_t) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderDrawIndexedIndirect(WGPURenderPassEncoder, WGPUBuffer, uint64_t) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderDrawIndirect(WGPURenderPassEncoder, WGPUBuffer, uint64_t) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderEnd(WGPURenderPassEncoder) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderEndOcclusionQuery(WGPURenderPassEncoder) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderEndPipelineStatisticsQuery(WGPURenderPassEncoder) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderExecuteBundles(WGPURenderPassEncoder, uint32_t, WGPURenderBundle const*) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderInsertDebugMarker(WGPURenderPassEncoder, char const*) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderPopDebugGroup(WGPURenderPassEncoder) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderPushDebugGroup(WGPURenderPassEncoder, char const*) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderSetBindGroup(WGPURenderPassEncoder, uint32_t, WGPUBindGroup, uint32_t, uint32_t const*) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderSetBlendConstant(WGPURenderPassEncoder, WGPUColor const*) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderSetIndexBuffer(WGPURenderPassEncoder, WGPUBuffer, WGPUIndexFormat, uint64_t, uint64_t) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderSetPipeline(WGPURenderPassEncoder, WGPURenderPipeline) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderSetScissorRect(WGPURenderPassEncoder, uint32_t, uint32_t, uint32_t, uint32_t) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderSetStencilReference(WGPURenderPassEncoder, uint32_t) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderSetVertexBuffer(WGPURenderPassEncoder, uint32_t, WGPUBuffer, uint64_t, uint64_t) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderSetViewport(WGPURenderPassEncoder, float, float, float, float, float, float) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderSetPushConstants(WGPURenderPassEncoder, WGPUShaderStageFlags, uint32_t, uint32_t, void* const) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderMultiDrawIndirect(WGPURenderPassEncoder, WGPUBuffer, uint64_t, uint32_t) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderMultiDrawIndexedIndirect(WGPURenderPassEncoder, WGPUBuffer, uint64_t, uint32_t) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderMultiDrawIndirectCount(WGPURenderPassEncoder, WGPUBuffer, uint64_t, WGPUBuffer, uint64_t, uint32_t) {
+    MOCK_CALL();
+}
+
+void wgpuRenderPassEncoderMultiDrawIndexedIndirectCount(WGPURenderPassEncoder, WGPUBuffer, uint64_t, WGPUBuffer, uint64_t, uint32_t) {
+    MOCK_CALL();
+}
+
+// Surface and swap chain
+
+WGPUTextureFormat wgpuSurfaceGetPreferredFormat(WGPUSurface, WGPUAdapter) {
+    MOCK_CALL();
+    return WGPUTextureFormat_BGRA8Unorm;
+}
+
+void wgpuSurfaceGetCapabilities(WGPUSurface, WGPUAdapter, WGPUSurfaceCapabilities* capabilities) {
+    MOCK_CALL();
+    // Counts first, then the arrays if the caller provides them
+    capabilities->formatCount = 1;
+    if (capabilities->formats) capabilities->formats[0] = WGPUTextureFormat_BGRA8Unorm;
+    capabilities->presentModeCount = 2;
+    if (capabilities->presentModes) {
+        capabilities->presentModes[0] = WGPUPresentMode_Fifo;
+        capabilities->presentModes[1] = WGPUPresentMode_Immediate;
+    }
+    capabilities->alphaModeCount = 1;
+    if (capabilities->alphaModes) capabilities->alphaModes[0] = WGPUCompositeAlphaMode_Opaque;
+}
+
+WGPUTextureView wgpuSwapChainGetCurrentTextureView(WGPUSwapChain) {
+    MOCK_CALL();
+    return new WGPUTextureViewImpl();
+}
+
+void wgpuSwapChainPresent(WGPUSwapChain) {
+    MOCK_CALL();
+}
+
+// Texture
+
+WGPUTextureView wgpuTextureCreateView(WGPUTexture, WGPUTextureViewDescriptor const* descriptor) {
+    MOCK_CALL();
+    WGPUTextureView view = new WGPUTextureViewImpl();
+    setLabel(view, descriptor);
+    return view;
+}
+
+void wgpuTextureDestroy(WGPUTexture) {
+    MOCK_CALL();
+}
+
+uint32_t wgpuTextureGetDepthOrArrayLayers(WGPUTexture texture) {
+    MOCK_CALL();
+    return texture->size.depthOrArrayLayers;
+}
+
+WGPUTextureDimension wgpuTextureGetDimension(WGPUTexture texture) {
+    MOCK_CALL();
+    return texture->dimension;
+}
+
+WGPUTextureFormat wgpuTextureGetFormat(WGPUTexture texture) {
+    MOCK_CALL();
+    return texture->format;
+}
+
+uint32_t wgpuTextureGetHeight(WGPUTexture texture) {
+    MOCK_CALL();
+    return texture->size.height;
+}
+
+uint32_t wgpuTextureGetMipLevelCount(WGPUTexture texture) {
+    MOCK_CALL();
+    return texture->mipLevelCount;
+}
+
+uint32_t wgpuTextureGetSampleCount(WGPUTexture texture) {
+    MOCK_CALL();
+    return texture->sampleCount;
+}
+
+WGPUTextureUsage wgpuTextureGetUsage(WGPUTexture texture) {
+    MOCK_CALL();
+    return static_cast<WGPUTextureUsage>(texture->usage);
+}
+
+uint32_t wgpuTextureGetWidth(WGPUTexture texture) {
+    MOCK_CALL();
+    return texture->size.width;
+}
+
+// wgpu-native extensions
+
+void wgpuGenerateReport(WGPUInstance, WGPUGlobalReport* report) {
+    MOCK_CALL();
+    *report = {};
+    report->backendType = WGPUBackendType_Null;
+    fillStorageReport(report->surfaces, ObjectType::Surface);
+    // Any hub will do: readers add them up
+    WGPUHubReport& hub = report->vulkan;
+    fillStorageReport(hub.adapters, ObjectType::Adapter);
+    fillStorageReport(hub.devices, ObjectType::Device);
+    fillStorageReport(hub.pipelineLayouts, ObjectType::PipelineLayout);
+    fillStorageReport(hub.shaderModules, ObjectType::ShaderModule);
+    fillStorageReport(hub.bindGroupLayouts, ObjectType::BindGroupLayout);
+    fillStorageReport(hub.bindGroups, ObjectType::BindGroup);
+    fillStorageReport(hub.commandBuffers, ObjectType::CommandBuffer);
+    fillStorageReport(hub.renderBundles, ObjectType::RenderBundle);
+    fillStorageReport(hub.renderPipelines, ObjectType::RenderPipeline);
+    fillStorageReport(hub.computePipelines, ObjectType::ComputePipeline);
+    fillStorageReport(hub.querySets, ObjectType::QuerySet);
+    fillStorageReport(hub.buffers, ObjectType::Buffer);
+    fillStorageReport(hub.textures, ObjectType::Texture);
+    fillStorageReport(hub.textureViews, ObjectType::TextureView);
+    fillStorageReport(hub.samplers, ObjectType::Sampler);
+}
+
+void wgpuSetLogCallback(WGPULogCallback callback, void* userdata) {
+    MOCK_CALL();
+    MockState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.logCallback = callback;
+    s.logUserdata = userdata;
+}
+
+void wgpuSetLogLevel(WGPULogLevel level) {
+    MOCK_CALL();
+    MockState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.logLevel = level;
+}
+
+uint32_t wgpuGetVersion(void) {
+    MOCK_CALL();
+    return 0;
+}
+
+} // extern "C"
+
+uint64_t MockWebGpu::totalCallCount() {
+    return state().totalCalls.load(std::memory_order_relaxed);
+}
+
+uint64_t MockWebGpu::callCount(const char* function) {
+    for (CallCounter* counter = state().counters.load(std::memory_order_acquire); counter; counter = counter->next) {
+        if (std::strcmp(counter->function, function) == 0) return counter->count.load(std::memory_order_relaxed);
+    }
+    return 0;
+}
+
+std::vector<MockWebGpu::CallCount> MockWebGpu::callCounts() {
+    std::vector<CallCount> counts;
+    for (CallCounter* counter = state().counters.load(std::memory_order_acquire); counter; counter = counter->next) {
+        uint64_t count = counter->count.load(std::memory_order_relaxed);
+        if (count > 0) counts.push_back({ counter->function, count });
+    }
+    std::sort(counts.begin(), counts.end(), [](const CallCount& a, const CallCount& b) {
+        return std::strcmp(a.function, b.function) < 0;
+    });
+    return counts;
+}
+
+void MockWebGpu::resetCallCounts() {
+    MockState& s = state();
+    for (CallCounter* counter = s.counters.load(std::memory_order_acquire); counter; counter = counter->next) {
+        counter->count.store(0, std::memory_order_relaxed);
+    }
+    s.totalCalls.store(0, std::memory_order_relaxed);
+}
+
+void MockWebGpu::setRecording(bool recording) {
+    state().recording.store(recording, std::memory_order_relaxed);
+}
+
+std::vector<const char*> MockWebGpu::takeRecordedCalls() {
+    MockState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    std::vector<const char*> recorded;
+    recorded.swap(s.recorded);
+    return recorded;
+}
+
+int64_t MockWebGpu::liveObjectCount() {
+    int64_t count = 0;
+    for (const std::atomic<int64_t>& live : state().liveObjects) count += live.load(std::memory_order_relaxed);
+    return count;
+}
+
+void MockWebGpu::report(std::ostream& out) {
+    out << "MockWebGpu: " << totalCallCount() << " calls, " << liveObjectCount() << " objects alive" << std::endl;
+    for (const CallCount& count : callCounts()) {
+        out << "  " << count.function << ": " << count.count << std::endl;
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+/**
+ * A recording stand-in for wgpu-native, linked in its place when configured
+ * with -DWEBGPU_MOCK=ON, so that the benchmarks run on machines without a
+ * GPU (CI).
+ *
+ * Every entry point of webgpu.h and wgpu.h is implemented on the CPU.
+ * Objects are reference counted host allocations. Buffers keep their bytes,
+ * so writeBuffer, buffer copies, clears and mapping behave as they would on
+ * a device, and out of range copies raise validation errors (to the error
+ * scopes, or the uncaptured error callback). Map and work done callbacks
+ * run from the next wgpuDevicePoll or wgpuInstanceProcessEvents, the others
+ * right away. Shaders never run: dispatches and draws are only counted, so
+ * kernels compute nothing.
+ *
+ * Each call is counted per entry point, which makes the API cost of a
+ * benchmark deterministic, and can be recorded in order.
+ */
+class MockWebGpu {
+public:
+    struct CallCount {
+        // Name of the C entry point, e.g. "wgpuQueueWriteBuffer"
+        const char* function;
+        uint64_t count;
+    };
+
+    static uint64_t totalCallCount();
+    static uint64_t callCount(const char* function);
+    /**
+     * Entry points called at least once, by name.
+     */
+    static std::vector<CallCount> callCounts();
+    static void resetCallCounts();
+
+    /**
+     * Keep the name of every call, in order, until takeRecordedCalls().
+     */
+    static void setRecording(bool recording);
+    static std::vector<const char*> takeRecordedCalls();
+
+    /**
+     * Objects not released yet, of every type.
+     */
+    static int64_t liveObjectCount();
+
+    static void report(std::ostream& out);
+};
@@ -0,0 +1,3 @@
+// Third party code: built without warnings, see CMakeLists.txt
+#define NK_IMPLEMENTATION
+#include "NuklearConfig.h"
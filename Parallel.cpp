@@ -0,0 +1,29 @@
+#include "Parallel.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+unsigned parallelThreadCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+size_t parallelChunkCount(size_t count, size_t minChunkSize) {
+    if (count == 0) return 0;
+    size_t chunks = count / std::max<size_t>(minChunkSize, 1);
+    return std::max<size_t>(1, std::min<size_t>(chunks, parallelThreadCount()));
+}
+
+void parallelChunks(size_t count, size_t minChunkSize, const std::function<void(size_t chunk, size_t begin, size_t end)>& f) {
+    size_t chunkCount = parallelChunkCount(count, minChunkSize);
+    if (chunkCount == 0) return;
+
+    auto chunkBegin = [&](size_t chunk) { return count * chunk / chunkCount; };
+    std::vector<std::thread> threads;
+    threads.reserve(chunkCount - 1);
+    for (size_t chunk = 1; chunk < chunkCount; ++chunk) {
+        threads.emplace_back(f, chunk, chunkBegin(chunk), chunkBegin(chunk + 1));
+    }
+    f(0, 0, chunkBegin(1));
+    for (std::thread& thread : threads) thread.join();
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+/**
+ * Minimal fork-join helpers for the CPU fallbacks of the compute kernels.
+ * Threads are started for each call, which is fine for the large arrays
+ * these are meant for, and not for small ones: use minChunkSize.
+ */
+
+/**
+ * Hardware threads, at least 1.
+ */
+unsigned parallelThreadCount();
+
+/**
+ * Number of chunks parallelChunks() splits count items into: at most one per
+ * thread, and each at least minChunkSize items (except when count is
+ * smaller). 0 when count is 0.
+ */
+size_t parallelChunkCount(size_t count, size_t minChunkSize);
+
+/**
+ * Call f(chunk, begin, end) for each of the parallelChunkCount() contiguous
+ * chunks of [0, count), one per thread, and wait for all of them. The
+ * calling thread runs the first chunk.
+ */
+void parallelChunks(size_t count, size_t minChunkSize, const std::function<void(size_t chunk, size_t begin, size_t end)>& f);
@@ -0,0 +1,620 @@
+#include "ParticleSystem.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+const char* particleComputeSource = R"(
+struct Particle {
+	position: vec3f,
+	life: f32,
+	velocity: vec3f,
+	size: f32,
+}
+
+struct Params {
+	dt: f32,
+	gravity: f32,
+	emitCount: u32,
+	seed: u32,
+	capacity: u32,
+	maxWorkgroupsPerDimension: u32,
+}
+
+// ParticleSystem state buffer
+struct State {
+	dispatchX: u32,
+	dispatchY: u32,
+	dispatchZ: u32,
+	count: atomic<u32>,
+	vertexCount: u32,
+	instanceCount: u32,
+	firstVertex: u32,
+	firstInstance: u32,
+	depthKeysDispatchX: u32,
+	depthKeysDispatchY: u32,
+	depthKeysDispatchZ: u32,
+	depthKeysCount: u32,
+}
+
+override workgroupSize: u32 = 256u;
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var<storage, read> particlesIn: array<Particle>;
+@group(0) @binding(2) var<storage, read_write> particlesOut: array<Particle>;
+// Also the indirect buffer of simulate, so it cannot hold atomics
+@group(0) @binding(3) var<storage, read> stateIn: array<u32, 12>;
+@group(0) @binding(4) var<storage, read_write> stateOut: State;
+@group(0) @binding(5) var<storage, read_write> keys: array<u32>;
+@group(0) @binding(6) var<storage, read_write> order: array<u32>;
+
+var<workgroup> localCount: atomic<u32>;
+var<workgroup> localBase: u32;
+
+// PCG hash, as in the CPU reference
+fn hash(x: u32) -> u32 {
+	let state = x * 747796405u + 2891336453u;
+	let word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	return (word >> 22u) ^ word;
+}
+
+fn unit(h: u32) -> f32 {
+	return f32(h >> 8u) / 16777216.0;
+}
+
+fn spawn(index: u32) -> Particle {
+	var h = hash((params.seed * 2654435769u) ^ index);
+	var p: Particle;
+	p.position.x = 0.1 * (unit(h) - 0.5);
+	h = hash(h);
+	p.position.y = -0.8;
+	p.position.z = 0.2 + 0.6 * unit(h);
+	h = hash(h);
+	p.velocity.x = 0.6 * (unit(h) - 0.5);
+	h = hash(h);
+	p.velocity.y = 1.2 + 0.6 * unit(h);
+	h = hash(h);
+	p.velocity.z = 0.1 * (unit(h) - 0.5);
+	h = hash(h);
+	// Multiples of 1/64 s, so that with dt = 1/64 s lifetimes end exactly
+	p.life = f32(1u + h % 192u) / 64.0;
+	h = hash(h);
+	p.size = 0.01 + 0.02 * unit(h);
+	return p;
+}
+
+@compute @workgroup_size(1)
+fn reset() {
+	atomicStore(&stateOut.count, 0u);
+}
+
+@compute @workgroup_size(workgroupSize)
+fn simulate(
+	@builtin(local_invocation_index) localIndex: u32,
+	@builtin(global_invocation_id) id: vec3<u32>,
+	@builtin(num_workgroups) groups: vec3<u32>
+) {
+	let index = id.x + id.y * groups.x * workgroupSize;
+	if (localIndex == 0u) {
+		atomicStore(&localCount, 0u);
+	}
+	workgroupBarrier();
+
+	var p: Particle;
+	var alive = false;
+	var localOffset = 0u;
+	if (index < stateIn[3]) {
+		p = particlesIn[index];
+		p.velocity.y = p.velocity.y - params.gravity * params.dt;
+		p.position = p.position + p.velocity * params.dt;
+		if (p.position.y < -1.0) {
+			p.position.y = -1.0;
+			p.velocity.y = -0.5 * p.velocity.y;
+		}
+		p.life = p.life - params.dt;
+		alive = p.life > 0.0;
+	}
+	if (alive) {
+		localOffset = atomicAdd(&localCount, 1u);
+	}
+	workgroupBarrier();
+
+	// Compaction of the survivors, one global atomic per workgroup
+	if (localIndex == 0u) {
+		localBase = atomicAdd(&stateOut.count, atomicLoad(&localCount));
+	}
+	workgroupBarrier();
+
+	if (alive) {
+		particlesOut[localBase + localOffset] = p;
+	}
+}
+
+@compute @workgroup_size(workgroupSize)
+fn emit(@builtin(global_invocation_id) id: vec3<u32>, @builtin(num_workgroups) groups: vec3<u32>) {
+	let index = id.x + id.y * groups.x * workgroupSize;
+	if (index >= params.emitCount) {
+		return;
+	}
+	// The count may go past the capacity, finalize clamps it
+	let slot = atomicAdd(&stateOut.count, 1u);
+	if (slot < params.capacity) {
+		particlesOut[slot] = spawn(index);
+	}
+}
+
+fn workgroupCounts(invocationCount: u32) -> vec3<u32> {
+	let groupCount = (invocationCount + workgroupSize - 1u) / workgroupSize;
+	if (groupCount <= params.maxWorkgroupsPerDimension) {
+		return vec3<u32>(groupCount, 1u, 1u);
+	}
+	let maxGroups = params.maxWorkgroupsPerDimension;
+	return vec3<u32>(maxGroups, (groupCount + maxGroups - 1u) / maxGroups, 1u);
+}
+
+@compute @workgroup_size(1)
+fn finalize() {
+	let count = min(atomicLoad(&stateOut.count), params.capacity);
+	atomicStore(&stateOut.count, count);
+	let groups = workgroupCounts(count);
+	stateOut.dispatchX = groups.x;
+	stateOut.dispatchY = groups.y;
+	stateOut.dispatchZ = groups.z;
+	// One quad per particle
+	stateOut.vertexCount = 6u;
+	stateOut.instanceCount = count;
+	stateOut.firstVertex = 0u;
+	stateOut.firstInstance = 0u;
+	// Also over the keys of the previous update, to clear those past the
+	// new count
+	let keysCount = max(count, stateIn[3]);
+	let keysGroups = workgroupCounts(keysCount);
+	stateOut.depthKeysDispatchX = keysGroups.x;
+	stateOut.depthKeysDispatchY = keysGroups.y;
+	stateOut.depthKeysDispatchZ = keysGroups.z;
+	stateOut.depthKeysCount = keysCount;
+}
+
+// Farthest first; empty slots sort last. Bound with the state of this
+// update as stateIn, since it is also the indirect buffer. Keys past
+// depthKeysCount are already cleared: the previous sort moved them there.
+@compute @workgroup_size(workgroupSize)
+fn depthKeys(@builtin(global_invocation_id) id: vec3<u32>, @builtin(num_workgroups) groups: vec3<u32>) {
+	let index = id.x + id.y * groups.x * workgroupSize;
+	if (index >= stateIn[11]) {
+		return;
+	}
+	var key = 0xffffffffu;
+	if (index < stateIn[3]) {
+		key = ~bitcast<u32>(clamp(particlesOut[index].position.z, 0.0, 1.0));
+	}
+	keys[index] = key;
+	order[index] = index;
+}
+)";
+
+const char* particleRenderSource = R"(
+struct Particle {
+	position: vec3f,
+	life: f32,
+	velocity: vec3f,
+	size: f32,
+}
+
+@group(0) @binding(0) var<storage, read> particles: array<Particle>;
+@group(0) @binding(1) var<storage, read> order: array<u32>;
+
+struct VertexOutput {
+	@builtin(position) position: vec4f,
+	@location(0) uv: vec2f,
+	@location(1) color: vec4f,
+}
+
+@vertex
+fn vs_main(@builtin(vertex_index) vertexIndex: u32, @builtin(instance_index) instanceIndex: u32) -> VertexOutput {
+	var corners = array<vec2f, 6>(
+		vec2f(-1.0, -1.0), vec2f(1.0, -1.0), vec2f(1.0, 1.0),
+		vec2f(-1.0, -1.0), vec2f(1.0, 1.0), vec2f(-1.0, 1.0)
+	);
+	let corner = corners[vertexIndex];
+	let p = particles[order[instanceIndex]];
+	var out: VertexOutput;
+	out.position = vec4f(p.position.xy + p.size * corner, p.position.z, 1.0);
+	out.uv = corner;
+	// Fades from yellow to red as the particle ages
+	let t = clamp(p.life / 3.0, 0.0, 1.0);
+	out.color = vec4f(1.0, 0.2 + 0.7 * t, 0.1, 0.3 + 0.5 * t);
+	return out;
+}
+
+@fragment
+fn fs_main(in: VertexOutput) -> @location(0) vec4f {
+	let d = length(in.uv);
+	if (d > 1.0) {
+		discard;
+	}
+	return vec4f(in.color.rgb, in.color.a * (1.0 - d * d));
+}
+)";
+
+// CPU references of the compute entry points, in the same order of
+// operations
+
+uint32_t hash(uint32_t x) {
+    uint32_t state = x * 747796405u + 2891336453u;
+    uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+float unit(uint32_t h) {
+    return float(h >> 8) / 16777216.0f;
+}
+
+ParticleSystem::Particle spawn(uint32_t seed, uint32_t index) {
+    uint32_t h = hash((seed * 2654435769u) ^ index);
+    ParticleSystem::Particle p;
+    p.position[0] = 0.1f * (unit(h) - 0.5f);
+    h = hash(h);
+    p.position[1] = -0.8f;
+    p.position[2] = 0.2f + 0.6f * unit(h);
+    h = hash(h);
+    p.velocity[0] = 0.6f * (unit(h) - 0.5f);
+    h = hash(h);
+    p.velocity[1] = 1.2f + 0.6f * unit(h);
+    h = hash(h);
+    p.velocity[2] = 0.1f * (unit(h) - 0.5f);
+    h = hash(h);
+    p.life = float(1u + h % 192u) / 64.0f;
+    h = hash(h);
+    p.size = 0.01f + 0.02f * unit(h);
+    return p;
+}
+
+template <typename T>
+T* hostArray(const KernelArgs& args, size_t index) {
+    return static_cast<GpuArray<T>*>(args[index])->host();
+}
+
+// Argument indices, in binding order
+constexpr size_t ParamsArg = 0;
+constexpr size_t ParticlesInArg = 1;
+constexpr size_t ParticlesOutArg = 2;
+constexpr size_t StateInArg = 3;
+constexpr size_t StateOutArg = 4;
+constexpr size_t KeysArg = 5;
+constexpr size_t OrderArg = 6;
+constexpr uint32_t CountIndex = 3;
+constexpr uint32_t DepthKeysCountIndex = 11;
+constexpr size_t StateSize = 12;
+
+// Workgroup counts of an indirect dispatch, as in finalize
+void writeWorkgroupCounts(uint32_t* groups, uint32_t invocationCount, uint32_t maxGroups) {
+    const uint32_t groupCount = (invocationCount + ParticleSystem::WorkgroupSize - 1) / ParticleSystem::WorkgroupSize;
+    groups[0] = std::min(groupCount, maxGroups);
+    groups[1] = groupCount <= maxGroups ? 1 : (groupCount + maxGroups - 1) / maxGroups;
+    groups[2] = 1;
+}
+
+} // namespace
+
+ParticleSystem::ParticleSystem(ComputeContext& context, const Options& options)
+    : m_context(context)
+    , m_options(options)
+{
+    assert(options.capacity > 0);
+    m_maxEmitCount = static_cast<uint32_t>(std::ceil(options.emitPerSecond * options.maxTimeStep));
+
+    m_params = std::make_unique<GpuArray<Params>>(context, 1, WGPUBufferUsage_Uniform);
+    for (int i = 0; i < 2; ++i) {
+        // Zero initialized, so the first update starts from no particles
+        m_particles[i] = std::make_unique<GpuArray<Particle>>(context, options.capacity);
+        m_state[i] = std::make_unique<GpuArray<uint32_t>>(context, StateSize, WGPUBufferUsage_Indirect);
+    }
+    m_keys = std::make_unique<GpuArray<uint32_t>>(context, options.capacity);
+    // depthKeys only writes the keys in use, the others must sort last
+    m_keys->upload(std::vector<uint32_t>(options.capacity, 0xffffffffu));
+    m_order = std::make_unique<GpuArray<uint32_t>>(context, options.capacity);
+    m_sort = std::make_unique<RadixSort>(context, SortKeyType::U32);
+    createKernels();
+
+    for (uint32_t front = 0; front < 2; ++front) {
+        const uint32_t back = 1 - front;
+        KernelArgs args = { m_params.get(), m_particles[front].get(), m_particles[back].get(),
+            m_state[front].get(), m_state[back].get(), m_keys.get(), m_order.get() };
+
+        auto chain = std::make_unique<ComputeChain>(context, "Particles");
+        chain->add(*m_resetKernel, args, 1);
+        chain->addIndirect(*m_simulateKernel, args, *m_state[front], DispatchArgsOffset);
+        if (m_maxEmitCount > 0) chain->add(*m_emitKernel, args, m_maxEmitCount);
+        chain->add(*m_finalizeKernel, args, 1);
+        // Also writes the identity order that draw() goes through when not
+        // sorting
+        KernelArgs depthKeysArgs = args;
+        depthKeysArgs[StateInArg] = m_state[back].get();
+        depthKeysArgs[StateOutArg] = m_state[front].get();
+        chain->addIndirect(*m_depthKeysKernel, depthKeysArgs, *m_state[back], DepthKeysDispatchArgsOffset);
+        if (options.sortByDepth) {
+            chain->addStep("Depth sort", [this](wgpu::ComputePassEncoder pass) {
+                return m_sort->encode(pass, *m_keys, m_order.get(), m_options.capacity);
+            }, [this]() {
+                return m_sort->run(*m_keys, m_order.get(), m_options.capacity);
+            });
+        }
+        m_chains[front] = std::move(chain);
+    }
+}
+
+ParticleSystem::~ParticleSystem() {
+    // Chains hold bind groups on the kernels and arrays
+    m_chains[0].reset();
+    m_chains[1].reset();
+    releaseRenderPipeline();
+}
+
+void ParticleSystem::createKernels() {
+    KernelDesc desc;
+    desc.source = particleComputeSource;
+    desc.workgroupSize = WorkgroupSize;
+    desc.bindings = {
+        KernelBinding::Uniform,
+        KernelBinding::ReadOnlyStorage,
+        KernelBinding::Storage,
+        KernelBinding::ReadOnlyStorage,
+        KernelBinding::Storage,
+        KernelBinding::Storage,
+        KernelBinding::Storage,
+    };
+
+    desc.label = "Particles reset";
+    desc.entryPoint = "reset";
+    desc.cpuReference = [](const KernelArgs& args, uint32_t) {
+        hostArray<uint32_t>(args, StateOutArg)[CountIndex] = 0;
+    };
+    m_resetKernel = std::make_unique<Kernel>(m_context, desc);
+
+    desc.label = "Particles simulate";
+    desc.entryPoint = "simulate";
+    desc.cpuReference = [](const KernelArgs& args, uint32_t invocationCount) {
+        const Params& params = *hostArray<Params>(args, ParamsArg);
+        const Particle* in = hostArray<Particle>(args, ParticlesInArg);
+        Particle* out = hostArray<Particle>(args, ParticlesOutArg);
+        const uint32_t count = std::min(hostArray<uint32_t>(args, StateInArg)[CountIndex], invocationCount);
+        uint32_t& outCount = hostArray<uint32_t>(args, StateOutArg)[CountIndex];
+        for (uint32_t i = 0; i < count; ++i) {
+            Particle p = in[i];
+            p.velocity[1] = p.velocity[1] - params.gravity * params.dt;
+            for (int c = 0; c < 3; ++c) p.position[c] = p.position[c] + p.velocity[c] * params.dt;
+            if (p.position[1] < -1.0f) {
+                p.position[1] = -1.0f;
+                p.velocity[1] = -0.5f * p.velocity[1];
+            }
+            p.life = p.life - params.dt;
+            if (p.life > 0.0f) out[outCount++] = p;
+        }
+    };
+    m_simulateKernel = std::make_unique<Kernel>(m_context, desc);
+
+    desc.label = "Particles emit";
+    desc.entryPoint = "emit";
+    desc.cpuReference = [](const KernelArgs& args, uint32_t invocationCount) {
+        const Params& params = *hostArray<Params>(args, ParamsArg);
+        Particle* out = hostArray<Particle>(args, ParticlesOutArg);
+        uint32_t& outCount = hostArray<uint32_t>(args, StateOutArg)[CountIndex];
+        for (uint32_t i = 0; i < std::min(params.emitCount, invocationCount); ++i) {
+            uint32_t slot = outCount++;
+            if (slot < params.capacity) out[slot] = spawn(params.seed, i);
+        }
+    };
+    m_emitKernel = std::make_unique<Kernel>(m_context, desc);
+
+    desc.label = "Particles arguments";
+    desc.entryPoint = "finalize";
+    desc.cpuReference = [](const KernelArgs& args, uint32_t) {
+        const Params& params = *hostArray<Params>(args, ParamsArg);
+        const uint32_t previousCount = hostArray<uint32_t>(args, StateInArg)[CountIndex];
+        uint32_t* state = hostArray<uint32_t>(args, StateOutArg);
+        const uint32_t count = std::min(state[CountIndex], params.capacity);
+        writeWorkgroupCounts(state, count, params.maxWorkgroupsPerDimension);
+        state[CountIndex] = count;
+        state[4] = 6;
+        state[5] = count;
+        state[6] = 0;
+        state[7] = 0;
+        const uint32_t keysCount = std::max(count, previousCount);
+        writeWorkgroupCounts(state + 8, keysCount, params.maxWorkgroupsPerDimension);
+        state[DepthKeysCountIndex] = keysCount;
+    };
+    m_finalizeKernel = std::make_unique<Kernel>(m_context, desc);
+
+    desc.label = "Particles depth keys";
+    desc.entryPoint = "depthKeys";
+    desc.cpuReference = [](const KernelArgs& args, uint32_t invocationCount) {
+        const Particle* particles = hostArray<Particle>(args, ParticlesOutArg);
+        const uint32_t* state = hostArray<uint32_t>(args, StateInArg);
+        const uint32_t count = state[CountIndex];
+        uint32_t* keys = hostArray<uint32_t>(args, KeysArg);
+        uint32_t* order = hostArray<uint32_t>(args, OrderArg);
+        for (uint32_t i = 0; i < std::min(state[DepthKeysCountIndex], invocationCount); ++i) {
+            uint32_t key = 0xffffffffu;
+            if (i < count) {
+                float depth = std::min(std::max(particles[i].position[2], 0.0f), 1.0f);
+                std::memcpy(&key, &depth, sizeof(float));
+                key = ~key;
+            }
+            keys[i] = key;
+            order[i] = i;
+        }
+    };
+    m_depthKeysKernel = std::make_unique<Kernel>(m_context, desc);
+}
+
+bool ParticleSystem::update(float dt) {
+    if (m_context.hasGpu() && m_particles[0]->buffer().getSize() > m_context.maxStorageBufferBindingSize()) {
+        std::cerr << "ParticleSystem: " << m_options.capacity << " particles exceed the storage binding limit of "
+            << m_context.maxStorageBufferBindingSize() << " bytes" << std::endl;
+        return false;
+    }
+
+    dt = std::min(std::max(dt, 0.0f), m_options.maxTimeStep);
+
+    // Fractional particles carry over to the next update
+    m_emitRemainder += double(m_options.emitPerSecond) * dt;
+    uint32_t emitCount = static_cast<uint32_t>(std::min<double>(m_emitRemainder, m_maxEmitCount));
+    m_emitRemainder -= emitCount;
+
+    Params params = {};
+    params.dt = dt;
+    params.gravity = m_options.gravity;
+    params.emitCount = emitCount;
+    params.seed = m_frameIndex;
+    params.capacity = m_options.capacity;
+    params.maxWorkgroupsPerDimension = m_context.maxWorkgroupsPerDimension();
+    m_params->upload(&params, 1);
+
+    if (!m_chains[m_front]->run()) return false;
+    m_front = 1 - m_front;
+    ++m_frameIndex;
+    return true;
+}
+
+void ParticleSystem::createRenderPipeline(wgpu::TextureFormat colorFormat, wgpu::TextureFormat depthFormat, uint32_t sampleCount) {
+    assert(m_context.hasGpu());
+    releaseRenderPipeline();
+    wgpu::Device device = m_context.device();
+
+    wgpu::ShaderModuleWGSLDescriptor shaderCodeDesc;
+    shaderCodeDesc.chain.next = nullptr;
+    shaderCodeDesc.chain.sType = wgpu::SType::ShaderModuleWGSLDescriptor;
+    shaderCodeDesc.code = particleRenderSource;
+    wgpu::ShaderModuleDescriptor shaderDesc;
+    shaderDesc.nextInChain = &shaderCodeDesc.chain;
+    shaderDesc.label = "Particles render shader";
+    shaderDesc.hintCount = 0;
+    shaderDesc.hints = nullptr;
+    m_renderShaderModule = device.createShaderModule(shaderDesc);
+
+    wgpu::BindGroupLayoutEntry bindingLayouts[2] = { wgpu::Default, wgpu::Default };
+    for (uint32_t i = 0; i < 2; ++i) {
+        bindingLayouts[i].binding = i;
+        bindingLayouts[i].visibility = wgpu::ShaderStage::Vertex;
+        bindingLayouts[i].buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+    }
+    wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc;
+    bindGroupLayoutDesc.label = "Particles render bind group layout";
+    bindGroupLayoutDesc.entryCount = 2;
+    bindGroupLayoutDesc.entries = bindingLayouts;
+    m_renderBindGroupLayout = device.createBindGroupLayout(bindGroupLayoutDesc);
+
+    wgpu::PipelineLayoutDescriptor pipelineLayoutDesc;
+    pipelineLayoutDesc.label = "Particles render pipeline layout";
+    pipelineLayoutDesc.bindGroupLayoutCount = 1;
+    pipelineLayoutDesc.bindGroupLayouts = reinterpret_cast<WGPUBindGroupLayout*>(&m_renderBindGroupLayout);
+    m_renderPipelineLayout = device.createPipelineLayout(pipelineLayoutDesc);
+
+    // draw() reads the buffers written by the last update
+    for (uint32_t front = 0; front < 2; ++front) {
+        wgpu::BindGroupEntry bindings[2] = { wgpu::Default, wgpu::Default };
+        bindings[0].binding = 0;
+        bindings[0].buffer = m_particles[front]->buffer();
+        bindings[0].offset = 0;
+        bindings[0].size = m_particles[front]->buffer().getSize();
+        bindings[1].binding = 1;
+        bindings[1].buffer = m_order->buffer();
+        bindings[1].offset = 0;
+        bindings[1].size = m_order->buffer().getSize();
+        wgpu::BindGroupDescriptor bindGroupDesc;
+        bindGroupDesc.label = "Particles render bind group";
+        bindGroupDesc.layout = m_renderBindGroupLayout;
+        bindGroupDesc.entryCount = 2;
+        bindGroupDesc.entries = bindings;
+        m_renderBindGroups[front] = device.createBindGroup(bindGroupDesc);
+    }
+
+    wgpu::RenderPipelineDescriptor pipelineDesc;
+    pipelineDesc.label = "Particles render pipeline";
+    pipelineDesc.layout = m_renderPipelineLayout;
+    pipelineDesc.vertex.bufferCount = 0;
+    pipelineDesc.vertex.buffers = nullptr;
+    pipelineDesc.vertex.module = m_renderShaderModule;
+    pipelineDesc.vertex.entryPoint = "vs_main";
+    pipelineDesc.vertex.constantCount = 0;
+    pipelineDesc.vertex.constants = nullptr;
+    pipelineDesc.primitive.topology = wgpu::PrimitiveTopology::TriangleList;
+    pipelineDesc.primitive.stripIndexFormat = wgpu::IndexFormat::Undefined;
+    pipelineDesc.primitive.frontFace = wgpu::FrontFace::CCW;
+    pipelineDesc.primitive.cullMode = wgpu::CullMode::None;
+    // Hidden by the scene, but do not hide each other: they are blended
+    // back to front instead
+    wgpu::DepthStencilState depthStencilState = wgpu::Default;
+    depthStencilState.format = depthFormat;
+    depthStencilState.depthWriteEnabled = false;
+    depthStencilState.depthCompare = wgpu::CompareFunction::Less;
+    depthStencilState.stencilReadMask = 0;
+    depthStencilState.stencilWriteMask = 0;
+    pipelineDesc.depthStencil = &depthStencilState;
+    pipelineDesc.multisample.count = sampleCount;
+    pipelineDesc.multisample.mask = ~0u;
+    pipelineDesc.multisample.alphaToCoverageEnabled = false;
+
+    wgpu::FragmentState fragmentState;
+    fragmentState.module = m_renderShaderModule;
+    fragmentState.entryPoint = "fs_main";
+    fragmentState.constantCount = 0;
+    fragmentState.constants = nullptr;
+    wgpu::BlendState blendState;
+    blendState.color.srcFactor = wgpu::BlendFactor::SrcAlpha;
+    blendState.color.dstFactor = wgpu::BlendFactor::OneMinusSrcAlpha;
+    blendState.color.operation = wgpu::BlendOperation::Add;
+    blendState.alpha.srcFactor = wgpu::BlendFactor::Zero;
+    blendState.alpha.dstFactor = wgpu::BlendFactor::One;
+    blendState.alpha.operation = wgpu::BlendOperation::Add;
+    wgpu::ColorTargetState colorTarget;
+    colorTarget.format = colorFormat;
+    colorTarget.blend = &blendState;
+    colorTarget.writeMask = wgpu::ColorWriteMask::All;
+    fragmentState.targetCount = 1;
+    fragmentState.targets = &colorTarget;
+    pipelineDesc.fragment = &fragmentState;
+
+    m_renderPipeline = device.createRenderPipeline(pipelineDesc);
+}
+
+void ParticleSystem::releaseRenderPipeline() {
+    if (m_renderPipeline) m_renderPipeline.release();
+    for (wgpu::BindGroup& bindGroup : m_renderBindGroups) {
+        if (bindGroup) bindGroup.release();
+        bindGroup = nullptr;
+    }
+    if (m_renderPipelineLayout) m_renderPipelineLayout.release();
+    if (m_renderBindGroupLayout) m_renderBindGroupLayout.release();
+    if (m_renderShaderModule) m_renderShaderModule.release();
+    m_renderPipeline = nullptr;
+    m_renderPipelineLayout = nullptr;
+    m_renderBindGroupLayout = nullptr;
+    m_renderShaderModule = nullptr;
+}
+
+void ParticleSystem::draw(wgpu::RenderPassEncoder renderPass) {
+    assert(m_renderPipeline);
+    renderPass.setPipeline(m_renderPipeline);
+    renderPass.setBindGroup(0, m_renderBindGroups[m_front], 0, nullptr);
+    renderPass.drawIndirect(m_state[m_front]->buffer(), DrawArgsOffset);
+}
+
+uint32_t ParticleSystem::readCount() const {
+    if (!m_context.hasGpu()) return m_state[m_front]->host()[CountIndex];
+    return m_state[m_front]->download()[CountIndex];
+}
+
+std::vector<ParticleSystem::Particle> ParticleSystem::readParticles() const {
+    const uint32_t count = readCount();
+    std::vector<Particle> particles = m_particles[m_front]->download();
+    std::vector<uint32_t> order = m_order->download();
+    std::vector<Particle> result(count);
+    for (uint32_t i = 0; i < count; ++i) result[i] = particles[order[i]];
+    return result;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "ComputeChain.h"
+#include "ComputeRuntime.h"
+#include "RadixSort.h"
+
+#include <webgpu/webgpu.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Particles emitted, simulated, compacted, sorted and drawn without the CPU
+ * ever touching them. Each update is one compute pass (a ComputeChain):
+ *  1. simulate the live particles of the front buffer, appending the ones
+ *     that survive to the back buffer (dispatched indirectly, from the count
+ *     of the previous update),
+ *  2. emit new particles at the end of the back buffer,
+ *  3. write the count as dispatch arguments for the next update and draw
+ *     arguments for draw(),
+ *  4. write depth keys for the live particles (dispatched indirectly too),
+ *     and sort them back to front with RadixSort, for blending. The sort
+ *     covers the whole capacity, since RadixSort takes its count from the
+ *     CPU: keys past the live count are kept at the maximum so that they
+ *     stay last.
+ * The buffers are then swapped. The CPU only uploads a few constants per
+ * update, whatever the particle count.
+ *
+ * In CPU mode the chain runs its CPU reference executor, which simulates
+ * deterministically (same dt, same particles in the same order), so that
+ * tests can run on machines without a GPU. On the GPU, the order of the
+ * particles in memory depends on scheduling, but not the draw order.
+ */
+class ParticleSystem {
+public:
+    // Must match struct Particle in the shaders
+    struct Particle {
+        float position[3];
+        // Remaining seconds
+        float life;
+        float velocity[3];
+        float size;
+    };
+
+    struct Options {
+        uint32_t capacity = 1 << 20;
+        float emitPerSecond = 200000.0f;
+        float gravity = 0.8f;
+        bool sortByDepth = true;
+        // Longest time step, also bounds the particles emitted per update
+        float maxTimeStep = 0.1f;
+    };
+
+    static constexpr uint32_t WorkgroupSize = 256;
+    // Layout of the state buffers, in u32: simulate dispatch arguments (3),
+    // particle count (1), draw arguments (4), as StreamCompaction::args(),
+    // then depth keys dispatch arguments (3) and key count (1)
+    static constexpr uint64_t DispatchArgsOffset = 0;
+    static constexpr uint64_t CountOffset = 3 * sizeof(uint32_t);
+    static constexpr uint64_t DrawArgsOffset = 4 * sizeof(uint32_t);
+    static constexpr uint64_t DepthKeysDispatchArgsOffset = 8 * sizeof(uint32_t);
+
+    ParticleSystem(ComputeContext& context, const Options& options);
+    ~ParticleSystem();
+    ParticleSystem(const ParticleSystem&) = delete;
+    ParticleSystem& operator=(const ParticleSystem&) = delete;
+
+    /**
+     * Advance by dt seconds (clamped to options.maxTimeStep): submitted
+     * without waiting in GPU mode, done on return in CPU mode.
+     */
+    bool update(float dt);
+
+    /**
+     * Create the pipeline of draw(), for a render pass with a colorFormat
+     * attachment and a depthFormat depth attachment of sampleCount samples.
+     * Particles are depth tested but do not write depth.
+     */
+    void createRenderPipeline(wgpu::TextureFormat colorFormat, wgpu::TextureFormat depthFormat, uint32_t sampleCount);
+
+    /**
+     * Draw the particles as of the last update, one instanced quad each,
+     * with an indirect draw (GPU mode).
+     */
+    void draw(wgpu::RenderPassEncoder renderPass);
+
+    /**
+     * Blocking read back of the live particles, in draw order.
+     */
+    std::vector<Particle> readParticles() const;
+    uint32_t readCount() const;
+
+    const Options& options() const { return m_options; }
+    uint32_t frameIndex() const { return m_frameIndex; }
+
+private:
+    struct Params {
+        float dt;
+        float gravity;
+        uint32_t emitCount;
+        uint32_t seed;
+        uint32_t capacity;
+        uint32_t maxWorkgroupsPerDimension;
+        uint32_t _pad[2];
+    };
+
+    void createKernels();
+    void releaseRenderPipeline();
+
+private:
+    ComputeContext& m_context;
+    Options m_options;
+    uint32_t m_maxEmitCount = 0;
+    double m_emitRemainder = 0.0;
+    uint32_t m_frameIndex = 0;
+    // Index of the buffers holding the result of the last update
+    uint32_t m_front = 0;
+
+    std::unique_ptr<GpuArray<Params>> m_params;
+    std::unique_ptr<GpuArray<Particle>> m_particles[2];
+    std::unique_ptr<GpuArray<uint32_t>> m_state[2];
+    std::unique_ptr<GpuArray<uint32_t>> m_keys;
+    std::unique_ptr<GpuArray<uint32_t>> m_order;
+
+    std::unique_ptr<Kernel> m_resetKernel;
+    std::unique_ptr<Kernel> m_simulateKernel;
+    std::unique_ptr<Kernel> m_emitKernel;
+    std::unique_ptr<Kernel> m_finalizeKernel;
+    std::unique_ptr<Kernel> m_depthKeysKernel;
+    std::unique_ptr<RadixSort> m_sort;
+    // One per front buffer
+    std::unique_ptr<ComputeChain> m_chains[2];
+
+    wgpu::ShaderModule m_renderShaderModule = nullptr;
+    wgpu::BindGroupLayout m_renderBindGroupLayout = nullptr;
+    wgpu::PipelineLayout m_renderPipelineLayout = nullptr;
+    wgpu::RenderPipeline m_renderPipeline = nullptr;
+    wgpu::BindGroup m_renderBindGroups[2] = { nullptr, nullptr };
+};
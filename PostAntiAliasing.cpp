@@ -0,0 +1,191 @@
+#include "PostAntiAliasing.h"
+
+namespace {
+
+const char* postAntiAliasingShaderSource = R"(
+@group(0) @binding(0) var inputTexture: texture_2d<f32>;
+@group(0) @binding(1) var inputSampler: sampler;
+
+struct VertexOutput {
+    @builtin(position) position: vec4f,
+    @location(0) uv: vec2f,
+};
+
+// One triangle covering the whole screen
+@vertex
+fn vs_main(@builtin(vertex_index) in_vertex_index: u32) -> VertexOutput {
+    let uv = vec2f(f32((in_vertex_index << 1u) & 2u), f32(in_vertex_index & 2u));
+    var out: VertexOutput;
+    out.position = vec4f(uv * 2.0 - 1.0, 0.0, 1.0);
+    out.uv = vec2f(uv.x, 1.0 - uv.y);
+    return out;
+}
+
+fn luma(color: vec3f) -> f32 {
+    return dot(color, vec3f(0.299, 0.587, 0.114));
+}
+
+fn fetch(uv: vec2f) -> vec4f {
+    return textureSampleLevel(inputTexture, inputSampler, uv, 0.0);
+}
+
+@fragment
+fn fs_main(in: VertexOutput) -> @location(0) vec4f {
+    let texel = 1.0 / vec2f(textureDimensions(inputTexture));
+    let center = fetch(in.uv);
+    let m = luma(center.rgb);
+    let n = luma(fetch(in.uv + vec2f(0.0, -texel.y)).rgb);
+    let s = luma(fetch(in.uv + vec2f(0.0, texel.y)).rgb);
+    let e = luma(fetch(in.uv + vec2f(texel.x, 0.0)).rgb);
+    let w = luma(fetch(in.uv + vec2f(-texel.x, 0.0)).rgb);
+
+    let lumaMin = min(m, min(min(n, s), min(e, w)));
+    let lumaMax = max(m, max(max(n, s), max(e, w)));
+    if (lumaMax - lumaMin < max(0.0312, 0.125 * lumaMax)) {
+        return center;
+    }
+
+    // Blur along the edge, i.e. orthogonally to the luminance gradient
+    let gradient = vec2f(e - w, s - n);
+    let direction = normalize(vec2f(-gradient.y, gradient.x) + vec2f(1e-5, 0.0)) * texel;
+    let blurred = 0.25 * (
+        fetch(in.uv - 1.5 * direction) +
+        fetch(in.uv - 0.5 * direction) +
+        fetch(in.uv + 0.5 * direction) +
+        fetch(in.uv + 1.5 * direction)
+    );
+    return mix(center, blurred, 0.75);
+}
+)";
+
+} // namespace
+
+PostAntiAliasing::PostAntiAliasing(wgpu::Device device, wgpu::TextureFormat outputFormat)
+    : m_device(device)
+{
+    wgpu::ShaderModuleWGSLDescriptor shaderCodeDesc;
+    shaderCodeDesc.chain.next = nullptr;
+    shaderCodeDesc.chain.sType = wgpu::SType::ShaderModuleWGSLDescriptor;
+    shaderCodeDesc.code = postAntiAliasingShaderSource;
+    wgpu::ShaderModuleDescriptor shaderDesc;
+    shaderDesc.nextInChain = &shaderCodeDesc.chain;
+    shaderDesc.label = "Post anti-aliasing shader";
+    shaderDesc.hintCount = 0;
+    shaderDesc.hints = nullptr;
+    m_shaderModule = device.createShaderModule(shaderDesc);
+
+    std::vector<wgpu::BindGroupLayoutEntry> bindingLayouts(2, wgpu::Default);
+    bindingLayouts[0].binding = 0;
+    bindingLayouts[0].visibility = wgpu::ShaderStage::Fragment;
+    bindingLayouts[0].texture.sampleType = wgpu::TextureSampleType::Float;
+    bindingLayouts[0].texture.viewDimension = wgpu::TextureViewDimension::_2D;
+    bindingLayouts[1].binding = 1;
+    bindingLayouts[1].visibility = wgpu::ShaderStage::Fragment;
+    bindingLayouts[1].sampler.type = wgpu::SamplerBindingType::Filtering;
+
+    wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc;
+    bindGroupLayoutDesc.label = "Post anti-aliasing bind group layout";
+    bindGroupLayoutDesc.entryCount = static_cast<uint32_t>(bindingLayouts.size());
+    bindGroupLayoutDesc.entries = bindingLayouts.data();
+    m_bindGroupLayout = device.createBindGroupLayout(bindGroupLayoutDesc);
+
+    wgpu::PipelineLayoutDescriptor pipelineLayoutDesc;
+    pipelineLayoutDesc.label = "Post anti-aliasing pipeline layout";
+    pipelineLayoutDesc.bindGroupLayoutCount = 1;
+    pipelineLayoutDesc.bindGroupLayouts = reinterpret_cast<WGPUBindGroupLayout*>(&m_bindGroupLayout);
+    m_pipelineLayout = device.createPipelineLayout(pipelineLayoutDesc);
+
+    wgpu::RenderPipelineDescriptor pipelineDesc;
+    pipelineDesc.label = "Post anti-aliasing pipeline";
+    pipelineDesc.layout = m_pipelineLayout;
+    pipelineDesc.vertex.bufferCount = 0;
+    pipelineDesc.vertex.buffers = nullptr;
+    pipelineDesc.vertex.module = m_shaderModule;
+    pipelineDesc.vertex.entryPoint = "vs_main";
+    pipelineDesc.vertex.constantCount = 0;
+    pipelineDesc.vertex.constants = nullptr;
+    pipelineDesc.primitive.topology = wgpu::PrimitiveTopology::TriangleList;
+    pipelineDesc.primitive.stripIndexFormat = wgpu::IndexFormat::Undefined;
+    pipelineDesc.primitive.frontFace = wgpu::FrontFace::CCW;
+    pipelineDesc.primitive.cullMode = wgpu::CullMode::None;
+
+    wgpu::ColorTargetState colorTarget;
+    colorTarget.format = outputFormat;
+    colorTarget.blend = nullptr;
+    colorTarget.writeMask = wgpu::ColorWriteMask::All;
+
+    wgpu::FragmentState fragmentState;
+    fragmentState.module = m_shaderModule;
+    fragmentState.entryPoint = "fs_main";
+    fragmentState.constantCount = 0;
+    fragmentState.constants = nullptr;
+    fragmentState.targetCount = 1;
+    fragmentState.targets = &colorTarget;
+    pipelineDesc.fragment = &fragmentState;
+    pipelineDesc.depthStencil = nullptr;
+
+    pipelineDesc.multisample.count = 1;
+    pipelineDesc.multisample.mask = ~0u;
+    pipelineDesc.multisample.alphaToCoverageEnabled = false;
+    m_pipeline = device.createRenderPipeline(pipelineDesc);
+
+    wgpu::SamplerDescriptor samplerDesc = wgpu::Default;
+    samplerDesc.label = "Post anti-aliasing sampler";
+    samplerDesc.magFilter = wgpu::FilterMode::Linear;
+    samplerDesc.minFilter = wgpu::FilterMode::Linear;
+    samplerDesc.maxAnisotropy = 1;
+    m_sampler = device.createSampler(samplerDesc);
+}
+
+PostAntiAliasing::~PostAntiAliasing() {
+    if (m_bindGroup) m_bindGroup.release();
+    if (m_boundInput) m_boundInput.release();
+    m_sampler.release();
+    m_pipeline.release();
+    m_pipelineLayout.release();
+    m_bindGroupLayout.release();
+    m_shaderModule.release();
+}
+
+void PostAntiAliasing::encode(wgpu::CommandEncoder encoder, wgpu::TextureView input, wgpu::TextureView output) {
+    if (static_cast<WGPUTextureView>(m_boundInput) != static_cast<WGPUTextureView>(input)) {
+        if (m_bindGroup) m_bindGroup.release();
+        if (m_boundInput) m_boundInput.release();
+
+        std::vector<wgpu::BindGroupEntry> bindings(2, wgpu::Default);
+        bindings[0].binding = 0;
+        bindings[0].textureView = input;
+        bindings[1].binding = 1;
+        bindings[1].sampler = m_sampler;
+
+        wgpu::BindGroupDescriptor bindGroupDesc;
+        bindGroupDesc.label = "Post anti-aliasing bind group";
+        bindGroupDesc.layout = m_bindGroupLayout;
+        bindGroupDesc.entryCount = static_cast<uint32_t>(bindings.size());
+        bindGroupDesc.entries = bindings.data();
+        m_bindGroup = m_device.createBindGroup(bindGroupDesc);
+        m_boundInput = input;
+        m_boundInput.reference();
+    }
+
+    wgpu::RenderPassColorAttachment colorAttachment = {};
+    colorAttachment.view = output;
+    colorAttachment.resolveTarget = nullptr;
+    colorAttachment.loadOp = WGPULoadOp_Clear;
+    colorAttachment.storeOp = WGPUStoreOp_Store;
+    colorAttachment.clearValue = wgpu::Color{ 0.0, 0.0, 0.0, 1.0 };
+
+    wgpu::RenderPassDescriptor renderPassDesc = {};
+    renderPassDesc.colorAttachmentCount = 1;
+    renderPassDesc.colorAttachments = &colorAttachment;
+    renderPassDesc.depthStencilAttachment = nullptr;
+    renderPassDesc.timestampWriteCount = 0;
+    renderPassDesc.timestampWrites = nullptr;
+
+    wgpu::RenderPassEncoder renderPass = encoder.beginRenderPass(renderPassDesc);
+    renderPass.setPipeline(m_pipeline);
+    renderPass.setBindGroup(0, m_bindGroup, 0, nullptr);
+    renderPass.draw(3, 1, 0, 0);
+    renderPass.end();
+    renderPass.release();
+}
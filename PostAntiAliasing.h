@@ -0,0 +1,37 @@
+#pragma once
+
+#include <webgpu/webgpu.hpp>
+
+/**
+ * Screen-space anti-aliasing pass (a simplified FXAA): reads a single-sampled
+ * scene texture and blurs along the edges it detects from luminance contrast.
+ * This is the cheap alternative to rendering the scene with MSAA.
+ */
+class PostAntiAliasing {
+public:
+    PostAntiAliasing(wgpu::Device device, wgpu::TextureFormat outputFormat);
+    ~PostAntiAliasing();
+    PostAntiAliasing(const PostAntiAliasing&) = delete;
+    PostAntiAliasing& operator=(const PostAntiAliasing&) = delete;
+
+    /**
+     * Record a render pass that reads input (which needs TextureBinding usage)
+     * and overwrites output.
+     */
+    void encode(wgpu::CommandEncoder encoder, wgpu::TextureView input, wgpu::TextureView output);
+
+private:
+    wgpu::Device m_device;
+    wgpu::ShaderModule m_shaderModule = nullptr;
+    wgpu::BindGroupLayout m_bindGroupLayout = nullptr;
+    wgpu::PipelineLayout m_pipelineLayout = nullptr;
+    wgpu::RenderPipeline m_pipeline = nullptr;
+    wgpu::Sampler m_sampler = nullptr;
+
+    // The input usually comes from the TexturePool and is the same view
+    // frame after frame, so the bind group is only rebuilt when it changes.
+    // Referenced, so that a new view (after a resize) cannot get the address
+    // of the released one and match the stale bind group.
+    wgpu::TextureView m_boundInput = nullptr;
+    wgpu::BindGroup m_bindGroup = nullptr;
+};
@@ -0,0 +1,339 @@
+#include "PrefixScan.h"
+
+#include "Parallel.h"
+#include "SimdLanes.h"
+
+#include <cassert>
+#include <iostream>
+#include <string>
+
+namespace {
+
+// ELEMENT is replaced by u32 or f32
+const char* scanSource = R"(
+struct Params {
+	count: u32,
+	blockCount: u32,
+	inclusive: u32,
+	hasBlockOffsets: u32,
+}
+
+override workgroupSize: u32 = 256u;
+const itemsPerThread = 4u;
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var<storage, read> input: array<ELEMENT>;
+@group(0) @binding(2) var<storage, read_write> output: array<ELEMENT>;
+// Tile sums (reduce) or tile offsets (scan)
+@group(0) @binding(3) var<storage, read_write> blockValues: array<ELEMENT>;
+
+// Sized for PrefixScan::WorkgroupSize
+var<workgroup> partials: array<ELEMENT, 256>;
+
+// Hillis-Steele scan of one value per invocation. partials holds the
+// inclusive scan of the whole workgroup when it returns.
+fn workgroupInclusiveScan(localIndex: u32, value: ELEMENT) -> ELEMENT {
+	partials[localIndex] = value;
+	workgroupBarrier();
+	for (var offset = 1u; offset < workgroupSize; offset = offset * 2u) {
+		var sum = partials[localIndex];
+		if (localIndex >= offset) {
+			sum = sum + partials[localIndex - offset];
+		}
+		workgroupBarrier();
+		partials[localIndex] = sum;
+		workgroupBarrier();
+	}
+	return partials[localIndex];
+}
+
+@compute @workgroup_size(workgroupSize)
+fn reduce(
+	@builtin(local_invocation_index) localIndex: u32,
+	@builtin(workgroup_id) workgroupId: vec3<u32>,
+	@builtin(num_workgroups) groups: vec3<u32>
+) {
+	let tile = workgroupId.x + workgroupId.y * groups.x;
+	let first = (tile * workgroupSize + localIndex) * itemsPerThread;
+	var sum = ELEMENT(0);
+	for (var i = 0u; i < itemsPerThread; i = i + 1u) {
+		if (first + i < params.count) {
+			sum = sum + input[first + i];
+		}
+	}
+	let total = workgroupInclusiveScan(localIndex, sum);
+	if (localIndex == workgroupSize - 1u && tile < params.blockCount) {
+		blockValues[tile] = total;
+	}
+}
+
+@compute @workgroup_size(workgroupSize)
+fn scan(
+	@builtin(local_invocation_index) localIndex: u32,
+	@builtin(workgroup_id) workgroupId: vec3<u32>,
+	@builtin(num_workgroups) groups: vec3<u32>
+) {
+	let tile = workgroupId.x + workgroupId.y * groups.x;
+	let first = (tile * workgroupSize + localIndex) * itemsPerThread;
+	var sum = ELEMENT(0);
+	for (var i = 0u; i < itemsPerThread; i = i + 1u) {
+		if (first + i < params.count) {
+			sum = sum + input[first + i];
+		}
+	}
+	workgroupInclusiveScan(localIndex, sum);
+
+	// Read the exclusive prefix rather than subtracting, which would not be
+	// exact for f32
+	var running = ELEMENT(0);
+	if (localIndex > 0u) {
+		running = partials[localIndex - 1u];
+	}
+	if (params.hasBlockOffsets != 0u && tile < params.blockCount) {
+		running = running + blockValues[tile];
+	}
+	for (var i = 0u; i < itemsPerThread; i = i + 1u) {
+		let index = first + i;
+		if (index < params.count) {
+			let value = input[index];
+			if (params.inclusive != 0u) {
+				running = running + value;
+				output[index] = running;
+			}
+			else {
+				output[index] = running;
+				running = running + value;
+			}
+		}
+	}
+}
+)";
+
+std::string scanSourceFor(ScanElement element) {
+    std::string source = scanSource;
+    const std::string placeholder = "ELEMENT";
+    const std::string type = element == ScanElement::U32 ? "u32" : "f32";
+    for (size_t pos = source.find(placeholder); pos != std::string::npos; pos = source.find(placeholder, pos)) {
+        source.replace(pos, placeholder.size(), type);
+        pos += type.size();
+    }
+    return source;
+}
+
+template <typename T>
+T sumRange(const T* input, size_t count) {
+    size_t i = 0;
+    T total = T(0);
+#ifdef COMPUTE_SSE2
+    using L = Lanes<T>;
+    typename L::V sums = L::broadcast(T(0));
+    for (; i + 4 <= count; i += 4) {
+        sums = L::add(sums, L::load(input + i));
+    }
+    // The last lane of the scan of the lanes is their sum
+    sums = L::add(sums, L::shift1(sums));
+    sums = L::add(sums, L::shift2(sums));
+    total = L::last(sums);
+#endif
+    for (; i < count; ++i) total += input[i];
+    return total;
+}
+
+template <typename T>
+void scanRange(const T* input, T* output, size_t count, T carry, bool inclusive) {
+    size_t i = 0;
+#ifdef COMPUTE_SSE2
+    using L = Lanes<T>;
+    for (; i + 4 <= count; i += 4) {
+        typename L::V x = L::load(input + i);
+        x = L::add(x, L::shift1(x));
+        x = L::add(x, L::shift2(x));
+        typename L::V offset = L::broadcast(carry);
+        typename L::V scanned = L::add(x, offset);
+        L::store(output + i, inclusive ? scanned : L::add(L::shift1(x), offset));
+        carry = L::last(scanned);
+    }
+#endif
+    for (; i < count; ++i) {
+        T value = input[i];
+        if (inclusive) {
+            carry += value;
+            output[i] = carry;
+        }
+        else {
+            output[i] = carry;
+            carry += value;
+        }
+    }
+}
+
+template <typename T>
+void parallelScan(const T* input, T* output, size_t count, ScanKind kind) {
+    // Below this, starting threads costs more than scanning
+    constexpr size_t minChunkSize = 1 << 16;
+    const bool inclusive = kind == ScanKind::Inclusive;
+    size_t chunkCount = parallelChunkCount(count, minChunkSize);
+    if (chunkCount <= 1) {
+        scanRange(input, output, count, T(0), inclusive);
+        return;
+    }
+
+    std::vector<T> chunkOffsets(chunkCount);
+    parallelChunks(count, minChunkSize, [&](size_t chunk, size_t begin, size_t end) {
+        chunkOffsets[chunk] = sumRange(input + begin, end - begin);
+    });
+    T offset = T(0);
+    for (T& chunkOffset : chunkOffsets) {
+        T sum = chunkOffset;
+        chunkOffset = offset;
+        offset += sum;
+    }
+    parallelChunks(count, minChunkSize, [&](size_t chunk, size_t begin, size_t end) {
+        scanRange(input + begin, output + begin, end - begin, chunkOffsets[chunk], inclusive);
+    });
+}
+
+} // namespace
+
+PrefixScan::PrefixScan(ComputeContext& context, ScanElement element)
+    : m_context(context)
+    , m_element(element)
+{
+    if (!context.hasGpu()) return;
+
+    KernelDesc desc;
+    desc.source = scanSourceFor(element);
+    desc.workgroupSize = WorkgroupSize;
+    desc.bindings = { KernelBinding::Uniform, KernelBinding::ReadOnlyStorage, KernelBinding::Storage, KernelBinding::Storage };
+    desc.label = "Prefix scan reduce";
+    desc.entryPoint = "reduce";
+    m_reduceKernel = std::make_unique<Kernel>(context, desc);
+    desc.label = "Prefix scan";
+    desc.entryPoint = "scan";
+    m_scanKernel = std::make_unique<Kernel>(context, desc);
+
+    m_dummy = std::make_unique<GpuArray<uint32_t>>(context, 1);
+}
+
+PrefixScan::~PrefixScan() {
+    releaseLevels();
+}
+
+void PrefixScan::releaseLevels() {
+    for (Level& level : m_levels) {
+        if (level.reduceBindGroup) level.reduceBindGroup.release();
+        if (level.scanBindGroup) level.scanBindGroup.release();
+    }
+    m_levels.clear();
+    m_preparedInput = 0;
+    m_preparedOutput = 0;
+}
+
+void PrefixScan::prepare(GpuArrayBase& input, GpuArrayBase& output, uint32_t count) {
+    releaseLevels();
+
+    uint32_t levelCount = count;
+    for (;;) {
+        Level level;
+        level.count = levelCount;
+        level.blockCount = (levelCount + TileSize - 1) / TileSize;
+        level.params = std::make_unique<GpuArray<Params>>(m_context, 1, WGPUBufferUsage_Uniform);
+        if (level.blockCount > 1) {
+            level.blockSums = std::make_unique<GpuArray<uint32_t>>(m_context, level.blockCount);
+            level.blockOffsets = std::make_unique<GpuArray<uint32_t>>(m_context, level.blockCount);
+        }
+        m_levels.push_back(std::move(level));
+        if (m_levels.back().blockCount <= 1) break;
+        levelCount = m_levels.back().blockCount;
+    }
+
+    for (size_t i = 0; i < m_levels.size(); ++i) {
+        Level& level = m_levels[i];
+        GpuArrayBase* levelInput = i == 0 ? &input : m_levels[i - 1].blockSums.get();
+        GpuArrayBase* levelOutput = i == 0 ? &output : m_levels[i - 1].blockOffsets.get();
+        if (level.blockCount > 1) {
+            level.reduceBindGroup = m_reduceKernel->createBindGroup({ level.params.get(), levelInput, levelOutput, level.blockSums.get() });
+            level.scanBindGroup = m_scanKernel->createBindGroup({ level.params.get(), levelInput, levelOutput, level.blockOffsets.get() });
+        }
+        else {
+            level.scanBindGroup = m_scanKernel->createBindGroup({ level.params.get(), levelInput, levelOutput, m_dummy.get() });
+        }
+    }
+
+    m_preparedInput = input.id();
+    m_preparedOutput = output.id();
+}
+
+bool PrefixScan::encode(wgpu::ComputePassEncoder pass, GpuArrayBase& input, GpuArrayBase& output, uint32_t count, ScanKind kind) {
+    assert(m_context.hasGpu());
+    assert(count <= input.size() && count <= output.size());
+    if (count == 0) return true;
+
+    uint64_t maxBindingSize = m_context.maxStorageBufferBindingSize();
+    if (input.buffer().getSize() > maxBindingSize || output.buffer().getSize() > maxBindingSize) {
+        std::cerr << "Prefix scan: arrays of " << count << " elements exceed the storage binding limit of "
+            << maxBindingSize << " bytes" << std::endl;
+        return false;
+    }
+
+    if (m_levels.empty() || m_levels[0].count != count
+        || m_preparedInput != input.id()
+        || m_preparedOutput != output.id()) {
+        prepare(input, output, count);
+    }
+
+    for (size_t i = 0; i < m_levels.size(); ++i) {
+        const Level& level = m_levels[i];
+        Params params;
+        params.count = level.count;
+        params.blockCount = level.blockCount;
+        // Tile offsets are exclusive sums of the tiles before
+        params.inclusive = i == 0 && kind == ScanKind::Inclusive ? 1 : 0;
+        params.hasBlockOffsets = level.blockCount > 1 ? 1 : 0;
+        level.params->upload(&params, 1);
+    }
+
+    // Reduce down to a single tile, scan it, then scan back up the levels
+    for (const Level& level : m_levels) {
+        if (level.blockCount > 1) {
+            m_reduceKernel->dispatch(pass, level.reduceBindGroup, level.blockCount * WorkgroupSize);
+        }
+    }
+    for (size_t i = m_levels.size(); i-- > 0;) {
+        m_scanKernel->dispatch(pass, m_levels[i].scanBindGroup, m_levels[i].blockCount * WorkgroupSize);
+    }
+    return true;
+}
+
+bool PrefixScan::run(GpuArrayBase& input, GpuArrayBase& output, uint32_t count, ScanKind kind) {
+    if (!m_context.hasGpu()) {
+        assert(count <= input.size() && count <= output.size());
+        if (m_element == ScanElement::U32) {
+            scanCpu(static_cast<const uint32_t*>(input.hostData()), static_cast<uint32_t*>(output.hostData()), count, kind);
+        }
+        else {
+            scanCpu(static_cast<const float*>(input.hostData()), static_cast<float*>(output.hostData()), count, kind);
+        }
+        return true;
+    }
+
+    wgpu::CommandEncoder encoder = m_context.createEncoder("Prefix scan");
+    wgpu::ComputePassDescriptor computePassDesc;
+    computePassDesc.label = "Prefix scan";
+    computePassDesc.timestampWriteCount = 0;
+    computePassDesc.timestampWrites = nullptr;
+    wgpu::ComputePassEncoder pass = encoder.beginComputePass(computePassDesc);
+    bool ok = encode(pass, input, output, count, kind);
+    pass.end();
+    pass.release();
+    m_context.submit(encoder);
+    return ok;
+}
+
+void PrefixScan::scanCpu(const uint32_t* input, uint32_t* output, size_t count, ScanKind kind) {
+    parallelScan(input, output, count, kind);
+}
+
+void PrefixScan::scanCpu(const float* input, float* output, size_t count, ScanKind kind) {
+    parallelScan(input, output, count, kind);
+}
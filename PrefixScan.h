@@ -0,0 +1,107 @@
+#pragma once
+
+#include "ComputeRuntime.h"
+
+#include <webgpu/webgpu.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+enum class ScanElement {
+    U32,
+    F32,
+};
+
+enum class ScanKind {
+    // output[i] = input[0] + ... + input[i - 1]
+    Exclusive,
+    // output[i] = input[0] + ... + input[i]
+    Inclusive,
+};
+
+/**
+ * Prefix sum of u32 or f32 arrays, reduce-then-scan on the GPU:
+ *  1. each workgroup sums a tile of TileSize elements,
+ *  2. the tile sums are scanned, recursively with the same kernels,
+ *  3. each workgroup scans its tile again, starting from its tile offset.
+ * A level is added every factor of TileSize, so 100M elements take three.
+ *
+ * In CPU mode, the same calls run a multithreaded scan (SSE2 when
+ * available) on the host memory of the arrays.
+ *
+ * Intermediate buffers are kept from one call to the next, as long as the
+ * count does not change. f32 scans are not bitwise identical between the
+ * GPU and the CPU since additions are not done in the same order.
+ */
+class PrefixScan {
+public:
+    static constexpr uint32_t WorkgroupSize = 256;
+    static constexpr uint32_t ItemsPerThread = 4;
+    static constexpr uint32_t TileSize = WorkgroupSize * ItemsPerThread;
+
+    PrefixScan(ComputeContext& context, ScanElement element);
+    ~PrefixScan();
+    PrefixScan(const PrefixScan&) = delete;
+    PrefixScan& operator=(const PrefixScan&) = delete;
+
+    /**
+     * Record the scan of the first count elements of input into output
+     * (GPU mode). input and output must be different arrays. Parameters
+     * are written to the queue, so when recording several scans in the same
+     * submission, use one PrefixScan per scan. Returns false if the arrays
+     * are larger than the storage binding limit.
+     */
+    bool encode(wgpu::ComputePassEncoder pass, GpuArrayBase& input, GpuArrayBase& output, uint32_t count, ScanKind kind);
+
+    /**
+     * Scan on its own: encode and submit in GPU mode (without waiting), or
+     * scan on the CPU.
+     */
+    bool run(GpuArrayBase& input, GpuArrayBase& output, uint32_t count, ScanKind kind);
+
+    ScanElement element() const { return m_element; }
+
+    /**
+     * The CPU fallback, usable on any memory. input and output may be the
+     * same array.
+     */
+    static void scanCpu(const uint32_t* input, uint32_t* output, size_t count, ScanKind kind);
+    static void scanCpu(const float* input, float* output, size_t count, ScanKind kind);
+
+private:
+    struct Params {
+        uint32_t count;
+        uint32_t blockCount;
+        uint32_t inclusive;
+        uint32_t hasBlockOffsets;
+    };
+
+    // One level of the recursion: the tile sums of a level are the input of
+    // the next one, and its output is the tile offsets of the previous one.
+    struct Level {
+        uint32_t count = 0;
+        uint32_t blockCount = 0;
+        std::unique_ptr<GpuArray<Params>> params;
+        // Only when blockCount > 1
+        std::unique_ptr<GpuArray<uint32_t>> blockSums;
+        std::unique_ptr<GpuArray<uint32_t>> blockOffsets;
+        wgpu::BindGroup reduceBindGroup = nullptr;
+        wgpu::BindGroup scanBindGroup = nullptr;
+    };
+
+    void prepare(GpuArrayBase& input, GpuArrayBase& output, uint32_t count);
+    void releaseLevels();
+
+private:
+    ComputeContext& m_context;
+    ScanElement m_element;
+    std::unique_ptr<Kernel> m_reduceKernel;
+    std::unique_ptr<Kernel> m_scanKernel;
+    // Bound instead of the tile offsets on the last level, which has none
+    std::unique_ptr<GpuArray<uint32_t>> m_dummy;
+
+    std::vector<Level> m_levels;
+    // GpuArrayBase::id() of the arrays the levels are bound to, 0 if none
+    uint64_t m_preparedInput = 0;
+    uint64_t m_preparedOutput = 0;
+};
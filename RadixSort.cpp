@@ -0,0 +1,364 @@
+#include "RadixSort.h"
+
+#include "Parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <utility>
+
+namespace {
+
+// KEY and DIGIT_OF are replaced depending on the key type
+const char* radixSortSource = R"(
+struct Params {
+	count: u32,
+	blockCount: u32,
+	shift: u32,
+	hasValues: u32,
+}
+
+override workgroupSize: u32 = 256u;
+const itemsPerThread = 4u;
+const radix = 16u;
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var<storage, read> keysIn: array<KEY>;
+@group(0) @binding(2) var<storage, read> valuesIn: array<u32>;
+@group(0) @binding(3) var<storage, read_write> keysOut: array<KEY>;
+@group(0) @binding(4) var<storage, read_write> valuesOut: array<u32>;
+// Digit major: histograms[digit * blockCount + tile]. Counts when written
+// by count(), first destination of the digit in the tile when read by
+// scatter().
+@group(0) @binding(5) var<storage, read_write> histograms: array<u32>;
+
+var<workgroup> digitCounts: array<atomic<u32>, 16>;
+// Per invocation count of each digit, 16 bits per digit
+var<workgroup> partials: array<array<u32, 8>, 256>;
+
+DIGIT_OF
+
+@compute @workgroup_size(workgroupSize)
+fn count(
+	@builtin(local_invocation_index) localIndex: u32,
+	@builtin(workgroup_id) workgroupId: vec3<u32>,
+	@builtin(num_workgroups) groups: vec3<u32>
+) {
+	let tile = workgroupId.x + workgroupId.y * groups.x;
+	if (localIndex < radix) {
+		atomicStore(&digitCounts[localIndex], 0u);
+	}
+	workgroupBarrier();
+
+	let first = (tile * workgroupSize + localIndex) * itemsPerThread;
+	for (var i = 0u; i < itemsPerThread; i = i + 1u) {
+		if (first + i < params.count) {
+			atomicAdd(&digitCounts[digitOf(keysIn[first + i])], 1u);
+		}
+	}
+	workgroupBarrier();
+
+	if (localIndex < radix && tile < params.blockCount) {
+		histograms[localIndex * params.blockCount + tile] = atomicLoad(&digitCounts[localIndex]);
+	}
+}
+
+@compute @workgroup_size(workgroupSize)
+fn scatter(
+	@builtin(local_invocation_index) localIndex: u32,
+	@builtin(workgroup_id) workgroupId: vec3<u32>,
+	@builtin(num_workgroups) groups: vec3<u32>
+) {
+	let tile = workgroupId.x + workgroupId.y * groups.x;
+	let first = (tile * workgroupSize + localIndex) * itemsPerThread;
+
+	var digits: array<u32, 4>;
+	var counts: array<u32, 8>;
+	for (var i = 0u; i < itemsPerThread; i = i + 1u) {
+		digits[i] = radix;
+		if (first + i < params.count) {
+			let digit = digitOf(keysIn[first + i]);
+			digits[i] = digit;
+			counts[digit / 2u] = counts[digit / 2u] + (1u << (16u * (digit % 2u)));
+		}
+	}
+
+	// Scan the counts across the workgroup, so that each invocation knows
+	// how many keys of each digit come before its own in the tile
+	partials[localIndex] = counts;
+	workgroupBarrier();
+	for (var offset = 1u; offset < workgroupSize; offset = offset * 2u) {
+		var sum = partials[localIndex];
+		if (localIndex >= offset) {
+			let other = partials[localIndex - offset];
+			for (var w = 0u; w < 8u; w = w + 1u) {
+				sum[w] = sum[w] + other[w];
+			}
+		}
+		workgroupBarrier();
+		partials[localIndex] = sum;
+		workgroupBarrier();
+	}
+	var before: array<u32, 8>;
+	if (localIndex > 0u) {
+		before = partials[localIndex - 1u];
+	}
+
+	for (var i = 0u; i < itemsPerThread; i = i + 1u) {
+		let digit = digits[i];
+		if (digit < radix) {
+			let shift = 16u * (digit % 2u);
+			let rank = (before[digit / 2u] >> shift) & 0xffffu;
+			before[digit / 2u] = before[digit / 2u] + (1u << shift);
+			let destination = histograms[digit * params.blockCount + tile] + rank;
+			keysOut[destination] = keysIn[first + i];
+			if (params.hasValues != 0u) {
+				valuesOut[destination] = valuesIn[first + i];
+			}
+		}
+	}
+}
+)";
+
+const char* digitOfU32 = R"(
+fn digitOf(key: u32) -> u32 {
+	return (key >> params.shift) & 15u;
+}
+)";
+
+const char* digitOfU64 = R"(
+fn digitOf(key: vec2<u32>) -> u32 {
+	if (params.shift < 32u) {
+		return (key.x >> params.shift) & 15u;
+	}
+	return (key.y >> (params.shift - 32u)) & 15u;
+}
+)";
+
+void replaceAll(std::string& source, const std::string& placeholder, const std::string& text) {
+    for (size_t pos = source.find(placeholder); pos != std::string::npos; pos = source.find(placeholder, pos)) {
+        source.replace(pos, placeholder.size(), text);
+        pos += text.size();
+    }
+}
+
+template <typename K>
+void parallelRadixSort(K* keys, uint32_t* values, size_t count) {
+    constexpr int digitCount = sizeof(K);
+    constexpr size_t minChunkSize = 1 << 16;
+    if (count < 2) return;
+
+    std::vector<K> keysScratch(count);
+    std::vector<uint32_t> valuesScratch(values ? count : 0);
+    K* sourceKeys = keys;
+    K* destinationKeys = keysScratch.data();
+    uint32_t* sourceValues = values;
+    uint32_t* destinationValues = valuesScratch.data();
+
+    // One histogram per chunk, turned into the chunk's destination offsets
+    size_t chunkCount = parallelChunkCount(count, minChunkSize);
+    std::vector<std::array<size_t, 256>> histograms(chunkCount);
+
+    for (int d = 0; d < digitCount; ++d) {
+        const int shift = 8 * d;
+        parallelChunks(count, minChunkSize, [&](size_t chunk, size_t begin, size_t end) {
+            std::array<size_t, 256>& histogram = histograms[chunk];
+            histogram.fill(0);
+            for (size_t i = begin; i < end; ++i) {
+                ++histogram[(sourceKeys[i] >> shift) & 0xff];
+            }
+        });
+
+        // Every key has the same digit: this pass would not move anything
+        size_t firstDigit = (sourceKeys[0] >> shift) & 0xff;
+        size_t firstDigitCount = 0;
+        for (const auto& histogram : histograms) firstDigitCount += histogram[firstDigit];
+        if (firstDigitCount == count) continue;
+
+        size_t offset = 0;
+        for (size_t digit = 0; digit < 256; ++digit) {
+            for (auto& histogram : histograms) {
+                size_t digitCount = histogram[digit];
+                histogram[digit] = offset;
+                offset += digitCount;
+            }
+        }
+
+        parallelChunks(count, minChunkSize, [&](size_t chunk, size_t begin, size_t end) {
+            std::array<size_t, 256>& offsets = histograms[chunk];
+            for (size_t i = begin; i < end; ++i) {
+                size_t destination = offsets[(sourceKeys[i] >> shift) & 0xff]++;
+                destinationKeys[destination] = sourceKeys[i];
+                if (values) destinationValues[destination] = sourceValues[i];
+            }
+        });
+        std::swap(sourceKeys, destinationKeys);
+        std::swap(sourceValues, destinationValues);
+    }
+
+    if (sourceKeys != keys) {
+        std::copy(sourceKeys, sourceKeys + count, keys);
+        if (values) std::copy(sourceValues, sourceValues + count, values);
+    }
+}
+
+} // namespace
+
+RadixSort::RadixSort(ComputeContext& context, SortKeyType keyType)
+    : m_context(context)
+    , m_keyType(keyType)
+{
+    if (!context.hasGpu()) return;
+
+    std::string source = radixSortSource;
+    replaceAll(source, "DIGIT_OF", keyType == SortKeyType::U32 ? digitOfU32 : digitOfU64);
+    replaceAll(source, "KEY", keyType == SortKeyType::U32 ? "u32" : "vec2<u32>");
+
+    KernelDesc desc;
+    desc.source = source;
+    desc.workgroupSize = WorkgroupSize;
+    desc.bindings = {
+        KernelBinding::Uniform,
+        KernelBinding::ReadOnlyStorage,
+        KernelBinding::ReadOnlyStorage,
+        KernelBinding::Storage,
+        KernelBinding::Storage,
+        KernelBinding::Storage,
+    };
+    desc.label = "Radix sort count";
+    desc.entryPoint = "count";
+    m_countKernel = std::make_unique<Kernel>(context, desc);
+    desc.label = "Radix sort scatter";
+    desc.entryPoint = "scatter";
+    m_scatterKernel = std::make_unique<Kernel>(context, desc);
+
+    m_scan = std::make_unique<PrefixScan>(context, ScanElement::U32);
+    m_dummyValues[0] = std::make_unique<GpuArray<uint32_t>>(context, 1);
+    m_dummyValues[1] = std::make_unique<GpuArray<uint32_t>>(context, 1);
+}
+
+RadixSort::~RadixSort() {
+    releasePasses();
+}
+
+void RadixSort::releasePasses() {
+    for (Pass& pass : m_passes) {
+        if (pass.countBindGroup) pass.countBindGroup.release();
+        if (pass.scatterBindGroup) pass.scatterBindGroup.release();
+    }
+    m_passes.clear();
+    m_preparedKeys = 0;
+    m_preparedValues = 0;
+}
+
+void RadixSort::prepare(GpuArrayBase& keys, GpuArrayBase* values, uint32_t count) {
+    releasePasses();
+
+    if (count != m_count) {
+        uint32_t keyWords = m_keyType == SortKeyType::U32 ? 1 : 2;
+        m_count = count;
+        m_blockCount = (count + TileSize - 1) / TileSize;
+        m_keysScratch = std::make_unique<GpuArray<uint32_t>>(m_context, size_t(count) * keyWords);
+        m_valuesScratch = std::make_unique<GpuArray<uint32_t>>(m_context, count);
+        m_histograms = std::make_unique<GpuArray<uint32_t>>(m_context, size_t(Radix) * m_blockCount);
+        m_digitOffsets = std::make_unique<GpuArray<uint32_t>>(m_context, size_t(Radix) * m_blockCount);
+    }
+
+    // Ping-pong between the caller's arrays and the scratch arrays. There is
+    // an even number of passes, so the result ends up in the caller's.
+    GpuArrayBase* keyArrays[2] = { &keys, m_keysScratch.get() };
+    GpuArrayBase* valueArrays[2] = { values, m_valuesScratch.get() };
+    if (!values) {
+        valueArrays[0] = m_dummyValues[0].get();
+        valueArrays[1] = m_dummyValues[1].get();
+    }
+
+    m_passes.resize(passCount());
+    for (uint32_t i = 0; i < passCount(); ++i) {
+        Pass& pass = m_passes[i];
+        pass.params = std::make_unique<GpuArray<Params>>(m_context, 1, WGPUBufferUsage_Uniform);
+        uint32_t in = i % 2;
+        uint32_t out = 1 - in;
+        pass.countBindGroup = m_countKernel->createBindGroup({
+            pass.params.get(), keyArrays[in], valueArrays[in], keyArrays[out], valueArrays[out], m_histograms.get() });
+        pass.scatterBindGroup = m_scatterKernel->createBindGroup({
+            pass.params.get(), keyArrays[in], valueArrays[in], keyArrays[out], valueArrays[out], m_digitOffsets.get() });
+    }
+
+    m_preparedKeys = keys.id();
+    m_preparedValues = values ? values->id() : 0;
+}
+
+bool RadixSort::encode(wgpu::ComputePassEncoder pass, GpuArrayBase& keys, GpuArrayBase* values, uint32_t count) {
+    assert(m_context.hasGpu());
+    assert(count <= keys.size() && (!values || count <= values->size()));
+    if (count < 2) return true;
+
+    uint64_t maxBindingSize = m_context.maxStorageBufferBindingSize();
+    if (keys.buffer().getSize() > maxBindingSize || (values && values->buffer().getSize() > maxBindingSize)) {
+        std::cerr << "Radix sort: arrays of " << count << " elements exceed the storage binding limit of "
+            << maxBindingSize << " bytes" << std::endl;
+        return false;
+    }
+
+    if (m_passes.empty() || count != m_count
+        || m_preparedKeys != keys.id()
+        || m_preparedValues != (values ? values->id() : 0)) {
+        prepare(keys, values, count);
+    }
+
+    for (uint32_t i = 0; i < passCount(); ++i) {
+        Params params;
+        params.count = count;
+        params.blockCount = m_blockCount;
+        params.shift = i * RadixBits;
+        params.hasValues = values ? 1 : 0;
+        m_passes[i].params->upload(&params, 1);
+    }
+
+    uint32_t invocationCount = m_blockCount * WorkgroupSize;
+    for (const Pass& sortPass : m_passes) {
+        m_countKernel->dispatch(pass, sortPass.countBindGroup, invocationCount);
+        if (!m_scan->encode(pass, *m_histograms, *m_digitOffsets, Radix * m_blockCount, ScanKind::Exclusive)) {
+            return false;
+        }
+        m_scatterKernel->dispatch(pass, sortPass.scatterBindGroup, invocationCount);
+    }
+    return true;
+}
+
+bool RadixSort::run(GpuArrayBase& keys, GpuArrayBase* values, uint32_t count) {
+    if (!m_context.hasGpu()) {
+        assert(count <= keys.size() && (!values || count <= values->size()));
+        uint32_t* valueData = values ? static_cast<uint32_t*>(values->hostData()) : nullptr;
+        if (m_keyType == SortKeyType::U32) {
+            sortCpu(static_cast<uint32_t*>(keys.hostData()), valueData, count);
+        }
+        else {
+            sortCpu(static_cast<uint64_t*>(keys.hostData()), valueData, count);
+        }
+        return true;
+    }
+
+    wgpu::CommandEncoder encoder = m_context.createEncoder("Radix sort");
+    wgpu::ComputePassDescriptor computePassDesc;
+    computePassDesc.label = "Radix sort";
+    computePassDesc.timestampWriteCount = 0;
+    computePassDesc.timestampWrites = nullptr;
+    wgpu::ComputePassEncoder pass = encoder.beginComputePass(computePassDesc);
+    bool ok = encode(pass, keys, values, count);
+    pass.end();
+    pass.release();
+    m_context.submit(encoder);
+    return ok;
+}
+
+void RadixSort::sortCpu(uint32_t* keys, uint32_t* values, size_t count) {
+    parallelRadixSort(keys, values, count);
+}
+
+void RadixSort::sortCpu(uint64_t* keys, uint32_t* values, size_t count) {
+    parallelRadixSort(keys, values, count);
+}
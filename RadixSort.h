@@ -0,0 +1,105 @@
+#pragma once
+
+#include "ComputeRuntime.h"
+#include "PrefixScan.h"
+
+#include <webgpu/webgpu.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+enum class SortKeyType {
+    // GpuArray<uint32_t> keys
+    U32,
+    // GpuArray<uint64_t> keys, seen as vec2<u32> (low, high) by the shaders
+    U64,
+};
+
+/**
+ * Stable sort of u32 or u64 keys by increasing value, optionally carrying a
+ * u32 payload per key (typically the index of what the key stands for).
+ *
+ * On the GPU this is an LSD radix sort on 4-bit digits, so 8 passes for u32
+ * keys and 16 for u64 keys. Each pass
+ *  1. counts digits per tile of TileSize keys (histograms[digit][tile]),
+ *  2. scans the histograms with PrefixScan, which gives the position of the
+ *     first key of each digit of each tile,
+ *  3. scatters the keys, ranking them within their tile so that the sort
+ *     stays stable.
+ *
+ * In CPU mode, the same calls run a multithreaded LSD radix sort on 8-bit
+ * digits, which skips digits that are the same for all keys.
+ */
+class RadixSort {
+public:
+    static constexpr uint32_t WorkgroupSize = 256;
+    static constexpr uint32_t ItemsPerThread = 4;
+    static constexpr uint32_t TileSize = WorkgroupSize * ItemsPerThread;
+    static constexpr uint32_t RadixBits = 4;
+    static constexpr uint32_t Radix = 1 << RadixBits;
+
+    RadixSort(ComputeContext& context, SortKeyType keyType);
+    ~RadixSort();
+    RadixSort(const RadixSort&) = delete;
+    RadixSort& operator=(const RadixSort&) = delete;
+
+    /**
+     * Record the sort of the first count keys, in place (GPU mode). values
+     * may be nullptr, otherwise it is a GpuArray<uint32_t> reordered along
+     * with the keys. Scratch buffers are kept as long as the count and the
+     * arrays do not change. Same limitations as PrefixScan::encode.
+     */
+    bool encode(wgpu::ComputePassEncoder pass, GpuArrayBase& keys, GpuArrayBase* values, uint32_t count);
+
+    /**
+     * Sort on its own: encode and submit in GPU mode (without waiting), or
+     * sort on the CPU.
+     */
+    bool run(GpuArrayBase& keys, GpuArrayBase* values, uint32_t count);
+
+    SortKeyType keyType() const { return m_keyType; }
+
+    /**
+     * The CPU fallback, usable on any memory. values may be nullptr.
+     */
+    static void sortCpu(uint32_t* keys, uint32_t* values, size_t count);
+    static void sortCpu(uint64_t* keys, uint32_t* values, size_t count);
+
+private:
+    struct Params {
+        uint32_t count;
+        uint32_t blockCount;
+        uint32_t shift;
+        uint32_t hasValues;
+    };
+
+    struct Pass {
+        std::unique_ptr<GpuArray<Params>> params;
+        wgpu::BindGroup countBindGroup = nullptr;
+        wgpu::BindGroup scatterBindGroup = nullptr;
+    };
+
+    uint32_t passCount() const { return (m_keyType == SortKeyType::U32 ? 32 : 64) / RadixBits; }
+    void prepare(GpuArrayBase& keys, GpuArrayBase* values, uint32_t count);
+    void releasePasses();
+
+private:
+    ComputeContext& m_context;
+    SortKeyType m_keyType;
+    std::unique_ptr<Kernel> m_countKernel;
+    std::unique_ptr<Kernel> m_scatterKernel;
+    std::unique_ptr<PrefixScan> m_scan;
+    // Bound in place of the values when sorting keys only
+    std::unique_ptr<GpuArray<uint32_t>> m_dummyValues[2];
+
+    uint32_t m_count = 0;
+    uint32_t m_blockCount = 0;
+    std::unique_ptr<GpuArray<uint32_t>> m_keysScratch;
+    std::unique_ptr<GpuArray<uint32_t>> m_valuesScratch;
+    std::unique_ptr<GpuArray<uint32_t>> m_histograms;
+    std::unique_ptr<GpuArray<uint32_t>> m_digitOffsets;
+    std::vector<Pass> m_passes;
+    // GpuArrayBase::id() of the arrays the passes are bound to, 0 if none
+    uint64_t m_preparedKeys = 0;
+    uint64_t m_preparedValues = 0;
+};
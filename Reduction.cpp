@@ -0,0 +1,387 @@
+#include "Reduction.h"
+
+#include "Parallel.h"
+#include "SimdLanes.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+
+namespace {
+
+// ELEMENT is replaced by u32 or f32, COMBINE by identity() and combine()
+// for the operation
+const char* reductionSource = R"(
+struct Params {
+	count: u32,
+	blockCount: u32,
+}
+
+struct Item {
+	value: ELEMENT,
+	index: u32,
+}
+
+override workgroupSize: u32 = 256u;
+const itemsPerThread = 8u;
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var<storage, read> input: array<ELEMENT>;
+// (value bits, index)
+@group(0) @binding(2) var<storage, read> partialsIn: array<vec2<u32>>;
+@group(0) @binding(3) var<storage, read_write> partialsOut: array<vec2<u32>>;
+
+// Sized for Reduction::WorkgroupSize
+var<workgroup> values: array<ELEMENT, 256>;
+var<workgroup> indices: array<u32, 256>;
+
+COMBINE
+
+// Tree reduction: halve the active invocations at each step
+fn reduceWorkgroup(localIndex: u32, tile: u32, item: Item) {
+	values[localIndex] = item.value;
+	indices[localIndex] = item.index;
+	workgroupBarrier();
+	for (var stride = workgroupSize / 2u; stride > 0u; stride = stride / 2u) {
+		if (localIndex < stride) {
+			let a = Item(values[localIndex], indices[localIndex]);
+			let b = Item(values[localIndex + stride], indices[localIndex + stride]);
+			let combined = combine(a, b);
+			values[localIndex] = combined.value;
+			indices[localIndex] = combined.index;
+		}
+		workgroupBarrier();
+	}
+	if (localIndex == 0u && tile < params.blockCount) {
+		partialsOut[tile] = vec2<u32>(bitcast<u32>(values[0]), indices[0]);
+	}
+}
+
+@compute @workgroup_size(workgroupSize)
+fn reduceInput(
+	@builtin(local_invocation_index) localIndex: u32,
+	@builtin(workgroup_id) workgroupId: vec3<u32>,
+	@builtin(num_workgroups) groups: vec3<u32>
+) {
+	let tile = workgroupId.x + workgroupId.y * groups.x;
+	// Consecutive invocations read consecutive elements
+	let first = tile * workgroupSize * itemsPerThread + localIndex;
+	var item = identity();
+	for (var i = 0u; i < itemsPerThread; i = i + 1u) {
+		let index = first + i * workgroupSize;
+		if (index < params.count) {
+			item = combine(item, Item(input[index], index));
+		}
+	}
+	reduceWorkgroup(localIndex, tile, item);
+}
+
+@compute @workgroup_size(workgroupSize)
+fn reducePartials(
+	@builtin(local_invocation_index) localIndex: u32,
+	@builtin(workgroup_id) workgroupId: vec3<u32>,
+	@builtin(num_workgroups) groups: vec3<u32>
+) {
+	let tile = workgroupId.x + workgroupId.y * groups.x;
+	let first = tile * workgroupSize * itemsPerThread + localIndex;
+	var item = identity();
+	for (var i = 0u; i < itemsPerThread; i = i + 1u) {
+		let index = first + i * workgroupSize;
+		if (index < params.count) {
+			let partial = partialsIn[index];
+			item = combine(item, Item(bitcast<ELEMENT>(partial.x), partial.y));
+		}
+	}
+	reduceWorkgroup(localIndex, tile, item);
+}
+)";
+
+std::string combineSource(ReduceElement element, ReduceOp op) {
+    const bool isU32 = element == ReduceElement::U32;
+    // f32 identities are infinities, so that infinite inputs reduce like on
+    // the CPU. They are read from a variable: infinities are not allowed in
+    // constant expressions.
+    const std::string declarations = isU32 ? "" : "var<private> infinityBits: u32 = 0x7f800000u;\n";
+    const std::string lowest = isU32 ? "0u" : "-bitcast<f32>(infinityBits)";
+    const std::string highest = isU32 ? "0xffffffffu" : "bitcast<f32>(infinityBits)";
+    switch (op) {
+    case ReduceOp::Sum:
+        return "fn identity() -> Item { return Item(ELEMENT(0), 0u); }\n"
+            "fn combine(a: Item, b: Item) -> Item { return Item(a.value + b.value, 0u); }\n";
+    case ReduceOp::Min:
+        return declarations + "fn identity() -> Item { return Item(" + highest + ", 0u); }\n"
+            "fn combine(a: Item, b: Item) -> Item { return Item(min(a.value, b.value), 0u); }\n";
+    case ReduceOp::Max:
+        return declarations + "fn identity() -> Item { return Item(" + lowest + ", 0u); }\n"
+            "fn combine(a: Item, b: Item) -> Item { return Item(max(a.value, b.value), 0u); }\n";
+    case ReduceOp::ArgMax:
+        // Ties go to the smallest index, so the order of the tree does not
+        // matter and the result matches the CPU
+        return declarations + "fn identity() -> Item { return Item(" + lowest + ", 0xffffffffu); }\n"
+            "fn combine(a: Item, b: Item) -> Item {\n"
+            "\tif (b.value > a.value || (b.value == a.value && b.index < a.index)) {\n"
+            "\t\treturn b;\n"
+            "\t}\n"
+            "\treturn a;\n"
+            "}\n";
+    }
+    return "";
+}
+
+void replaceAll(std::string& source, const std::string& placeholder, const std::string& text) {
+    for (size_t pos = source.find(placeholder); pos != std::string::npos; pos = source.find(placeholder, pos)) {
+        source.replace(pos, placeholder.size(), text);
+        pos += text.size();
+    }
+}
+
+template <typename T>
+struct Item {
+    T value;
+    uint32_t index;
+};
+
+// The same as in the shaders: infinities for floats
+template <typename T>
+Item<T> identity(ReduceOp op) {
+    using Limits = std::numeric_limits<T>;
+    const T highest = Limits::has_infinity ? Limits::infinity() : Limits::max();
+    const T lowest = Limits::has_infinity ? -Limits::infinity() : Limits::lowest();
+    switch (op) {
+    case ReduceOp::Min: return { highest, 0 };
+    case ReduceOp::Max: return { lowest, 0 };
+    // No index until an element is kept
+    case ReduceOp::ArgMax: return { lowest, UINT32_MAX };
+    default: return { T(0), 0 };
+    }
+}
+
+template <typename T>
+Item<T> combine(const Item<T>& a, const Item<T>& b, ReduceOp op) {
+    switch (op) {
+    case ReduceOp::Sum: return { T(a.value + b.value), 0 };
+    case ReduceOp::Min: return { std::min(a.value, b.value), 0 };
+    case ReduceOp::Max: return { std::max(a.value, b.value), 0 };
+    case ReduceOp::ArgMax: return b.value > a.value || (b.value == a.value && b.index < a.index) ? b : a;
+    }
+    return a;
+}
+
+template <typename T>
+Item<T> reduceRange(const T* input, size_t count, ReduceOp op) {
+    Item<T> result = identity<T>(op);
+    size_t i = 0;
+#ifdef COMPUTE_SSE2
+    using L = Lanes<T>;
+    if (count >= 4) {
+        typename L::V accumulator = L::broadcast(result.value);
+        for (; i + 4 <= count; i += 4) {
+            typename L::V x = L::load(input + i);
+            switch (op) {
+            case ReduceOp::Sum: accumulator = L::add(accumulator, x); break;
+            case ReduceOp::Min: accumulator = L::min(accumulator, x); break;
+            default: accumulator = L::max(accumulator, x); break;
+            }
+        }
+        T lanes[4];
+        L::store(lanes, accumulator);
+        for (T lane : lanes) result = combine(result, { lane, 0 }, op == ReduceOp::ArgMax ? ReduceOp::Max : op);
+    }
+#endif
+    if (op == ReduceOp::ArgMax) {
+        // The lanes only gave the largest value, find where it first is
+        // (nowhere if they were all NaNs)
+        result.index = UINT32_MAX;
+        for (size_t j = 0; j < i; ++j) {
+            if (input[j] == result.value) {
+                result.index = static_cast<uint32_t>(j);
+                break;
+            }
+        }
+    }
+    for (; i < count; ++i) {
+        result = combine(result, { input[i], static_cast<uint32_t>(i) }, op);
+    }
+    return result;
+}
+
+template <typename T>
+ReduceResult parallelReduce(const T* input, size_t count, ReduceOp op) {
+    constexpr size_t minChunkSize = 1 << 16;
+    std::vector<Item<T>> chunkResults(std::max<size_t>(parallelChunkCount(count, minChunkSize), 1), identity<T>(op));
+    parallelChunks(count, minChunkSize, [&](size_t chunk, size_t begin, size_t end) {
+        Item<T> item = reduceRange(input + begin, end - begin, op);
+        // The ArgMax of a chunk keeps the identity's index if nothing beat
+        // it (NaNs only), which must not be offset
+        if (op != ReduceOp::ArgMax || item.index != UINT32_MAX) item.index += static_cast<uint32_t>(begin);
+        chunkResults[chunk] = item;
+    });
+
+    Item<T> result = identity<T>(op);
+    for (const Item<T>& item : chunkResults) result = combine(result, item, op);
+
+    ReduceResult reduceResult;
+    reduceResult.value = static_cast<double>(result.value);
+    reduceResult.index = result.index;
+    return reduceResult;
+}
+
+} // namespace
+
+Reduction::Reduction(ComputeContext& context, ReduceElement element, ReduceOp op)
+    : m_context(context)
+    , m_element(element)
+    , m_op(op)
+{
+    if (!context.hasGpu()) return;
+
+    std::string source = reductionSource;
+    replaceAll(source, "COMBINE", combineSource(element, op));
+    replaceAll(source, "ELEMENT", element == ReduceElement::U32 ? "u32" : "f32");
+
+    KernelDesc desc;
+    desc.source = source;
+    desc.workgroupSize = WorkgroupSize;
+    desc.bindings = { KernelBinding::Uniform, KernelBinding::ReadOnlyStorage, KernelBinding::ReadOnlyStorage, KernelBinding::Storage };
+    desc.label = "Reduction";
+    desc.entryPoint = "reduceInput";
+    m_inputKernel = std::make_unique<Kernel>(context, desc);
+    desc.label = "Reduction of partials";
+    desc.entryPoint = "reducePartials";
+    m_partialsKernel = std::make_unique<Kernel>(context, desc);
+
+    m_dummy = std::make_unique<GpuArray<uint32_t>>(context, 2);
+}
+
+Reduction::~Reduction() {
+    releaseLevels();
+}
+
+void Reduction::releaseLevels() {
+    for (Level& level : m_levels) {
+        if (level.bindGroup) level.bindGroup.release();
+    }
+    m_levels.clear();
+    m_preparedInput = 0;
+}
+
+void Reduction::prepare(GpuArrayBase& input, uint32_t count) {
+    releaseLevels();
+
+    uint32_t levelCount = count;
+    for (;;) {
+        Level level;
+        level.count = levelCount;
+        level.blockCount = (levelCount + TileSize - 1) / TileSize;
+        level.params = std::make_unique<GpuArray<Params>>(m_context, 1, WGPUBufferUsage_Uniform);
+        level.partials = std::make_unique<GpuArray<uint32_t>>(m_context, 2 * size_t(level.blockCount));
+        m_levels.push_back(std::move(level));
+        if (m_levels.back().blockCount <= 1) break;
+        levelCount = m_levels.back().blockCount;
+    }
+
+    for (size_t i = 0; i < m_levels.size(); ++i) {
+        Level& level = m_levels[i];
+        if (i == 0) {
+            level.bindGroup = m_inputKernel->createBindGroup({ level.params.get(), &input, m_dummy.get(), level.partials.get() });
+        }
+        else {
+            level.bindGroup = m_partialsKernel->createBindGroup({ level.params.get(), m_dummy.get(), m_levels[i - 1].partials.get(), level.partials.get() });
+        }
+    }
+
+    m_preparedInput = input.id();
+}
+
+bool Reduction::encode(wgpu::ComputePassEncoder pass, GpuArrayBase& input, uint32_t count) {
+    assert(m_context.hasGpu());
+    assert(count > 0 && count <= input.size());
+
+    if (input.buffer().getSize() > m_context.maxStorageBufferBindingSize()) {
+        std::cerr << "Reduction: array of " << count << " elements exceeds the storage binding limit of "
+            << m_context.maxStorageBufferBindingSize() << " bytes" << std::endl;
+        return false;
+    }
+
+    if (m_levels.empty() || m_levels[0].count != count || m_preparedInput != input.id()) {
+        prepare(input, count);
+    }
+
+    for (size_t i = 0; i < m_levels.size(); ++i) {
+        const Level& level = m_levels[i];
+        Params params = {};
+        params.count = level.count;
+        params.blockCount = level.blockCount;
+        level.params->upload(&params, 1);
+        Kernel& kernel = i == 0 ? *m_inputKernel : *m_partialsKernel;
+        kernel.dispatch(pass, level.bindGroup, std::max(level.blockCount, 1u) * WorkgroupSize);
+    }
+    return true;
+}
+
+wgpu::Buffer Reduction::resultBuffer() const {
+    assert(!m_levels.empty());
+    return m_levels.back().partials->buffer();
+}
+
+ReduceResult Reduction::decode(const uint32_t* words) const {
+    ReduceResult result;
+    if (m_element == ReduceElement::U32) {
+        result.value = words[0];
+    }
+    else {
+        float value;
+        std::memcpy(&value, &words[0], sizeof(float));
+        result.value = value;
+    }
+    result.index = words[1];
+    return result;
+}
+
+bool Reduction::reduceAsync(GpuArrayBase& input, uint32_t count, std::function<void(const ReduceResult&)> callback) {
+    if (!m_context.hasGpu()) {
+        assert(count <= input.size());
+        if (m_element == ReduceElement::U32) {
+            callback(reduceCpu(static_cast<const uint32_t*>(input.hostData()), count, m_op));
+        }
+        else {
+            callback(reduceCpu(static_cast<const float*>(input.hostData()), count, m_op));
+        }
+        return true;
+    }
+
+    wgpu::CommandEncoder encoder = m_context.createEncoder("Reduction");
+    wgpu::ComputePassDescriptor computePassDesc;
+    computePassDesc.label = "Reduction";
+    computePassDesc.timestampWriteCount = 0;
+    computePassDesc.timestampWrites = nullptr;
+    wgpu::ComputePassEncoder pass = encoder.beginComputePass(computePassDesc);
+    bool ok = encode(pass, input, count);
+    pass.end();
+    pass.release();
+    m_context.submit(encoder);
+    if (!ok) return false;
+
+    m_context.readAsync(resultBuffer(), 0, 2 * sizeof(uint32_t), [this, callback](const void* data) {
+        if (data) callback(decode(static_cast<const uint32_t*>(data)));
+    });
+    return true;
+}
+
+ReduceResult Reduction::reduce(GpuArrayBase& input, uint32_t count) {
+    ReduceResult result;
+    reduceAsync(input, count, [&result](const ReduceResult& r) { result = r; });
+    m_context.wait();
+    return result;
+}
+
+ReduceResult Reduction::reduceCpu(const uint32_t* input, size_t count, ReduceOp op) {
+    return parallelReduce(input, count, op);
+}
+
+ReduceResult Reduction::reduceCpu(const float* input, size_t count, ReduceOp op) {
+    return parallelReduce(input, count, op);
+}
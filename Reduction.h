@@ -0,0 +1,117 @@
+#pragma once
+
+#include "ComputeRuntime.h"
+
+#include <webgpu/webgpu.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+enum class ReduceElement {
+    U32,
+    F32,
+};
+
+enum class ReduceOp {
+    Sum,
+    Min,
+    Max,
+    // Largest value and its index; the first one when several are equal
+    ArgMax,
+};
+
+struct ReduceResult {
+    // Exact for both u32 and f32 elements
+    double value = 0.0;
+    // ArgMax only
+    uint32_t index = 0;
+};
+
+/**
+ * Reduction of a u32 or f32 array to a single value, with one operation per
+ * Reduction object.
+ *
+ * On the GPU each workgroup reduces a tile of TileSize elements with a tree
+ * in workgroup memory (no subgroup operations), writing one (value, index)
+ * partial per tile, and partials are reduced again until a single one is
+ * left. Results come back through ComputeContext::readAsync, so reduceAsync
+ * does not stall the caller.
+ *
+ * In CPU mode, the same calls run a multithreaded SSE2 reduction. f32 sums
+ * depend on the order of the additions and differ slightly between the two.
+ */
+class Reduction {
+public:
+    static constexpr uint32_t WorkgroupSize = 256;
+    static constexpr uint32_t ItemsPerThread = 8;
+    static constexpr uint32_t TileSize = WorkgroupSize * ItemsPerThread;
+
+    Reduction(ComputeContext& context, ReduceElement element, ReduceOp op);
+    ~Reduction();
+    Reduction(const Reduction&) = delete;
+    Reduction& operator=(const Reduction&) = delete;
+
+    /**
+     * Record the reduction of the first count (> 0) elements of input (GPU
+     * mode). The result is then in resultBuffer(), as (value bits, index)
+     * u32s. Returns false if input is larger than the storage binding limit.
+     */
+    bool encode(wgpu::ComputePassEncoder pass, GpuArrayBase& input, uint32_t count);
+    wgpu::Buffer resultBuffer() const;
+
+    /**
+     * Reduce and call back with the result, from a later poll() or wait() of
+     * the context in GPU mode (the Reduction must still exist then), or
+     * right away in CPU mode.
+     */
+    bool reduceAsync(GpuArrayBase& input, uint32_t count, std::function<void(const ReduceResult&)> callback);
+
+    /**
+     * Blocking version of reduceAsync.
+     */
+    ReduceResult reduce(GpuArrayBase& input, uint32_t count);
+
+    ReduceElement element() const { return m_element; }
+    ReduceOp op() const { return m_op; }
+
+    /**
+     * The CPU fallback, usable on any memory.
+     */
+    static ReduceResult reduceCpu(const uint32_t* input, size_t count, ReduceOp op);
+    static ReduceResult reduceCpu(const float* input, size_t count, ReduceOp op);
+
+private:
+    struct Params {
+        uint32_t count;
+        uint32_t blockCount;
+        uint32_t _pad[2];
+    };
+
+    // The first level reduces the input, the others the partials of the
+    // level before
+    struct Level {
+        uint32_t count = 0;
+        uint32_t blockCount = 0;
+        std::unique_ptr<GpuArray<Params>> params;
+        std::unique_ptr<GpuArray<uint32_t>> partials;
+        wgpu::BindGroup bindGroup = nullptr;
+    };
+
+    void prepare(GpuArrayBase& input, uint32_t count);
+    void releaseLevels();
+    ReduceResult decode(const uint32_t* words) const;
+
+private:
+    ComputeContext& m_context;
+    ReduceElement m_element;
+    ReduceOp m_op;
+    std::unique_ptr<Kernel> m_inputKernel;
+    std::unique_ptr<Kernel> m_partialsKernel;
+    // Bound in place of the input or of the partials, whichever is unused
+    std::unique_ptr<GpuArray<uint32_t>> m_dummy;
+
+    std::vector<Level> m_levels;
+    // GpuArrayBase::id() of the input the levels are bound to, 0 if none
+    uint64_t m_preparedInput = 0;
+};
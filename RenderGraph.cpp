@@ -0,0 +1,308 @@
+#include "RenderGraph.h"
+
+#include "ErrorScopes.h"
+#include "GpuTimeline.h"
+#include "Trace.h"
+
+#include <cassert>
+#include <chrono>
+#include <iostream>
+
+RenderGraph::RenderGraph(wgpu::Device device, TexturePool& texturePool)
+    : m_device(device)
+    , m_texturePool(texturePool)
+{}
+
+void RenderGraph::reset() {
+    m_resources.clear();
+    m_passes.clear();
+    m_order.clear();
+    m_compiled = false;
+}
+
+RenderGraph::ResourceId RenderGraph::createTexture(const std::string& name, const TexturePool::Key& key) {
+    Resource resource;
+    resource.name = name;
+    resource.key = key;
+    m_resources.push_back(resource);
+    return static_cast<ResourceId>(m_resources.size() - 1);
+}
+
+RenderGraph::ResourceId RenderGraph::importTexture(const std::string& name, wgpu::TextureView view) {
+    Resource resource;
+    resource.name = name;
+    resource.imported = true;
+    resource.view = view;
+    m_resources.push_back(resource);
+    return static_cast<ResourceId>(m_resources.size() - 1);
+}
+
+void RenderGraph::addPass(
+    const std::string& name,
+    const std::vector<ResourceId>& reads,
+    const std::vector<ResourceId>& writes,
+    ExecuteCallback&& execute
+) {
+    addPass(name, reads, writes, std::move(execute), PassOptions{});
+}
+
+void RenderGraph::addPass(
+    const std::string& name,
+    const std::vector<ResourceId>& reads,
+    const std::vector<ResourceId>& writes,
+    ExecuteCallback&& execute,
+    const PassOptions& options
+) {
+    Pass pass;
+    pass.name = name;
+    pass.label = label(name);
+    pass.reads = reads;
+    pass.writes = writes;
+    pass.execute = std::move(execute);
+    pass.options = options;
+    m_passes.push_back(std::move(pass));
+    m_compiled = false;
+}
+
+const char* RenderGraph::label(const std::string& name) {
+    // A frame has a handful of passes, a linear search is enough
+    for (const char* interned : m_labels) {
+        if (name == interned) return interned;
+    }
+    m_labels.push_back(Trace::intern(name));
+    return m_labels.back();
+}
+
+bool RenderGraph::compile() {
+    const uint32_t passCount = static_cast<uint32_t>(m_passes.size());
+
+    // Build dependency edges. Writers of a resource run in declaration order,
+    // a reader sees the last writer declared before it (or the last writer
+    // at all if it is declared before any of them), and a writer must wait
+    // for the readers of the previous version.
+    struct Edge {
+        uint32_t from;
+        uint32_t to;
+        bool carriesData;
+    };
+    std::vector<Edge> edges;
+    auto contains = [](const std::vector<ResourceId>& list, ResourceId id) {
+        for (ResourceId other : list) if (other == id) return true;
+        return false;
+    };
+    for (ResourceId r = 0; r < m_resources.size(); ++r) {
+        std::vector<uint32_t> writers;
+        for (uint32_t p = 0; p < passCount; ++p) {
+            if (contains(m_passes[p].writes, r)) writers.push_back(p);
+        }
+        for (size_t i = 1; i < writers.size(); ++i) {
+            edges.push_back({ writers[i - 1], writers[i], true });
+        }
+        if (writers.empty()) continue;
+        for (uint32_t p = 0; p < passCount; ++p) {
+            if (!contains(m_passes[p].reads, r) || contains(m_passes[p].writes, r)) continue;
+            uint32_t previousWriter = writers.back();
+            uint32_t nextWriter = UINT32_MAX;
+            if (writers.front() < p) {
+                for (uint32_t w : writers) {
+                    if (w < p) previousWriter = w;
+                    else if (nextWriter == UINT32_MAX) nextWriter = w;
+                }
+            }
+            edges.push_back({ previousWriter, p, true });
+            if (nextWriter != UINT32_MAX) edges.push_back({ p, nextWriter, false });
+        }
+    }
+
+    // Cull: keep passes that have side effects or write an imported texture,
+    // plus everything they (transitively) consume.
+    std::vector<bool> needed(passCount, false);
+    std::vector<uint32_t> stack;
+    for (uint32_t p = 0; p < passCount; ++p) {
+        bool isOutput = m_passes[p].options.hasSideEffects;
+        for (ResourceId r : m_passes[p].writes) isOutput = isOutput || m_resources[r].imported;
+        if (isOutput) {
+            needed[p] = true;
+            stack.push_back(p);
+        }
+    }
+    while (!stack.empty()) {
+        uint32_t p = stack.back();
+        stack.pop_back();
+        for (const Edge& edge : edges) {
+            if (edge.to != p || !edge.carriesData || needed[edge.from]) continue;
+            needed[edge.from] = true;
+            stack.push_back(edge.from);
+        }
+    }
+
+    // Order the remaining passes (Kahn, ties broken by declaration order)
+    std::vector<uint32_t> inDegree(passCount, 0);
+    for (const Edge& edge : edges) {
+        if (needed[edge.from] && needed[edge.to]) ++inDegree[edge.to];
+    }
+    m_order.clear();
+    std::vector<bool> scheduled(passCount, false);
+    for (uint32_t p = 0; p < passCount; ++p) {
+        m_passes[p].culled = !needed[p];
+        if (!needed[p]) scheduled[p] = true;
+    }
+    size_t neededCount = 0;
+    for (bool n : needed) neededCount += n ? 1 : 0;
+    while (m_order.size() < neededCount) {
+        uint32_t next = UINT32_MAX;
+        for (uint32_t p = 0; p < passCount; ++p) {
+            if (!scheduled[p] && inDegree[p] == 0) {
+                next = p;
+                break;
+            }
+        }
+        if (next == UINT32_MAX) {
+            std::cerr << "RenderGraph: cycle in pass dependencies" << std::endl;
+            m_order.clear();
+            return false;
+        }
+        scheduled[next] = true;
+        m_order.push_back(next);
+        for (const Edge& edge : edges) {
+            if (edge.from == next && needed[edge.to]) --inDegree[edge.to];
+        }
+    }
+
+    // Resource lifetimes, in execution order
+    for (Resource& resource : m_resources) {
+        resource.firstPass = UINT32_MAX;
+        resource.lastPass = 0;
+    }
+    for (uint32_t i = 0; i < m_order.size(); ++i) {
+        const Pass& pass = m_passes[m_order[i]];
+        for (const auto* list : { &pass.reads, &pass.writes }) {
+            for (ResourceId r : *list) {
+                Resource& resource = m_resources[r];
+                if (resource.firstPass == UINT32_MAX) resource.firstPass = i;
+                resource.lastPass = i;
+            }
+        }
+    }
+
+    m_compiled = true;
+    return true;
+}
+
+void RenderGraph::execute(wgpu::Queue queue) {
+    if (!m_compiled && !compile()) return;
+
+    std::vector<WGPUCommandBuffer> commands;
+    wgpu::CommandEncoder encoder = nullptr;
+    m_encoderCount = 0;
+
+    auto finishEncoder = [&]() {
+        if (!encoder) return;
+        wgpu::CommandBufferDescriptor cmdBufferDescriptor = {};
+        cmdBufferDescriptor.label = "RenderGraph command buffer";
+        commands.push_back(encoder.finish(cmdBufferDescriptor));
+        encoder.release();
+        encoder = nullptr;
+    };
+
+    for (uint32_t i = 0; i < m_order.size(); ++i) {
+        Pass& pass = m_passes[m_order[i]];
+#ifdef VALIDATION_SCOPES_ENABLED
+        const bool validating = m_errorScopes && m_errorScopes->enabled();
+        ERROR_SCOPE(m_errorScopes, validating ? pass.label : nullptr);
+#else
+        const bool validating = false;
+#endif
+
+        for (Resource& resource : m_resources) {
+            if (!resource.imported && resource.firstPass == i) {
+                resource.view = m_texturePool.acquire(resource.key, resource.firstPass, resource.lastPass).view;
+            }
+        }
+
+        if (pass.options.beginsNewEncoder || validating) finishEncoder();
+        if (!encoder) {
+            wgpu::CommandEncoderDescriptor commandEncoderDesc = {};
+            commandEncoderDesc.label = "RenderGraph encoder";
+            encoder = m_device.createCommandEncoder(commandEncoderDesc);
+            ++m_encoderCount;
+        }
+
+        const bool timed = m_gpuTimeline && m_gpuTimeline->active();
+        const char* traceName = timed || Trace::enabled() ? pass.label : nullptr;
+        if (timed) m_gpuTimeline->mark(encoder, traceName);
+#ifdef TRACING_ENABLED
+        TRACE_ZONE(traceName);
+#endif
+        auto start = std::chrono::steady_clock::now();
+        encoder.pushDebugGroup(pass.name.c_str());
+        PassContext context = { encoder, this };
+        pass.execute(context);
+        encoder.popDebugGroup();
+        if (validating) finishEncoder();
+        auto end = std::chrono::steady_clock::now();
+        pass.cpuTimeMs = std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    finishEncoder();
+
+    TRACE_ZONE("Submit");
+    ERROR_SCOPE(m_errorScopes, "Submit");
+    if (!commands.empty()) queue.submit(commands);
+    for (WGPUCommandBuffer command : commands) {
+        wgpuCommandBufferRelease(command);
+    }
+}
+
+wgpu::TextureView RenderGraph::view(ResourceId resource) const {
+    assert(resource < m_resources.size());
+    assert(m_resources[resource].view);
+    return m_resources[resource].view;
+}
+
+void RenderGraph::dump(std::ostream& out) const {
+    size_t culledCount = 0;
+    for (const Pass& pass : m_passes) culledCount += pass.culled ? 1 : 0;
+
+    auto names = [&](const std::vector<ResourceId>& list) {
+        std::string result;
+        for (ResourceId r : list) {
+            if (!result.empty()) result += ", ";
+            result += m_resources[r].name;
+        }
+        return result.empty() ? std::string("-") : result;
+    };
+
+    out << "RenderGraph: " << m_order.size() << " passes (" << culledCount << " culled), "
+        << m_encoderCount << " encoder(s)" << std::endl;
+    for (uint32_t i = 0; i < m_order.size(); ++i) {
+        const Pass& pass = m_passes[m_order[i]];
+        out << "  [" << i << "] " << pass.name
+            << " (" << pass.cpuTimeMs << " ms)"
+            << " reads: " << names(pass.reads)
+            << " writes: " << names(pass.writes)
+            << (pass.options.beginsNewEncoder ? " [new encoder]" : "")
+            << std::endl;
+    }
+    for (const Pass& pass : m_passes) {
+        if (pass.culled) out << "  culled: " << pass.name << std::endl;
+    }
+    out << "Resources:" << std::endl;
+    for (const Resource& resource : m_resources) {
+        out << "  " << resource.name;
+        if (resource.imported) {
+            out << " (imported)";
+        }
+        else {
+            out << " (" << resource.key.width << "x" << resource.key.height
+                << ", format " << resource.key.format
+                << ", " << resource.key.sampleCount << " sample(s))";
+        }
+        if (resource.firstPass == UINT32_MAX) {
+            out << " unused";
+        }
+        else {
+            out << " passes " << resource.firstPass << ".." << resource.lastPass;
+        }
+        out << std::endl;
+    }
+}
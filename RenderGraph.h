@@ -0,0 +1,156 @@
+#pragma once
+
+#include "TexturePool.h"
+
+#include <webgpu/webgpu.hpp>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+class ErrorScopes;
+class GpuTimeline;
+
+/**
+ * A frame graph: each frame, passes are declared together with the textures
+ * they read and write, then the graph
+ *  - culls passes that do not contribute to an imported texture (e.g. the
+ *    swap chain view) and are not flagged as having side effects,
+ *  - orders the remaining passes so that writers run before readers,
+ *  - computes the lifetime of each transient texture so that the TexturePool
+ *    can alias non-overlapping ones,
+ *  - records consecutive passes in as few CommandEncoders as possible.
+ *
+ * Typical use, once per frame:
+ *     graph.reset();
+ *     auto backbuffer = graph.importTexture("backbuffer", nextTexture);
+ *     graph.addPass("main", {}, { backbuffer }, [&](RenderGraph::PassContext& ctx) { ... });
+ *     graph.compile();
+ *     graph.execute(queue);
+ */
+class RenderGraph {
+public:
+    using ResourceId = uint32_t;
+
+    struct PassContext {
+        wgpu::CommandEncoder encoder;
+        const RenderGraph* graph;
+
+        wgpu::TextureView view(ResourceId resource) const { return graph->view(resource); }
+    };
+
+    using ExecuteCallback = std::function<void(PassContext& context)>;
+
+    struct PassOptions {
+        // Never culled, even if nothing reads its outputs (readbacks, queries...)
+        bool hasSideEffects = false;
+        // Submit everything recorded so far before this pass starts
+        bool beginsNewEncoder = false;
+    };
+
+    RenderGraph(wgpu::Device device, TexturePool& texturePool);
+
+    /**
+     * Forget all passes and resources of the previous frame.
+     */
+    void reset();
+
+    ResourceId createTexture(const std::string& name, const TexturePool::Key& key);
+    ResourceId importTexture(const std::string& name, wgpu::TextureView view);
+
+    void addPass(
+        const std::string& name,
+        const std::vector<ResourceId>& reads,
+        const std::vector<ResourceId>& writes,
+        ExecuteCallback&& execute
+    );
+    void addPass(
+        const std::string& name,
+        const std::vector<ResourceId>& reads,
+        const std::vector<ResourceId>& writes,
+        ExecuteCallback&& execute,
+        const PassOptions& options
+    );
+
+    /**
+     * Cull, order, and compute resource lifetimes. Returns false if the
+     * declared dependencies contain a cycle.
+     */
+    bool compile();
+
+    /**
+     * Record and submit the compiled passes. Transient textures are acquired
+     * from the pool right before the first pass that uses them.
+     */
+    void execute(wgpu::Queue queue);
+
+    /**
+     * Only valid while the graph executes.
+     */
+    wgpu::TextureView view(ResourceId resource) const;
+
+    /**
+     * Print the compiled graph: pass order, culled passes, resource lifetimes
+     * and the CPU time spent recording each pass during the last execute().
+     */
+    void dump(std::ostream& out) const;
+
+    uint32_t encoderCount() const { return m_encoderCount; }
+
+    /**
+     * Mark the beginning of each pass on this timeline (may be nullptr).
+     * Passes are also CPU zones of the trace.
+     */
+    void setGpuTimeline(GpuTimeline* timeline) { m_gpuTimeline = timeline; }
+
+    /**
+     * Run each pass in an error scope labelled with its name (may be
+     * nullptr). While the scopes are enabled, each pass gets its own encoder,
+     * finished inside the scope, so that command validation errors are
+     * attributed to it rather than to the submit.
+     */
+    void setErrorScopes(ErrorScopes* scopes) { m_errorScopes = scopes; }
+
+private:
+    struct Resource {
+        std::string name;
+        bool imported = false;
+        TexturePool::Key key;
+        wgpu::TextureView view = nullptr;
+        // Lifetime, as indices in m_order
+        uint32_t firstPass = UINT32_MAX;
+        uint32_t lastPass = 0;
+    };
+
+    struct Pass {
+        std::string name;
+        // Interned name, for trace zones, GPU marks and error scopes
+        const char* label = nullptr;
+        std::vector<ResourceId> reads;
+        std::vector<ResourceId> writes;
+        ExecuteCallback execute;
+        PassOptions options;
+        bool culled = false;
+        double cpuTimeMs = 0.0;
+    };
+
+    /**
+     * Interned copy of a pass name. Passes are declared again every frame,
+     * so the names seen so far are kept across reset() and only a new name
+     * goes through Trace::intern() and its lock.
+     */
+    const char* label(const std::string& name);
+
+    wgpu::Device m_device;
+    TexturePool& m_texturePool;
+    std::vector<Resource> m_resources;
+    std::vector<Pass> m_passes;
+    // Indices in m_passes of the passes to run, in execution order
+    std::vector<uint32_t> m_order;
+    std::vector<const char*> m_labels;
+    uint32_t m_encoderCount = 0;
+    GpuTimeline* m_gpuTimeline = nullptr;
+    ErrorScopes* m_errorScopes = nullptr;
+    bool m_compiled = false;
+};
@@ -0,0 +1,301 @@
+#include "Scene.h"
+
+#include <algorithm>
+
+namespace {
+
+const char* sceneShaderSource = R"(
+struct Object {
+    offset: vec2f,
+    scale: f32,
+    depth: f32,
+    color: vec4f,
+};
+
+@group(0) @binding(0) var<storage, read> objects: array<Object>;
+
+struct VertexOutput {
+    // Invariant, so that the depth pre-pass and the color pass compute the
+    // same depth with different pipelines
+    @builtin(position) @invariant position: vec4f,
+    @location(0) color: vec4f,
+};
+
+@vertex
+fn vs_main(@builtin(vertex_index) in_vertex_index: u32, @builtin(instance_index) in_instance_index: u32) -> VertexOutput {
+    var p = vec2f(0.0, 0.0);
+    if (in_vertex_index == 0u) {
+        p = vec2f(-0.5, -0.5);
+    } else if (in_vertex_index == 1u) {
+        p = vec2f(0.5, -0.5);
+    } else {
+        p = vec2f(0.0, 0.5);
+    }
+    let object = objects[in_instance_index];
+    var out: VertexOutput;
+    out.position = vec4f(object.offset + object.scale * p, object.depth, 1.0);
+    out.color = object.color;
+    return out;
+}
+
+@fragment
+fn fs_main(in: VertexOutput) -> @location(0) vec4f {
+    return in.color;
+}
+
+// Depth pre-pass: only the depth is written
+@fragment
+fn fs_depth() {
+}
+)";
+
+// Same triangle as in the shader
+const float triangle[3][2] = { { -0.5f, -0.5f }, { 0.5f, -0.5f }, { 0.0f, 0.5f } };
+
+} // namespace
+
+Scene::Scene(wgpu::Device device, wgpu::Queue queue, wgpu::TextureFormat colorFormat, const Options& options)
+    : m_device(device)
+    , m_queue(queue)
+    , m_options(options)
+{
+    createObjects();
+    createPipelines(colorFormat);
+}
+
+Scene::~Scene() {
+    m_colorPipeline.release();
+    if (m_depthPipeline) m_depthPipeline.release();
+    m_bindGroup.release();
+    m_pipelineLayout.release();
+    m_bindGroupLayout.release();
+    m_shaderModule.release();
+    m_objectBuffer.destroy();
+    m_objectBuffer.release();
+}
+
+void Scene::createObjects() {
+    m_objects.resize(std::max(m_options.objectCount, 1u));
+    if (m_objects.size() == 1) {
+        // The original triangle
+        m_objects[0] = { { 0.0f, 0.0f }, 1.0f, 0.5f, { 0.0f, 0.4f, 1.0f, 1.0f } };
+    }
+    else {
+        // Deterministic pseudo-random layout, so that runs are comparable
+        uint32_t state = 12345;
+        auto random = [&state]() {
+            state = state * 1664525u + 1013904223u;
+            return (state >> 8) / float(1 << 24);
+        };
+        for (Object& object : m_objects) {
+            object.offset[0] = 1.6f * random() - 0.8f;
+            object.offset[1] = 1.6f * random() - 0.8f;
+            object.scale = 0.3f + 0.7f * random();
+            object.depth = random();
+            object.color[0] = random();
+            object.color[1] = random();
+            object.color[2] = random();
+            object.color[3] = 1.0f;
+        }
+    }
+
+    wgpu::BufferDescriptor bufferDesc;
+    bufferDesc.label = "Scene objects";
+    bufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
+    bufferDesc.size = m_objects.size() * sizeof(Object);
+    bufferDesc.mappedAtCreation = false;
+    m_objectBuffer = m_device.createBuffer(bufferDesc);
+    m_queue.writeBuffer(m_objectBuffer, 0, m_objects.data(), bufferDesc.size);
+}
+
+void Scene::createPipelines(wgpu::TextureFormat colorFormat) {
+    wgpu::ShaderModuleWGSLDescriptor shaderCodeDesc;
+    shaderCodeDesc.chain.next = nullptr;
+    shaderCodeDesc.chain.sType = wgpu::SType::ShaderModuleWGSLDescriptor;
+    shaderCodeDesc.code = sceneShaderSource;
+    wgpu::ShaderModuleDescriptor shaderDesc;
+    shaderDesc.nextInChain = &shaderCodeDesc.chain;
+    shaderDesc.label = "Scene shader";
+    shaderDesc.hintCount = 0;
+    shaderDesc.hints = nullptr;
+    m_shaderModule = m_device.createShaderModule(shaderDesc);
+
+    wgpu::BindGroupLayoutEntry bindingLayout = wgpu::Default;
+    bindingLayout.binding = 0;
+    bindingLayout.visibility = wgpu::ShaderStage::Vertex;
+    bindingLayout.buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+    bindingLayout.buffer.minBindingSize = sizeof(Object);
+    wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc;
+    bindGroupLayoutDesc.label = "Scene bind group layout";
+    bindGroupLayoutDesc.entryCount = 1;
+    bindGroupLayoutDesc.entries = &bindingLayout;
+    m_bindGroupLayout = m_device.createBindGroupLayout(bindGroupLayoutDesc);
+
+    wgpu::PipelineLayoutDescriptor pipelineLayoutDesc;
+    pipelineLayoutDesc.label = "Scene pipeline layout";
+    pipelineLayoutDesc.bindGroupLayoutCount = 1;
+    pipelineLayoutDesc.bindGroupLayouts = reinterpret_cast<WGPUBindGroupLayout*>(&m_bindGroupLayout);
+    m_pipelineLayout = m_device.createPipelineLayout(pipelineLayoutDesc);
+
+    wgpu::BindGroupEntry binding = wgpu::Default;
+    binding.binding = 0;
+    binding.buffer = m_objectBuffer;
+    binding.offset = 0;
+    binding.size = m_objects.size() * sizeof(Object);
+    wgpu::BindGroupDescriptor bindGroupDesc;
+    bindGroupDesc.label = "Scene bind group";
+    bindGroupDesc.layout = m_bindGroupLayout;
+    bindGroupDesc.entryCount = 1;
+    bindGroupDesc.entries = &binding;
+    m_bindGroup = m_device.createBindGroup(bindGroupDesc);
+
+    wgpu::RenderPipelineDescriptor pipelineDesc;
+    pipelineDesc.layout = m_pipelineLayout;
+    // define vertex shader
+    pipelineDesc.vertex.bufferCount = 0;
+    pipelineDesc.vertex.buffers = nullptr;
+    pipelineDesc.vertex.module = m_shaderModule;
+    pipelineDesc.vertex.entryPoint = "vs_main";
+    pipelineDesc.vertex.constantCount = 0;
+    pipelineDesc.vertex.constants = nullptr;
+    // define rasterization
+    pipelineDesc.primitive.topology = wgpu::PrimitiveTopology::TriangleList;
+    pipelineDesc.primitive.stripIndexFormat = wgpu::IndexFormat::Undefined;
+    pipelineDesc.primitive.frontFace = wgpu::FrontFace::CCW;
+    pipelineDesc.primitive.cullMode = wgpu::CullMode::None;
+    // define stencil/depth test
+    wgpu::DepthStencilState depthStencilState = wgpu::Default;
+    depthStencilState.format = DepthFormat;
+    depthStencilState.depthWriteEnabled = true;
+    depthStencilState.depthCompare = wgpu::CompareFunction::Less;
+    depthStencilState.stencilReadMask = 0;
+    depthStencilState.stencilWriteMask = 0;
+    pipelineDesc.depthStencil = &depthStencilState;
+
+    pipelineDesc.multisample.count = m_options.sampleCount;
+    pipelineDesc.multisample.mask = ~0u;
+    pipelineDesc.multisample.alphaToCoverageEnabled = false;
+
+    // define fragment shader
+    wgpu::FragmentState fragmentState;
+    fragmentState.module = m_shaderModule;
+    fragmentState.entryPoint = "fs_main";
+    fragmentState.constantCount = 0;
+    fragmentState.constants = nullptr;
+    pipelineDesc.fragment = &fragmentState;
+    // define blending
+    wgpu::BlendState blendState;
+    blendState.color.srcFactor = wgpu::BlendFactor::SrcAlpha;
+    blendState.color.dstFactor = wgpu::BlendFactor::OneMinusSrcAlpha;
+    blendState.color.operation = wgpu::BlendOperation::Add;
+    blendState.alpha.srcFactor = wgpu::BlendFactor::Zero;
+    blendState.alpha.dstFactor = wgpu::BlendFactor::One;
+    blendState.alpha.operation = wgpu::BlendOperation::Add;
+    wgpu::ColorTargetState colorTarget;
+    colorTarget.format = colorFormat;
+    colorTarget.blend = &blendState;
+    colorTarget.writeMask = wgpu::ColorWriteMask::All;
+
+    fragmentState.targetCount = 1;
+    fragmentState.targets = &colorTarget;
+
+    if (m_options.depthPrepass) {
+        // Depth only, but drawn in the color pass, so the pipeline declares
+        // its color target too, with nothing written to it
+        wgpu::ColorTargetState depthOnlyTarget = colorTarget;
+        depthOnlyTarget.blend = nullptr;
+        depthOnlyTarget.writeMask = wgpu::ColorWriteMask::None;
+        wgpu::FragmentState depthOnlyFragmentState = fragmentState;
+        depthOnlyFragmentState.entryPoint = "fs_depth";
+        depthOnlyFragmentState.targets = &depthOnlyTarget;
+        pipelineDesc.fragment = &depthOnlyFragmentState;
+        pipelineDesc.label = "Scene depth pre-pass pipeline";
+        m_depthPipeline = m_device.createRenderPipeline(pipelineDesc);
+        pipelineDesc.fragment = &fragmentState;
+
+        // The color pass then only shades the fragments that won
+        depthStencilState.depthWriteEnabled = false;
+        depthStencilState.depthCompare = wgpu::CompareFunction::LessEqual;
+    }
+
+    pipelineDesc.label = "Scene color pipeline";
+    m_colorPipeline = m_device.createRenderPipeline(pipelineDesc);
+
+    if (m_depthPipeline) m_depthPipelineIndex = m_drawList.addPipeline(m_depthPipeline);
+    m_colorPipelineIndex = m_drawList.addPipeline(m_colorPipeline);
+    m_bindGroupIndex = m_drawList.addBindGroup(m_bindGroup);
+}
+
+void Scene::sortDraws() {
+    m_drawList.clear();
+    for (uint32_t i = 0; i < m_objects.size(); ++i) {
+        DrawList::Draw draw;
+        draw.bindGroup = m_bindGroupIndex;
+        // Unsorted draws keep their declaration order, the sort being stable
+        draw.depth = m_options.sortFrontToBack ? m_objects[i].depth : 0.0f;
+        draw.vertexCount = 3;
+        // The object index goes through instance_index
+        draw.firstInstance = i;
+
+        if (m_options.depthPrepass) {
+            draw.pass = DepthPrepassPass;
+            draw.pipeline = m_depthPipelineIndex;
+            m_drawList.add(draw);
+        }
+        draw.pass = ColorPass;
+        draw.pipeline = m_colorPipelineIndex;
+        m_drawList.add(draw);
+    }
+    m_drawList.sort();
+}
+
+void Scene::encode(wgpu::RenderPassEncoder renderPass) {
+    if (m_options.depthPrepass) {
+        m_drawList.encode(renderPass, DepthPrepassPass);
+    }
+    m_drawList.encode(renderPass, ColorPass);
+}
+
+void Scene::updateOverdrawStats() {
+    constexpr int gridWidth = 64;
+    constexpr int gridHeight = 48;
+    std::vector<float> depthBuffer(gridWidth * gridHeight, 1.0f);
+    uint64_t covered = 0;
+    uint64_t shaded = 0;
+
+    for (size_t d = 0; d < m_drawList.size(); ++d) {
+        const DrawList::Draw& draw = m_drawList.sortedDraw(d);
+        if (draw.pass != ColorPass) continue;
+        const Object& object = m_objects[draw.firstInstance];
+        float x[3], y[3];
+        for (int v = 0; v < 3; ++v) {
+            x[v] = object.offset[0] + object.scale * triangle[v][0];
+            y[v] = object.offset[1] + object.scale * triangle[v][1];
+        }
+        for (int j = 0; j < gridHeight; ++j) {
+            float py = 1.0f - 2.0f * (j + 0.5f) / gridHeight;
+            for (int i = 0; i < gridWidth; ++i) {
+                float px = 2.0f * (i + 0.5f) / gridWidth - 1.0f;
+                bool inside = true;
+                for (int e = 0; e < 3 && inside; ++e) {
+                    int f = (e + 1) % 3;
+                    inside = (x[f] - x[e]) * (py - y[e]) - (y[f] - y[e]) * (px - x[e]) >= 0.0f;
+                }
+                if (!inside) continue;
+                ++covered;
+                float& depth = depthBuffer[j * gridWidth + i];
+                if (object.depth < depth) {
+                    depth = object.depth;
+                    ++shaded;
+                }
+            }
+        }
+    }
+
+    const double cellCount = gridWidth * gridHeight;
+    m_stats.depthComplexity = covered / cellCount;
+    // With a pre-pass, each covered pixel is shaded exactly once
+    uint64_t visible = 0;
+    for (float depth : depthBuffer) visible += depth < 1.0f ? 1 : 0;
+    m_stats.shadedOverdraw = (m_options.depthPrepass ? visible : shaded) / cellCount;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "DrawList.h"
+
+#include <webgpu/webgpu.hpp>
+#include <cstdint>
+#include <vector>
+
+/**
+ * The triangles drawn by the app. Each object is one instance of the
+ * triangle, positioned by an entry of a storage buffer read in the vertex
+ * shader. With many objects the scene becomes overdraw heavy, which is what
+ * depth testing, front-to-back sorting and the depth pre-pass address.
+ */
+class Scene {
+public:
+    struct Options {
+        uint32_t objectCount = 1;
+        uint32_t sampleCount = 1;
+        // Lay down depth with a cheap depth-only pipeline first, so that the
+        // color pipeline only shades visible fragments
+        bool depthPrepass = false;
+        // Disable to measure what front-to-back ordering buys
+        bool sortFrontToBack = true;
+    };
+
+    struct Stats {
+        // Covered pixels over screen pixels, i.e. the average number of
+        // fragments per pixel without any depth rejection
+        double depthComplexity = 0.0;
+        // Estimated color fragments shaded per pixel, given the draw order
+        // (or 1 with a depth pre-pass)
+        double shadedOverdraw = 0.0;
+    };
+
+    static constexpr WGPUTextureFormat DepthFormat = WGPUTextureFormat_Depth24Plus;
+
+    Scene(wgpu::Device device, wgpu::Queue queue, wgpu::TextureFormat colorFormat, const Options& options);
+    ~Scene();
+    Scene(const Scene&) = delete;
+    Scene& operator=(const Scene&) = delete;
+
+    /**
+     * Fill the draw list for this frame and sort it: by pipeline, then front
+     * to back. Call once per frame before encode().
+     */
+    void sortDraws();
+
+    /**
+     * Record the draws into a render pass that has a color and a DepthFormat
+     * depth attachment, both with options.sampleCount samples.
+     */
+    void encode(wgpu::RenderPassEncoder renderPass);
+
+    /**
+     * Fill depthComplexity and shadedOverdraw by rasterizing the scene on a
+     * coarse CPU grid, in the current draw order. Too slow to run every frame
+     * with many objects, call it when reporting.
+     */
+    void updateOverdrawStats();
+
+    const Options& options() const { return m_options; }
+    const Stats& stats() const { return m_stats; }
+    const DrawList::Stats& drawStats() const { return m_drawList.stats(); }
+
+private:
+    // Must match struct Object in the shader
+    struct Object {
+        float offset[2];
+        float scale;
+        float depth;
+        float color[4];
+    };
+
+    void createObjects();
+    void createPipelines(wgpu::TextureFormat colorFormat);
+
+    wgpu::Device m_device;
+    wgpu::Queue m_queue;
+    Options m_options;
+
+    std::vector<Object> m_objects;
+    wgpu::Buffer m_objectBuffer = nullptr;
+
+    wgpu::ShaderModule m_shaderModule = nullptr;
+    wgpu::BindGroupLayout m_bindGroupLayout = nullptr;
+    wgpu::PipelineLayout m_pipelineLayout = nullptr;
+    wgpu::BindGroup m_bindGroup = nullptr;
+    wgpu::RenderPipeline m_depthPipeline = nullptr;
+    wgpu::RenderPipeline m_colorPipeline = nullptr;
+
+    // DrawList pass indices
+    static constexpr uint32_t DepthPrepassPass = 0;
+    static constexpr uint32_t ColorPass = 1;
+
+    DrawList m_drawList;
+    uint32_t m_depthPipelineIndex = 0;
+    uint32_t m_colorPipelineIndex = 0;
+    uint32_t m_bindGroupIndex = 0;
+    Stats m_stats;
+};
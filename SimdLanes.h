@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * The few SSE2 operations the CPU fallbacks of the compute kernels need,
+ * on 4 lanes of u32 or f32, so that they can be written once for both.
+ * COMPUTE_SSE2 is only defined when SSE2 is available; code using Lanes
+ * must keep a scalar path for other targets.
+ */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COMPUTE_SSE2 1
+#endif
+
+#ifdef COMPUTE_SSE2
+
+template <typename T>
+struct Lanes;
+
+template <>
+struct Lanes<uint32_t> {
+    using V = __m128i;
+    static V load(const uint32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(uint32_t* p, V v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static V broadcast(uint32_t x) { return _mm_set1_epi32(static_cast<int>(x)); }
+    static V add(V a, V b) { return _mm_add_epi32(a, b); }
+    // SSE2 only compares signed integers: flip the sign bits first
+    static V greater(V a, V b) {
+        const V bias = _mm_set1_epi32(INT32_MIN);
+        return _mm_cmpgt_epi32(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias));
+    }
+    static V min(V a, V b) {
+        V aGreater = greater(a, b);
+        return _mm_or_si128(_mm_and_si128(aGreater, b), _mm_andnot_si128(aGreater, a));
+    }
+    static V max(V a, V b) {
+        V aGreater = greater(a, b);
+        return _mm_or_si128(_mm_and_si128(aGreater, a), _mm_andnot_si128(aGreater, b));
+    }
+    // Move lanes up by 1 or 2, shifting in zeros
+    static V shift1(V v) { return _mm_slli_si128(v, 4); }
+    static V shift2(V v) { return _mm_slli_si128(v, 8); }
+    static uint32_t last(V v) { return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3)))); }
+};
+
+template <>
+struct Lanes<float> {
+    using V = __m128;
+    static V load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, V v) { _mm_storeu_ps(p, v); }
+    static V broadcast(float x) { return _mm_set1_ps(x); }
+    static V add(V a, V b) { return _mm_add_ps(a, b); }
+    static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+    static V min(V a, V b) { return _mm_min_ps(a, b); }
+    static V max(V a, V b) { return _mm_max_ps(a, b); }
+    static V shift1(V v) { return _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4)); }
+    static V shift2(V v) { return _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 8)); }
+    static float last(V v) { return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))); }
+};
+
+#endif // COMPUTE_SSE2
@@ -0,0 +1,525 @@
+#include "StatsOverlay.h"
+
+#include "FrameStats.h"
+#include "GpuTelemetry.h"
+#include "NuklearConfig.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+const char* overlayShaderSource = R"(
+// Set when the target is sRGB: nuklear colors are already sRGB encoded
+override linearizeColors: bool = false;
+
+struct Uniforms {
+	// From pixels to clip space
+	scale: vec2f,
+};
+
+@group(0) @binding(0) var<uniform> uniforms: Uniforms;
+@group(0) @binding(1) var fontTexture: texture_2d<f32>;
+@group(0) @binding(2) var fontSampler: sampler;
+
+struct VertexInput {
+	@location(0) position: vec2f,
+	@location(1) uv: vec2f,
+	@location(2) color: vec4f,
+};
+
+struct VertexOutput {
+	@builtin(position) position: vec4f,
+	@location(0) uv: vec2f,
+	@location(1) color: vec4f,
+};
+
+@vertex
+fn vs_main(in: VertexInput) -> VertexOutput {
+	var out: VertexOutput;
+	out.position = vec4f(in.position * uniforms.scale + vec2f(-1.0, 1.0), 0.0, 1.0);
+	out.uv = in.uv;
+	out.color = in.color;
+	if (linearizeColors) {
+		out.color = vec4f(pow(in.color.rgb, vec3f(2.2)), in.color.a);
+	}
+	return out;
+}
+
+@fragment
+fn fs_main(in: VertexOutput) -> @location(0) vec4f {
+	return in.color * textureSample(fontTexture, fontSampler, in.uv);
+}
+)";
+
+// Vertex format nk_convert writes, matching the pipeline's vertex layout
+struct Vertex {
+    float position[2];
+    float uv[2];
+    nk_byte color[4];
+};
+
+const nk_draw_vertex_layout_element vertexLayout[] = {
+    { NK_VERTEX_POSITION, NK_FORMAT_FLOAT, offsetof(Vertex, position) },
+    { NK_VERTEX_TEXCOORD, NK_FORMAT_FLOAT, offsetof(Vertex, uv) },
+    { NK_VERTEX_COLOR, NK_FORMAT_R8G8B8A8, offsetof(Vertex, color) },
+    { NK_VERTEX_LAYOUT_END },
+};
+
+constexpr float windowWidth = 300.0f;
+constexpr float rowHeight = 16.0f;
+constexpr float chartHeight = 60.0f;
+
+// writeBuffer sizes must be multiples of 4 bytes
+uint64_t alignTo4(uint64_t size) {
+    return (size + 3) & ~uint64_t(3);
+}
+
+bool isSrgb(wgpu::TextureFormat format) {
+    return format == wgpu::TextureFormat::BGRA8UnormSrgb || format == wgpu::TextureFormat::RGBA8UnormSrgb;
+}
+
+} // namespace
+
+struct StatsOverlay::Nuklear {
+    nk_context context;
+    nk_font_atlas atlas;
+    nk_draw_null_texture nullTexture;
+    nk_buffer commands;
+    // Storage of the fixed vertex and index nk_buffers, grown on overflow
+    std::vector<uint8_t> vertices = std::vector<uint8_t>(64 * 1024);
+    std::vector<uint8_t> indices = std::vector<uint8_t>(16 * 1024);
+};
+
+StatsOverlay::StatsOverlay(wgpu::Device device, wgpu::Queue queue, wgpu::TextureFormat targetFormat)
+    : m_device(device)
+    , m_queue(queue)
+    , m_nk(std::make_unique<Nuklear>())
+{
+    createPipeline(targetFormat);
+
+    // Bake the default font; its atlas also holds the white pixel nuklear
+    // uses for untextured shapes
+    nk_font_atlas_init_default(&m_nk->atlas);
+    nk_font_atlas_begin(&m_nk->atlas);
+    nk_font* font = nk_font_atlas_add_default(&m_nk->atlas, 13.0f, nullptr);
+    int atlasWidth = 0;
+    int atlasHeight = 0;
+    const void* pixels = nk_font_atlas_bake(&m_nk->atlas, &atlasWidth, &atlasHeight, NK_FONT_ATLAS_RGBA32);
+    createFontTexture(pixels, static_cast<uint32_t>(atlasWidth), static_cast<uint32_t>(atlasHeight));
+    nk_font_atlas_end(&m_nk->atlas, nk_handle_id(0), &m_nk->nullTexture);
+    nk_init_default(&m_nk->context, &font->handle);
+    nk_buffer_init_default(&m_nk->commands);
+
+    wgpu::BufferDescriptor bufferDesc;
+    bufferDesc.label = "Stats overlay uniforms";
+    bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform;
+    bufferDesc.size = sizeof(Uniforms);
+    bufferDesc.mappedAtCreation = false;
+    m_uniformBuffer = m_device.createBuffer(bufferDesc);
+
+    std::vector<wgpu::BindGroupEntry> bindings(3, wgpu::Default);
+    bindings[0].binding = 0;
+    bindings[0].buffer = m_uniformBuffer;
+    bindings[0].offset = 0;
+    bindings[0].size = sizeof(Uniforms);
+    bindings[1].binding = 1;
+    bindings[1].textureView = m_fontView;
+    bindings[2].binding = 2;
+    bindings[2].sampler = m_sampler;
+    wgpu::BindGroupDescriptor bindGroupDesc;
+    bindGroupDesc.label = "Stats overlay bind group";
+    bindGroupDesc.layout = m_bindGroupLayout;
+    bindGroupDesc.entryCount = static_cast<uint32_t>(bindings.size());
+    bindGroupDesc.entries = bindings.data();
+    m_bindGroup = m_device.createBindGroup(bindGroupDesc);
+
+    ensureBufferSizes(m_nk->vertices.size(), m_nk->indices.size());
+}
+
+StatsOverlay::~StatsOverlay() {
+    nk_buffer_free(&m_nk->commands);
+    nk_free(&m_nk->context);
+    nk_font_atlas_clear(&m_nk->atlas);
+
+    if (m_vertexBuffer) {
+        m_vertexBuffer.destroy();
+        m_vertexBuffer.release();
+    }
+    if (m_indexBuffer) {
+        m_indexBuffer.destroy();
+        m_indexBuffer.release();
+    }
+    m_bindGroup.release();
+    m_uniformBuffer.destroy();
+    m_uniformBuffer.release();
+    m_sampler.release();
+    m_fontView.release();
+    m_fontTexture.destroy();
+    m_fontTexture.release();
+    m_pipeline.release();
+    m_pipelineLayout.release();
+    m_bindGroupLayout.release();
+    m_shaderModule.release();
+}
+
+void StatsOverlay::createPipeline(wgpu::TextureFormat targetFormat) {
+    wgpu::ShaderModuleWGSLDescriptor shaderCodeDesc;
+    shaderCodeDesc.chain.next = nullptr;
+    shaderCodeDesc.chain.sType = wgpu::SType::ShaderModuleWGSLDescriptor;
+    shaderCodeDesc.code = overlayShaderSource;
+    wgpu::ShaderModuleDescriptor shaderDesc;
+    shaderDesc.nextInChain = &shaderCodeDesc.chain;
+    shaderDesc.label = "Stats overlay shader";
+    shaderDesc.hintCount = 0;
+    shaderDesc.hints = nullptr;
+    m_shaderModule = m_device.createShaderModule(shaderDesc);
+
+    std::vector<wgpu::BindGroupLayoutEntry> bindingLayouts(3, wgpu::Default);
+    bindingLayouts[0].binding = 0;
+    bindingLayouts[0].visibility = wgpu::ShaderStage::Vertex;
+    bindingLayouts[0].buffer.type = wgpu::BufferBindingType::Uniform;
+    bindingLayouts[0].buffer.minBindingSize = sizeof(Uniforms);
+    bindingLayouts[1].binding = 1;
+    bindingLayouts[1].visibility = wgpu::ShaderStage::Fragment;
+    bindingLayouts[1].texture.sampleType = wgpu::TextureSampleType::Float;
+    bindingLayouts[1].texture.viewDimension = wgpu::TextureViewDimension::_2D;
+    bindingLayouts[2].binding = 2;
+    bindingLayouts[2].visibility = wgpu::ShaderStage::Fragment;
+    bindingLayouts[2].sampler.type = wgpu::SamplerBindingType::Filtering;
+    wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc;
+    bindGroupLayoutDesc.label = "Stats overlay bind group layout";
+    bindGroupLayoutDesc.entryCount = static_cast<uint32_t>(bindingLayouts.size());
+    bindGroupLayoutDesc.entries = bindingLayouts.data();
+    m_bindGroupLayout = m_device.createBindGroupLayout(bindGroupLayoutDesc);
+
+    wgpu::PipelineLayoutDescriptor layoutDesc;
+    layoutDesc.label = "Stats overlay pipeline layout";
+    layoutDesc.bindGroupLayoutCount = 1;
+    layoutDesc.bindGroupLayouts = (WGPUBindGroupLayout*)&m_bindGroupLayout;
+    m_pipelineLayout = m_device.createPipelineLayout(layoutDesc);
+
+    std::vector<wgpu::VertexAttribute> vertexAttributes(3);
+    vertexAttributes[0].shaderLocation = 0;
+    vertexAttributes[0].format = wgpu::VertexFormat::Float32x2;
+    vertexAttributes[0].offset = offsetof(Vertex, position);
+    vertexAttributes[1].shaderLocation = 1;
+    vertexAttributes[1].format = wgpu::VertexFormat::Float32x2;
+    vertexAttributes[1].offset = offsetof(Vertex, uv);
+    vertexAttributes[2].shaderLocation = 2;
+    vertexAttributes[2].format = wgpu::VertexFormat::Unorm8x4;
+    vertexAttributes[2].offset = offsetof(Vertex, color);
+    wgpu::VertexBufferLayout vertexBufferLayout;
+    vertexBufferLayout.arrayStride = sizeof(Vertex);
+    vertexBufferLayout.stepMode = wgpu::VertexStepMode::Vertex;
+    vertexBufferLayout.attributeCount = static_cast<uint32_t>(vertexAttributes.size());
+    vertexBufferLayout.attributes = vertexAttributes.data();
+
+    wgpu::ConstantEntry linearizeConstant;
+    linearizeConstant.key = "linearizeColors";
+    linearizeConstant.value = isSrgb(targetFormat) ? 1.0 : 0.0;
+
+    wgpu::RenderPipelineDescriptor pipelineDesc;
+    pipelineDesc.label = "Stats overlay pipeline";
+    pipelineDesc.layout = m_pipelineLayout;
+    // define vertex shader
+    pipelineDesc.vertex.bufferCount = 1;
+    pipelineDesc.vertex.buffers = &vertexBufferLayout;
+    pipelineDesc.vertex.module = m_shaderModule;
+    pipelineDesc.vertex.entryPoint = "vs_main";
+    pipelineDesc.vertex.constantCount = 1;
+    pipelineDesc.vertex.constants = &linearizeConstant;
+    // define rasterization
+    pipelineDesc.primitive.topology = wgpu::PrimitiveTopology::TriangleList;
+    pipelineDesc.primitive.stripIndexFormat = wgpu::IndexFormat::Undefined;
+    pipelineDesc.primitive.frontFace = wgpu::FrontFace::CCW;
+    pipelineDesc.primitive.cullMode = wgpu::CullMode::None;
+    // drawn over the finished frame, no depth test
+    pipelineDesc.depthStencil = nullptr;
+
+    pipelineDesc.multisample.count = 1;
+    pipelineDesc.multisample.mask = ~0u;
+    pipelineDesc.multisample.alphaToCoverageEnabled = false;
+
+    // define fragment shader
+    wgpu::FragmentState fragmentState;
+    fragmentState.module = m_shaderModule;
+    fragmentState.entryPoint = "fs_main";
+    fragmentState.constantCount = 0;
+    fragmentState.constants = nullptr;
+    pipelineDesc.fragment = &fragmentState;
+    // define blending
+    wgpu::BlendState blendState;
+    blendState.color.srcFactor = wgpu::BlendFactor::SrcAlpha;
+    blendState.color.dstFactor = wgpu::BlendFactor::OneMinusSrcAlpha;
+    blendState.color.operation = wgpu::BlendOperation::Add;
+    blendState.alpha.srcFactor = wgpu::BlendFactor::Zero;
+    blendState.alpha.dstFactor = wgpu::BlendFactor::One;
+    blendState.alpha.operation = wgpu::BlendOperation::Add;
+    wgpu::ColorTargetState colorTarget;
+    colorTarget.format = targetFormat;
+    colorTarget.blend = &blendState;
+    colorTarget.writeMask = wgpu::ColorWriteMask::All;
+    fragmentState.targetCount = 1;
+    fragmentState.targets = &colorTarget;
+
+    m_pipeline = m_device.createRenderPipeline(pipelineDesc);
+
+    wgpu::SamplerDescriptor samplerDesc = wgpu::Default;
+    samplerDesc.label = "Stats overlay sampler";
+    samplerDesc.magFilter = wgpu::FilterMode::Linear;
+    samplerDesc.minFilter = wgpu::FilterMode::Linear;
+    samplerDesc.maxAnisotropy = 1;
+    m_sampler = m_device.createSampler(samplerDesc);
+}
+
+void StatsOverlay::createFontTexture(const void* pixels, uint32_t width, uint32_t height) {
+    wgpu::TextureDescriptor textureDesc;
+    textureDesc.label = "Stats overlay font";
+    textureDesc.dimension = wgpu::TextureDimension::_2D;
+    textureDesc.format = wgpu::TextureFormat::RGBA8Unorm;
+    textureDesc.size = { width, height, 1 };
+    textureDesc.mipLevelCount = 1;
+    textureDesc.sampleCount = 1;
+    textureDesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst;
+    textureDesc.viewFormatCount = 0;
+    textureDesc.viewFormats = nullptr;
+    m_fontTexture = m_device.createTexture(textureDesc);
+
+    wgpu::ImageCopyTexture destination = wgpu::Default;
+    destination.texture = m_fontTexture;
+    destination.mipLevel = 0;
+    destination.origin = { 0, 0, 0 };
+    destination.aspect = wgpu::TextureAspect::All;
+    wgpu::TextureDataLayout layout = wgpu::Default;
+    layout.offset = 0;
+    layout.bytesPerRow = width * 4;
+    layout.rowsPerImage = height;
+    m_queue.writeTexture(destination, pixels, uint64_t(width) * height * 4, layout, { width, height, 1 });
+
+    wgpu::TextureViewDescriptor viewDesc;
+    viewDesc.label = "Stats overlay font view";
+    viewDesc.format = wgpu::TextureFormat::RGBA8Unorm;
+    viewDesc.dimension = wgpu::TextureViewDimension::_2D;
+    viewDesc.baseMipLevel = 0;
+    viewDesc.mipLevelCount = 1;
+    viewDesc.baseArrayLayer = 0;
+    viewDesc.arrayLayerCount = 1;
+    viewDesc.aspect = wgpu::TextureAspect::All;
+    m_fontView = m_fontTexture.createView(viewDesc);
+}
+
+void StatsOverlay::ensureBufferSizes(uint64_t vertexBytes, uint64_t indexBytes) {
+    // Grown by doubling, never shrunk, so that a steady UI reallocates nothing
+    if (vertexBytes > m_vertexCapacity) {
+        if (m_vertexBuffer) {
+            m_vertexBuffer.destroy();
+            m_vertexBuffer.release();
+        }
+        m_vertexCapacity = alignTo4(std::max(vertexBytes, 2 * m_vertexCapacity));
+        wgpu::BufferDescriptor bufferDesc;
+        bufferDesc.label = "Stats overlay vertices";
+        bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Vertex;
+        bufferDesc.size = m_vertexCapacity;
+        bufferDesc.mappedAtCreation = false;
+        m_vertexBuffer = m_device.createBuffer(bufferDesc);
+    }
+    if (indexBytes > m_indexCapacity) {
+        if (m_indexBuffer) {
+            m_indexBuffer.destroy();
+            m_indexBuffer.release();
+        }
+        m_indexCapacity = alignTo4(std::max(indexBytes, 2 * m_indexCapacity));
+        wgpu::BufferDescriptor bufferDesc;
+        bufferDesc.label = "Stats overlay indices";
+        bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Index;
+        bufferDesc.size = m_indexCapacity;
+        bufferDesc.mappedAtCreation = false;
+        m_indexBuffer = m_device.createBuffer(bufferDesc);
+    }
+}
+
+void StatsOverlay::layout(const FrameData& data) {
+    nk_context* ctx = &m_nk->context;
+    const nk_flags flags = NK_WINDOW_BORDER | NK_WINDOW_TITLE | NK_WINDOW_NO_SCROLLBAR | NK_WINDOW_NO_INPUT;
+    size_t zoneCount = data.gpuZones ? data.gpuZones->size() : 0;
+    float height = 30.0f + chartHeight + rowHeight * (12 + zoneCount);
+    if (nk_begin(ctx, "Stats", nk_rect(10.0f, 10.0f, windowWidth, height), flags)) {
+        if (data.frameStats && data.frameStats->frameCount() > 1) {
+            // Over the charted frames, so that a hitch at startup does not
+            // stay in the numbers
+            std::vector<float> history = data.frameStats->history();
+            double sum = 0.0;
+            for (float ms : history) sum += ms;
+            double mean = sum / history.size();
+            auto [minMs, maxMs] = std::minmax_element(history.begin(), history.end());
+            nk_layout_row_dynamic(ctx, rowHeight, 1);
+            nk_labelf(ctx, NK_TEXT_LEFT, "Frame %.2f ms (%.0f fps), min %.2f, max %.2f",
+                mean, 1000.0 / std::max(mean, 1e-3), *minMs, *maxMs);
+
+            // Scaled to at least 30 fps so that a steady frame rate reads as a flat line
+            float top = std::max(33.3f, *maxMs);
+            nk_layout_row_dynamic(ctx, chartHeight, 1);
+            if (nk_chart_begin(ctx, NK_CHART_LINES, static_cast<int>(history.size()), 0.0f, top)) {
+                for (float ms : history) nk_chart_push(ctx, ms);
+                nk_chart_end(ctx);
+            }
+        }
+
+        if (data.drawStats) {
+            const DrawList::Stats& stats = *data.drawStats;
+            nk_layout_row_dynamic(ctx, rowHeight, 1);
+            nk_labelf(ctx, NK_TEXT_LEFT, "Draws %u", stats.drawCount);
+            nk_labelf(ctx, NK_TEXT_LEFT, "Pipelines %u, bind groups %u, vertex buffers %u",
+                stats.pipelineChanges, stats.bindGroupChanges, stats.vertexBufferChanges);
+            nk_labelf(ctx, NK_TEXT_LEFT, "Redundant state calls skipped %u", stats.redundantCallsEliminated);
+        }
+
+        nk_layout_row_dynamic(ctx, rowHeight, 1);
+        nk_labelf(ctx, NK_TEXT_LEFT, "Uploaded %.1f KB (overlay %.1f KB)",
+            (data.uploadedBytes + m_lastUploadBytes) / 1024.0, m_lastUploadBytes / 1024.0);
+
+        if (zoneCount > 0) {
+            double total = 0.0;
+            for (const GpuTimeline::Zone& zone : *data.gpuZones) total += zone.ms;
+            nk_labelf(ctx, NK_TEXT_LEFT, "GPU %.3f ms", total);
+            for (const GpuTimeline::Zone& zone : *data.gpuZones) {
+                nk_labelf(ctx, NK_TEXT_LEFT, "  %s %.3f ms", zone.name, zone.ms);
+            }
+        }
+
+        if (data.telemetry && data.telemetry->sampleCount() > 0) {
+            const GpuTelemetry::Sample& sample = data.telemetry->lastSample();
+            nk_labelf(ctx, NK_TEXT_LEFT, "Buffers %llu, textures %llu, views %llu",
+                (unsigned long long)sample.counts[GpuTelemetry::Buffers],
+                (unsigned long long)sample.counts[GpuTelemetry::Textures],
+                (unsigned long long)sample.counts[GpuTelemetry::TextureViews]);
+            nk_labelf(ctx, NK_TEXT_LEFT, "Bind groups %llu, pipelines %llu",
+                (unsigned long long)sample.counts[GpuTelemetry::BindGroups],
+                (unsigned long long)(sample.counts[GpuTelemetry::RenderPipelines] + sample.counts[GpuTelemetry::ComputePipelines]));
+        }
+
+        nk_labelf(ctx, NK_TEXT_LEFT, "Overlay CPU %.3f ms", m_cpuTimeMs);
+    }
+    nk_end(ctx);
+}
+
+void StatsOverlay::update(const FrameData& data, uint32_t width, uint32_t height) {
+    if (!m_visible) return;
+    TRACE_ZONE("Overlay");
+    auto start = std::chrono::steady_clock::now();
+    m_width = width;
+    m_height = height;
+
+    nk_context* ctx = &m_nk->context;
+    // Display only: the window takes no mouse or keyboard input
+    nk_input_begin(ctx);
+    nk_input_end(ctx);
+    layout(data);
+
+    nk_convert_config config;
+    std::memset(&config, 0, sizeof(config));
+    config.vertex_layout = vertexLayout;
+    config.vertex_size = sizeof(Vertex);
+    config.vertex_alignment = NK_ALIGNOF(Vertex);
+    config.null = m_nk->nullTexture;
+    config.circle_segment_count = 22;
+    config.curve_segment_count = 22;
+    config.arc_segment_count = 22;
+    config.global_alpha = 1.0f;
+    config.shape_AA = NK_ANTI_ALIASING_ON;
+    config.line_AA = NK_ANTI_ALIASING_ON;
+
+    // Convert into the current storage, doubling whichever was too small
+    nk_buffer vertices;
+    nk_buffer indices;
+    for (;;) {
+        nk_buffer_clear(&m_nk->commands);
+        nk_buffer_init_fixed(&vertices, m_nk->vertices.data(), m_nk->vertices.size());
+        nk_buffer_init_fixed(&indices, m_nk->indices.data(), m_nk->indices.size());
+        nk_flags result = nk_convert(ctx, &m_nk->commands, &vertices, &indices, &config);
+        if (result & NK_CONVERT_VERTEX_BUFFER_FULL) m_nk->vertices.resize(2 * m_nk->vertices.size());
+        if (result & NK_CONVERT_ELEMENT_BUFFER_FULL) m_nk->indices.resize(2 * m_nk->indices.size());
+        if (!(result & (NK_CONVERT_VERTEX_BUFFER_FULL | NK_CONVERT_ELEMENT_BUFFER_FULL))) {
+            if (result != NK_CONVERT_SUCCESS) std::cerr << "StatsOverlay: nk_convert failed (" << result << ")" << std::endl;
+            break;
+        }
+    }
+
+    // One write per buffer; rounding up to 4 bytes stays within the storage,
+    // whose sizes are multiples of 4
+    m_vertexBytes = alignTo4(vertices.allocated);
+    m_indexBytes = alignTo4(indices.allocated);
+    assert(m_vertexBytes <= m_nk->vertices.size() && m_indexBytes <= m_nk->indices.size());
+    ensureBufferSizes(m_vertexBytes, m_indexBytes);
+    if (m_vertexBytes > 0) m_queue.writeBuffer(m_vertexBuffer, 0, m_nk->vertices.data(), m_vertexBytes);
+    if (m_indexBytes > 0) m_queue.writeBuffer(m_indexBuffer, 0, m_nk->indices.data(), m_indexBytes);
+    Uniforms uniforms = {};
+    uniforms.scale[0] = 2.0f / std::max(width, 1u);
+    uniforms.scale[1] = -2.0f / std::max(height, 1u);
+    m_queue.writeBuffer(m_uniformBuffer, 0, &uniforms, sizeof(Uniforms));
+    m_lastUploadBytes = m_vertexBytes + m_indexBytes + sizeof(Uniforms);
+
+    m_draws.clear();
+    const nk_draw_command* command = nullptr;
+    nk_draw_foreach(command, ctx, &m_nk->commands) {
+        if (!command->elem_count) continue;
+        // Clip rectangles may lie partly or fully outside the target
+        float x0 = std::clamp(command->clip_rect.x, 0.0f, static_cast<float>(width));
+        float y0 = std::clamp(command->clip_rect.y, 0.0f, static_cast<float>(height));
+        float x1 = std::clamp(command->clip_rect.x + command->clip_rect.w, x0, static_cast<float>(width));
+        float y1 = std::clamp(command->clip_rect.y + command->clip_rect.h, y0, static_cast<float>(height));
+        Draw draw;
+        draw.indexCount = command->elem_count;
+        draw.scissor[0] = static_cast<uint32_t>(x0);
+        draw.scissor[1] = static_cast<uint32_t>(y0);
+        draw.scissor[2] = static_cast<uint32_t>(std::ceil(x1)) - draw.scissor[0];
+        draw.scissor[3] = static_cast<uint32_t>(std::ceil(y1)) - draw.scissor[1];
+        m_draws.push_back(draw);
+    }
+    nk_clear(ctx);
+
+    m_cpuTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void StatsOverlay::encode(wgpu::CommandEncoder encoder, wgpu::TextureView target) {
+    if (!m_visible || m_draws.empty()) return;
+
+    wgpu::RenderPassColorAttachment colorAttachment = {};
+    colorAttachment.view = target;
+    colorAttachment.resolveTarget = nullptr;
+    // Drawn over what is already there
+    colorAttachment.loadOp = WGPULoadOp_Load;
+    colorAttachment.storeOp = WGPUStoreOp_Store;
+    colorAttachment.clearValue = wgpu::Color{ 0.0, 0.0, 0.0, 1.0 };
+
+    wgpu::RenderPassDescriptor renderPassDesc = {};
+    renderPassDesc.label = "Stats overlay";
+    renderPassDesc.colorAttachmentCount = 1;
+    renderPassDesc.colorAttachments = &colorAttachment;
+    renderPassDesc.depthStencilAttachment = nullptr;
+    renderPassDesc.timestampWriteCount = 0;
+    renderPassDesc.timestampWrites = nullptr;
+
+    wgpu::RenderPassEncoder renderPass = encoder.beginRenderPass(renderPassDesc);
+    renderPass.setPipeline(m_pipeline);
+    renderPass.setBindGroup(0, m_bindGroup, 0, nullptr);
+    renderPass.setVertexBuffer(0, m_vertexBuffer, 0, m_vertexBytes);
+    renderPass.setIndexBuffer(m_indexBuffer, wgpu::IndexFormat::Uint16, 0, m_indexBytes);
+    uint32_t firstIndex = 0;
+    for (const Draw& draw : m_draws) {
+        if (draw.scissor[2] > 0 && draw.scissor[3] > 0) {
+            renderPass.setScissorRect(draw.scissor[0], draw.scissor[1], draw.scissor[2], draw.scissor[3]);
+            renderPass.drawIndexed(draw.indexCount, 1, firstIndex, 0, 0);
+        }
+        firstIndex += draw.indexCount;
+    }
+    renderPass.end();
+    renderPass.release();
+}
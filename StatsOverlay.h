@@ -0,0 +1,109 @@
+#pragma once
+
+#include "DrawList.h"
+#include "GpuTimeline.h"
+
+#include <webgpu/webgpu.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class FrameStats;
+class GpuTelemetry;
+
+/**
+ * Per-frame statistics drawn over the frame with nuklear (glfw/deps): frame
+ * time graph, draw calls and state changes, bytes uploaded, GPU pass times
+ * and live wgpu objects.
+ *
+ * The whole UI is one draw list, uploaded each frame into a single vertex
+ * and a single index buffer (grown when it does not fit), and drawn in one
+ * render pass with one draw per scissor rectangle. Hidden, it costs nothing
+ * but the visible() test.
+ */
+class StatsOverlay {
+public:
+    // What to show; null pointers are skipped
+    struct FrameData {
+        const FrameStats* frameStats = nullptr;
+        const DrawList::Stats* drawStats = nullptr;
+        // Written with queue.writeBuffer/writeTexture this frame, besides
+        // the overlay's own geometry
+        uint64_t uploadedBytes = 0;
+        const std::vector<GpuTimeline::Zone>* gpuZones = nullptr;
+        const GpuTelemetry* telemetry = nullptr;
+    };
+
+    StatsOverlay(wgpu::Device device, wgpu::Queue queue, wgpu::TextureFormat targetFormat);
+    ~StatsOverlay();
+    StatsOverlay(const StatsOverlay&) = delete;
+    StatsOverlay& operator=(const StatsOverlay&) = delete;
+
+    bool visible() const { return m_visible; }
+    void setVisible(bool visible) { m_visible = visible; }
+    void toggle() { m_visible = !m_visible; }
+
+    /**
+     * Lay out the UI for a width x height target and upload its geometry.
+     * Call before encode(), when visible.
+     */
+    void update(const FrameData& data, uint32_t width, uint32_t height);
+
+    /**
+     * Record a render pass drawing the UI over target (single-sampled, of
+     * the targetFormat given at construction).
+     */
+    void encode(wgpu::CommandEncoder encoder, wgpu::TextureView target);
+
+    // CPU time of the last update(), to check the overlay stays cheap
+    double cpuTimeMs() const { return m_cpuTimeMs; }
+
+private:
+    // Must match struct Uniforms in the shader
+    struct Uniforms {
+        float scale[2];
+        float _pad[2];
+    };
+
+    // nuklear state, kept out of this header
+    struct Nuklear;
+
+    void createPipeline(wgpu::TextureFormat targetFormat);
+    void createFontTexture(const void* pixels, uint32_t width, uint32_t height);
+    void ensureBufferSizes(uint64_t vertexBytes, uint64_t indexBytes);
+    void layout(const FrameData& data);
+
+private:
+    wgpu::Device m_device;
+    wgpu::Queue m_queue;
+    bool m_visible = false;
+    std::unique_ptr<Nuklear> m_nk;
+
+    wgpu::ShaderModule m_shaderModule = nullptr;
+    wgpu::BindGroupLayout m_bindGroupLayout = nullptr;
+    wgpu::PipelineLayout m_pipelineLayout = nullptr;
+    wgpu::RenderPipeline m_pipeline = nullptr;
+    wgpu::Texture m_fontTexture = nullptr;
+    wgpu::TextureView m_fontView = nullptr;
+    wgpu::Sampler m_sampler = nullptr;
+    wgpu::Buffer m_uniformBuffer = nullptr;
+    wgpu::BindGroup m_bindGroup = nullptr;
+
+    wgpu::Buffer m_vertexBuffer = nullptr;
+    wgpu::Buffer m_indexBuffer = nullptr;
+    uint64_t m_vertexCapacity = 0;
+    uint64_t m_indexCapacity = 0;
+    uint64_t m_vertexBytes = 0;
+    uint64_t m_indexBytes = 0;
+
+    // Draws of the last update(): index count and scissor rectangle
+    struct Draw {
+        uint32_t indexCount;
+        uint32_t scissor[4];
+    };
+    std::vector<Draw> m_draws;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    uint64_t m_lastUploadBytes = 0;
+    double m_cpuTimeMs = 0.0;
+};
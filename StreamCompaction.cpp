@@ -0,0 +1,266 @@
+#include "StreamCompaction.h"
+
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+// ELEMENT is replaced by the element type, DECLARATIONS by the declarations
+// it needs and PREDICATE by the condition on value and index
+const char* compactionSource = R"(
+DECLARATIONS
+
+struct Params {
+	count: u32,
+	consumerWorkgroupSize: u32,
+	verticesPerInstance: u32,
+	maxWorkgroupsPerDimension: u32,
+}
+
+// StreamCompaction::args()
+struct Args {
+	dispatchX: u32,
+	dispatchY: u32,
+	dispatchZ: u32,
+	count: atomic<u32>,
+	vertexCount: u32,
+	instanceCount: u32,
+	firstVertex: u32,
+	firstInstance: u32,
+}
+
+override workgroupSize: u32 = 256u;
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var<storage, read> input: array<ELEMENT>;
+@group(0) @binding(2) var<storage, read_write> output: array<ELEMENT>;
+@group(0) @binding(3) var<storage, read_write> args: Args;
+
+var<workgroup> localCount: atomic<u32>;
+var<workgroup> localBase: u32;
+
+fn keep(value: ELEMENT, index: u32) -> bool {
+	return PREDICATE;
+}
+
+@compute @workgroup_size(1)
+fn reset() {
+	atomicStore(&args.count, 0u);
+}
+
+@compute @workgroup_size(workgroupSize)
+fn compact(
+	@builtin(local_invocation_index) localIndex: u32,
+	@builtin(global_invocation_id) id: vec3<u32>,
+	@builtin(num_workgroups) groups: vec3<u32>
+) {
+	let index = id.x + id.y * groups.x * workgroupSize;
+	if (localIndex == 0u) {
+		atomicStore(&localCount, 0u);
+	}
+	workgroupBarrier();
+
+	var kept = false;
+	var value: ELEMENT;
+	var localOffset = 0u;
+	if (index < params.count) {
+		value = input[index];
+		kept = keep(value, index);
+	}
+	if (kept) {
+		localOffset = atomicAdd(&localCount, 1u);
+	}
+	workgroupBarrier();
+
+	// One global atomic per workgroup rather than per kept element
+	if (localIndex == 0u) {
+		localBase = atomicAdd(&args.count, atomicLoad(&localCount));
+	}
+	workgroupBarrier();
+
+	if (kept) {
+		output[localBase + localOffset] = value;
+	}
+}
+
+@compute @workgroup_size(1)
+fn finalize() {
+	let count = atomicLoad(&args.count);
+	let groupCount = (count + params.consumerWorkgroupSize - 1u) / params.consumerWorkgroupSize;
+	if (groupCount <= params.maxWorkgroupsPerDimension) {
+		args.dispatchX = groupCount;
+		args.dispatchY = 1u;
+	} else {
+		args.dispatchX = params.maxWorkgroupsPerDimension;
+		args.dispatchY = (groupCount + params.maxWorkgroupsPerDimension - 1u) / params.maxWorkgroupsPerDimension;
+	}
+	args.dispatchZ = 1u;
+	args.vertexCount = params.verticesPerInstance;
+	args.instanceCount = count;
+	args.firstVertex = 0u;
+	args.firstInstance = 0u;
+}
+)";
+
+void replaceAll(std::string& source, const std::string& placeholder, const std::string& text) {
+    for (size_t pos = source.find(placeholder); pos != std::string::npos; pos = source.find(placeholder, pos)) {
+        source.replace(pos, placeholder.size(), text);
+        pos += text.size();
+    }
+}
+
+} // namespace
+
+StreamCompaction::StreamCompaction(ComputeContext& context, const CompactionDesc& desc)
+    : m_context(context)
+    , m_desc(desc)
+{
+    assert(desc.elementSize > 0 && desc.elementSize % 4 == 0);
+    assert(desc.consumerWorkgroupSize > 0);
+
+    m_args = std::make_unique<GpuArray<uint32_t>>(context, 8, WGPUBufferUsage_Indirect);
+    if (!context.hasGpu()) {
+        writeCpuArgs(0);
+        return;
+    }
+
+    std::string source = compactionSource;
+    replaceAll(source, "DECLARATIONS", desc.declarations);
+    replaceAll(source, "PREDICATE", desc.predicate);
+    replaceAll(source, "ELEMENT", desc.elementType);
+
+    KernelDesc kernelDesc;
+    kernelDesc.source = source;
+    kernelDesc.workgroupSize = WorkgroupSize;
+    kernelDesc.bindings = { KernelBinding::Uniform, KernelBinding::ReadOnlyStorage, KernelBinding::Storage, KernelBinding::Storage };
+    kernelDesc.label = desc.label + " reset";
+    kernelDesc.entryPoint = "reset";
+    m_resetKernel = std::make_unique<Kernel>(context, kernelDesc);
+    kernelDesc.label = desc.label;
+    kernelDesc.entryPoint = "compact";
+    m_compactKernel = std::make_unique<Kernel>(context, kernelDesc);
+    kernelDesc.label = desc.label + " arguments";
+    kernelDesc.entryPoint = "finalize";
+    m_finalizeKernel = std::make_unique<Kernel>(context, kernelDesc);
+
+    m_params = std::make_unique<GpuArray<Params>>(context, 1, WGPUBufferUsage_Uniform);
+}
+
+StreamCompaction::~StreamCompaction() {
+    if (m_bindGroup) m_bindGroup.release();
+}
+
+bool StreamCompaction::encode(wgpu::ComputePassEncoder pass, GpuArrayBase& input, GpuArrayBase& output, uint32_t count) {
+    assert(m_context.hasGpu());
+    assert(count <= input.size() && count <= output.size());
+
+    for (GpuArrayBase* array : { &input, &output }) {
+        if (array->buffer().getSize() > m_context.maxStorageBufferBindingSize()) {
+            std::cerr << "StreamCompaction: array of " << array->size() << " elements exceeds the storage binding limit of "
+                << m_context.maxStorageBufferBindingSize() << " bytes" << std::endl;
+            return false;
+        }
+    }
+
+    if (!m_bindGroup || m_boundInput != input.id() || m_boundOutput != output.id()) {
+        if (m_bindGroup) m_bindGroup.release();
+        m_bindGroup = m_compactKernel->createBindGroup({ m_params.get(), &input, &output, m_args.get() });
+        m_boundInput = input.id();
+        m_boundOutput = output.id();
+    }
+
+    Params params = {};
+    params.count = count;
+    params.consumerWorkgroupSize = m_desc.consumerWorkgroupSize;
+    params.verticesPerInstance = m_desc.verticesPerInstance;
+    params.maxWorkgroupsPerDimension = m_context.maxWorkgroupsPerDimension();
+    m_params->upload(&params, 1);
+
+    // The three kernels share the bind group layout (same bindings, same
+    // module), and dispatches of a pass are ordered
+    m_resetKernel->dispatch(pass, m_bindGroup, 1);
+    if (count > 0) m_compactKernel->dispatch(pass, m_bindGroup, count);
+    m_finalizeKernel->dispatch(pass, m_bindGroup, 1);
+    return true;
+}
+
+bool StreamCompaction::run(GpuArrayBase& input, GpuArrayBase& output, uint32_t count) {
+    if (!m_context.hasGpu()) {
+        assert(count <= input.size() && count <= output.size());
+        uint32_t kept = compactCpu(input.hostData(), output.hostData(), count, m_desc.elementSize, m_desc.cpuPredicate);
+        writeCpuArgs(kept);
+        return true;
+    }
+
+    wgpu::CommandEncoder encoder = m_context.createEncoder("Stream compaction");
+    wgpu::ComputePassDescriptor computePassDesc;
+    computePassDesc.label = "Stream compaction";
+    computePassDesc.timestampWriteCount = 0;
+    computePassDesc.timestampWrites = nullptr;
+    wgpu::ComputePassEncoder pass = encoder.beginComputePass(computePassDesc);
+    bool ok = encode(pass, input, output, count);
+    pass.end();
+    pass.release();
+    m_context.submit(encoder);
+    return ok;
+}
+
+uint32_t StreamCompaction::readCount() const {
+    if (!m_context.hasGpu()) return m_args->host()[CountOffset / sizeof(uint32_t)];
+    return m_args->download()[CountOffset / sizeof(uint32_t)];
+}
+
+void StreamCompaction::writeCpuArgs(uint32_t keptCount) {
+    uint32_t groupCount = (keptCount + m_desc.consumerWorkgroupSize - 1) / m_desc.consumerWorkgroupSize;
+    uint32_t maxGroups = m_context.maxWorkgroupsPerDimension();
+    uint32_t* args = m_args->host();
+    args[0] = std::min(groupCount, maxGroups);
+    args[1] = groupCount <= maxGroups ? 1 : (groupCount + maxGroups - 1) / maxGroups;
+    args[2] = 1;
+    args[3] = keptCount;
+    args[4] = m_desc.verticesPerInstance;
+    args[5] = keptCount;
+    args[6] = 0;
+    args[7] = 0;
+}
+
+uint32_t StreamCompaction::compactCpu(const void* input, void* output, uint32_t count, uint32_t elementSize, const CompactionPredicate& predicate) {
+    const uint8_t* in = static_cast<const uint8_t*>(input);
+    uint8_t* out = static_cast<uint8_t*>(output);
+
+    // Count the kept elements of each chunk, then each chunk copies them
+    // from its offset, which keeps the order
+    constexpr size_t minChunkSize = 1 << 16;
+    std::vector<uint32_t> chunkCounts(std::max<size_t>(parallelChunkCount(count, minChunkSize), 1), 0);
+    std::vector<uint8_t> kept(count);
+    parallelChunks(count, minChunkSize, [&](size_t chunk, size_t begin, size_t end) {
+        uint32_t chunkCount = 0;
+        for (size_t i = begin; i < end; ++i) {
+            kept[i] = predicate(in + i * elementSize, static_cast<uint32_t>(i)) ? 1 : 0;
+            chunkCount += kept[i];
+        }
+        chunkCounts[chunk] = chunkCount;
+    });
+
+    std::vector<uint32_t> chunkOffsets(chunkCounts.size());
+    uint32_t total = 0;
+    for (size_t chunk = 0; chunk < chunkCounts.size(); ++chunk) {
+        chunkOffsets[chunk] = total;
+        total += chunkCounts[chunk];
+    }
+
+    parallelChunks(count, minChunkSize, [&](size_t chunk, size_t begin, size_t end) {
+        uint8_t* dst = out + size_t(chunkOffsets[chunk]) * elementSize;
+        for (size_t i = begin; i < end; ++i) {
+            if (!kept[i]) continue;
+            std::memcpy(dst, in + i * elementSize, elementSize);
+            dst += elementSize;
+        }
+    });
+    return total;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "ComputeRuntime.h"
+
+#include <webgpu/webgpu.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+/**
+ * CPU version of the predicate, called with a pointer to the element and its
+ * index.
+ */
+using CompactionPredicate = std::function<bool(const void* element, uint32_t index)>;
+
+struct CompactionDesc {
+    std::string label = "Stream compaction";
+    // WGSL type of the elements, and the declarations it needs (structs)
+    std::string elementType = "u32";
+    std::string declarations;
+    uint32_t elementSize = 4;
+    // WGSL boolean expression of `value` (the element) and `index`, e.g.
+    // "value.life > 0.0"
+    std::string predicate;
+    CompactionPredicate cpuPredicate;
+    // Workgroup size of the kernel dispatched with dispatchArgsOffset(),
+    // one invocation per kept element
+    uint32_t consumerWorkgroupSize = 64;
+    // vertexCount of the draw arguments, one instance per kept element
+    uint32_t verticesPerInstance = 3;
+};
+
+/**
+ * Copies the elements of an array that match a predicate to another array,
+ * and writes their count as indirect dispatch and draw arguments, so that
+ * the next kernel or draw call processes exactly the kept elements without
+ * reading the count back on the CPU.
+ *
+ * On the GPU each workgroup counts its kept elements with a workgroup atomic
+ * and reserves room for them with a single atomicAdd on the global counter,
+ * so the kept elements come out in no particular order. In CPU mode they
+ * keep their order.
+ *
+ * Layout of args(), in u32:
+ *   0-2  dispatch workgroup counts (x, y, 1), split over two dimensions
+ *        like Kernel::workgroupCount when needed
+ *   3    count of kept elements
+ *   4-7  draw arguments (verticesPerInstance, count, 0, 0)
+ */
+class StreamCompaction {
+public:
+    static constexpr uint32_t WorkgroupSize = 256;
+    static constexpr uint64_t DispatchArgsOffset = 0;
+    static constexpr uint64_t CountOffset = 3 * sizeof(uint32_t);
+    static constexpr uint64_t DrawArgsOffset = 4 * sizeof(uint32_t);
+
+    StreamCompaction(ComputeContext& context, const CompactionDesc& desc);
+    ~StreamCompaction();
+    StreamCompaction(const StreamCompaction&) = delete;
+    StreamCompaction& operator=(const StreamCompaction&) = delete;
+
+    /**
+     * Record the compaction of the first count elements of input into output
+     * (which must have room for all of them), GPU mode. Returns false if an
+     * array is larger than the storage binding limit.
+     */
+    bool encode(wgpu::ComputePassEncoder pass, GpuArrayBase& input, GpuArrayBase& output, uint32_t count);
+
+    /**
+     * Compact on its own: encode and submit in GPU mode (without waiting),
+     * or compact on the CPU.
+     */
+    bool run(GpuArrayBase& input, GpuArrayBase& output, uint32_t count);
+
+    /**
+     * The indirect arguments (with Indirect usage in GPU mode), see above.
+     */
+    GpuArray<uint32_t>& args() { return *m_args; }
+
+    /**
+     * Blocking read back of the count of kept elements.
+     */
+    uint32_t readCount() const;
+
+    const CompactionDesc& desc() const { return m_desc; }
+
+    /**
+     * The CPU fallback, usable on any memory. Keeps the order of the
+     * elements and returns how many were kept.
+     */
+    static uint32_t compactCpu(const void* input, void* output, uint32_t count, uint32_t elementSize, const CompactionPredicate& predicate);
+
+private:
+    struct Params {
+        uint32_t count;
+        uint32_t consumerWorkgroupSize;
+        uint32_t verticesPerInstance;
+        uint32_t maxWorkgroupsPerDimension;
+    };
+
+    void writeCpuArgs(uint32_t keptCount);
+
+private:
+    ComputeContext& m_context;
+    CompactionDesc m_desc;
+    std::unique_ptr<Kernel> m_resetKernel;
+    std::unique_ptr<Kernel> m_compactKernel;
+    std::unique_ptr<Kernel> m_finalizeKernel;
+    std::unique_ptr<GpuArray<Params>> m_params;
+    std::unique_ptr<GpuArray<uint32_t>> m_args;
+
+    wgpu::BindGroup m_bindGroup = nullptr;
+    // GpuArrayBase::id() of the arrays m_bindGroup binds
+    uint64_t m_boundInput = 0;
+    uint64_t m_boundOutput = 0;
+};
@@ -0,0 +1,142 @@
+#include "TexturePool.h"
+
+#include <algorithm>
+#include <cassert>
+
+bool TexturePool::Key::operator==(const Key& other) const {
+    return format == other.format
+        && width == other.width
+        && height == other.height
+        && sampleCount == other.sampleCount
+        && usage == other.usage;
+}
+
+TexturePool::TexturePool(wgpu::Device device)
+    : m_device(device)
+{}
+
+TexturePool::~TexturePool() {
+    clear();
+}
+
+void TexturePool::beginFrame(uint32_t maxIdleFrames) {
+    ++m_frame;
+
+    auto isIdle = [&](Entry& entry) {
+        if (m_frame - entry.lastUsedFrame <= maxIdleFrames) return false;
+        destroy(entry);
+        return true;
+    };
+    m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(), isIdle), m_entries.end());
+
+    m_stats = {};
+    for (Entry& entry : m_entries) {
+        entry.lifetimes.clear();
+        m_stats.memoryBytes += uint64_t(entry.key.width) * entry.key.height
+            * entry.key.sampleCount * textureFormatTexelSize(entry.key.format);
+    }
+    m_stats.textureCount = m_entries.size();
+}
+
+TexturePool::Texture TexturePool::acquire(const Key& key, uint32_t firstPass, uint32_t lastPass) {
+    assert(firstPass <= lastPass);
+    ++m_stats.acquired;
+
+    for (Entry& entry : m_entries) {
+        if (!(entry.key == key) || overlaps(entry, firstPass, lastPass)) continue;
+        if (!entry.lifetimes.empty()) ++m_stats.aliased;
+        entry.lifetimes.push_back({ firstPass, lastPass });
+        entry.lastUsedFrame = m_frame;
+        return entry.texture;
+    }
+
+    wgpu::TextureDescriptor textureDesc;
+    textureDesc.label = "Pooled texture";
+    textureDesc.usage = key.usage;
+    textureDesc.dimension = wgpu::TextureDimension::_2D;
+    textureDesc.size = { key.width, key.height, 1 };
+    textureDesc.format = key.format;
+    textureDesc.mipLevelCount = 1;
+    textureDesc.sampleCount = key.sampleCount;
+    textureDesc.viewFormatCount = 0;
+    textureDesc.viewFormats = nullptr;
+
+    wgpu::TextureViewDescriptor viewDesc;
+    viewDesc.label = "Pooled texture view";
+    viewDesc.format = key.format;
+    viewDesc.dimension = wgpu::TextureViewDimension::_2D;
+    viewDesc.baseMipLevel = 0;
+    viewDesc.mipLevelCount = 1;
+    viewDesc.baseArrayLayer = 0;
+    viewDesc.arrayLayerCount = 1;
+    viewDesc.aspect = wgpu::TextureAspect::All;
+
+    Entry entry;
+    entry.key = key;
+    entry.texture.texture = m_device.createTexture(textureDesc);
+    entry.texture.view = entry.texture.texture.createView(viewDesc);
+    entry.lastUsedFrame = m_frame;
+    entry.lifetimes.push_back({ firstPass, lastPass });
+    m_entries.push_back(entry);
+
+    ++m_stats.created;
+    ++m_stats.textureCount;
+    m_stats.memoryBytes += uint64_t(key.width) * key.height * key.sampleCount * textureFormatTexelSize(key.format);
+    return entry.texture;
+}
+
+void TexturePool::clear() {
+    for (Entry& entry : m_entries) {
+        destroy(entry);
+    }
+    m_entries.clear();
+    m_stats.textureCount = 0;
+    m_stats.memoryBytes = 0;
+}
+
+bool TexturePool::overlaps(const Entry& entry, uint32_t firstPass, uint32_t lastPass) {
+    for (const Lifetime& lifetime : entry.lifetimes) {
+        if (firstPass <= lifetime.lastPass && lifetime.firstPass <= lastPass) return true;
+    }
+    return false;
+}
+
+void TexturePool::destroy(Entry& entry) {
+    entry.texture.view.release();
+    entry.texture.texture.destroy();
+    entry.texture.texture.release();
+}
+
+uint32_t textureFormatTexelSize(WGPUTextureFormat format) {
+    switch (format) {
+    case WGPUTextureFormat_R8Unorm:
+    case WGPUTextureFormat_R8Snorm:
+    case WGPUTextureFormat_R8Uint:
+    case WGPUTextureFormat_R8Sint:
+    case WGPUTextureFormat_Stencil8:
+        return 1;
+    case WGPUTextureFormat_R16Uint:
+    case WGPUTextureFormat_R16Sint:
+    case WGPUTextureFormat_R16Float:
+    case WGPUTextureFormat_RG8Unorm:
+    case WGPUTextureFormat_RG8Snorm:
+    case WGPUTextureFormat_RG8Uint:
+    case WGPUTextureFormat_RG8Sint:
+    case WGPUTextureFormat_Depth16Unorm:
+        return 2;
+    case WGPUTextureFormat_RG32Float:
+    case WGPUTextureFormat_RG32Uint:
+    case WGPUTextureFormat_RG32Sint:
+    case WGPUTextureFormat_RGBA16Uint:
+    case WGPUTextureFormat_RGBA16Sint:
+    case WGPUTextureFormat_RGBA16Float:
+    case WGPUTextureFormat_Depth32FloatStencil8:
+        return 8;
+    case WGPUTextureFormat_RGBA32Float:
+    case WGPUTextureFormat_RGBA32Uint:
+    case WGPUTextureFormat_RGBA32Sint:
+        return 16;
+    default:
+        return 4;
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <webgpu/webgpu.hpp>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Hands out render attachment textures by (format, size, sample count, usage)
+ * instead of calling device.createTexture every frame.
+ *
+ * Textures are kept alive across frames and reused by later requests with the
+ * same key. Within a frame, a texture is also shared between transient targets
+ * whose pass lifetimes [firstPass, lastPass] do not overlap (aliasing).
+ *
+ * The pool owns the textures and views it returns: do not release them.
+ */
+class TexturePool {
+public:
+    struct Key {
+        WGPUTextureFormat format = WGPUTextureFormat_Undefined;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t sampleCount = 1;
+        WGPUTextureUsageFlags usage = WGPUTextureUsage_RenderAttachment;
+
+        bool operator==(const Key& other) const;
+    };
+
+    struct Texture {
+        wgpu::Texture texture = nullptr;
+        wgpu::TextureView view = nullptr;
+    };
+
+    struct Stats {
+        size_t textureCount = 0;
+        uint64_t memoryBytes = 0;
+        // Since the last beginFrame()
+        uint32_t acquired = 0;
+        uint32_t created = 0;
+        uint32_t aliased = 0;
+    };
+
+    static constexpr uint32_t WholeFrame = UINT32_MAX;
+
+    explicit TexturePool(wgpu::Device device);
+    ~TexturePool();
+    TexturePool(const TexturePool&) = delete;
+    TexturePool& operator=(const TexturePool&) = delete;
+
+    /**
+     * Start a new frame: every texture becomes available again. Textures that
+     * were not used for more than maxIdleFrames frames are destroyed.
+     */
+    void beginFrame(uint32_t maxIdleFrames = 60);
+
+    /**
+     * Get a texture for the passes firstPass..lastPass (inclusive) of the
+     * current frame. Use the default range for targets that live the whole
+     * frame and must not be aliased.
+     */
+    Texture acquire(const Key& key, uint32_t firstPass = 0, uint32_t lastPass = WholeFrame);
+
+    /**
+     * Destroy all pooled textures, e.g. when the window is resized.
+     */
+    void clear();
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+    struct Lifetime {
+        uint32_t firstPass;
+        uint32_t lastPass;
+    };
+
+    struct Entry {
+        Key key;
+        Texture texture;
+        uint64_t lastUsedFrame = 0;
+        // Pass ranges this texture is already handed out for in the current frame
+        std::vector<Lifetime> lifetimes;
+    };
+
+    static bool overlaps(const Entry& entry, uint32_t firstPass, uint32_t lastPass);
+    static void destroy(Entry& entry);
+
+    wgpu::Device m_device;
+    std::vector<Entry> m_entries;
+    uint64_t m_frame = 0;
+    Stats m_stats;
+};
+
+/**
+ * Size in bytes of one texel, used to estimate pool memory. Block compressed
+ * formats are not expected as attachments and count as 4.
+ */
+uint32_t textureFormatTexelSize(WGPUTextureFormat format);
@@ -0,0 +1,177 @@
+#include "Trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+struct Event {
+    const char* name = nullptr;
+    uint64_t begin = 0;
+    uint64_t end = 0;
+};
+
+// Written by its thread only; events are overwritten oldest first
+struct ThreadBuffer {
+    std::vector<Event> events;
+    std::atomic<uint64_t> written{ 0 };
+    uint32_t id = 0;
+    std::string name;
+};
+
+struct TraceState {
+    std::atomic<bool> enabled{ false };
+    std::atomic<uint32_t> eventsPerThread{ 1 << 16 };
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> threads;
+    // Ring like the thread buffers, sized by start(); guarded by the mutex
+    std::vector<Event> gpuEvents;
+    uint64_t gpuWritten = 0;
+    std::unordered_set<std::string> names;
+};
+
+TraceState& state() {
+    // Never destroyed, so that threads still running at exit can record
+    static TraceState* s = new TraceState();
+    return *s;
+}
+
+ThreadBuffer& threadBuffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+        TraceState& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        auto newBuffer = std::make_unique<ThreadBuffer>();
+        newBuffer->events.resize(s.eventsPerThread.load());
+        newBuffer->id = static_cast<uint32_t>(s.threads.size()) + 1;
+        newBuffer->name = "thread " + std::to_string(newBuffer->id);
+        buffer = newBuffer.get();
+        s.threads.push_back(std::move(newBuffer));
+    }
+    return *buffer;
+}
+
+void writeEscaped(std::ostream& out, const char* text) {
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') out << '\\';
+        if (static_cast<unsigned char>(*c) >= 0x20) out << *c;
+    }
+}
+
+// Trace Event Format times are in microseconds
+void writeEvent(std::ostream& out, const Event& event, uint32_t tid, uint64_t origin, bool& first) {
+    out << (first ? "\n" : ",\n") << "{\"name\":\"";
+    writeEscaped(out, event.name);
+    out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+        << ",\"ts\":" << (event.begin - std::min(origin, event.begin)) / 1000.0
+        << ",\"dur\":" << (event.end - std::min(event.end, event.begin)) / 1000.0 << "}";
+    first = false;
+}
+
+void writeThreadName(std::ostream& out, uint32_t tid, const std::string& name, bool& first) {
+    out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid << ",\"args\":{\"name\":\"";
+    writeEscaped(out, name.c_str());
+    out << "\"}}";
+    first = false;
+}
+
+} // namespace
+
+void Trace::start(uint32_t eventsPerThread) {
+    TraceState& s = state();
+    s.eventsPerThread = std::max(eventsPerThread, 1u);
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.gpuEvents.empty()) s.gpuEvents.resize(s.eventsPerThread.load());
+    }
+    s.enabled.store(true, std::memory_order_relaxed);
+}
+
+void Trace::stop() {
+    state().enabled.store(false, std::memory_order_relaxed);
+}
+
+bool Trace::enabled() {
+    return state().enabled.load(std::memory_order_relaxed);
+}
+
+uint64_t Trace::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::addCpuZone(const char* name, uint64_t beginNs, uint64_t endNs) {
+    ThreadBuffer& buffer = threadBuffer();
+    uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    buffer.events[index % buffer.events.size()] = { name, beginNs, endNs };
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void Trace::addGpuZone(const char* name, uint64_t beginNs, uint64_t endNs) {
+    TraceState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.gpuEvents.empty()) return;
+    s.gpuEvents[s.gpuWritten % s.gpuEvents.size()] = { name, beginNs, endNs };
+    ++s.gpuWritten;
+}
+
+void Trace::setThreadName(const std::string& name) {
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(state().mutex);
+    buffer.name = name;
+}
+
+const char* Trace::intern(const std::string& name) {
+    TraceState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.names.insert(name).first->c_str();
+}
+
+bool Trace::write(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Trace: cannot write " << path << std::endl;
+        return false;
+    }
+
+    TraceState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    // Times relative to the first event, which keeps them short
+    uint64_t origin = UINT64_MAX;
+    const uint64_t gpuCount = std::min<uint64_t>(s.gpuWritten, s.gpuEvents.size());
+    for (uint64_t i = s.gpuWritten - gpuCount; i < s.gpuWritten; ++i) {
+        origin = std::min(origin, s.gpuEvents[i % s.gpuEvents.size()].begin);
+    }
+    for (const auto& thread : s.threads) {
+        uint64_t written = thread->written.load(std::memory_order_acquire);
+        uint64_t count = std::min<uint64_t>(written, thread->events.size());
+        for (uint64_t i = written - count; i < written; ++i) {
+            origin = std::min(origin, thread->events[i % thread->events.size()].begin);
+        }
+    }
+
+    bool first = true;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (const auto& thread : s.threads) {
+        writeThreadName(out, thread->id, thread->name, first);
+        uint64_t written = thread->written.load(std::memory_order_acquire);
+        uint64_t count = std::min<uint64_t>(written, thread->events.size());
+        for (uint64_t i = written - count; i < written; ++i) {
+            writeEvent(out, thread->events[i % thread->events.size()], thread->id, origin, first);
+        }
+    }
+    // tid 0 is the GPU
+    writeThreadName(out, 0, "GPU", first);
+    for (uint64_t i = s.gpuWritten - gpuCount; i < s.gpuWritten; ++i) {
+        writeEvent(out, s.gpuEvents[i % s.gpuEvents.size()], 0, origin, first);
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
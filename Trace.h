@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Timeline of named zones for chrome://tracing (or https://ui.perfetto.dev).
+ *
+ * CPU zones are scoped with TRACE_ZONE("name"). Each thread records into
+ * its own ring buffer, so recording takes no lock: two clock reads and a
+ * store, and a single relaxed load when tracing was not started. Building
+ * without TRACING_ENABLED removes the zones altogether. GPU zones (see
+ * GpuTimeline) are added on a separate "GPU" track.
+ *
+ * Zone names must outlive the trace: string literals, or intern().
+ */
+class Trace {
+public:
+    /**
+     * Start recording, keeping the last eventsPerThread zones of each
+     * thread, and as many GPU zones.
+     */
+    static void start(uint32_t eventsPerThread = 1 << 16);
+    static void stop();
+    static bool enabled();
+
+    /**
+     * Nanoseconds on the clock of the trace (steady_clock).
+     */
+    static uint64_t now();
+
+    static void addCpuZone(const char* name, uint64_t beginNs, uint64_t endNs);
+    static void addGpuZone(const char* name, uint64_t beginNs, uint64_t endNs);
+
+    /**
+     * Name of the current thread in the trace.
+     */
+    static void setThreadName(const std::string& name);
+
+    /**
+     * Stable copy of a name built at run time.
+     */
+    static const char* intern(const std::string& name);
+
+    /**
+     * Write everything recorded so far as Trace Event Format JSON. Call it
+     * when other threads are not recording, e.g. at exit.
+     */
+    static bool write(const std::string& path);
+};
+
+class TraceZone {
+public:
+    explicit TraceZone(const char* name)
+        : m_name(Trace::enabled() ? name : nullptr)
+        , m_begin(m_name ? Trace::now() : 0)
+    {}
+    ~TraceZone() {
+        if (m_name) Trace::addCpuZone(m_name, m_begin, Trace::now());
+    }
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+private:
+    const char* m_name;
+    uint64_t m_begin;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#ifdef TRACING_ENABLED
+#define TRACE_ZONE(name) TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
+#else
+#define TRACE_ZONE(name) do {} while (false)
+#endif
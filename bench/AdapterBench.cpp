@@ -0,0 +1,127 @@
+#include "Benchmark.h"
+
+#include "AdapterSelection.h"
+#include "DeviceGroup.h"
+#include "Reduction.h"
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t count = 1 << 25;
+constexpr double bytes = double(count) * sizeof(float);
+
+// Per device state of the workload, created before anything is timed
+struct Slot {
+    std::unique_ptr<GpuArray<float>> input;
+    std::unique_ptr<Reduction> reduction;
+    double sum = 0.0;
+};
+
+// Sum of host data: each slice is uploaded, then reduced on its device
+double runSum(DeviceGroup& group, std::vector<Slot>& slots, const std::vector<float>& input) {
+    group.split(count, Reduction::TileSize, [&](size_t device, ComputeContext&, size_t begin, size_t end) {
+        Slot& slot = slots[device];
+        slot.input->upload(input.data() + begin, end - begin);
+        slot.sum = slot.reduction->reduce(*slot.input, static_cast<uint32_t>(end - begin)).value;
+    });
+    double sum = 0.0;
+    for (Slot& slot : slots) {
+        sum += slot.sum;
+        slot.sum = 0.0;
+    }
+    return sum;
+}
+
+std::vector<Slot> createSlots(DeviceGroup& group) {
+    std::vector<Slot> slots(group.size());
+    for (size_t i = 0; i < group.size(); ++i) {
+        slots[i].input = std::make_unique<GpuArray<float>>(group.context(i), count);
+        slots[i].reduction = std::make_unique<Reduction>(group.context(i), ReduceElement::F32, ReduceOp::Sum);
+    }
+    return slots;
+}
+
+void checkSum(double sum, double reference) {
+    if (std::abs(sum - reference) > 1e-4 * std::abs(reference)) {
+        std::cout << "  MISMATCH with the CPU sum (" << sum << " instead of " << reference << ")" << std::endl;
+    }
+}
+
+} // namespace
+
+void benchAdapters() {
+    wgpu::InstanceDescriptor instanceDesc = {};
+    wgpu::Instance instance = wgpu::createInstance(instanceDesc);
+    if (!instance) return;
+    std::vector<AdapterInfo> adapters = AdapterSelection::enumerate(instance);
+    if (adapters.empty()) {
+        std::cout << "No WebGPU adapter, skipping the adapter benchmarks" << std::endl;
+        instance.release();
+        return;
+    }
+
+    std::cout << "Adapters:" << std::endl;
+    for (size_t i = 0; i < adapters.size(); ++i) {
+        AdapterInfo& info = adapters[i];
+        info.latencyMs = AdapterSelection::measureLatency(info.adapter);
+        std::cout << " " << i << ": " << info.name << " (" << AdapterSelection::typeName(info.type)
+            << ", " << AdapterSelection::backendName(info.backend) << ", " << info.driver
+            << "), submit round trip " << info.latencyMs << " ms" << std::endl;
+    }
+
+    std::vector<float> input(count);
+    uint32_t state = 1;
+    for (float& value : input) {
+        state = state * 1664525u + 1013904223u;
+        value = (state >> 8) / 16777216.0f;
+    }
+    const double reference = Reduction::reduceCpu(input.data(), count, ReduceOp::Sum).value;
+
+    // The same workload on each adapter alone
+    for (size_t i = 0; i < adapters.size(); ++i) {
+        DeviceGroup group;
+        if (group.open({ adapters[i] }) == 0) continue;
+        std::vector<Slot> slots = createSlots(group);
+        double sum = 0.0;
+        BenchmarkResult result = measure("Upload and sum, 32M f32, adapter " + std::to_string(i) + " (" + adapters[i].name + ")", 10, [&]() {
+            sum = runSum(group, slots, input);
+        });
+        reportBandwidth(result, bytes);
+        checkSum(sum, reference);
+    }
+
+    // Then split across the hardware adapters, once per physical device:
+    // the same GPU shows up once per backend
+    std::vector<AdapterInfo> distinct;
+    for (const AdapterInfo& info : adapters) {
+        if (info.type == WGPUAdapterType_CPU) continue;
+        bool seen = false;
+        for (const AdapterInfo& other : distinct) {
+            seen = seen || (other.vendorID == info.vendorID && other.deviceID == info.deviceID);
+        }
+        if (!seen) distinct.push_back(info);
+    }
+    if (distinct.size() > 1) {
+        DeviceGroup group;
+        if (group.open(distinct) > 1) {
+            std::vector<Slot> slots = createSlots(group);
+            double sum = 0.0;
+            BenchmarkResult result = measure("Upload and sum, 32M f32, split across " + std::to_string(group.size()) + " adapters", 10, [&]() {
+                sum = runSum(group, slots, input);
+            });
+            reportBandwidth(result, bytes);
+            checkSum(sum, reference);
+            for (size_t i = 0; i < group.size(); ++i) {
+                std::cout << "  " << group.info(i).name << ": " << 100.0 * group.share(i) << "% of the items, "
+                    << group.throughput(i) * 1e-6 << " G items/s" << std::endl;
+            }
+        }
+    }
+
+    AdapterSelection::release(adapters);
+    instance.release();
+}
@@ -0,0 +1,357 @@
+#include "Benchmark.h"
+
+#include "ComputeKernels.h"
+#include "ComputeRuntime.h"
+
+#include <webgpu/webgpu.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* triangleShaderSource = R"(
+@vertex
+fn vs_main(@builtin(vertex_index) index: u32) -> @builtin(position) vec4f {
+	let x = f32(i32(index) - 1);
+	let y = f32(i32(index & 1u) * 2 - 1);
+	return vec4f(x, y, 0.0, 1.0);
+}
+
+@fragment
+fn fs_main() -> @location(0) vec4f {
+	return vec4f(1.0, 0.5, 0.0, 1.0);
+}
+)";
+
+const wgpu::TextureFormat targetFormat = wgpu::TextureFormat::RGBA8Unorm;
+
+// Keeps the loops below from being optimized away
+volatile uint64_t sink = 0;
+// Called through a volatile pointer, so descriptors must really be filled in
+using Consume = uint64_t (*)(const WGPURenderPipelineDescriptor* descriptor);
+volatile Consume consume = [](const WGPURenderPipelineDescriptor* descriptor) {
+    return uint64_t(descriptor->multisample.count) + descriptor->depthStencil->depthCompare + descriptor->fragment->targets->blend->color.operation;
+};
+
+wgpu::ShaderModule createShaderModule(wgpu::Device device, const std::string& source) {
+    wgpu::ShaderModuleWGSLDescriptor shaderCodeDesc;
+    shaderCodeDesc.chain.next = nullptr;
+    shaderCodeDesc.chain.sType = wgpu::SType::ShaderModuleWGSLDescriptor;
+    shaderCodeDesc.code = source.c_str();
+    wgpu::ShaderModuleDescriptor shaderDesc;
+    shaderDesc.nextInChain = &shaderCodeDesc.chain;
+    shaderDesc.label = "Benchmark shader";
+    shaderDesc.hintCount = 0;
+    shaderDesc.hints = nullptr;
+    return device.createShaderModule(shaderDesc);
+}
+
+wgpu::RenderPipeline createTrianglePipeline(wgpu::Device device, wgpu::ShaderModule shaderModule) {
+    wgpu::RenderPipelineDescriptor pipelineDesc;
+    pipelineDesc.label = "Benchmark pipeline";
+    pipelineDesc.layout = nullptr;
+    pipelineDesc.vertex.bufferCount = 0;
+    pipelineDesc.vertex.buffers = nullptr;
+    pipelineDesc.vertex.module = shaderModule;
+    pipelineDesc.vertex.entryPoint = "vs_main";
+    pipelineDesc.vertex.constantCount = 0;
+    pipelineDesc.vertex.constants = nullptr;
+    pipelineDesc.primitive.topology = wgpu::PrimitiveTopology::TriangleList;
+    pipelineDesc.primitive.stripIndexFormat = wgpu::IndexFormat::Undefined;
+    pipelineDesc.primitive.frontFace = wgpu::FrontFace::CCW;
+    pipelineDesc.primitive.cullMode = wgpu::CullMode::None;
+
+    wgpu::ColorTargetState colorTarget;
+    colorTarget.format = targetFormat;
+    colorTarget.blend = nullptr;
+    colorTarget.writeMask = wgpu::ColorWriteMask::All;
+
+    wgpu::FragmentState fragmentState;
+    fragmentState.module = shaderModule;
+    fragmentState.entryPoint = "fs_main";
+    fragmentState.constantCount = 0;
+    fragmentState.constants = nullptr;
+    fragmentState.targetCount = 1;
+    fragmentState.targets = &colorTarget;
+    pipelineDesc.fragment = &fragmentState;
+    pipelineDesc.depthStencil = nullptr;
+
+    pipelineDesc.multisample.count = 1;
+    pipelineDesc.multisample.mask = ~0u;
+    pipelineDesc.multisample.alphaToCoverageEnabled = false;
+    return device.createRenderPipeline(pipelineDesc);
+}
+
+void benchHandles(ComputeContext& gpu) {
+    constexpr uint32_t callCount = 1000000;
+    wgpu::BufferDescriptor bufferDesc;
+    bufferDesc.label = "Benchmark buffer";
+    bufferDesc.usage = wgpu::BufferUsage::CopyDst;
+    bufferDesc.size = 256;
+    bufferDesc.mappedAtCreation = false;
+    wgpu::Buffer buffer = gpu.device().createBuffer(bufferDesc);
+    WGPUBuffer rawBuffer = buffer;
+
+    report(measure("C API wgpuBufferGetSize, 1M calls", 5, [&]() {
+        uint64_t total = 0;
+        for (uint32_t i = 0; i < callCount; ++i) total += wgpuBufferGetSize(rawBuffer);
+        sink = total;
+    }), callCount, "calls");
+    report(measure("webgpu.hpp Buffer::getSize, 1M calls", 5, [&]() {
+        uint64_t total = 0;
+        for (uint32_t i = 0; i < callCount; ++i) total += buffer.getSize();
+        sink = total;
+    }), callCount, "calls");
+    report(measure("C API reference + release, 1M pairs", 5, [&]() {
+        for (uint32_t i = 0; i < callCount; ++i) {
+            wgpuBufferReference(rawBuffer);
+            wgpuBufferRelease(rawBuffer);
+        }
+    }), callCount, "pairs");
+    report(measure("webgpu.hpp handle copy + reference + release, 1M pairs", 5, [&]() {
+        for (uint32_t i = 0; i < callCount; ++i) {
+            wgpu::Buffer copy = rawBuffer;
+            copy.reference();
+            copy.release();
+        }
+    }), callCount, "pairs");
+
+    buffer.destroy();
+    buffer.release();
+}
+
+void benchDescriptors() {
+    constexpr uint32_t descriptorCount = 1000000;
+    // What a render pipeline needs, filled in with setDefault()...
+    report(measure("webgpu.hpp render pipeline descriptors (wgpu::Default), 1M", 5, [&]() {
+        uint64_t total = 0;
+        for (uint32_t i = 0; i < descriptorCount; ++i) {
+            wgpu::RenderPipelineDescriptor pipelineDesc = wgpu::Default;
+            wgpu::FragmentState fragmentState = wgpu::Default;
+            wgpu::ColorTargetState colorTarget = wgpu::Default;
+            wgpu::BlendState blendState = wgpu::Default;
+            wgpu::DepthStencilState depthStencilState = wgpu::Default;
+            colorTarget.blend = &blendState;
+            fragmentState.targets = &colorTarget;
+            pipelineDesc.fragment = &fragmentState;
+            pipelineDesc.depthStencil = &depthStencilState;
+            total += consume(&pipelineDesc);
+        }
+        sink = total;
+    }), descriptorCount, "descriptors");
+    // ... and zero initialized, as the C API callers do
+    report(measure("C render pipeline descriptors (zero initialized), 1M", 5, [&]() {
+        uint64_t total = 0;
+        for (uint32_t i = 0; i < descriptorCount; ++i) {
+            WGPURenderPipelineDescriptor pipelineDesc = {};
+            WGPUFragmentState fragmentState = {};
+            WGPUColorTargetState colorTarget = {};
+            WGPUBlendState blendState = {};
+            WGPUDepthStencilState depthStencilState = {};
+            colorTarget.blend = &blendState;
+            fragmentState.targets = &colorTarget;
+            pipelineDesc.fragment = &fragmentState;
+            pipelineDesc.depthStencil = &depthStencilState;
+            total += consume(&pipelineDesc);
+        }
+        sink = total;
+    }), descriptorCount, "descriptors");
+}
+
+void benchUploads(ComputeContext& gpu) {
+    constexpr uint64_t totalSize = 64 << 20;
+    std::vector<uint8_t> data(totalSize);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<uint8_t>(i * 7);
+
+    wgpu::BufferDescriptor bufferDesc;
+    bufferDesc.label = "Upload destination";
+    bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Storage;
+    bufferDesc.size = totalSize;
+    bufferDesc.mappedAtCreation = false;
+    wgpu::Buffer destination = gpu.device().createBuffer(bufferDesc);
+
+    for (uint64_t chunkSize : { uint64_t(4) << 10, uint64_t(1) << 20, uint64_t(16) << 20 }) {
+        const std::string chunk = chunkSize >= (1 << 20) ? std::to_string(chunkSize >> 20) + " MB" : std::to_string(chunkSize >> 10) + " KB";
+
+        reportBandwidth(measure("Upload 64 MB, queue.writeBuffer in " + chunk + " chunks", 5, [&]() {
+            for (uint64_t offset = 0; offset < totalSize; offset += chunkSize) {
+                gpu.queue().writeBuffer(destination, offset, data.data() + offset, chunkSize);
+            }
+            // Writes are flushed with the next submit
+            gpu.submit(gpu.createEncoder("Upload"));
+            gpu.wait();
+        }), double(totalSize));
+
+        reportBandwidth(measure("Upload 64 MB, staging buffers mapped at creation, " + chunk + " chunks", 5, [&]() {
+            std::vector<wgpu::Buffer> stagingBuffers;
+            wgpu::CommandEncoder encoder = gpu.createEncoder("Staging upload");
+            for (uint64_t offset = 0; offset < totalSize; offset += chunkSize) {
+                wgpu::BufferDescriptor stagingDesc;
+                stagingDesc.label = "Staging buffer";
+                stagingDesc.usage = wgpu::BufferUsage::MapWrite | wgpu::BufferUsage::CopySrc;
+                stagingDesc.size = chunkSize;
+                stagingDesc.mappedAtCreation = true;
+                wgpu::Buffer staging = gpu.device().createBuffer(stagingDesc);
+                std::memcpy(staging.getMappedRange(0, chunkSize), data.data() + offset, chunkSize);
+                staging.unmap();
+                encoder.copyBufferToBuffer(staging, 0, destination, offset, chunkSize);
+                stagingBuffers.push_back(staging);
+            }
+            gpu.submit(encoder);
+            gpu.wait();
+            for (wgpu::Buffer& staging : stagingBuffers) {
+                staging.destroy();
+                staging.release();
+            }
+        }), double(totalSize));
+    }
+
+    destination.destroy();
+    destination.release();
+}
+
+void benchEncoding(ComputeContext& gpu) {
+    constexpr uint32_t commandCount = 10000;
+    constexpr uint32_t count = 1 << 16;
+
+    GpuArray<SaxpyParams> paramsArray(gpu, 1, WGPUBufferUsage_Uniform);
+    GpuArray<float> xArray(gpu, count);
+    GpuArray<float> yArray(gpu, count);
+    SaxpyParams params = { 2.0f, count, {0, 0} };
+    paramsArray.upload(&params, 1);
+    Kernel kernel(gpu, saxpyKernelDesc());
+    wgpu::BindGroup bindGroup = kernel.createBindGroup({ &paramsArray, &xArray, &yArray });
+
+    // Encoding only: nothing is submitted
+    report(measure("Compute pass encoding, 10000 dispatches", 10, [&]() {
+        wgpu::CommandEncoder encoder = gpu.createEncoder("Encoding benchmark");
+        wgpu::ComputePassDescriptor computePassDesc;
+        computePassDesc.label = "Encoding benchmark";
+        computePassDesc.timestampWriteCount = 0;
+        computePassDesc.timestampWrites = nullptr;
+        wgpu::ComputePassEncoder pass = encoder.beginComputePass(computePassDesc);
+        for (uint32_t i = 0; i < commandCount; ++i) kernel.dispatch(pass, bindGroup, count);
+        pass.end();
+        pass.release();
+        wgpu::CommandBufferDescriptor cmdBufferDescriptor = {};
+        cmdBufferDescriptor.label = "Encoding benchmark";
+        wgpu::CommandBuffer command = encoder.finish(cmdBufferDescriptor);
+        encoder.release();
+        command.release();
+    }), commandCount, "dispatches");
+    bindGroup.release();
+
+    wgpu::TextureDescriptor textureDesc;
+    textureDesc.label = "Encoding benchmark target";
+    textureDesc.dimension = wgpu::TextureDimension::_2D;
+    textureDesc.size = { 64, 64, 1 };
+    textureDesc.format = targetFormat;
+    textureDesc.mipLevelCount = 1;
+    textureDesc.sampleCount = 1;
+    textureDesc.usage = wgpu::TextureUsage::RenderAttachment;
+    textureDesc.viewFormatCount = 0;
+    textureDesc.viewFormats = nullptr;
+    wgpu::Texture target = gpu.device().createTexture(textureDesc);
+    wgpu::TextureViewDescriptor viewDesc;
+    viewDesc.label = "Encoding benchmark target view";
+    viewDesc.format = targetFormat;
+    viewDesc.dimension = wgpu::TextureViewDimension::_2D;
+    viewDesc.baseMipLevel = 0;
+    viewDesc.mipLevelCount = 1;
+    viewDesc.baseArrayLayer = 0;
+    viewDesc.arrayLayerCount = 1;
+    viewDesc.aspect = wgpu::TextureAspect::All;
+    wgpu::TextureView targetView = target.createView(viewDesc);
+    wgpu::ShaderModule shaderModule = createShaderModule(gpu.device(), triangleShaderSource);
+    wgpu::RenderPipeline pipeline = createTrianglePipeline(gpu.device(), shaderModule);
+
+    report(measure("Render pass encoding, 10000 draws", 10, [&]() {
+        wgpu::CommandEncoder encoder = gpu.createEncoder("Encoding benchmark");
+        wgpu::RenderPassColorAttachment colorAttachment = {};
+        colorAttachment.view = targetView;
+        colorAttachment.resolveTarget = nullptr;
+        colorAttachment.loadOp = WGPULoadOp_Clear;
+        colorAttachment.storeOp = WGPUStoreOp_Store;
+        colorAttachment.clearValue = wgpu::Color{ 0.0, 0.0, 0.0, 1.0 };
+        wgpu::RenderPassDescriptor renderPassDesc = {};
+        renderPassDesc.colorAttachmentCount = 1;
+        renderPassDesc.colorAttachments = &colorAttachment;
+        renderPassDesc.depthStencilAttachment = nullptr;
+        renderPassDesc.timestampWriteCount = 0;
+        renderPassDesc.timestampWrites = nullptr;
+        wgpu::RenderPassEncoder renderPass = encoder.beginRenderPass(renderPassDesc);
+        for (uint32_t i = 0; i < commandCount; ++i) {
+            renderPass.setPipeline(pipeline);
+            renderPass.draw(3, 1, 0, 0);
+        }
+        renderPass.end();
+        renderPass.release();
+        wgpu::CommandBufferDescriptor cmdBufferDescriptor = {};
+        cmdBufferDescriptor.label = "Encoding benchmark";
+        wgpu::CommandBuffer command = encoder.finish(cmdBufferDescriptor);
+        encoder.release();
+        command.release();
+    }), commandCount, "draws");
+
+    pipeline.release();
+    shaderModule.release();
+    targetView.release();
+    target.destroy();
+    target.release();
+}
+
+void benchPipelineCreation(ComputeContext& gpu) {
+    // A different source each time, so that nothing can be reused
+    uint32_t variant = 0;
+    report(measure("Compute pipeline creation (saxpy Kernel)", 20, [&]() {
+        KernelDesc desc = saxpyKernelDesc();
+        desc.source += "// variant " + std::to_string(variant++) + "\n";
+        Kernel kernel(gpu, desc);
+    }), 1, "pipelines");
+    report(measure("Render pipeline creation (shader module + pipeline)", 20, [&]() {
+        std::string source = std::string(triangleShaderSource) + "// variant " + std::to_string(variant++) + "\n";
+        wgpu::ShaderModule shaderModule = createShaderModule(gpu.device(), source);
+        wgpu::RenderPipeline pipeline = createTrianglePipeline(gpu.device(), shaderModule);
+        pipeline.release();
+        shaderModule.release();
+    }), 1, "pipelines");
+}
+
+#ifndef WEBGPU_MOCK
+void benchSaxpy(ComputeContext& gpu) {
+    // The one kernel without a benchmark of its own
+    constexpr uint32_t count = 1 << 24;
+    GpuArray<SaxpyParams> paramsArray(gpu, 1, WGPUBufferUsage_Uniform);
+    GpuArray<float> xArray(gpu, count);
+    GpuArray<float> yArray(gpu, count);
+    SaxpyParams params = { 2.0f, count, {0, 0} };
+    paramsArray.upload(&params, 1);
+    std::vector<float> x(count, 1.0f);
+    xArray.upload(x);
+    yArray.upload(x);
+    Kernel kernel(gpu, saxpyKernelDesc());
+    // Reads x and y, writes y
+    reportBandwidth(measure("Saxpy, 16M elements", 10, [&]() {
+        kernel.run({ &paramsArray, &xArray, &yArray }, count);
+        gpu.wait();
+    }), 3.0 * count * sizeof(float));
+}
+#endif
+
+} // namespace
+
+void benchWebGpuApi(ComputeContext& gpu) {
+    benchDescriptors();
+    if (!gpu.hasGpu()) return;
+    benchHandles(gpu);
+    benchUploads(gpu);
+    benchEncoding(gpu);
+    benchPipelineCreation(gpu);
+#ifndef WEBGPU_MOCK
+    // Dispatches do nothing on the mock: there is no bandwidth to measure
+    benchSaxpy(gpu);
+#endif
+}
@@ -0,0 +1,74 @@
+#include "Benchmark.h"
+
+#include "ComputeBatcher.h"
+#include "ComputeRuntime.h"
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace {
+
+const char* scaleSource = R"(
+override workgroupSize: u32 = 64u;
+
+@group(0) @binding(0) var<storage, read_write> data: array<f32>;
+
+@compute @workgroup_size(workgroupSize)
+fn main(@builtin(global_invocation_id) id: vec3<u32>, @builtin(num_workgroups) groups: vec3<u32>) {
+	let i = id.x + id.y * groups.x * workgroupSize;
+	if (i >= arrayLength(&data)) {
+		return;
+	}
+	data[i] = 0.5 * data[i];
+}
+)";
+
+void scaleReference(const KernelArgs& args, uint32_t invocationCount) {
+    GpuArray<float>& data = *static_cast<GpuArray<float>*>(args[0]);
+    for (uint32_t i = 0; i < invocationCount && i < data.size(); ++i) {
+        data.host()[i] *= 0.5f;
+    }
+}
+
+} // namespace
+
+void benchComputeBatcher(ComputeContext& gpu) {
+    // Small enough that the cost of each submit dominates
+    constexpr uint32_t jobCount = 4096;
+    constexpr uint32_t count = 256;
+
+    KernelDesc desc;
+    desc.label = "Scale";
+    desc.source = scaleSource;
+    desc.bindings = { KernelBinding::Storage };
+    desc.cpuReference = scaleReference;
+    Kernel kernel(gpu, desc);
+    std::vector<std::unique_ptr<GpuArray<float>>> arrays;
+    std::vector<float> ones(count, 1.0f);
+    for (uint32_t job = 0; job < jobCount; ++job) {
+        arrays.push_back(std::make_unique<GpuArray<float>>(gpu, count));
+        arrays.back()->upload(ones);
+    }
+
+    if (gpu.hasGpu()) {
+        auto oneSubmitPerJob = [&]() {
+            for (auto& array : arrays) kernel.run({ array.get() }, count);
+            gpu.wait();
+        };
+        report(measure("Kernel::run, 4096 jobs of 256 elements", 5, oneSubmitPerJob), jobCount, "jobs");
+    }
+
+    ComputeBatcher batcher(gpu);
+    bool ok = true;
+    auto batched = [&]() {
+        std::vector<std::future<bool>> futures;
+        futures.reserve(jobCount);
+        for (auto& array : arrays) futures.push_back(batcher.enqueue(kernel, { array.get() }, count));
+        batcher.wait();
+        for (std::future<bool>& future : futures) ok = future.get() && ok;
+    };
+    BenchmarkResult result = measure(std::string("ComputeBatcher ") + (gpu.hasGpu() ? "GPU" : "CPU") + ", 4096 jobs of 256 elements", 5, batched);
+    if (ok) report(result, jobCount, "jobs");
+}
@@ -0,0 +1,61 @@
+#include "BenchDevice.h"
+
+#include <iostream>
+
+bool BenchDevice::create() {
+    wgpu::InstanceDescriptor instanceDesc = {};
+    instance = wgpu::createInstance(instanceDesc);
+    if (!instance) {
+        std::cerr << "Could not initialize WebGPU, skipping GPU benchmarks" << std::endl;
+        return false;
+    }
+
+    wgpu::RequestAdapterOptions adapterOptions = {};
+    adapterOptions.compatibleSurface = nullptr;
+    adapterOptions.powerPreference = wgpu::PowerPreference::HighPerformance;
+    adapter = instance.requestAdapter(adapterOptions);
+    if (!adapter) {
+        std::cerr << "No WebGPU adapter, skipping GPU benchmarks" << std::endl;
+        release();
+        return false;
+    }
+
+    wgpu::SupportedLimits supportedLimits;
+    adapter.getLimits(&supportedLimits);
+    wgpu::RequiredLimits requiredLimits = wgpu::Default;
+    requiredLimits.limits = supportedLimits.limits;
+
+    wgpu::DeviceDescriptor deviceDesc = {};
+    deviceDesc.label = "Benchmark device";
+    deviceDesc.requiredFeaturesCount = 0;
+    deviceDesc.requiredLimits = &requiredLimits;
+    deviceDesc.defaultQueue.nextInChain = nullptr;
+    deviceDesc.defaultQueue.label = "Benchmark queue";
+    device = adapter.requestDevice(deviceDesc);
+    if (!device) {
+        std::cerr << "Could not get a WebGPU device, skipping GPU benchmarks" << std::endl;
+        release();
+        return false;
+    }
+
+    auto onDeviceError = [](WGPUErrorType type, char const* message, void*) {
+        std::cerr << "Uncaptured device error: type " << type;
+        if (message) std::cerr << " (" << message << ")";
+        std::cerr << std::endl;
+    };
+    wgpuDeviceSetUncapturedErrorCallback(device, onDeviceError, nullptr);
+
+    queue = device.getQueue();
+    return true;
+}
+
+void BenchDevice::release() {
+    if (queue) queue.release();
+    if (device) device.release();
+    if (adapter) adapter.release();
+    if (instance) instance.release();
+    queue = nullptr;
+    device = nullptr;
+    adapter = nullptr;
+    instance = nullptr;
+}
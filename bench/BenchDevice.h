@@ -0,0 +1,21 @@
+#pragma once
+
+#include <webgpu/webgpu.hpp>
+
+/**
+ * A device without any window, for the GPU side of the benchmarks. It gets
+ * all the limits the adapter supports, so benchmarks can use large buffers.
+ */
+struct BenchDevice {
+    wgpu::Instance instance = nullptr;
+    wgpu::Adapter adapter = nullptr;
+    wgpu::Device device = nullptr;
+    wgpu::Queue queue = nullptr;
+
+    /**
+     * Returns false (and prints why) if there is no usable GPU, in which
+     * case benchmarks only measure their CPU path.
+     */
+    bool create();
+    void release();
+};
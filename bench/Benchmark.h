@@ -0,0 +1,118 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef WEBGPU_MOCK
+#include "MockWebGpu.h"
+#endif
+
+/**
+ * Minimal timing helpers shared by the benchmarks.
+ */
+struct BenchmarkResult {
+    std::string name;
+    uint32_t iterations = 0;
+    double meanMs = 0.0;
+    double minMs = 0.0;
+    // WebGPU calls per iteration, counted by the mock backend only
+    double callsPerIteration = 0.0;
+    // Tail of the iteration times, for the frame jitter benchmarks only
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+};
+
+/**
+ * A reported result, with the rate it was reported with (0 if none), for
+ * the machine readable output of --json.
+ */
+struct BenchmarkRecord {
+    BenchmarkResult result;
+    double rate = 0.0;
+    std::string unit;
+};
+
+inline std::vector<BenchmarkRecord>& benchmarkRecords() {
+    static std::vector<BenchmarkRecord> records;
+    return records;
+}
+
+/**
+ * Run f once to warm up, then `iterations` more times.
+ */
+template <typename F>
+BenchmarkResult measure(const std::string& name, uint32_t iterations, F&& f) {
+    using Clock = std::chrono::steady_clock;
+    f();
+
+    BenchmarkResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.minMs = 1e30;
+    double totalMs = 0.0;
+#ifdef WEBGPU_MOCK
+    uint64_t callsBefore = MockWebGpu::totalCallCount();
+#endif
+    for (uint32_t i = 0; i < iterations; ++i) {
+        auto start = Clock::now();
+        f();
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        totalMs += ms;
+        if (ms < result.minMs) result.minMs = ms;
+    }
+    result.meanMs = totalMs / iterations;
+#ifdef WEBGPU_MOCK
+    result.callsPerIteration = double(MockWebGpu::totalCallCount() - callsBefore) / iterations;
+#endif
+    return result;
+}
+
+/**
+ * Print a result, with a throughput if itemsPerIteration is not 0.
+ */
+inline void report(const BenchmarkResult& result, double itemsPerIteration = 0.0, const char* unit = "items") {
+    std::cout << result.name << ": mean " << result.meanMs << " ms, min " << result.minMs << " ms";
+    double rate = 0.0;
+    if (itemsPerIteration > 0.0 && result.minMs > 0.0) {
+        rate = itemsPerIteration / (result.minMs * 1e-3);
+        std::cout << ", " << rate << " " << unit << "/s";
+    }
+    std::cout << std::endl;
+    benchmarkRecords().push_back({ result, rate, rate > 0.0 ? std::string(unit) + "/s" : std::string() });
+}
+
+/**
+ * Print the bandwidth of a memory bound result, and how it compares to a
+ * reference bandwidth (e.g. a copy of the same size) if not 0.
+ */
+inline void reportBandwidth(const BenchmarkResult& result, double bytesPerIteration, double referenceGBs = 0.0) {
+    double gbs = result.minMs > 0.0 ? bytesPerIteration / (result.minMs * 1e-3) * 1e-9 : 0.0;
+    std::cout << result.name << ": mean " << result.meanMs << " ms, min " << result.minMs << " ms, " << gbs << " GB/s";
+    if (referenceGBs > 0.0) std::cout << " (" << 100.0 * gbs / referenceGBs << "% of reference)";
+    std::cout << std::endl;
+    benchmarkRecords().push_back({ result, gbs, "GB/s" });
+}
+
+class ComputeContext;
+
+// One function per benchmark file, called from main(). GPU benchmarks get a
+// CPU only context when there is no GPU, and then only measure their CPU path.
+void benchDrawList();
+void benchTrace();
+void benchLog();
+// Costs of the WebGPU API itself: handle wrapping, descriptors, uploads,
+// command encoding and pipeline creation
+void benchWebGpuApi(ComputeContext& gpu);
+// Opens its own devices, one per adapter
+void benchAdapters();
+void benchPrefixScan(ComputeContext& gpu);
+void benchRadixSort(ComputeContext& gpu);
+void benchReduction(ComputeContext& gpu);
+void benchStreamCompaction(ComputeContext& gpu);
+void benchImageProcessing(ComputeContext& gpu);
+void benchComputeBatcher(ComputeContext& gpu);
+// adapterKey is empty without a GPU
+void benchMatrixMultiply(ComputeContext& gpu, const std::string& adapterKey);
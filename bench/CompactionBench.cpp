@@ -0,0 +1,60 @@
+#include "Benchmark.h"
+
+#include "ComputeRuntime.h"
+#include "StreamCompaction.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+void benchStreamCompaction(ComputeContext& gpu) {
+    constexpr uint32_t count = 1 << 25;
+
+    // Keeps about half of the elements, in no pattern a branch predictor
+    // could learn
+    std::vector<uint32_t> input(count);
+    uint32_t state = 1;
+    for (uint32_t& value : input) {
+        state = state * 1664525u + 1013904223u;
+        value = state >> 8;
+    }
+    std::vector<uint32_t> output(count);
+    std::vector<uint32_t> expected;
+    expected.reserve(count);
+
+    auto serial = [&]() {
+        expected.clear();
+        std::copy_if(input.begin(), input.end(), std::back_inserter(expected), [](uint32_t value) { return value & 1; });
+    };
+    report(measure("std::copy_if u32, 32M elements", 10, serial), count, "elements");
+
+    CompactionDesc desc;
+    desc.predicate = "(value & 1u) != 0u";
+    desc.cpuPredicate = [](const void* element, uint32_t) { return (*static_cast<const uint32_t*>(element) & 1) != 0; };
+
+    uint32_t kept = 0;
+    auto cpu = [&]() {
+        kept = StreamCompaction::compactCpu(input.data(), output.data(), count, sizeof(uint32_t), desc.cpuPredicate);
+    };
+    report(measure("StreamCompaction CPU u32, 32M elements", 10, cpu), count, "elements");
+    if (kept != expected.size() || !std::equal(expected.begin(), expected.end(), output.begin())) {
+        std::cout << "  MISMATCH with std::copy_if" << std::endl;
+    }
+
+    if (!gpu.hasGpu()) return;
+
+    GpuArray<uint32_t> inputArray(gpu, count);
+    GpuArray<uint32_t> outputArray(gpu, count);
+    inputArray.upload(input);
+    StreamCompaction compaction(gpu, desc);
+    bool ok = true;
+    auto gpuCompact = [&]() {
+        ok = compaction.run(inputArray, outputArray, count) && ok;
+        gpu.wait();
+    };
+    BenchmarkResult result = measure("StreamCompaction GPU u32, 32M elements", 10, gpuCompact);
+    if (!ok) return;
+    report(result, count, "elements");
+    if (compaction.readCount() != expected.size()) std::cout << "  MISMATCH with std::copy_if" << std::endl;
+}
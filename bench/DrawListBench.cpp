@@ -0,0 +1,93 @@
+#include "Benchmark.h"
+
+#include "DrawList.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+// Stands for a wgpu::RenderPassEncoder, only counts calls
+struct CountingEncoder {
+    uint64_t stateCalls = 0;
+    uint64_t drawCalls = 0;
+
+    void setPipeline(wgpu::RenderPipeline) { ++stateCalls; }
+    void setBindGroup(uint32_t, wgpu::BindGroup, uint32_t, uint32_t const*) { ++stateCalls; }
+    void setVertexBuffer(uint32_t, wgpu::Buffer, uint64_t, uint64_t) { ++stateCalls; }
+    void draw(uint32_t, uint32_t, uint32_t, uint32_t) { ++drawCalls; }
+};
+
+template <typename Handle, typename Raw>
+Handle fakeHandle(uintptr_t i) {
+    return Handle(reinterpret_cast<Raw>(i + 1));
+}
+
+} // namespace
+
+void benchDrawList() {
+    constexpr uint32_t drawCount = 100000;
+    constexpr uint32_t pipelineCount = 16;
+    constexpr uint32_t bindGroupCount = 256;
+    constexpr uint32_t vertexBufferCount = 64;
+
+    DrawList drawList;
+    std::vector<uint32_t> pipelines, bindGroups, vertexBuffers;
+    for (uint32_t i = 0; i < pipelineCount; ++i) {
+        pipelines.push_back(drawList.addPipeline(fakeHandle<wgpu::RenderPipeline, WGPURenderPipeline>(i)));
+    }
+    for (uint32_t i = 0; i < bindGroupCount; ++i) {
+        bindGroups.push_back(drawList.addBindGroup(fakeHandle<wgpu::BindGroup, WGPUBindGroup>(i)));
+    }
+    for (uint32_t i = 0; i < vertexBufferCount; ++i) {
+        vertexBuffers.push_back(drawList.addVertexBuffer(fakeHandle<wgpu::Buffer, WGPUBuffer>(i), 1024));
+    }
+
+    // Draws arrive in an arbitrary order, as they would from a scene traversal
+    std::vector<DrawList::Draw> draws(drawCount);
+    uint32_t state = 1;
+    auto random = [&state]() {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    };
+    for (DrawList::Draw& draw : draws) {
+        draw.pass = random() % 2;
+        draw.pipeline = pipelines[random() % pipelineCount];
+        draw.bindGroup = bindGroups[random() % bindGroupCount];
+        draw.vertexBuffer = vertexBuffers[random() % vertexBufferCount];
+        draw.depth = (random() & 0xffff) / 65535.0f;
+        draw.vertexCount = 3;
+    }
+
+    auto fillAndSort = [&]() {
+        drawList.clear();
+        for (const DrawList::Draw& draw : draws) drawList.add(draw);
+        drawList.sort();
+    };
+    report(measure("DrawList add + radix sort, 100k draws", 20, fillAndSort), drawCount, "draws");
+
+    std::vector<SortedDraw> keys(drawCount);
+    auto stdSort = [&]() {
+        for (uint32_t i = 0; i < drawCount; ++i) keys[i] = { DrawList::packKey(draws[i]), i };
+        std::sort(keys.begin(), keys.end(), [](const SortedDraw& a, const SortedDraw& b) { return a.key < b.key; });
+    };
+    report(measure("Key packing + std::sort, 100k draws", 20, stdSort), drawCount, "draws");
+
+    CountingEncoder encoder;
+    auto encode = [&]() {
+        encoder = CountingEncoder{};
+        fillAndSort();
+        drawList.encode(encoder, 0);
+        drawList.encode(encoder, 1);
+    };
+    report(measure("DrawList fill + sort + encode, 100k draws", 20, encode), drawCount, "draws");
+
+    const DrawList::Stats& stats = drawList.stats();
+    std::cout << "  state calls issued: " << encoder.stateCalls
+        << " (" << stats.pipelineChanges << " pipeline, "
+        << stats.bindGroupChanges << " bind group, "
+        << stats.vertexBufferChanges << " vertex buffer)"
+        << ", redundant calls eliminated: " << stats.redundantCallsEliminated
+        << ", draws: " << encoder.drawCalls << std::endl;
+}
@@ -0,0 +1,57 @@
+#include "Benchmark.h"
+
+#include "ComputeRuntime.h"
+#include "ImageProcessing.h"
+
+#include <cstdint>
+#include <vector>
+
+void benchImageProcessing(ComputeContext& gpu) {
+    // Thumbnails of a batch of photos
+    constexpr uint32_t imageCount = 32;
+    constexpr uint32_t width = 1024;
+    constexpr uint32_t height = 768;
+    constexpr uint32_t thumbnailWidth = 256;
+    constexpr uint32_t thumbnailHeight = 192;
+
+    std::vector<uint8_t> pixels(size_t(width) * height * 4 * imageCount);
+    uint32_t state = 1;
+    for (uint8_t& value : pixels) {
+        state = state * 1664525u + 1013904223u;
+        value = static_cast<uint8_t>(state >> 24);
+    }
+    std::vector<uint8_t> blurred(pixels.size());
+    std::vector<uint8_t> thumbnails(size_t(thumbnailWidth) * thumbnailHeight * 4 * imageCount);
+
+    auto cpuBlur = [&]() {
+        ImageProcessor::blurCpu(pixels.data(), blurred.data(), width, height, imageCount, 2.0f);
+    };
+    report(measure("ImageProcessor CPU blur sigma 2, 32 images 1024x768", 3, cpuBlur), imageCount, "images");
+    auto cpuResize = [&]() {
+        ImageProcessor::resizeCpu(pixels.data(), width, height, thumbnails.data(), thumbnailWidth, thumbnailHeight, imageCount, ResizeFilter::Lanczos3);
+    };
+    report(measure("ImageProcessor CPU Lanczos 1024x768 -> 256x192, 32 images", 3, cpuResize), imageCount, "images");
+
+    if (!gpu.hasGpu()) return;
+
+    ImageBatch src(gpu, width, height, imageCount);
+    ImageBatch dst(gpu, width, height, imageCount);
+    ImageBatch thumbnailBatch(gpu, thumbnailWidth, thumbnailHeight, imageCount);
+    for (uint32_t layer = 0; layer < imageCount; ++layer) {
+        src.upload(layer, pixels.data() + layer * src.layerByteSize());
+    }
+    ImageProcessor processor(gpu);
+    bool ok = true;
+    auto gpuBlur = [&]() {
+        ok = processor.blur(src, dst, 2.0f) && ok;
+        gpu.wait();
+    };
+    BenchmarkResult result = measure("ImageProcessor GPU blur sigma 2, 32 images 1024x768", 10, gpuBlur);
+    if (ok) report(result, imageCount, "images");
+    auto gpuResize = [&]() {
+        ok = processor.resize(src, thumbnailBatch, ResizeFilter::Lanczos3) && ok;
+        gpu.wait();
+    };
+    result = measure("ImageProcessor GPU Lanczos 1024x768 -> 256x192, 32 images", 10, gpuResize);
+    if (ok) report(result, imageCount, "images");
+}
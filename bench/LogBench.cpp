@@ -0,0 +1,97 @@
+#include "Benchmark.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t frameCount = 2000;
+constexpr uint32_t messagesPerFrame = 16;
+const char* logPath = "log_bench.txt";
+
+struct Jitter {
+    double meanMs = 0.0;
+    double minMs = 0.0;
+    double p50Ms = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+    double stddevMs = 0.0;
+};
+
+// Frames of fixed work, logging as they go
+template <typename LogMessage>
+Jitter runFrames(LogMessage&& logMessage) {
+    using Clock = std::chrono::steady_clock;
+    std::atomic<uint32_t> sink{ 0 };
+    std::vector<double> frameMs(frameCount);
+    for (uint32_t frame = 0; frame < frameCount; ++frame) {
+        auto start = Clock::now();
+        for (uint32_t m = 0; m < messagesPerFrame; ++m) {
+            for (uint32_t i = 0; i < 2000; ++i) sink.fetch_add(1, std::memory_order_relaxed);
+            logMessage(frame, m);
+        }
+        frameMs[frame] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    Jitter jitter;
+    for (double ms : frameMs) jitter.meanMs += ms;
+    jitter.meanMs /= frameCount;
+    for (double ms : frameMs) jitter.stddevMs += (ms - jitter.meanMs) * (ms - jitter.meanMs);
+    jitter.stddevMs = std::sqrt(jitter.stddevMs / frameCount);
+    std::sort(frameMs.begin(), frameMs.end());
+    jitter.minMs = frameMs.front();
+    jitter.p50Ms = frameMs[frameCount / 2];
+    jitter.p99Ms = frameMs[frameCount * 99 / 100];
+    jitter.maxMs = frameMs.back();
+    return jitter;
+}
+
+void reportJitter(const char* name, const Jitter& jitter) {
+    std::cout << name << ": frame mean " << jitter.meanMs << " ms, p50 " << jitter.p50Ms
+        << " ms, p99 " << jitter.p99Ms << " ms, max " << jitter.maxMs
+        << " ms, stddev " << jitter.stddevMs << " ms" << std::endl;
+
+    BenchmarkResult result;
+    result.name = name;
+    result.iterations = frameCount;
+    result.meanMs = jitter.meanMs;
+    result.minMs = jitter.minMs;
+    result.p99Ms = jitter.p99Ms;
+    result.maxMs = jitter.maxMs;
+    benchmarkRecords().push_back({ result, 0.0, std::string() });
+}
+
+} // namespace
+
+void benchLog() {
+    // Both write the same lines to a file, the way main.cpp used to write
+    // to std::cout: one flush per message
+    reportJitter("No logging, 16 x 2000 frames", runFrames([](uint32_t, uint32_t) {}));
+
+    {
+        std::ofstream out(logPath);
+        reportJitter("Synchronous writes, 16 x 2000 frames", runFrames([&](uint32_t frame, uint32_t m) {
+            out << "frame " << frame << ", message " << m << std::endl;
+        }));
+    }
+
+    Log::Options options;
+    options.path = logPath;
+    options.level = LogLevel::Info;
+    options.capacity = 4096;
+    if (Log::start(options)) {
+        reportJitter("Log::writef, 16 x 2000 frames", runFrames([](uint32_t frame, uint32_t m) {
+            Log::writef(LogLevel::Info, "bench", "frame %u, message %u", frame, m);
+        }));
+        uint64_t dropped = Log::droppedCount();
+        Log::stop();
+        if (dropped > 0) std::cout << "  (" << dropped << " messages dropped)" << std::endl;
+    }
+    std::remove(logPath);
+}
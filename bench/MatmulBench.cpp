@@ -0,0 +1,68 @@
+#include "Benchmark.h"
+
+#include "ComputeRuntime.h"
+#include "MatrixMultiply.h"
+
+#include <cstdint>
+#include <vector>
+
+void benchMatrixMultiply(ComputeContext& gpu, const std::string& adapterKey) {
+    constexpr uint32_t n = 1024;
+    constexpr double flops = 2.0 * n * n * n;
+
+    std::vector<float> a(size_t(n) * n), b(size_t(n) * n), c(size_t(n) * n);
+    uint32_t state = 1;
+    for (float& value : a) {
+        state = state * 1664525u + 1013904223u;
+        value = (state >> 8) / 16777216.0f - 0.5f;
+    }
+    b = a;
+
+    auto cpu = [&]() {
+        MatrixMultiply::multiplyCpu(a.data(), b.data(), c.data(), n, n, n);
+    };
+#if defined(__AVX2__)
+    const char* cpuName = "Matmul CPU f32 (AVX2), 1024^3";
+#else
+    const char* cpuName = "Matmul CPU f32, 1024^3";
+#endif
+    report(measure(cpuName, 3, cpu), flops * 1e-9, "GFLOP");
+
+    if (!gpu.hasGpu()) return;
+
+    GpuArray<float> aArray(gpu, a.size());
+    GpuArray<float> bArray(gpu, b.size());
+    GpuArray<float> cArray(gpu, c.size());
+    aArray.upload(a);
+    bArray.upload(b);
+    std::vector<uint32_t> halves = MatrixMultiply::packHalves(a);
+    GpuArray<uint32_t> aHalves(gpu, halves.size());
+    GpuArray<uint32_t> bHalves(gpu, halves.size());
+    aHalves.upload(halves);
+    bHalves.upload(halves);
+
+    // Every candidate, so that the autotuner's choice can be judged
+    for (const MatmulConfig& config : MatrixMultiply::candidateConfigs()) {
+        if (!config.isValid(gpu)) continue;
+        MatrixMultiply matmul(gpu, MatmulPrecision::F32, config);
+        auto run = [&]() {
+            matmul.run(aArray, bArray, cArray, n, n, n);
+            gpu.wait();
+        };
+        report(measure("Matmul GPU f32 " + config.name() + ", 1024^3", 10, run), flops * 1e-9, "GFLOP");
+    }
+
+    MatmulAutotuner autotuner;
+    for (MatmulPrecision precision : { MatmulPrecision::F32, MatmulPrecision::F16 }) {
+        MatmulConfig config = autotuner.tune(gpu, adapterKey, precision, n);
+        MatrixMultiply matmul(gpu, precision, config);
+        GpuArrayBase& aInput = precision == MatmulPrecision::F32 ? static_cast<GpuArrayBase&>(aArray) : aHalves;
+        GpuArrayBase& bInput = precision == MatmulPrecision::F32 ? static_cast<GpuArrayBase&>(bArray) : bHalves;
+        auto run = [&]() {
+            matmul.run(aInput, bInput, cArray, n, n, n);
+            gpu.wait();
+        };
+        const char* precisionName = precision == MatmulPrecision::F32 ? "f32" : "f16";
+        report(measure(std::string("Matmul GPU ") + precisionName + " autotuned " + config.name() + ", 1024^3", 10, run), flops * 1e-9, "GFLOP");
+    }
+}
@@ -0,0 +1,66 @@
+#include "Benchmark.h"
+
+#include "ComputeRuntime.h"
+#include "Reduction.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+void benchReduction(ComputeContext& gpu) {
+    constexpr uint32_t count = 1 << 25;
+    constexpr double bytes = double(count) * sizeof(float);
+
+    std::vector<float> input(count);
+    uint32_t state = 1;
+    for (float& value : input) {
+        state = state * 1664525u + 1013904223u;
+        value = (state >> 8) / 16777216.0f;
+    }
+
+    // A copy reads and writes every byte once: it is the reference for
+    // what the memory can do
+    std::vector<float> copy(count);
+    BenchmarkResult memcpyResult = measure("memcpy, 128 MB", 10, [&]() {
+        std::memcpy(copy.data(), input.data(), count * sizeof(float));
+    });
+    reportBandwidth(memcpyResult, 2 * bytes);
+    double cpuReferenceGBs = 2 * bytes / (memcpyResult.minMs * 1e-3) * 1e-9;
+
+    const ReduceOp ops[] = { ReduceOp::Sum, ReduceOp::Min, ReduceOp::Max, ReduceOp::ArgMax };
+    const char* opNames[] = { "sum", "min", "max", "argmax" };
+    ReduceResult cpuResults[4];
+    for (int i = 0; i < 4; ++i) {
+        BenchmarkResult result = measure(std::string("Reduction CPU f32 ") + opNames[i] + ", 32M elements", 10, [&]() {
+            cpuResults[i] = Reduction::reduceCpu(input.data(), count, ops[i]);
+        });
+        reportBandwidth(result, bytes, cpuReferenceGBs);
+    }
+
+    if (!gpu.hasGpu()) return;
+
+    GpuArray<float> inputArray(gpu, count);
+    GpuArray<float> copyArray(gpu, count);
+    inputArray.upload(input);
+    BenchmarkResult copyResult = measure("GPU buffer copy, 128 MB", 10, [&]() {
+        wgpu::CommandEncoder encoder = gpu.createEncoder("Copy");
+        encoder.copyBufferToBuffer(inputArray.buffer(), 0, copyArray.buffer(), 0, count * sizeof(float));
+        gpu.submit(encoder);
+        gpu.wait();
+    });
+    reportBandwidth(copyResult, 2 * bytes);
+    double gpuReferenceGBs = 2 * bytes / (copyResult.minMs * 1e-3) * 1e-9;
+
+    for (int i = 0; i < 4; ++i) {
+        Reduction reduction(gpu, ReduceElement::F32, ops[i]);
+        ReduceResult gpuResult;
+        BenchmarkResult result = measure(std::string("Reduction GPU f32 ") + opNames[i] + " (with readback), 32M elements", 10, [&]() {
+            gpuResult = reduction.reduce(inputArray, count);
+        });
+        reportBandwidth(result, bytes, gpuReferenceGBs);
+        // Sums are not expected to match exactly
+        if (ops[i] != ReduceOp::Sum && (gpuResult.value != cpuResults[i].value || gpuResult.index != cpuResults[i].index)) {
+            std::cout << "  MISMATCH with the CPU reduction" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#include "Benchmark.h"
+
+#include "ComputeRuntime.h"
+#include "PrefixScan.h"
+
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+void benchPrefixScan(ComputeContext& gpu) {
+    constexpr uint32_t count = 1 << 25;
+
+    std::vector<uint32_t> input(count);
+    uint32_t state = 1;
+    for (uint32_t& value : input) {
+        state = state * 1664525u + 1013904223u;
+        value = state >> 28;
+    }
+    std::vector<uint32_t> output(count);
+    std::vector<uint32_t> expected(count);
+
+    auto serial = [&]() {
+        std::exclusive_scan(input.begin(), input.end(), expected.begin(), 0u);
+    };
+    report(measure("std::exclusive_scan u32, 32M elements", 10, serial), count, "elements");
+
+    auto cpu = [&]() {
+        PrefixScan::scanCpu(input.data(), output.data(), count, ScanKind::Exclusive);
+    };
+    report(measure("PrefixScan CPU u32, 32M elements", 10, cpu), count, "elements");
+    if (output != expected) std::cout << "  MISMATCH with std::exclusive_scan" << std::endl;
+
+    std::vector<float> floatInput(input.begin(), input.end());
+    std::vector<float> floatOutput(count);
+    auto cpuFloat = [&]() {
+        PrefixScan::scanCpu(floatInput.data(), floatOutput.data(), count, ScanKind::Inclusive);
+    };
+    report(measure("PrefixScan CPU f32, 32M elements", 10, cpuFloat), count, "elements");
+
+    if (!gpu.hasGpu()) return;
+
+    GpuArray<uint32_t> inputArray(gpu, count);
+    GpuArray<uint32_t> outputArray(gpu, count);
+    inputArray.upload(input);
+    PrefixScan scan(gpu, ScanElement::U32);
+    bool ok = true;
+    auto gpuScan = [&]() {
+        ok = scan.run(inputArray, outputArray, count, ScanKind::Exclusive) && ok;
+        gpu.wait();
+    };
+    BenchmarkResult result = measure("PrefixScan GPU u32, 32M elements", 10, gpuScan);
+    if (!ok) return;
+    report(result, count, "elements");
+    if (outputArray.download() != expected) std::cout << "  MISMATCH with std::exclusive_scan" << std::endl;
+}
@@ -0,0 +1,75 @@
+#include "Benchmark.h"
+
+#include "ComputeRuntime.h"
+#include "RadixSort.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+namespace {
+
+template <typename K>
+void benchKeys(ComputeContext& gpu, SortKeyType keyType, const char* keyName) {
+    constexpr uint32_t count = 1 << 22;
+
+    std::vector<K> keys(count);
+    uint64_t state = 1;
+    for (K& key : keys) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        key = static_cast<K>(state >> (64 - 8 * sizeof(K)));
+    }
+    std::vector<uint32_t> indices(count);
+    std::iota(indices.begin(), indices.end(), 0u);
+
+    // Key-value sort with the standard library: sort (key, index) pairs
+    std::vector<std::pair<K, uint32_t>> pairs(count);
+    auto stdSort = [&]() {
+        for (uint32_t i = 0; i < count; ++i) pairs[i] = { keys[i], i };
+        std::sort(pairs.begin(), pairs.end());
+    };
+    report(measure(std::string("std::sort ") + keyName + " + index, 4M keys", 5, stdSort), count, "keys");
+
+    std::vector<K> sortedKeys(count);
+    std::vector<uint32_t> sortedValues(count);
+    auto cpu = [&]() {
+        sortedKeys = keys;
+        sortedValues = indices;
+        RadixSort::sortCpu(sortedKeys.data(), sortedValues.data(), count);
+    };
+    report(measure(std::string("RadixSort CPU ") + keyName + " + index, 4M keys", 5, cpu), count, "keys");
+    for (uint32_t i = 0; i < count; ++i) {
+        if (sortedKeys[i] != pairs[i].first || sortedValues[i] != pairs[i].second) {
+            std::cout << "  MISMATCH with std::sort" << std::endl;
+            break;
+        }
+    }
+
+    if (!gpu.hasGpu()) return;
+
+    GpuArray<K> keyArray(gpu, count);
+    GpuArray<uint32_t> valueArray(gpu, count);
+    RadixSort sort(gpu, keyType);
+    bool ok = true;
+    // The upload is part of each iteration since the sort is in place
+    auto gpuSort = [&]() {
+        keyArray.upload(keys);
+        valueArray.upload(indices);
+        ok = sort.run(keyArray, &valueArray, count) && ok;
+        gpu.wait();
+    };
+    BenchmarkResult result = measure(std::string("RadixSort GPU ") + keyName + " + index (with upload), 4M keys", 5, gpuSort);
+    if (!ok) return;
+    report(result, count, "keys");
+    if (keyArray.download() != sortedKeys || valueArray.download() != sortedValues) {
+        std::cout << "  MISMATCH with the CPU sort" << std::endl;
+    }
+}
+
+} // namespace
+
+void benchRadixSort(ComputeContext& gpu) {
+    benchKeys<uint32_t>(gpu, SortKeyType::U32, "u32");
+    benchKeys<uint64_t>(gpu, SortKeyType::U64, "u64");
+}
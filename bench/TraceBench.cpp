@@ -0,0 +1,30 @@
+#include "Benchmark.h"
+
+#include "Trace.h"
+
+#include <atomic>
+#include <cstdint>
+
+void benchTrace() {
+    constexpr uint32_t count = 1 << 22;
+
+    // Something for the zones to wrap that the compiler cannot drop
+    std::atomic<uint32_t> sink{ 0 };
+    auto work = [&]() {
+        for (uint32_t i = 0; i < count; ++i) {
+            sink.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+    auto zones = [&]() {
+        for (uint32_t i = 0; i < count; ++i) {
+            TRACE_ZONE("Bench zone");
+            sink.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
+    report(measure("No zone, 4M iterations", 5, work), count, "iterations");
+    report(measure("TRACE_ZONE, trace stopped, 4M iterations", 5, zones), count, "zones");
+    Trace::start();
+    report(measure("TRACE_ZONE, trace started, 4M iterations", 5, zones), count, "zones");
+    Trace::stop();
+}
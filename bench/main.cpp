@@ -0,0 +1,132 @@
+#define WEBGPU_CPP_IMPLEMENTATION
+#include <webgpu/webgpu.hpp>
+
+#include "Benchmark.h"
+#include "BenchDevice.h"
+
+#include "ComputeRuntime.h"
+#include "MatrixMultiply.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+
+namespace {
+
+void writeJsonString(std::ostream& out, const std::string& value) {
+    out << '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+            out << escaped;
+        }
+        else out << c;
+    }
+    out << '"';
+}
+
+bool writeJson(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Could not open " << path << " for writing" << std::endl;
+        return false;
+    }
+#ifdef WEBGPU_MOCK
+    out << "{\n  \"backend\": \"mock\",\n  \"results\": [";
+#else
+    out << "{\n  \"backend\": \"wgpu-native\",\n  \"results\": [";
+#endif
+    const std::vector<BenchmarkRecord>& records = benchmarkRecords();
+    for (size_t i = 0; i < records.size(); ++i) {
+        const BenchmarkRecord& record = records[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"name\": ";
+        writeJsonString(out, record.result.name);
+        out << ", \"iterations\": " << record.result.iterations
+            << ", \"meanMs\": " << record.result.meanMs
+            << ", \"minMs\": " << record.result.minMs
+            << ", \"rate\": " << record.rate
+            << ", \"unit\": ";
+        writeJsonString(out, record.unit);
+        out << ", \"callsPerIteration\": " << record.result.callsPerIteration;
+        if (record.result.p99Ms > 0.0) {
+            out << ", \"p99Ms\": " << record.result.p99Ms << ", \"maxMs\": " << record.result.maxMs;
+        }
+        out << "}";
+    }
+    out << "\n  ]";
+#ifdef WEBGPU_MOCK
+    // Deterministic, unlike the timings: what CI should compare
+    out << ",\n  \"calls\": {";
+    std::vector<MockWebGpu::CallCount> calls = MockWebGpu::callCounts();
+    for (size_t i = 0; i < calls.size(); ++i) {
+        out << (i == 0 ? "\n    " : ",\n    ");
+        writeJsonString(out, calls[i].function);
+        out << ": " << calls[i].count;
+    }
+    out << "\n  }";
+#endif
+    out << "\n}\n";
+    return bool(out);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string jsonPath;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        }
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--json <path>]" << std::endl;
+            return 1;
+        }
+    }
+
+    benchDrawList();
+    benchTrace();
+    benchLog();
+
+    BenchDevice benchDevice;
+    std::unique_ptr<ComputeContext> gpu;
+    std::string adapterKey;
+    if (benchDevice.create()) {
+        gpu = std::make_unique<ComputeContext>(benchDevice.device, benchDevice.queue);
+        adapterKey = MatmulAutotuner::adapterKey(benchDevice.adapter);
+    }
+    else {
+        gpu = std::make_unique<ComputeContext>();
+    }
+    benchWebGpuApi(*gpu);
+#ifdef WEBGPU_MOCK
+    // Shaders do not run on the mock, so the kernels take their CPU path
+    // (and check against it) rather than compare with nothing
+    gpu.reset();
+    gpu = std::make_unique<ComputeContext>();
+    adapterKey.clear();
+#endif
+    benchPrefixScan(*gpu);
+    benchRadixSort(*gpu);
+    benchReduction(*gpu);
+    benchMatrixMultiply(*gpu, adapterKey);
+    benchStreamCompaction(*gpu);
+    benchImageProcessing(*gpu);
+    benchComputeBatcher(*gpu);
+#ifndef WEBGPU_MOCK
+    benchAdapters();
+#endif
+
+    gpu.reset();
+    benchDevice.release();
+#ifdef WEBGPU_MOCK
+    // After the release of the benchmark device, so that any object still
+    // alive is a leak of a benchmark
+    MockWebGpu::report(std::cout);
+#endif
+    if (!jsonPath.empty() && !writeJson(jsonPath)) return 1;
+    return 0;
+}
@@ -1,32 +1,39 @@
 #include <iostream>
 #include <GLFW/glfw3.h>
+#ifndef WEBGPU_MOCK
 #include <glfw3webgpu.h>
+#endif
 #include <webgpu/webgpu.h>
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
 #include <vector>
 #define WEBGPU_CPP_IMPLEMENTATION
 #include <webgpu/webgpu.hpp>
 
+#include "AdapterSelection.h"
+#include "ComputeKernels.h"
+#include "ComputeRuntime.h"
+#include "DeviceProfile.h"
+#include "ErrorScopes.h"
+#include "FrameRegression.h"
+#include "FrameStats.h"
+#include "GpuTelemetry.h"
+#include "GpuTimeline.h"
+#include "HeadlessTarget.h"
+#include "Log.h"
+#include "ParticleSystem.h"
+#include "PostAntiAliasing.h"
+#include "RenderGraph.h"
+#include "Scene.h"
+#include "StatsOverlay.h"
+#include "TexturePool.h"
+#include "Trace.h"
 
-const char* shaderSource = R"(
-@vertex
-fn vs_main(@builtin(vertex_index) in_vertex_index:u32) -> @builtin(position) vec4f {
-    var p = vec2f(0.0, 0.0);
-    if (in_vertex_index == 0u) {
-        p = vec2f(-0.5, -0.5);
-    } else if (in_vertex_index == 1u) {
-        p = vec2f(0.5, -0.5);
-    } else {
-        p = vec2f(0.0, 0.5);
-    }
-    return vec4f(p, 0.0, 1.0);
-}
 
-@fragment
-fn fs_main() -> @location(0) vec4f {
-    return vec4f(0.0, 0.4, 1.0, 1.0);
-}
-)";
 
 
 WGPUAdapter requestAdapter(WGPUInstance instance, WGPURequestAdapterOptions const* options) {
@@ -45,7 +52,7 @@ WGPUAdapter requestAdapter(WGPUInstance instance, WGPURequestAdapterOptions cons
 
         }
         else {
-            std::cout << "Could not get WebGPU adapter:" << message << std::endl;
+            Log::writef(LogLevel::Error, "app", "Could not get WebGPU adapter: %s", message);
         }
         userData.requestEnded = true;
     };
@@ -71,7 +78,7 @@ WGPUDevice requestDevice(WGPUAdapter adapter, WGPUDeviceDescriptor const* descri
             userData.device = device;
         }
         else {
-            std::cout << "Could not get WebGPU device: " << message << std::endl;
+            Log::writef(LogLevel::Error, "app", "Could not get WebGPU device: %s", message);
         }
         userData.requestEnded = true;
     };
@@ -89,21 +96,219 @@ WGPUDevice requestDevice(WGPUAdapter adapter, WGPUDeviceDescriptor const* descri
 }
 
 
-int main(int,char**) 
+struct Options {
+    // 1 renders directly into the swap chain, 4 renders into a multisampled
+    // target that is resolved into the swap chain
+    uint32_t sampleCount = 1;
+    // Render single-sampled into an offscreen target, then anti-alias it
+    // with a full screen pass
+    bool postAntiAliasing = false;
+    // If not 0, disable vsync, run this many frames, print timings and exit
+    uint32_t benchmarkFrames = 0;
+    // Number of triangles in the scene; use many to make it overdraw heavy
+    uint32_t objectCount = 1;
+    bool depthPrepass = false;
+    bool sortFrontToBack = true;
+    // Run the compute kernels on the GPU and the CPU, compare and exit
+    bool computeCheck = false;
+    // If not 0, simulate and draw up to this many particles on the GPU
+    uint32_t particleCount = 0;
+    // If not empty, sample wgpu object counts every 60 frames into this
+    // file (Prometheus text if it ends in .prom, JSON lines otherwise)
+    std::string telemetryPath;
+    // If not empty, record CPU and GPU zones and write them to this file as
+    // chrome://tracing JSON on exit
+    std::string tracePath;
+    // Show the statistics overlay from the start (F1 toggles it)
+    bool overlay = false;
+    // Time the webgpu.hpp calls, in builds with WEBGPU_CPP_INSTRUMENTATION
+    bool callLatency = false;
+    // Messages of the app and the driver below this level are dropped
+    LogLevel logLevel = LogLevel::Info;
+    // Log file, the console if empty
+    std::string logPath;
+    // Report validation errors with the frame phase or render graph pass
+    // they come from
+    bool validate = false;
+    // Adapter features and limits, kept from one run to the next
+    std::string profilePath = "device_profile.txt";
+    // When either is set, pick among all the adapters rather than take the
+    // one requestAdapter returns
+    bool selectAdapter = false;
+    AdapterSelection::Policy adapterPolicy;
+    // No window nor surface: render into an offscreen target, e.g. on CI
+    bool headless = false;
+    // If not empty, time the phases of the --benchmark frames and compare
+    // them with this baseline (or write it, with updateBaseline)
+    std::string baselinePath;
+    bool updateBaseline = false;
+};
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--msaa") == 0 && i + 1 < argc) {
+            options.sampleCount = static_cast<uint32_t>(std::atoi(argv[++i]));
+            if (options.sampleCount != 1 && options.sampleCount != 4) {
+                std::cerr << "Unsupported sample count " << options.sampleCount << " (use 1 or 4)" << std::endl;
+                return false;
+            }
+        }
+        else if (std::strcmp(argv[i], "--post-aa") == 0) {
+            options.postAntiAliasing = true;
+        }
+        else if (std::strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc) {
+            options.benchmarkFrames = static_cast<uint32_t>(std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--objects") == 0 && i + 1 < argc) {
+            options.objectCount = static_cast<uint32_t>(std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--depth-prepass") == 0) {
+            options.depthPrepass = true;
+        }
+        else if (std::strcmp(argv[i], "--unsorted") == 0) {
+            options.sortFrontToBack = false;
+        }
+        else if (std::strcmp(argv[i], "--compute-check") == 0) {
+            options.computeCheck = true;
+        }
+        else if (std::strcmp(argv[i], "--particles") == 0 && i + 1 < argc) {
+            options.particleCount = static_cast<uint32_t>(std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc) {
+            options.telemetryPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            options.tracePath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--overlay") == 0) {
+            options.overlay = true;
+        }
+        else if (std::strcmp(argv[i], "--call-latency") == 0) {
+            options.callLatency = true;
+        }
+        else if (std::strcmp(argv[i], "--log-level") == 0 && i + 1 < argc && Log::parseLevel(argv[i + 1], options.logLevel)) {
+            ++i;
+        }
+        else if (std::strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+            options.logPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--validate") == 0) {
+            options.validate = true;
+        }
+        else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            options.profilePath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--adapter") == 0 && i + 1 < argc && AdapterSelection::parsePreference(argv[i + 1], options.adapterPolicy.preference)) {
+            options.selectAdapter = true;
+            ++i;
+        }
+        else if (std::strcmp(argv[i], "--backend") == 0 && i + 1 < argc && AdapterSelection::parseBackend(argv[i + 1], options.adapterPolicy.backend)) {
+            options.selectAdapter = true;
+            ++i;
+        }
+        else if (std::strcmp(argv[i], "--headless") == 0) {
+            options.headless = true;
+        }
+        else if (std::strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            options.baselinePath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--update-baseline") == 0) {
+            options.updateBaseline = true;
+        }
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--msaa 1|4] [--post-aa] [--benchmark <frames>]"
+                << " [--objects <count>] [--depth-prepass] [--unsorted] [--compute-check] [--particles <count>] [--telemetry <path>] [--trace <path>] [--overlay] [--call-latency]"
+                << " [--log-level off|error|warn|info|debug|trace] [--log <path>] [--validate] [--profile <path>]"
+                << " [--adapter default|discrete|integrated|latency] [--backend any|vulkan|metal|d3d12|d3d11|opengl|opengles]"
+                << " [--headless] [--baseline <path>] [--update-baseline]" << std::endl;
+            return false;
+        }
+    }
+    if (options.postAntiAliasing && options.sampleCount != 1) {
+        std::cerr << "--post-aa replaces MSAA, it cannot be combined with --msaa " << options.sampleCount << std::endl;
+        return false;
+    }
+    if (options.headless && options.benchmarkFrames == 0 && !options.computeCheck) {
+        std::cerr << "Nothing closes a --headless run: give it a number of --benchmark frames" << std::endl;
+        return false;
+    }
+    if (!options.baselinePath.empty() && options.benchmarkFrames == 0) {
+        std::cerr << "--baseline compares the frames of a --benchmark run" << std::endl;
+        return false;
+    }
+    if (options.updateBaseline && options.baselinePath.empty()) {
+        std::cerr << "--update-baseline needs the --baseline <path> to write" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+void printSceneStats(Scene& scene) {
+    scene.updateOverdrawStats();
+    const Scene::Stats& stats = scene.stats();
+    const DrawList::Stats& drawStats = scene.drawStats();
+    std::cout << "Scene: " << drawStats.drawCount << " draws"
+        << ", sort " << drawStats.sortTimeMs << " ms"
+        << ", " << drawStats.pipelineChanges << " pipeline / "
+        << drawStats.bindGroupChanges << " bind group / "
+        << drawStats.vertexBufferChanges << " vertex buffer changes"
+        << ", " << drawStats.redundantCallsEliminated << " redundant state calls skipped"
+        << ", depth complexity " << stats.depthComplexity
+        << ", shaded overdraw " << stats.shadedOverdraw
+        << (scene.options().depthPrepass ? " (depth pre-pass)" : "")
+        << std::endl;
+}
+
+
+int main(int argc, char** argv) 
 {
-    if (!glfwInit())
-    {
-        std::cerr << "Could not initialize GLFW!" << std::endl;
-        return 1;
+    Options options;
+    if (!parseOptions(argc, argv, options)) return 1;
+    Log::Options logOptions;
+    logOptions.level = options.logLevel;
+    logOptions.path = options.logPath;
+    if (!Log::start(logOptions)) return 1;
+    Log::installWgpuCallback();
+    if (!options.tracePath.empty()) {
+#ifndef TRACING_ENABLED
+        std::cerr << "Built with TRACING off: the trace will only have GPU zones" << std::endl;
+#endif
+        Trace::start();
+        Trace::setThreadName("main");
+#if defined(TRACING_ENABLED) && defined(WEBGPU_CPP_INSTRUMENTATION)
+        // Each webgpu.hpp call is a zone too, nested in the phase making it
+        wgpu::instrumentation::setCallObserver([](const char* name, uint64_t beginNs, uint64_t endNs) {
+            Trace::addCpuZone(name, beginNs, endNs);
+        });
+#endif
+    }
+    if (options.callLatency) {
+#ifdef WEBGPU_CPP_INSTRUMENTATION
+        wgpu::instrumentation::setRecordLatency(true);
+#else
+        std::cerr << "Built without WEBGPU_INSTRUMENTATION: --call-latency does nothing" << std::endl;
+#endif
     }
 
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    GLFWwindow* window = glfwCreateWindow(650, 480, "Learn WebGPU", NULL, NULL);
-    if (!window) 
-    {
-        std::cerr << "Could not open window!" << std::endl;
-        glfwTerminate();
-        return 1;
+    GLFWwindow* window = nullptr;
+    if (!options.headless) {
+        if (!glfwInit())
+        {
+            std::cerr << "Could not initialize GLFW!" << std::endl;
+            Log::stop();
+            return 1;
+        }
+
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        window = glfwCreateWindow(650, 480, "Learn WebGPU", NULL, NULL);
+        if (!window) 
+        {
+            std::cerr << "Could not open window!" << std::endl;
+            glfwTerminate();
+            Log::stop();
+            return 1;
+        }
     }
 
     wgpu::InstanceDescriptor desc = {};
@@ -112,6 +317,11 @@ int main(int,char**)
     if (!instance) 
     {
         std::cerr << "Could not initialize WebGPU!" << std::endl;
+        if (window) {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+        }
+        Log::stop();
         return 1;
     }
 
@@ -119,26 +329,46 @@ int main(int,char**)
 
     std::cout << "Requesting adapter..." << std::endl;
 
-    wgpu::Surface surface = glfwGetWGPUSurface(instance, window);
-
-    wgpu::RequestAdapterOptions adapterOptions = {};
-    adapterOptions.compatibleSurface = surface;
-    wgpu::Adapter adapter = requestAdapter(instance, &adapterOptions);
+    // Rendered into a HeadlessTarget instead when there is none
+    wgpu::Surface surface = nullptr;
+#ifndef WEBGPU_MOCK
+    if (window) surface = glfwGetWGPUSurface(instance, window);
+#endif
+
+    wgpu::Adapter adapter = nullptr;
+    if (options.selectAdapter) {
+        std::vector<AdapterInfo> adapters = AdapterSelection::enumerate(instance);
+        options.adapterPolicy.compatibleSurface = surface;
+        int selected = AdapterSelection::select(adapters, options.adapterPolicy);
+        for (int i = 0; i < static_cast<int>(adapters.size()); ++i) {
+            const AdapterInfo& info = adapters[i];
+            std::cout << (i == selected ? " * " : "   ") << info.name << " (" << AdapterSelection::typeName(info.type)
+                << ", " << AdapterSelection::backendName(info.backend) << ")";
+            if (info.latencyMs >= 0.0) std::cout << ", submit round trip " << info.latencyMs << " ms";
+            std::cout << std::endl;
+        }
+        if (selected >= 0) {
+            // Keep it past the release of the list
+            adapter = adapters[selected].adapter;
+            adapters[selected].adapter = nullptr;
+        }
+        else {
+            std::cerr << "No adapter matches --adapter/--backend, falling back to the default one" << std::endl;
+        }
+        AdapterSelection::release(adapters);
+    }
+    if (!adapter) {
+        wgpu::RequestAdapterOptions adapterOptions = {};
+        adapterOptions.compatibleSurface = surface;
+        adapter = requestAdapter(instance, &adapterOptions);
+    }
 
     std::cout << "Got adapter: " << adapter << std::endl;
 
-    // Is something missing here??
-        // Why doesn't this work??
-        // Huh??
-        // PR opportunity??
-    std::vector<WGPUFeatureName> features;
-    size_t featureCount = wgpuAdapterEnumerateFeatures(adapter, nullptr);
-    features.resize(featureCount);
-
-    wgpuAdapterEnumerateFeatures(adapter, features.data());
-
-    std::cout << "Adapter features:" << std::endl;
-    for (auto f : features) {
+    // Features and limits, probed on the first run only
+    DeviceProfile profile = DeviceProfile::load(adapter, options.profilePath);
+    std::cout << "Adapter features (" << (profile.cached() ? "cached" : "probed") << "):" << std::endl;
+    for (auto f : profile.features()) {
         std::cout << " - " << f << std::endl;
     }
 
@@ -146,16 +376,47 @@ int main(int,char**)
     wgpu::DeviceDescriptor deviceDesc = {};
     deviceDesc.label = "My Device";
     deviceDesc.requiredFeaturesCount = 0;
-    deviceDesc.requiredLimits = nullptr;
+    // GPU zones of the trace and the overlay need timestamps
+    const WGPUFeatureName timestampQuery = WGPUFeatureName_TimestampQuery;
+    if (profile.hasFeature(timestampQuery)) {
+        deviceDesc.requiredFeaturesCount = 1;
+        deviceDesc.requiredFeatures = &timestampQuery;
+    }
+    wgpu::RequiredLimits requiredLimits = profile.requiredLimits();
+    deviceDesc.requiredLimits = &requiredLimits;
     deviceDesc.defaultQueue.nextInChain = nullptr;
     deviceDesc.defaultQueue.label = "The default queue";
     wgpu::Device device = adapter.requestDevice(deviceDesc);
+    if (!device && profile.cached()) {
+        // Stale profile, e.g. after a driver update that kept its name
+        std::cerr << "Device request failed with the cached profile, probing the adapter again" << std::endl;
+        profile = DeviceProfile::probe(adapter);
+        profile.save(options.profilePath);
+        deviceDesc.requiredFeaturesCount = 0;
+        deviceDesc.requiredFeatures = nullptr;
+        if (profile.hasFeature(timestampQuery)) {
+            deviceDesc.requiredFeaturesCount = 1;
+            deviceDesc.requiredFeatures = &timestampQuery;
+        }
+        requiredLimits = profile.requiredLimits();
+        device = adapter.requestDevice(deviceDesc);
+    }
+    if (!device) {
+        std::cerr << "Could not get a WebGPU device!" << std::endl;
+        adapter.release();
+        if (surface) surface.release();
+        instance.release();
+        if (window) {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+        }
+        Log::stop();
+        return 1;
+    }
     std::cout << "Got device: " << device << std::endl;
 
     auto onDeviceError = [](WGPUErrorType type, char const* message, void*) {
-        std::cout << "Uncaptured device error: type " << type;
-        if (message) std::cout << " (" << message << ")";
-        std::cout << std::endl;
+        Log::writef(LogLevel::Error, "device", "Uncaptured device error: type %d (%s)", static_cast<int>(type), message ? message : "");
     };
     wgpuDeviceSetUncapturedErrorCallback(device, onDeviceError, nullptr);
 
@@ -174,7 +435,7 @@ int main(int,char**)
     wgpu::Queue queue = device.getQueue();
 
     auto onQueueWorkDone = [](WGPUQueueWorkDoneStatus status, void*) {
-        std::cout << "Queued work finished with status: " << status << std::endl;
+        Log::writef(LogLevel::Info, "app", "Queued work finished with status: %d", static_cast<int>(status));
     };
 
     wgpuQueueOnSubmittedWorkDone(queue, onQueueWorkDone, nullptr);
@@ -196,83 +457,115 @@ int main(int,char**)
     queue.submit(1, &command);
     command.release();
 
+    int exitCode = 0;
+    bool running = true;
+    if (options.computeCheck) {
+#ifdef WEBGPU_MOCK
+        // Shaders do not run on the mock: check the CPU paths instead, as
+        // Bench does, rather than report every GPU result as a mismatch
+        ComputeContext computeContext;
+#else
+        ComputeContext computeContext(device, queue);
+#endif
+        exitCode = checkComputeKernels(computeContext) ? 0 : 1;
+        // Skip the frame loop, but still go through the cleanup
+        running = false;
+    }
 
 
 
     wgpu::SwapChainDescriptor swapChainDesc = {};
     swapChainDesc.width = 640;
     swapChainDesc.height = 480;
-    swapChainDesc.format = surface.getPreferredFormat(adapter);
+    // The most common preferred format, when there is no surface to ask
+    swapChainDesc.format = wgpu::TextureFormat::BGRA8Unorm;
+    if (surface) swapChainDesc.format = surface.getPreferredFormat(adapter);
     swapChainDesc.usage = wgpu::TextureUsage::RenderAttachment;
-    swapChainDesc.presentMode = wgpu::PresentMode::Fifo;
-    wgpu::SwapChain swapChain = device.createSwapChain(surface, swapChainDesc);
-    std::cout << "Swapchain: " << swapChain << std::endl;
-
-
-
-    // None of this is relevant for this one
-
-    // Create shader module
-    wgpu::ShaderModuleDescriptor shaderDesc;
-    shaderDesc.hintCount = 0;
-    shaderDesc.hints = nullptr;
-
-    wgpu::ShaderModuleWGSLDescriptor shaderCodeDesc;
-    shaderCodeDesc.chain.next = nullptr;
-    shaderCodeDesc.chain.sType = wgpu::SType::ShaderModuleWGSLDescriptor;
-    shaderCodeDesc.code = shaderSource;
-    shaderDesc.nextInChain = &shaderCodeDesc.chain;
-    wgpu::ShaderModule shaderModule = device.createShaderModule(shaderDesc);
-
-    // begin renering here
-    wgpu::RenderPipelineDescriptor pipelineDesc;
-    // define vertex shader
-    pipelineDesc.vertex.bufferCount = 0;
-    pipelineDesc.vertex.buffers = nullptr;
-    pipelineDesc.vertex.module = shaderModule;
-    pipelineDesc.vertex.entryPoint = "vs_main";
-    pipelineDesc.vertex.constantCount = 0;
-    pipelineDesc.vertex.constants = nullptr;
-    // define rasterization
-    pipelineDesc.primitive.topology = wgpu::PrimitiveTopology::TriangleList;
-    pipelineDesc.primitive.stripIndexFormat = wgpu::IndexFormat::Undefined;
-    pipelineDesc.primitive.frontFace = wgpu::FrontFace::CCW;
-    pipelineDesc.primitive.cullMode = wgpu::CullMode::None;
-    // define fragment shader
-    wgpu::FragmentState fragmentState;
-    fragmentState.module = shaderModule;
-    fragmentState.entryPoint = "fs_main";
-    fragmentState.constantCount = 0;
-    fragmentState.constants = nullptr;
-    pipelineDesc.fragment = &fragmentState;
-    // define stencil/depth test
-    pipelineDesc.depthStencil = nullptr;
-    // define blending
-    wgpu::BlendState blendState;
-    blendState.color.srcFactor = wgpu::BlendFactor::SrcAlpha;
-    blendState.color.dstFactor = wgpu::BlendFactor::OneMinusSrcAlpha;
-    blendState.color.operation = wgpu::BlendOperation::Add;
-    blendState.alpha.srcFactor = wgpu::BlendFactor::Zero;
-    blendState.alpha.dstFactor = wgpu::BlendFactor::One;
-    blendState.alpha.operation = wgpu::BlendOperation::Add;
-    wgpu::ColorTargetState colorTarget;
-    wgpu::TextureFormat swapChainFormat = surface.getPreferredFormat(adapter);
-    colorTarget.format = swapChainFormat; //????
-    colorTarget.blend = &blendState;
-    colorTarget.writeMask = wgpu::ColorWriteMask::All;
-
-    fragmentState.targetCount = 1;
-    fragmentState.targets = &colorTarget;
-
-    pipelineDesc.multisample.count = 1;
-    pipelineDesc.multisample.mask = ~0u;
-    pipelineDesc.multisample.alphaToCoverageEnabled = false;
-
-    pipelineDesc.label = nullptr;
-
-    wgpu::RenderPipeline pipeline = device.createRenderPipeline(pipelineDesc);
-
-    // None of this is relevant for this one
+    // Vsync would hide the cost of what we are benchmarking
+    swapChainDesc.presentMode = options.benchmarkFrames > 0 ? wgpu::PresentMode::Immediate : wgpu::PresentMode::Fifo;
+    wgpu::SwapChain swapChain = nullptr;
+    std::unique_ptr<HeadlessTarget> headlessTarget;
+    if (surface) {
+        swapChain = device.createSwapChain(surface, swapChainDesc);
+        std::cout << "Swapchain: " << swapChain << std::endl;
+    }
+    else {
+        headlessTarget = std::make_unique<HeadlessTarget>(device, swapChainDesc.width, swapChainDesc.height, swapChainDesc.format);
+    }
+
+    // Everything the phase timings depend on, so that a baseline is only
+    // compared with runs of the same scene on the same adapter
+    std::unique_ptr<FrameRegression> frameRegression;
+    if (!options.baselinePath.empty()) {
+        const std::string configuration = "frames=" + std::to_string(options.benchmarkFrames)
+            + " objects=" + std::to_string(options.objectCount)
+            + " msaa=" + std::to_string(options.sampleCount)
+            + " post-aa=" + std::to_string(options.postAntiAliasing)
+            + " depth-prepass=" + std::to_string(options.depthPrepass)
+            + " sorted=" + std::to_string(options.sortFrontToBack)
+            + " particles=" + std::to_string(options.particleCount)
+            + " overlay=" + std::to_string(options.overlay)
+            + " validate=" + std::to_string(options.validate)
+            + " headless=" + std::to_string(options.headless)
+            + " adapter=" + DeviceProfile::adapterKey(adapter);
+        FrameRegression::Options regressionOptions;
+        regressionOptions.warmupFrames = std::clamp(options.benchmarkFrames / 4, 1u, regressionOptions.warmupFrames);
+        frameRegression = std::make_unique<FrameRegression>(configuration, options.benchmarkFrames, regressionOptions);
+    }
+
+    // Offscreen attachments (post-processing targets etc.) come from here
+    TexturePool texturePool(device);
+    RenderGraph renderGraph(device, texturePool);
+    bool dumpRenderGraph = true;
+    // Mean, min and max cover all frames of a benchmark whatever its length
+    FrameStats frameStats;
+    // Always sampled, so that leaks are reported even without an output file
+    GpuTelemetry::Options telemetryOptions;
+    telemetryOptions.outputPath = options.telemetryPath;
+    telemetryOptions.format = GpuTelemetry::formatForPath(options.telemetryPath);
+    GpuTelemetry telemetry(instance, telemetryOptions);
+    // Records while tracing or while the overlay is shown
+    auto gpuTimeline = std::make_unique<GpuTimeline>(device, queue);
+    if (!options.tracePath.empty() && !gpuTimeline->active()) {
+        std::cerr << "No timestamp queries on this device: the trace will only have CPU zones" << std::endl;
+    }
+    renderGraph.setGpuTimeline(gpuTimeline.get());
+    auto errorScopes = std::make_unique<ErrorScopes>(device);
+    errorScopes->setEnabled(options.validate);
+#ifndef VALIDATION_SCOPES_ENABLED
+    if (options.validate) std::cerr << "Built with VALIDATION_SCOPES off: --validate does nothing" << std::endl;
+#endif
+    renderGraph.setErrorScopes(errorScopes.get());
+    auto overlay = std::make_unique<StatsOverlay>(device, queue, swapChainDesc.format);
+    overlay->setVisible(options.overlay);
+    bool toggleKeyDown = false;
+
+    std::unique_ptr<PostAntiAliasing> postAntiAliasing;
+    if (options.postAntiAliasing) {
+        postAntiAliasing = std::make_unique<PostAntiAliasing>(device, swapChainDesc.format);
+    }
+
+
+
+    Scene::Options sceneOptions;
+    sceneOptions.objectCount = options.objectCount;
+    sceneOptions.sampleCount = options.sampleCount;
+    sceneOptions.depthPrepass = options.depthPrepass;
+    sceneOptions.sortFrontToBack = options.sortFrontToBack;
+    auto scene = std::make_unique<Scene>(device, queue, swapChainDesc.format, sceneOptions);
+
+    std::unique_ptr<ComputeContext> computeContext;
+    std::unique_ptr<ParticleSystem> particles;
+    if (options.particleCount > 0) {
+        computeContext = std::make_unique<ComputeContext>(device, queue);
+        ParticleSystem::Options particleOptions;
+        particleOptions.capacity = options.particleCount;
+        // About as many alive as the capacity, lifetimes averaging 1.5 s
+        particleOptions.emitPerSecond = options.particleCount / 1.5f;
+        particles = std::make_unique<ParticleSystem>(*computeContext, particleOptions);
+        particles->createRenderPipeline(swapChainDesc.format, Scene::DepthFormat, options.sampleCount);
+    }
+    double lastFrameTime = window ? glfwGetTime() : 0.0;
 
 
 
@@ -283,16 +576,16 @@ int main(int,char**)
 
     auto onBuffer2Mapped = [](WGPUBufferMapAsyncStatus status, void* pUserData) {
         Context* context = reinterpret_cast<Context*>(pUserData);
-        std::cout << "Buffer 2 mapped with status " << status << std::endl;
+        Log::writef(LogLevel::Info, "app", "Buffer 2 mapped with status %d", static_cast<int>(status));
         if (status != wgpu::BufferMapAsyncStatus::Success) return;
         uint8_t* bufferData = (uint8_t*)context->buffer.getConstMappedRange(0, 16);
 
-        std::cout << "bufferData = [";
+        std::string values;
         for (int i = 0;i < 16; ++i) {
-            if (i > 0) std::cout << ", ";
-            std::cout << bufferData[i];
+            if (i > 0) values += ", ";
+            values += std::to_string(bufferData[i]);
         }
-        std::cout << "]" << std::endl;
+        Log::writef(LogLevel::Info, "app", "bufferData = [%s]", values.c_str());
 
         context->buffer.unmap();
     };
@@ -300,77 +593,232 @@ int main(int,char**)
     Context context = { buffer2 };
     wgpuBufferMapAsync(buffer2, wgpu::MapMode::Read, 0, 16, onBuffer2Mapped, (void*)&context);
 
-    while (!glfwWindowShouldClose(window)) 
+    while (running && (!window || !glfwWindowShouldClose(window))) 
     {
+        TRACE_ZONE("Frame");
+        if (frameRegression) frameRegression->setFrame(frameStats.frameCount());
+        FRAME_PHASE(frameRegression.get(), "Frame");
+        errorScopes->setFrame(frameStats.frameCount());
+        gpuTimeline->setEnabled(overlay->visible());
+        gpuTimeline->beginFrame();
         queue.submit(0, nullptr);
 
-        glfwPollEvents();
+        if (window) {
+            {
+                TRACE_ZONE("Poll events");
+                glfwPollEvents();
+            }
+            bool toggleKey = glfwGetKey(window, GLFW_KEY_F1) == GLFW_PRESS;
+            if (toggleKey && !toggleKeyDown) overlay->toggle();
+            toggleKeyDown = toggleKey;
+        }
+
+        texturePool.beginFrame();
 
-        wgpu::TextureView nextTexture = swapChain.getCurrentTextureView();
+        wgpu::TextureView nextTexture = nullptr;
+        {
+            TRACE_ZONE("Acquire texture");
+            FRAME_PHASE(frameRegression.get(), "Acquire texture");
+            ERROR_SCOPE(errorScopes.get(), "Acquire texture");
+            nextTexture = swapChain ? swapChain.getCurrentTextureView() : headlessTarget->getCurrentTextureView();
+        }
         if (!nextTexture) {
-            std::cerr << "Cannot acquire next swap chain texture" << std::endl;
+            Log::write(LogLevel::Error, "app", "Cannot acquire next swap chain texture");
             break;
         }
-        std::cout << "nextTexture: " << nextTexture << std::endl;
-
-        wgpu::RenderPassDescriptor renderPassDesc = {};
-        
-
-        wgpu::RenderPassColorAttachment renderPassColorAttachment = {};
-        renderPassColorAttachment.view = nextTexture;
-        renderPassColorAttachment.resolveTarget = nullptr;
-        renderPassColorAttachment.loadOp = WGPULoadOp_Clear;
-        renderPassColorAttachment.storeOp = WGPUStoreOp_Store;
-        renderPassColorAttachment.clearValue = wgpu::Color{ 0.9, 0.1, 0.2, 1.0 };
-
-
-        renderPassDesc.colorAttachmentCount = 1;
-        renderPassDesc.colorAttachments = &renderPassColorAttachment;
-        renderPassDesc.depthStencilAttachment = nullptr;
-        renderPassDesc.timestampWriteCount = 0;
-        renderPassDesc.timestampWrites = nullptr;
-
-
-        commandEncoderDesc = {};
-        commandEncoderDesc.label = "Command Encoder";
-        encoder = device.createCommandEncoder(commandEncoderDesc);
+        Log::writef(LogLevel::Trace, "app", "nextTexture: %p", static_cast<void*>(static_cast<WGPUTextureView>(nextTexture)));
+
+        renderGraph.reset();
+        RenderGraph::ResourceId backbuffer = renderGraph.importTexture("backbuffer", nextTexture);
+
+        // Where the scene is drawn depends on the anti-aliasing mode
+        RenderGraph::ResourceId sceneTarget = backbuffer;
+        std::vector<RenderGraph::ResourceId> sceneWrites = { backbuffer };
+        if (options.sampleCount > 1) {
+            TexturePool::Key msaaKey;
+            msaaKey.format = swapChainDesc.format;
+            msaaKey.width = swapChainDesc.width;
+            msaaKey.height = swapChainDesc.height;
+            msaaKey.sampleCount = options.sampleCount;
+            msaaKey.usage = wgpu::TextureUsage::RenderAttachment;
+            sceneTarget = renderGraph.createTexture("msaaColor", msaaKey);
+            sceneWrites = { sceneTarget, backbuffer };
+        }
+        else if (options.postAntiAliasing) {
+            TexturePool::Key sceneKey;
+            sceneKey.format = swapChainDesc.format;
+            sceneKey.width = swapChainDesc.width;
+            sceneKey.height = swapChainDesc.height;
+            sceneKey.usage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::TextureBinding;
+            sceneTarget = renderGraph.createTexture("scene", sceneKey);
+            sceneWrites = { sceneTarget };
+        }
 
+        TexturePool::Key depthKey;
+        depthKey.format = Scene::DepthFormat;
+        depthKey.width = swapChainDesc.width;
+        depthKey.height = swapChainDesc.height;
+        depthKey.sampleCount = options.sampleCount;
+        depthKey.usage = wgpu::TextureUsage::RenderAttachment;
+        RenderGraph::ResourceId depth = renderGraph.createTexture("depth", depthKey);
+        sceneWrites.push_back(depth);
+
+        {
+            TRACE_ZONE("Sort draws");
+            FRAME_PHASE(frameRegression.get(), "Sort draws");
+            scene->sortDraws();
+        }
 
-        wgpu::RenderPassEncoder renderPass = encoder.beginRenderPass(renderPassDesc);
-        
+        if (particles) {
+            TRACE_ZONE("Update particles");
+            FRAME_PHASE(frameRegression.get(), "Update particles");
+            ERROR_SCOPE(errorScopes.get(), "Update particles");
+            // Fixed steps when benchmarking, so that runs are comparable
+            double now = window ? glfwGetTime() : lastFrameTime;
+            float dt = options.benchmarkFrames > 0 ? 1.0f / 60.0f : static_cast<float>(now - lastFrameTime);
+            lastFrameTime = now;
+            particles->update(dt);
+        }
 
-        renderPass.setPipeline(pipeline);
+        renderGraph.addPass("main", {}, sceneWrites, [&, sceneTarget, depth](RenderGraph::PassContext& ctx) {
+            wgpu::RenderPassDescriptor renderPassDesc = {};
+
+            wgpu::RenderPassColorAttachment renderPassColorAttachment = {};
+            renderPassColorAttachment.view = ctx.view(sceneTarget);
+            renderPassColorAttachment.resolveTarget = nullptr;
+            renderPassColorAttachment.loadOp = WGPULoadOp_Clear;
+            renderPassColorAttachment.storeOp = WGPUStoreOp_Store;
+            if (options.sampleCount > 1) {
+                // Only the resolved image is needed after the pass
+                renderPassColorAttachment.resolveTarget = ctx.view(backbuffer);
+                renderPassColorAttachment.storeOp = WGPUStoreOp_Discard;
+            }
+            renderPassColorAttachment.clearValue = wgpu::Color{ 0.9, 0.1, 0.2, 1.0 };
+
+            renderPassDesc.colorAttachmentCount = 1;
+            renderPassDesc.colorAttachments = &renderPassColorAttachment;
+
+            // The depth buffer is only needed during the pass
+            wgpu::RenderPassDepthStencilAttachment depthStencilAttachment = wgpu::Default;
+            depthStencilAttachment.view = ctx.view(depth);
+            depthStencilAttachment.depthClearValue = 1.0f;
+            depthStencilAttachment.depthLoadOp = wgpu::LoadOp::Clear;
+            depthStencilAttachment.depthStoreOp = wgpu::StoreOp::Discard;
+            depthStencilAttachment.depthReadOnly = false;
+            // Depth24Plus has no stencil aspect
+            depthStencilAttachment.stencilLoadOp = wgpu::LoadOp::Undefined;
+            depthStencilAttachment.stencilStoreOp = wgpu::StoreOp::Undefined;
+            depthStencilAttachment.stencilReadOnly = true;
+            renderPassDesc.depthStencilAttachment = &depthStencilAttachment;
+
+            renderPassDesc.timestampWriteCount = 0;
+            renderPassDesc.timestampWrites = nullptr;
+
+            wgpu::RenderPassEncoder renderPass = ctx.encoder.beginRenderPass(renderPassDesc);
+
+            scene->encode(renderPass);
+            if (particles) particles->draw(renderPass);
+
+            renderPass.end();
+            renderPass.release();
+        });
+
+        if (options.postAntiAliasing) {
+            renderGraph.addPass("postAntiAliasing", { sceneTarget }, { backbuffer }, [&, sceneTarget](RenderGraph::PassContext& ctx) {
+                postAntiAliasing->encode(ctx.encoder, ctx.view(sceneTarget), ctx.view(backbuffer));
+            });
+        }
 
-        // Not sure I understand how this gets mapped to wlsl
-        renderPass.draw(3, 1, 0, 0);
+        if (overlay->visible()) {
+            FRAME_PHASE(frameRegression.get(), "Overlay");
+            ERROR_SCOPE(errorScopes.get(), "Overlay");
+            StatsOverlay::FrameData overlayData;
+            overlayData.frameStats = &frameStats;
+            overlayData.drawStats = &scene->drawStats();
+            overlayData.gpuZones = &gpuTimeline->lastFrameZones();
+            overlayData.telemetry = &telemetry;
+            overlay->update(overlayData, swapChainDesc.width, swapChainDesc.height);
+            renderGraph.addPass("overlay", { backbuffer }, { backbuffer }, [&](RenderGraph::PassContext& ctx) {
+                overlay->encode(ctx.encoder, ctx.view(backbuffer));
+            });
+        }
 
-        renderPass.end();
-        renderPass.release();
+        {
+            TRACE_ZONE("Compile render graph");
+            FRAME_PHASE(frameRegression.get(), "Compile render graph");
+            renderGraph.compile();
+        }
+        {
+            FRAME_PHASE(frameRegression.get(), "Render graph");
+            ERROR_SCOPE(errorScopes.get(), "Render graph");
+            renderGraph.execute(queue);
+        }
+        gpuTimeline->endFrame();
+        if (dumpRenderGraph) {
+            renderGraph.dump(std::cout);
+            printSceneStats(*scene);
+            dumpRenderGraph = false;
+        }
 
         nextTexture.release();
-        
-        wgpu::CommandBufferDescriptor cmdBufferDescriptor = {};
-        cmdBufferDescriptor.label = "command buffer";
-        command = encoder.finish(cmdBufferDescriptor);
-        encoder.release();
-        queue.submit(1, &command);
-        command.release();
-
-        swapChain.present();
+
+        {
+            TRACE_ZONE("Present");
+            FRAME_PHASE(frameRegression.get(), "Present");
+            ERROR_SCOPE(errorScopes.get(), "Present");
+            if (swapChain) swapChain.present();
+            else headlessTarget->present();
+        }
+        errorScopes->collect();
+
+        frameStats.tick();
+        telemetry.tick();
+        if (options.benchmarkFrames > 0 && frameStats.frameCount() >= options.benchmarkFrames) {
+            const char* label = options.postAntiAliasing ? "post-aa" : (options.sampleCount > 1 ? "msaa 4" : "no aa");
+            frameStats.print(std::cout, label);
+            printSceneStats(*scene);
+            telemetry.print(std::cout);
+            break;
+        }
     }        
+    if (frameRegression) {
+        if (options.updateBaseline) {
+            frameRegression->print(std::cout);
+            if (frameRegression->save(options.baselinePath)) std::cout << "Baseline written to " << options.baselinePath << std::endl;
+            else exitCode = 1;
+        }
+        else if (!frameRegression->compare(options.baselinePath, std::cout)) {
+            exitCode = 1;
+        }
+    }
     buffer1.destroy();
     buffer2.destroy();
     buffer1.release();
     buffer2.release();
 
-    swapChain.release();
+    scene.reset();
+    particles.reset();
+    overlay.reset();
+    errorScopes.reset();
+    gpuTimeline.reset();
+    if (!options.tracePath.empty() && Trace::write(options.tracePath)) {
+        std::cout << "Trace written to " << options.tracePath << std::endl;
+    }
+    computeContext.reset();
+    postAntiAliasing.reset();
+    texturePool.clear();
+    headlessTarget.reset();
+    if (swapChain) swapChain.release();
     queue.release();
     device.release();
     adapter.release();
-    surface.release();
+    if (surface) surface.release();
     instance.release();
 
-    glfwDestroyWindow(window);
-    glfwTerminate();
-    return 0;
+    if (window) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+    Log::stop();
+    return exitCode;
 }
\ No newline at end of file
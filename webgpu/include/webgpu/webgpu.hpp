@@ -43,6 +43,13 @@
 #include <cassert>
 #include <memory>
 
+#ifdef WEBGPU_CPP_INSTRUMENTATION
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#endif
+
 /**
  * A namespace providing a more C++ idiomatic API to WebGPU.
  */
@@ -51,6 +58,74 @@ namespace wgpu {
 struct DefaultFlag {};
 constexpr DefaultFlag Default;
 
+#ifdef WEBGPU_CPP_INSTRUMENTATION
+/**
+ * Defining WEBGPU_CPP_INSTRUMENTATION (in every source file including this
+ * header) counts the calls of each handle method and, when enabled with
+ * setRecordLatency(), times them into a histogram. The report is printed to
+ * std::cerr on exit, sorted by call count. A call observer, when set, gets
+ * the name and times of each call, e.g. to add it to a trace.
+ */
+namespace instrumentation {
+
+// Bucket i counts the calls that took [2^i, 2^(i+1)) ns
+constexpr int LatencyBucketCount = 36;
+
+struct CallSite {
+	const char* name;
+	std::atomic<uint64_t> calls{ 0 };
+	std::atomic<uint64_t> totalNs{ 0 };
+	std::atomic<uint64_t> latency[LatencyBucketCount] = {};
+	CallSite* next = nullptr;
+	// Registers the site; sites are never destroyed, so that the report
+	// can run at exit
+	explicit CallSite(const char* name);
+};
+
+// Begin and end are steady_clock nanoseconds since its epoch
+using CallObserver = void (*)(const char* name, uint64_t beginNs, uint64_t endNs);
+
+void setRecordLatency(bool record);
+bool recordLatency();
+void setCallObserver(CallObserver observer);
+CallObserver callObserver();
+void recordCall(CallSite& site, uint64_t ns);
+void report(std::ostream& out);
+
+class CallScope {
+public:
+	explicit CallScope(CallSite& site) : m_site(site), m_timed(recordLatency()), m_observer(callObserver()) {
+		m_site.calls.fetch_add(1, std::memory_order_relaxed);
+		if (m_timed || m_observer) m_begin = std::chrono::steady_clock::now();
+	}
+	~CallScope() {
+		if (!m_timed && !m_observer) return;
+		auto end = std::chrono::steady_clock::now();
+		if (m_timed) recordCall(m_site, std::chrono::duration_cast<std::chrono::nanoseconds>(end - m_begin).count());
+		if (m_observer) {
+			m_observer(m_site.name,
+				std::chrono::duration_cast<std::chrono::nanoseconds>(m_begin.time_since_epoch()).count(),
+				std::chrono::duration_cast<std::chrono::nanoseconds>(end.time_since_epoch()).count());
+		}
+	}
+	CallScope(const CallScope&) = delete;
+	CallScope& operator=(const CallScope&) = delete;
+private:
+	CallSite& m_site;
+	bool m_timed;
+	CallObserver m_observer;
+	std::chrono::steady_clock::time_point m_begin;
+};
+
+} // namespace instrumentation
+
+#define WEBGPU_CPP_CALL(Type, Method) \
+	static ::wgpu::instrumentation::CallSite& wgpuCallSite = *new ::wgpu::instrumentation::CallSite(#Type "::" #Method); \
+	::wgpu::instrumentation::CallScope wgpuCallScope(wgpuCallSite)
+#else
+#define WEBGPU_CPP_CALL(Type, Method) (void)0
+#endif // WEBGPU_CPP_INSTRUMENTATION
+
 #define HANDLE(Type) \
 class Type { \
 public: \
@@ -1346,6 +1421,108 @@ Instance createInstance(const InstanceDescriptor& descriptor);
 
 #ifdef WEBGPU_CPP_IMPLEMENTATION
 
+#ifdef WEBGPU_CPP_INSTRUMENTATION
+namespace instrumentation {
+
+namespace {
+std::atomic<CallSite*> s_callSites{ nullptr };
+std::atomic<bool> s_recordLatency{ false };
+std::atomic<CallObserver> s_callObserver{ nullptr };
+
+// Prints the report when the program exits
+struct ExitReport {
+	~ExitReport() {
+		if (s_callSites.load()) report(std::cerr);
+	}
+} s_exitReport;
+} // namespace
+
+CallSite::CallSite(const char* name) : name(name) {
+	next = s_callSites.load(std::memory_order_relaxed);
+	while (!s_callSites.compare_exchange_weak(next, this)) {}
+}
+
+void setRecordLatency(bool record) {
+	s_recordLatency.store(record, std::memory_order_relaxed);
+}
+
+bool recordLatency() {
+	return s_recordLatency.load(std::memory_order_relaxed);
+}
+
+void setCallObserver(CallObserver observer) {
+	s_callObserver.store(observer, std::memory_order_relaxed);
+}
+
+CallObserver callObserver() {
+	return s_callObserver.load(std::memory_order_relaxed);
+}
+
+void recordCall(CallSite& site, uint64_t ns) {
+	int bucket = 0;
+	while (bucket + 1 < LatencyBucketCount && (ns >> (bucket + 1)) != 0) ++bucket;
+	site.totalNs.fetch_add(ns, std::memory_order_relaxed);
+	site.latency[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void report(std::ostream& out) {
+	struct Row {
+		const char* name;
+		uint64_t calls;
+		uint64_t timedCalls;
+		uint64_t totalNs;
+		uint64_t latency[LatencyBucketCount];
+	};
+	std::vector<Row> rows;
+	for (CallSite* site = s_callSites.load(); site; site = site->next) {
+		uint64_t calls = site->calls.load(std::memory_order_relaxed);
+		if (calls == 0) continue;
+		// Overloads share a name and a row
+		Row* row = nullptr;
+		for (Row& other : rows) {
+			if (std::string(other.name) == site->name) row = &other;
+		}
+		if (!row) {
+			rows.push_back({ site->name, 0, 0, 0, {} });
+			row = &rows.back();
+		}
+		row->calls += calls;
+		row->totalNs += site->totalNs.load(std::memory_order_relaxed);
+		for (int i = 0; i < LatencyBucketCount; ++i) {
+			uint64_t count = site->latency[i].load(std::memory_order_relaxed);
+			row->latency[i] += count;
+			row->timedCalls += count;
+		}
+	}
+	std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.calls > b.calls; });
+
+	// Upper bound of the bucket holding the given fraction of the timed calls
+	auto percentileUs = [](const Row& row, double fraction) {
+		uint64_t target = static_cast<uint64_t>(fraction * (row.timedCalls - 1)) + 1;
+		uint64_t seen = 0;
+		for (int i = 0; i < LatencyBucketCount; ++i) {
+			seen += row.latency[i];
+			if (seen >= target) return static_cast<double>(uint64_t(2) << i) / 1000.0;
+		}
+		return 0.0;
+	};
+
+	out << "webgpu.hpp calls (count, then for timed calls: total ms, mean / p50 / p99 us)" << std::endl;
+	for (const Row& row : rows) {
+		out << "  " << row.name << ": " << row.calls;
+		if (row.timedCalls > 0) {
+			out << ", " << row.totalNs / 1e6 << " ms"
+				<< ", " << row.totalNs / 1e3 / row.timedCalls
+				<< " / " << percentileUs(row, 0.5)
+				<< " / " << percentileUs(row, 0.99);
+		}
+		out << std::endl;
+	}
+}
+
+} // namespace instrumentation
+#endif // WEBGPU_CPP_INSTRUMENTATION
+
 Instance createInstance(const InstanceDescriptor& descriptor) {
 	return wgpuCreateInstance(&descriptor);
 }
@@ -1900,18 +2077,23 @@ void InstanceEnumerateAdapterOptions::setDefault() {
 
 // Methods of Adapter
 size_t Adapter::enumerateFeatures(FeatureName * features) {
+	WEBGPU_CPP_CALL(Adapter, enumerateFeatures);
 	return wgpuAdapterEnumerateFeatures(m_raw, reinterpret_cast<WGPUFeatureName *>(features));
 }
 bool Adapter::getLimits(SupportedLimits * limits) {
+	WEBGPU_CPP_CALL(Adapter, getLimits);
 	return wgpuAdapterGetLimits(m_raw, limits);
 }
 void Adapter::getProperties(AdapterProperties * properties) {
+	WEBGPU_CPP_CALL(Adapter, getProperties);
 	return wgpuAdapterGetProperties(m_raw, properties);
 }
 bool Adapter::hasFeature(FeatureName feature) {
+	WEBGPU_CPP_CALL(Adapter, hasFeature);
 	return wgpuAdapterHasFeature(m_raw, static_cast<WGPUFeatureName>(feature));
 }
 std::unique_ptr<RequestDeviceCallback> Adapter::requestDevice(const DeviceDescriptor& descriptor, RequestDeviceCallback&& callback) {
+	WEBGPU_CPP_CALL(Adapter, requestDevice);
 	auto handle = std::make_unique<RequestDeviceCallback>(callback);
 	static auto cCallback = [](WGPURequestDeviceStatus status, WGPUDevice device, char const * message, void * userdata) -> void {
 		RequestDeviceCallback& callback = *reinterpret_cast<RequestDeviceCallback*>(userdata);
@@ -1921,57 +2103,72 @@ std::unique_ptr<RequestDeviceCallback> Adapter::requestDevice(const DeviceDescri
 	return handle;
 }
 void Adapter::reference() {
+	WEBGPU_CPP_CALL(Adapter, reference);
 	return wgpuAdapterReference(m_raw);
 }
 void Adapter::release() {
+	WEBGPU_CPP_CALL(Adapter, release);
 	return wgpuAdapterRelease(m_raw);
 }
 
 
 // Methods of BindGroup
 void BindGroup::setLabel(char const * label) {
+	WEBGPU_CPP_CALL(BindGroup, setLabel);
 	return wgpuBindGroupSetLabel(m_raw, label);
 }
 void BindGroup::reference() {
+	WEBGPU_CPP_CALL(BindGroup, reference);
 	return wgpuBindGroupReference(m_raw);
 }
 void BindGroup::release() {
+	WEBGPU_CPP_CALL(BindGroup, release);
 	return wgpuBindGroupRelease(m_raw);
 }
 
 
 // Methods of BindGroupLayout
 void BindGroupLayout::setLabel(char const * label) {
+	WEBGPU_CPP_CALL(BindGroupLayout, setLabel);
 	return wgpuBindGroupLayoutSetLabel(m_raw, label);
 }
 void BindGroupLayout::reference() {
+	WEBGPU_CPP_CALL(BindGroupLayout, reference);
 	return wgpuBindGroupLayoutReference(m_raw);
 }
 void BindGroupLayout::release() {
+	WEBGPU_CPP_CALL(BindGroupLayout, release);
 	return wgpuBindGroupLayoutRelease(m_raw);
 }
 
 
 // Methods of Buffer
 void Buffer::destroy() {
+	WEBGPU_CPP_CALL(Buffer, destroy);
 	return wgpuBufferDestroy(m_raw);
 }
 void const * Buffer::getConstMappedRange(size_t offset, size_t size) {
+	WEBGPU_CPP_CALL(Buffer, getConstMappedRange);
 	return wgpuBufferGetConstMappedRange(m_raw, offset, size);
 }
 BufferMapState Buffer::getMapState() {
+	WEBGPU_CPP_CALL(Buffer, getMapState);
 	return static_cast<BufferMapState>(wgpuBufferGetMapState(m_raw));
 }
 void * Buffer::getMappedRange(size_t offset, size_t size) {
+	WEBGPU_CPP_CALL(Buffer, getMappedRange);
 	return wgpuBufferGetMappedRange(m_raw, offset, size);
 }
 uint64_t Buffer::getSize() {
+	WEBGPU_CPP_CALL(Buffer, getSize);
 	return wgpuBufferGetSize(m_raw);
 }
 BufferUsage Buffer::getUsage() {
+	WEBGPU_CPP_CALL(Buffer, getUsage);
 	return static_cast<BufferUsage>(wgpuBufferGetUsage(m_raw));
 }
 std::unique_ptr<BufferMapCallback> Buffer::mapAsync(MapModeFlags mode, size_t offset, size_t size, BufferMapCallback&& callback) {
+	WEBGPU_CPP_CALL(Buffer, mapAsync);
 	auto handle = std::make_unique<BufferMapCallback>(callback);
 	static auto cCallback = [](WGPUBufferMapAsyncStatus status, void * userdata) -> void {
 		BufferMapCallback& callback = *reinterpret_cast<BufferMapCallback*>(userdata);
@@ -1981,162 +2178,210 @@ std::unique_ptr<BufferMapCallback> Buffer::mapAsync(MapModeFlags mode, size_t of
 	return handle;
 }
 void Buffer::setLabel(char const * label) {
+	WEBGPU_CPP_CALL(Buffer, setLabel);
 	return wgpuBufferSetLabel(m_raw, label);
 }
 void Buffer::unmap() {
+	WEBGPU_CPP_CALL(Buffer, unmap);
 	return wgpuBufferUnmap(m_raw);
 }
 void Buffer::reference() {
+	WEBGPU_CPP_CALL(Buffer, reference);
 	return wgpuBufferReference(m_raw);
 }
 void Buffer::release() {
+	WEBGPU_CPP_CALL(Buffer, release);
 	return wgpuBufferRelease(m_raw);
 }
 
 
 // Methods of CommandBuffer
 void CommandBuffer::setLabel(char const * label) {
+	WEBGPU_CPP_CALL(CommandBuffer, setLabel);
 	return wgpuCommandBufferSetLabel(m_raw, label);
 }
 void CommandBuffer::reference() {
+	WEBGPU_CPP_CALL(CommandBuffer, reference);
 	return wgpuCommandBufferReference(m_raw);
 }
 void CommandBuffer::release() {
+	WEBGPU_CPP_CALL(CommandBuffer, release);
 	return wgpuCommandBufferRelease(m_raw);
 }
 
 
 // Methods of CommandEncoder
 ComputePassEncoder CommandEncoder::beginComputePass(const ComputePassDescriptor& descriptor) {
+	WEBGPU_CPP_CALL(CommandEncoder, beginComputePass);
 	return wgpuCommandEncoderBeginComputePass(m_raw, &descriptor);
 }
 RenderPassEncoder CommandEncoder::beginRenderPass(const RenderPassDescriptor& descriptor) {
+	WEBGPU_CPP_CALL(CommandEncoder, beginRenderPass);
 	return wgpuCommandEncoderBeginRenderPass(m_raw, &descriptor);
 }
 void CommandEncoder::clearBuffer(Buffer buffer, uint64_t offset, uint64_t size) {
+	WEBGPU_CPP_CALL(CommandEncoder, clearBuffer);
 	return wgpuCommandEncoderClearBuffer(m_raw, buffer, offset, size);
 }
 void CommandEncoder::copyBufferToBuffer(Buffer source, uint64_t sourceOffset, Buffer destination, uint64_t destinationOffset, uint64_t size) {
+	WEBGPU_CPP_CALL(CommandEncoder, copyBufferToBuffer);
 	return wgpuCommandEncoderCopyBufferToBuffer(m_raw, source, sourceOffset, destination, destinationOffset, size);
 }
 void CommandEncoder::copyBufferToTexture(const ImageCopyBuffer& source, const ImageCopyTexture& destination, const Extent3D& copySize) {
+	WEBGPU_CPP_CALL(CommandEncoder, copyBufferToTexture);
 	return wgpuCommandEncoderCopyBufferToTexture(m_raw, &source, &destination, &copySize);
 }
 void CommandEncoder::copyTextureToBuffer(const ImageCopyTexture& source, const ImageCopyBuffer& destination, const Extent3D& copySize) {
+	WEBGPU_CPP_CALL(CommandEncoder, copyTextureToBuffer);
 	return wgpuCommandEncoderCopyTextureToBuffer(m_raw, &source, &destination, &copySize);
 }
 void CommandEncoder::copyTextureToTexture(const ImageCopyTexture& source, const ImageCopyTexture& destination, const Extent3D& copySize) {
+	WEBGPU_CPP_CALL(CommandEncoder, copyTextureToTexture);
 	return wgpuCommandEncoderCopyTextureToTexture(m_raw, &source, &destination, &copySize);
 }
 CommandBuffer CommandEncoder::finish(const CommandBufferDescriptor& descriptor) {
+	WEBGPU_CPP_CALL(CommandEncoder, finish);
 	return wgpuCommandEncoderFinish(m_raw, &descriptor);
 }
 void CommandEncoder::insertDebugMarker(char const * markerLabel) {
+	WEBGPU_CPP_CALL(CommandEncoder, insertDebugMarker);
 	return wgpuCommandEncoderInsertDebugMarker(m_raw, markerLabel);
 }
 void CommandEncoder::popDebugGroup() {
+	WEBGPU_CPP_CALL(CommandEncoder, popDebugGroup);
 	return wgpuCommandEncoderPopDebugGroup(m_raw);
 }
 void CommandEncoder::pushDebugGroup(char const * groupLabel) {
+	WEBGPU_CPP_CALL(CommandEncoder, pushDebugGroup);
 	return wgpuCommandEncoderPushDebugGroup(m_raw, groupLabel);
 }
 void CommandEncoder::resolveQuerySet(QuerySet querySet, uint32_t firstQuery, uint32_t queryCount, Buffer destination, uint64_t destinationOffset) {
+	WEBGPU_CPP_CALL(CommandEncoder, resolveQuerySet);
 	return wgpuCommandEncoderResolveQuerySet(m_raw, querySet, firstQuery, queryCount, destination, destinationOffset);
 }
 void CommandEncoder::setLabel(char const * label) {
+	WEBGPU_CPP_CALL(CommandEncoder, setLabel);
 	return wgpuCommandEncoderSetLabel(m_raw, label);
 }
 void CommandEncoder::writeTimestamp(QuerySet querySet, uint32_t queryIndex) {
+	WEBGPU_CPP_CALL(CommandEncoder, writeTimestamp);
 	return wgpuCommandEncoderWriteTimestamp(m_raw, querySet, queryIndex);
 }
 void CommandEncoder::reference() {
+	WEBGPU_CPP_CALL(CommandEncoder, reference);
 	return wgpuCommandEncoderReference(m_raw);
 }
 void CommandEncoder::release() {
+	WEBGPU_CPP_CALL(CommandEncoder, release);
 	return wgpuCommandEncoderRelease(m_raw);
 }
 
 
 // Methods of ComputePassEncoder
 void ComputePassEncoder::beginPipelineStatisticsQuery(QuerySet querySet, uint32_t queryIndex) {
+	WEBGPU_CPP_CALL(ComputePassEncoder, beginPipelineStatisticsQuery);
 	return wgpuComputePassEncoderBeginPipelineStatisticsQuery(m_raw, querySet, queryIndex);
 }
 void ComputePassEncoder::dispatchWorkgroups(uint32_t workgroupCountX, uint32_t workgroupCountY, uint32_t workgroupCountZ) {
+	WEBGPU_CPP_CALL(ComputePassEncoder, dispatchWorkgroups);
 	return wgpuComputePassEncoderDispatchWorkgroups(m_raw, workgroupCountX, workgroupCountY, workgroupCountZ);
 }
 void ComputePassEncoder::dispatchWorkgroupsIndirect(Buffer indirectBuffer, uint64_t indirectOffset) {
+	WEBGPU_CPP_CALL(ComputePassEncoder, dispatchWorkgroupsIndirect);
 	return wgpuComputePassEncoderDispatchWorkgroupsIndirect(m_raw, indirectBuffer, indirectOffset);
 }
 void ComputePassEncoder::end() {
+	WEBGPU_CPP_CALL(ComputePassEncoder, end);
 	return wgpuComputePassEncoderEnd(m_raw);
 }
 void ComputePassEncoder::endPipelineStatisticsQuery() {
+	WEBGPU_CPP_CALL(ComputePassEncoder, endPipelineStatisticsQuery);
 	return wgpuComputePassEncoderEndPipelineStatisticsQuery(m_raw);
 }
 void ComputePassEncoder::insertDebugMarker(char const * markerLabel) {
+	WEBGPU_CPP_CALL(ComputePassEncoder, insertDebugMarker);
 	return wgpuComputePassEncoderInsertDebugMarker(m_raw, markerLabel);
 }
 void ComputePassEncoder::popDebugGroup() {
+	WEBGPU_CPP_CALL(ComputePassEncoder, popDebugGroup);
 	return wgpuComputePassEncoderPopDebugGroup(m_raw);
 }
 void ComputePassEncoder::pushDebugGroup(char const * groupLabel) {
+	WEBGPU_CPP_CALL(ComputePassEncoder, pushDebugGroup);
 	return wgpuComputePassEncoderPushDebugGroup(m_raw, groupLabel);
 }
 void ComputePassEncoder::setBindGroup(uint32_t groupIndex, BindGroup group, uint32_t dynamicOffsetCount, uint32_t const * dynamicOffsets) {
+	WEBGPU_CPP_CALL(ComputePassEncoder, setBindGroup);
 	return wgpuComputePassEncoderSetBindGroup(m_raw, groupIndex, group, dynamicOffsetCount, dynamicOffsets);
 }
 void ComputePassEncoder::setBindGroup(uint32_t groupIndex, BindGroup group, const std::vector<uint32_t>& dynamicOffsets) {
+	WEBGPU_CPP_CALL(ComputePassEncoder, setBindGroup);
 	return wgpuComputePassEncoderSetBindGroup(m_raw, groupIndex, group, static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
 }
 void ComputePassEncoder::setBindGroup(uint32_t groupIndex, BindGroup group, const uint32_t& dynamicOffsets) {
+	WEBGPU_CPP_CALL(ComputePassEncoder, setBindGroup);
 	return wgpuComputePassEncoderSetBindGroup(m_raw, groupIndex, group, 1, &dynamicOffsets);
 }
 void ComputePassEncoder::setLabel(char const * label) {
+	WEBGPU_CPP_CALL(ComputePassEncoder, setLabel);
 	return wgpuComputePassEncoderSetLabel(m_raw, label);
 }
 void ComputePassEncoder::setPipeline(ComputePipeline pipeline) {
+	WEBGPU_CPP_CALL(ComputePassEncoder, setPipeline);
 	return wgpuComputePassEncoderSetPipeline(m_raw, pipeline);
 }
 void ComputePassEncoder::reference() {
+	WEBGPU_CPP_CALL(ComputePassEncoder, reference);
 	return wgpuComputePassEncoderReference(m_raw);
 }
 void ComputePassEncoder::release() {
+	WEBGPU_CPP_CALL(ComputePassEncoder, release);
 	return wgpuComputePassEncoderRelease(m_raw);
 }
 
 
 // Methods of ComputePipeline
 BindGroupLayout ComputePipeline::getBindGroupLayout(uint32_t groupIndex) {
+	WEBGPU_CPP_CALL(ComputePipeline, getBindGroupLayout);
 	return wgpuComputePipelineGetBindGroupLayout(m_raw, groupIndex);
 }
 void ComputePipeline::setLabel(char const * label) {
+	WEBGPU_CPP_CALL(ComputePipeline, setLabel);
 	return wgpuComputePipelineSetLabel(m_raw, label);
 }
 void ComputePipeline::reference() {
+	WEBGPU_CPP_CALL(ComputePipeline, reference);
 	return wgpuComputePipelineReference(m_raw);
 }
 void ComputePipeline::release() {
+	WEBGPU_CPP_CALL(ComputePipeline, release);
 	return wgpuComputePipelineRelease(m_raw);
 }
 
 
 // Methods of Device
 BindGroup Device::createBindGroup(const BindGroupDescriptor& descriptor) {
+	WEBGPU_CPP_CALL(Device, createBindGroup);
 	return wgpuDeviceCreateBindGroup(m_raw, &descriptor);
 }
 BindGroupLayout Device::createBindGroupLayout(const BindGroupLayoutDescriptor& descriptor) {
+	WEBGPU_CPP_CALL(Device, createBindGroupLayout);
 	return wgpuDeviceCreateBindGroupLayout(m_raw, &descriptor);
 }
 Buffer Device::createBuffer(const BufferDescriptor& descriptor) {
+	WEBGPU_CPP_CALL(Device, createBuffer);
 	return wgpuDeviceCreateBuffer(m_raw, &descriptor);
 }
 CommandEncoder Device::createCommandEncoder(const CommandEncoderDescriptor& descriptor) {
+	WEBGPU_CPP_CALL(Device, createCommandEncoder);
 	return wgpuDeviceCreateCommandEncoder(m_raw, &descriptor);
 }
 ComputePipeline Device::createComputePipeline(const ComputePipelineDescriptor& descriptor) {
+	WEBGPU_CPP_CALL(Device, createComputePipeline);
 	return wgpuDeviceCreateComputePipeline(m_raw, &descriptor);
 }
 std::unique_ptr<CreateComputePipelineAsyncCallback> Device::createComputePipelineAsync(const ComputePipelineDescriptor& descriptor, CreateComputePipelineAsyncCallback&& callback) {
+	WEBGPU_CPP_CALL(Device, createComputePipelineAsync);
 	auto handle = std::make_unique<CreateComputePipelineAsyncCallback>(callback);
 	static auto cCallback = [](WGPUCreatePipelineAsyncStatus status, WGPUComputePipeline pipeline, char const * message, void * userdata) -> void {
 		CreateComputePipelineAsyncCallback& callback = *reinterpret_cast<CreateComputePipelineAsyncCallback*>(userdata);
@@ -2146,18 +2391,23 @@ std::unique_ptr<CreateComputePipelineAsyncCallback> Device::createComputePipelin
 	return handle;
 }
 PipelineLayout Device::createPipelineLayout(const PipelineLayoutDescriptor& descriptor) {
+	WEBGPU_CPP_CALL(Device, createPipelineLayout);
 	return wgpuDeviceCreatePipelineLayout(m_raw, &descriptor);
 }
 QuerySet Device::createQuerySet(const QuerySetDescriptor& descriptor) {
+	WEBGPU_CPP_CALL(Device, createQuerySet);
 	return wgpuDeviceCreateQuerySet(m_raw, &descriptor);
 }
 RenderBundleEncoder Device::createRenderBundleEncoder(const RenderBundleEncoderDescriptor& descriptor) {
+	WEBGPU_CPP_CALL(Device, createRenderBundleEncoder);
 	return wgpuDeviceCreateRenderBundleEncoder(m_raw, &descriptor);
 }
 RenderPipeline Device::createRenderPipeline(const RenderPipelineDescriptor& descriptor) {
+	WEBGPU_CPP_CALL(Device, createRenderPipeline);
 	return wgpuDeviceCreateRenderPipeline(m_raw, &descriptor);
 }
 std::unique_ptr<CreateRenderPipelineAsyncCallback> Device::createRenderPipelineAsync(const RenderPipelineDescriptor& descriptor, CreateRenderPipelineAsyncCallback&& callback) {
+	WEBGPU_CPP_CALL(Device, createRenderPipelineAsync);
 	auto handle = std::make_unique<CreateRenderPipelineAsyncCallback>(callback);
 	static auto cCallback = [](WGPUCreatePipelineAsyncStatus status, WGPURenderPipeline pipeline, char const * message, void * userdata) -> void {
 		CreateRenderPipelineAsyncCallback& callback = *reinterpret_cast<CreateRenderPipelineAsyncCallback*>(userdata);
@@ -2167,33 +2417,43 @@ std::unique_ptr<CreateRenderPipelineAsyncCallback> Device::createRenderPipelineA
 	return handle;
 }
 Sampler Device::createSampler(const SamplerDescriptor& descriptor) {
+	WEBGPU_CPP_CALL(Device, createSampler);
 	return wgpuDeviceCreateSampler(m_raw, &descriptor);
 }
 ShaderModule Device::createShaderModule(const ShaderModuleDescriptor& descriptor) {
+	WEBGPU_CPP_CALL(Device, createShaderModule);
 	return wgpuDeviceCreateShaderModule(m_raw, &descriptor);
 }
 SwapChain Device::createSwapChain(Surface surface, const SwapChainDescriptor& descriptor) {
+	WEBGPU_CPP_CALL(Device, createSwapChain);
 	return wgpuDeviceCreateSwapChain(m_raw, surface, &descriptor);
 }
 Texture Device::createTexture(const TextureDescriptor& descriptor) {
+	WEBGPU_CPP_CALL(Device, createTexture);
 	return wgpuDeviceCreateTexture(m_raw, &descriptor);
 }
 void Device::destroy() {
+	WEBGPU_CPP_CALL(Device, destroy);
 	return wgpuDeviceDestroy(m_raw);
 }
 size_t Device::enumerateFeatures(FeatureName * features) {
+	WEBGPU_CPP_CALL(Device, enumerateFeatures);
 	return wgpuDeviceEnumerateFeatures(m_raw, reinterpret_cast<WGPUFeatureName *>(features));
 }
 bool Device::getLimits(SupportedLimits * limits) {
+	WEBGPU_CPP_CALL(Device, getLimits);
 	return wgpuDeviceGetLimits(m_raw, limits);
 }
 Queue Device::getQueue() {
+	WEBGPU_CPP_CALL(Device, getQueue);
 	return wgpuDeviceGetQueue(m_raw);
 }
 bool Device::hasFeature(FeatureName feature) {
+	WEBGPU_CPP_CALL(Device, hasFeature);
 	return wgpuDeviceHasFeature(m_raw, static_cast<WGPUFeatureName>(feature));
 }
 std::unique_ptr<ErrorCallback> Device::popErrorScope(ErrorCallback&& callback) {
+	WEBGPU_CPP_CALL(Device, popErrorScope);
 	auto handle = std::make_unique<ErrorCallback>(callback);
 	static auto cCallback = [](WGPUErrorType type, char const * message, void * userdata) -> void {
 		ErrorCallback& callback = *reinterpret_cast<ErrorCallback*>(userdata);
@@ -2203,12 +2463,15 @@ std::unique_ptr<ErrorCallback> Device::popErrorScope(ErrorCallback&& callback) {
 	return handle;
 }
 void Device::pushErrorScope(ErrorFilter filter) {
+	WEBGPU_CPP_CALL(Device, pushErrorScope);
 	return wgpuDevicePushErrorScope(m_raw, static_cast<WGPUErrorFilter>(filter));
 }
 void Device::setLabel(char const * label) {
+	WEBGPU_CPP_CALL(Device, setLabel);
 	return wgpuDeviceSetLabel(m_raw, label);
 }
 std::unique_ptr<ErrorCallback> Device::setUncapturedErrorCallback(ErrorCallback&& callback) {
+	WEBGPU_CPP_CALL(Device, setUncapturedErrorCallback);
 	auto handle = std::make_unique<ErrorCallback>(callback);
 	static auto cCallback = [](WGPUErrorType type, char const * message, void * userdata) -> void {
 		ErrorCallback& callback = *reinterpret_cast<ErrorCallback*>(userdata);
@@ -2218,21 +2481,26 @@ std::unique_ptr<ErrorCallback> Device::setUncapturedErrorCallback(ErrorCallback&
 	return handle;
 }
 void Device::reference() {
+	WEBGPU_CPP_CALL(Device, reference);
 	return wgpuDeviceReference(m_raw);
 }
 void Device::release() {
+	WEBGPU_CPP_CALL(Device, release);
 	return wgpuDeviceRelease(m_raw);
 }
 
 
 // Methods of Instance
 Surface Instance::createSurface(const SurfaceDescriptor& descriptor) {
+	WEBGPU_CPP_CALL(Instance, createSurface);
 	return wgpuInstanceCreateSurface(m_raw, &descriptor);
 }
 void Instance::processEvents() {
+	WEBGPU_CPP_CALL(Instance, processEvents);
 	return wgpuInstanceProcessEvents(m_raw);
 }
 std::unique_ptr<RequestAdapterCallback> Instance::requestAdapter(const RequestAdapterOptions& options, RequestAdapterCallback&& callback) {
+	WEBGPU_CPP_CALL(Instance, requestAdapter);
 	auto handle = std::make_unique<RequestAdapterCallback>(callback);
 	static auto cCallback = [](WGPURequestAdapterStatus status, WGPUAdapter adapter, char const * message, void * userdata) -> void {
 		RequestAdapterCallback& callback = *reinterpret_cast<RequestAdapterCallback*>(userdata);
@@ -2242,48 +2510,60 @@ std::unique_ptr<RequestAdapterCallback> Instance::requestAdapter(const RequestAd
 	return handle;
 }
 void Instance::reference() {
+	WEBGPU_CPP_CALL(Instance, reference);
 	return wgpuInstanceReference(m_raw);
 }
 void Instance::release() {
+	WEBGPU_CPP_CALL(Instance, release);
 	return wgpuInstanceRelease(m_raw);
 }
 
 
 // Methods of PipelineLayout
 void PipelineLayout::setLabel(char const * label) {
+	WEBGPU_CPP_CALL(PipelineLayout, setLabel);
 	return wgpuPipelineLayoutSetLabel(m_raw, label);
 }
 void PipelineLayout::reference() {
+	WEBGPU_CPP_CALL(PipelineLayout, reference);
 	return wgpuPipelineLayoutReference(m_raw);
 }
 void PipelineLayout::release() {
+	WEBGPU_CPP_CALL(PipelineLayout, release);
 	return wgpuPipelineLayoutRelease(m_raw);
 }
 
 
 // Methods of QuerySet
 void QuerySet::destroy() {
+	WEBGPU_CPP_CALL(QuerySet, destroy);
 	return wgpuQuerySetDestroy(m_raw);
 }
 uint32_t QuerySet::getCount() {
+	WEBGPU_CPP_CALL(QuerySet, getCount);
 	return wgpuQuerySetGetCount(m_raw);
 }
 QueryType QuerySet::getType() {
+	WEBGPU_CPP_CALL(QuerySet, getType);
 	return static_cast<QueryType>(wgpuQuerySetGetType(m_raw));
 }
 void QuerySet::setLabel(char const * label) {
+	WEBGPU_CPP_CALL(QuerySet, setLabel);
 	return wgpuQuerySetSetLabel(m_raw, label);
 }
 void QuerySet::reference() {
+	WEBGPU_CPP_CALL(QuerySet, reference);
 	return wgpuQuerySetReference(m_raw);
 }
 void QuerySet::release() {
+	WEBGPU_CPP_CALL(QuerySet, release);
 	return wgpuQuerySetRelease(m_raw);
 }
 
 
 // Methods of Queue
 std::unique_ptr<QueueWorkDoneCallback> Queue::onSubmittedWorkDone(QueueWorkDoneCallback&& callback) {
+	WEBGPU_CPP_CALL(Queue, onSubmittedWorkDone);
 	auto handle = std::make_unique<QueueWorkDoneCallback>(callback);
 	static auto cCallback = [](WGPUQueueWorkDoneStatus status, void * userdata) -> void {
 		QueueWorkDoneCallback& callback = *reinterpret_cast<QueueWorkDoneCallback*>(userdata);
@@ -2293,210 +2573,273 @@ std::unique_ptr<QueueWorkDoneCallback> Queue::onSubmittedWorkDone(QueueWorkDoneC
 	return handle;
 }
 void Queue::setLabel(char const * label) {
+	WEBGPU_CPP_CALL(Queue, setLabel);
 	return wgpuQueueSetLabel(m_raw, label);
 }
 void Queue::submit(uint32_t commandCount, CommandBuffer const * commands) {
+	WEBGPU_CPP_CALL(Queue, submit);
 	return wgpuQueueSubmit(m_raw, commandCount, reinterpret_cast<WGPUCommandBuffer const *>(commands));
 }
 void Queue::submit(const std::vector<WGPUCommandBuffer>& commands) {
+	WEBGPU_CPP_CALL(Queue, submit);
 	return wgpuQueueSubmit(m_raw, static_cast<uint32_t>(commands.size()), commands.data());
 }
 void Queue::submit(const WGPUCommandBuffer& commands) {
+	WEBGPU_CPP_CALL(Queue, submit);
 	return wgpuQueueSubmit(m_raw, 1, &commands);
 }
 void Queue::writeBuffer(Buffer buffer, uint64_t bufferOffset, void const * data, size_t size) {
+	WEBGPU_CPP_CALL(Queue, writeBuffer);
 	return wgpuQueueWriteBuffer(m_raw, buffer, bufferOffset, data, size);
 }
 void Queue::writeTexture(const ImageCopyTexture& destination, void const * data, size_t dataSize, const TextureDataLayout& dataLayout, const Extent3D& writeSize) {
+	WEBGPU_CPP_CALL(Queue, writeTexture);
 	return wgpuQueueWriteTexture(m_raw, &destination, data, dataSize, &dataLayout, &writeSize);
 }
 void Queue::reference() {
+	WEBGPU_CPP_CALL(Queue, reference);
 	return wgpuQueueReference(m_raw);
 }
 void Queue::release() {
+	WEBGPU_CPP_CALL(Queue, release);
 	return wgpuQueueRelease(m_raw);
 }
 
 
 // Methods of RenderBundle
 void RenderBundle::reference() {
+	WEBGPU_CPP_CALL(RenderBundle, reference);
 	return wgpuRenderBundleReference(m_raw);
 }
 void RenderBundle::release() {
+	WEBGPU_CPP_CALL(RenderBundle, release);
 	return wgpuRenderBundleRelease(m_raw);
 }
 
 
 // Methods of RenderBundleEncoder
 void RenderBundleEncoder::draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) {
+	WEBGPU_CPP_CALL(RenderBundleEncoder, draw);
 	return wgpuRenderBundleEncoderDraw(m_raw, vertexCount, instanceCount, firstVertex, firstInstance);
 }
 void RenderBundleEncoder::drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance) {
+	WEBGPU_CPP_CALL(RenderBundleEncoder, drawIndexed);
 	return wgpuRenderBundleEncoderDrawIndexed(m_raw, indexCount, instanceCount, firstIndex, baseVertex, firstInstance);
 }
 void RenderBundleEncoder::drawIndexedIndirect(Buffer indirectBuffer, uint64_t indirectOffset) {
+	WEBGPU_CPP_CALL(RenderBundleEncoder, drawIndexedIndirect);
 	return wgpuRenderBundleEncoderDrawIndexedIndirect(m_raw, indirectBuffer, indirectOffset);
 }
 void RenderBundleEncoder::drawIndirect(Buffer indirectBuffer, uint64_t indirectOffset) {
+	WEBGPU_CPP_CALL(RenderBundleEncoder, drawIndirect);
 	return wgpuRenderBundleEncoderDrawIndirect(m_raw, indirectBuffer, indirectOffset);
 }
 RenderBundle RenderBundleEncoder::finish(const RenderBundleDescriptor& descriptor) {
+	WEBGPU_CPP_CALL(RenderBundleEncoder, finish);
 	return wgpuRenderBundleEncoderFinish(m_raw, &descriptor);
 }
 void RenderBundleEncoder::insertDebugMarker(char const * markerLabel) {
+	WEBGPU_CPP_CALL(RenderBundleEncoder, insertDebugMarker);
 	return wgpuRenderBundleEncoderInsertDebugMarker(m_raw, markerLabel);
 }
 void RenderBundleEncoder::popDebugGroup() {
+	WEBGPU_CPP_CALL(RenderBundleEncoder, popDebugGroup);
 	return wgpuRenderBundleEncoderPopDebugGroup(m_raw);
 }
 void RenderBundleEncoder::pushDebugGroup(char const * groupLabel) {
+	WEBGPU_CPP_CALL(RenderBundleEncoder, pushDebugGroup);
 	return wgpuRenderBundleEncoderPushDebugGroup(m_raw, groupLabel);
 }
 void RenderBundleEncoder::setBindGroup(uint32_t groupIndex, BindGroup group, uint32_t dynamicOffsetCount, uint32_t const * dynamicOffsets) {
+	WEBGPU_CPP_CALL(RenderBundleEncoder, setBindGroup);
 	return wgpuRenderBundleEncoderSetBindGroup(m_raw, groupIndex, group, dynamicOffsetCount, dynamicOffsets);
 }
 void RenderBundleEncoder::setBindGroup(uint32_t groupIndex, BindGroup group, const std::vector<uint32_t>& dynamicOffsets) {
+	WEBGPU_CPP_CALL(RenderBundleEncoder, setBindGroup);
 	return wgpuRenderBundleEncoderSetBindGroup(m_raw, groupIndex, group, static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
 }
 void RenderBundleEncoder::setBindGroup(uint32_t groupIndex, BindGroup group, const uint32_t& dynamicOffsets) {
+	WEBGPU_CPP_CALL(RenderBundleEncoder, setBindGroup);
 	return wgpuRenderBundleEncoderSetBindGroup(m_raw, groupIndex, group, 1, &dynamicOffsets);
 }
 void RenderBundleEncoder::setIndexBuffer(Buffer buffer, IndexFormat format, uint64_t offset, uint64_t size) {
+	WEBGPU_CPP_CALL(RenderBundleEncoder, setIndexBuffer);
 	return wgpuRenderBundleEncoderSetIndexBuffer(m_raw, buffer, static_cast<WGPUIndexFormat>(format), offset, size);
 }
 void RenderBundleEncoder::setLabel(char const * label) {
+	WEBGPU_CPP_CALL(RenderBundleEncoder, setLabel);
 	return wgpuRenderBundleEncoderSetLabel(m_raw, label);
 }
 void RenderBundleEncoder::setPipeline(RenderPipeline pipeline) {
+	WEBGPU_CPP_CALL(RenderBundleEncoder, setPipeline);
 	return wgpuRenderBundleEncoderSetPipeline(m_raw, pipeline);
 }
 void RenderBundleEncoder::setVertexBuffer(uint32_t slot, Buffer buffer, uint64_t offset, uint64_t size) {
+	WEBGPU_CPP_CALL(RenderBundleEncoder, setVertexBuffer);
 	return wgpuRenderBundleEncoderSetVertexBuffer(m_raw, slot, buffer, offset, size);
 }
 void RenderBundleEncoder::reference() {
+	WEBGPU_CPP_CALL(RenderBundleEncoder, reference);
 	return wgpuRenderBundleEncoderReference(m_raw);
 }
 void RenderBundleEncoder::release() {
+	WEBGPU_CPP_CALL(RenderBundleEncoder, release);
 	return wgpuRenderBundleEncoderRelease(m_raw);
 }
 
 
 // Methods of RenderPassEncoder
 void RenderPassEncoder::beginOcclusionQuery(uint32_t queryIndex) {
+	WEBGPU_CPP_CALL(RenderPassEncoder, beginOcclusionQuery);
 	return wgpuRenderPassEncoderBeginOcclusionQuery(m_raw, queryIndex);
 }
 void RenderPassEncoder::beginPipelineStatisticsQuery(QuerySet querySet, uint32_t queryIndex) {
+	WEBGPU_CPP_CALL(RenderPassEncoder, beginPipelineStatisticsQuery);
 	return wgpuRenderPassEncoderBeginPipelineStatisticsQuery(m_raw, querySet, queryIndex);
 }
 void RenderPassEncoder::draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) {
+	WEBGPU_CPP_CALL(RenderPassEncoder, draw);
 	return wgpuRenderPassEncoderDraw(m_raw, vertexCount, instanceCount, firstVertex, firstInstance);
 }
 void RenderPassEncoder::drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance) {
+	WEBGPU_CPP_CALL(RenderPassEncoder, drawIndexed);
 	return wgpuRenderPassEncoderDrawIndexed(m_raw, indexCount, instanceCount, firstIndex, baseVertex, firstInstance);
 }
 void RenderPassEncoder::drawIndexedIndirect(Buffer indirectBuffer, uint64_t indirectOffset) {
+	WEBGPU_CPP_CALL(RenderPassEncoder, drawIndexedIndirect);
 	return wgpuRenderPassEncoderDrawIndexedIndirect(m_raw, indirectBuffer, indirectOffset);
 }
 void RenderPassEncoder::drawIndirect(Buffer indirectBuffer, uint64_t indirectOffset) {
+	WEBGPU_CPP_CALL(RenderPassEncoder, drawIndirect);
 	return wgpuRenderPassEncoderDrawIndirect(m_raw, indirectBuffer, indirectOffset);
 }
 void RenderPassEncoder::end() {
+	WEBGPU_CPP_CALL(RenderPassEncoder, end);
 	return wgpuRenderPassEncoderEnd(m_raw);
 }
 void RenderPassEncoder::endOcclusionQuery() {
+	WEBGPU_CPP_CALL(RenderPassEncoder, endOcclusionQuery);
 	return wgpuRenderPassEncoderEndOcclusionQuery(m_raw);
 }
 void RenderPassEncoder::endPipelineStatisticsQuery() {
+	WEBGPU_CPP_CALL(RenderPassEncoder, endPipelineStatisticsQuery);
 	return wgpuRenderPassEncoderEndPipelineStatisticsQuery(m_raw);
 }
 void RenderPassEncoder::executeBundles(uint32_t bundleCount, RenderBundle const * bundles) {
+	WEBGPU_CPP_CALL(RenderPassEncoder, executeBundles);
 	return wgpuRenderPassEncoderExecuteBundles(m_raw, bundleCount, reinterpret_cast<WGPURenderBundle const *>(bundles));
 }
 void RenderPassEncoder::executeBundles(const std::vector<WGPURenderBundle>& bundles) {
+	WEBGPU_CPP_CALL(RenderPassEncoder, executeBundles);
 	return wgpuRenderPassEncoderExecuteBundles(m_raw, static_cast<uint32_t>(bundles.size()), bundles.data());
 }
 void RenderPassEncoder::executeBundles(const WGPURenderBundle& bundles) {
+	WEBGPU_CPP_CALL(RenderPassEncoder, executeBundles);
 	return wgpuRenderPassEncoderExecuteBundles(m_raw, 1, &bundles);
 }
 void RenderPassEncoder::insertDebugMarker(char const * markerLabel) {
+	WEBGPU_CPP_CALL(RenderPassEncoder, insertDebugMarker);
 	return wgpuRenderPassEncoderInsertDebugMarker(m_raw, markerLabel);
 }
 void RenderPassEncoder::popDebugGroup() {
+	WEBGPU_CPP_CALL(RenderPassEncoder, popDebugGroup);
 	return wgpuRenderPassEncoderPopDebugGroup(m_raw);
 }
 void RenderPassEncoder::pushDebugGroup(char const * groupLabel) {
+	WEBGPU_CPP_CALL(RenderPassEncoder, pushDebugGroup);
 	return wgpuRenderPassEncoderPushDebugGroup(m_raw, groupLabel);
 }
 void RenderPassEncoder::setBindGroup(uint32_t groupIndex, BindGroup group, uint32_t dynamicOffsetCount, uint32_t const * dynamicOffsets) {
+	WEBGPU_CPP_CALL(RenderPassEncoder, setBindGroup);
 	return wgpuRenderPassEncoderSetBindGroup(m_raw, groupIndex, group, dynamicOffsetCount, dynamicOffsets);
 }
 void RenderPassEncoder::setBindGroup(uint32_t groupIndex, BindGroup group, const std::vector<uint32_t>& dynamicOffsets) {
+	WEBGPU_CPP_CALL(RenderPassEncoder, setBindGroup);
 	return wgpuRenderPassEncoderSetBindGroup(m_raw, groupIndex, group, static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
 }
 void RenderPassEncoder::setBindGroup(uint32_t groupIndex, BindGroup group, const uint32_t& dynamicOffsets) {
+	WEBGPU_CPP_CALL(RenderPassEncoder, setBindGroup);
 	return wgpuRenderPassEncoderSetBindGroup(m_raw, groupIndex, group, 1, &dynamicOffsets);
 }
 void RenderPassEncoder::setBlendConstant(const Color& color) {
+	WEBGPU_CPP_CALL(RenderPassEncoder, setBlendConstant);
 	return wgpuRenderPassEncoderSetBlendConstant(m_raw, &color);
 }
 void RenderPassEncoder::setIndexBuffer(Buffer buffer, IndexFormat format, uint64_t offset, uint64_t size) {
+	WEBGPU_CPP_CALL(RenderPassEncoder, setIndexBuffer);
 	return wgpuRenderPassEncoderSetIndexBuffer(m_raw, buffer, static_cast<WGPUIndexFormat>(format), offset, size);
 }
 void RenderPassEncoder::setLabel(char const * label) {
+	WEBGPU_CPP_CALL(RenderPassEncoder, setLabel);
 	return wgpuRenderPassEncoderSetLabel(m_raw, label);
 }
 void RenderPassEncoder::setPipeline(RenderPipeline pipeline) {
+	WEBGPU_CPP_CALL(RenderPassEncoder, setPipeline);
 	return wgpuRenderPassEncoderSetPipeline(m_raw, pipeline);
 }
 void RenderPassEncoder::setScissorRect(uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+	WEBGPU_CPP_CALL(RenderPassEncoder, setScissorRect);
 	return wgpuRenderPassEncoderSetScissorRect(m_raw, x, y, width, height);
 }
 void RenderPassEncoder::setStencilReference(uint32_t reference) {
+	WEBGPU_CPP_CALL(RenderPassEncoder, setStencilReference);
 	return wgpuRenderPassEncoderSetStencilReference(m_raw, reference);
 }
 void RenderPassEncoder::setVertexBuffer(uint32_t slot, Buffer buffer, uint64_t offset, uint64_t size) {
+	WEBGPU_CPP_CALL(RenderPassEncoder, setVertexBuffer);
 	return wgpuRenderPassEncoderSetVertexBuffer(m_raw, slot, buffer, offset, size);
 }
 void RenderPassEncoder::setViewport(float x, float y, float width, float height, float minDepth, float maxDepth) {
+	WEBGPU_CPP_CALL(RenderPassEncoder, setViewport);
 	return wgpuRenderPassEncoderSetViewport(m_raw, x, y, width, height, minDepth, maxDepth);
 }
 void RenderPassEncoder::reference() {
+	WEBGPU_CPP_CALL(RenderPassEncoder, reference);
 	return wgpuRenderPassEncoderReference(m_raw);
 }
 void RenderPassEncoder::release() {
+	WEBGPU_CPP_CALL(RenderPassEncoder, release);
 	return wgpuRenderPassEncoderRelease(m_raw);
 }
 
 
 // Methods of RenderPipeline
 BindGroupLayout RenderPipeline::getBindGroupLayout(uint32_t groupIndex) {
+	WEBGPU_CPP_CALL(RenderPipeline, getBindGroupLayout);
 	return wgpuRenderPipelineGetBindGroupLayout(m_raw, groupIndex);
 }
 void RenderPipeline::setLabel(char const * label) {
+	WEBGPU_CPP_CALL(RenderPipeline, setLabel);
 	return wgpuRenderPipelineSetLabel(m_raw, label);
 }
 void RenderPipeline::reference() {
+	WEBGPU_CPP_CALL(RenderPipeline, reference);
 	return wgpuRenderPipelineReference(m_raw);
 }
 void RenderPipeline::release() {
+	WEBGPU_CPP_CALL(RenderPipeline, release);
 	return wgpuRenderPipelineRelease(m_raw);
 }
 
 
 // Methods of Sampler
 void Sampler::setLabel(char const * label) {
+	WEBGPU_CPP_CALL(Sampler, setLabel);
 	return wgpuSamplerSetLabel(m_raw, label);
 }
 void Sampler::reference() {
+	WEBGPU_CPP_CALL(Sampler, reference);
 	return wgpuSamplerReference(m_raw);
 }
 void Sampler::release() {
+	WEBGPU_CPP_CALL(Sampler, release);
 	return wgpuSamplerRelease(m_raw);
 }
 
 
 // Methods of ShaderModule
 std::unique_ptr<CompilationInfoCallback> ShaderModule::getCompilationInfo(CompilationInfoCallback&& callback) {
+	WEBGPU_CPP_CALL(ShaderModule, getCompilationInfo);
 	auto handle = std::make_unique<CompilationInfoCallback>(callback);
 	static auto cCallback = [](WGPUCompilationInfoRequestStatus status, struct WGPUCompilationInfo const * compilationInfo, void * userdata) -> void {
 		CompilationInfoCallback& callback = *reinterpret_cast<CompilationInfoCallback*>(userdata);
@@ -2506,93 +2849,119 @@ std::unique_ptr<CompilationInfoCallback> ShaderModule::getCompilationInfo(Compil
 	return handle;
 }
 void ShaderModule::setLabel(char const * label) {
+	WEBGPU_CPP_CALL(ShaderModule, setLabel);
 	return wgpuShaderModuleSetLabel(m_raw, label);
 }
 void ShaderModule::reference() {
+	WEBGPU_CPP_CALL(ShaderModule, reference);
 	return wgpuShaderModuleReference(m_raw);
 }
 void ShaderModule::release() {
+	WEBGPU_CPP_CALL(ShaderModule, release);
 	return wgpuShaderModuleRelease(m_raw);
 }
 
 
 // Methods of Surface
 TextureFormat Surface::getPreferredFormat(Adapter adapter) {
+	WEBGPU_CPP_CALL(Surface, getPreferredFormat);
 	return static_cast<TextureFormat>(wgpuSurfaceGetPreferredFormat(m_raw, adapter));
 }
 void Surface::reference() {
+	WEBGPU_CPP_CALL(Surface, reference);
 	return wgpuSurfaceReference(m_raw);
 }
 void Surface::release() {
+	WEBGPU_CPP_CALL(Surface, release);
 	return wgpuSurfaceRelease(m_raw);
 }
 
 
 // Methods of SwapChain
 TextureView SwapChain::getCurrentTextureView() {
+	WEBGPU_CPP_CALL(SwapChain, getCurrentTextureView);
 	return wgpuSwapChainGetCurrentTextureView(m_raw);
 }
 void SwapChain::present() {
+	WEBGPU_CPP_CALL(SwapChain, present);
 	return wgpuSwapChainPresent(m_raw);
 }
 void SwapChain::reference() {
+	WEBGPU_CPP_CALL(SwapChain, reference);
 	return wgpuSwapChainReference(m_raw);
 }
 void SwapChain::release() {
+	WEBGPU_CPP_CALL(SwapChain, release);
 	return wgpuSwapChainRelease(m_raw);
 }
 
 
 // Methods of Texture
 TextureView Texture::createView(const TextureViewDescriptor& descriptor) {
+	WEBGPU_CPP_CALL(Texture, createView);
 	return wgpuTextureCreateView(m_raw, &descriptor);
 }
 void Texture::destroy() {
+	WEBGPU_CPP_CALL(Texture, destroy);
 	return wgpuTextureDestroy(m_raw);
 }
 uint32_t Texture::getDepthOrArrayLayers() {
+	WEBGPU_CPP_CALL(Texture, getDepthOrArrayLayers);
 	return wgpuTextureGetDepthOrArrayLayers(m_raw);
 }
 TextureDimension Texture::getDimension() {
+	WEBGPU_CPP_CALL(Texture, getDimension);
 	return static_cast<TextureDimension>(wgpuTextureGetDimension(m_raw));
 }
 TextureFormat Texture::getFormat() {
+	WEBGPU_CPP_CALL(Texture, getFormat);
 	return static_cast<TextureFormat>(wgpuTextureGetFormat(m_raw));
 }
 uint32_t Texture::getHeight() {
+	WEBGPU_CPP_CALL(Texture, getHeight);
 	return wgpuTextureGetHeight(m_raw);
 }
 uint32_t Texture::getMipLevelCount() {
+	WEBGPU_CPP_CALL(Texture, getMipLevelCount);
 	return wgpuTextureGetMipLevelCount(m_raw);
 }
 uint32_t Texture::getSampleCount() {
+	WEBGPU_CPP_CALL(Texture, getSampleCount);
 	return wgpuTextureGetSampleCount(m_raw);
 }
 TextureUsage Texture::getUsage() {
+	WEBGPU_CPP_CALL(Texture, getUsage);
 	return static_cast<TextureUsage>(wgpuTextureGetUsage(m_raw));
 }
 uint32_t Texture::getWidth() {
+	WEBGPU_CPP_CALL(Texture, getWidth);
 	return wgpuTextureGetWidth(m_raw);
 }
 void Texture::setLabel(char const * label) {
+	WEBGPU_CPP_CALL(Texture, setLabel);
 	return wgpuTextureSetLabel(m_raw, label);
 }
 void Texture::reference() {
+	WEBGPU_CPP_CALL(Texture, reference);
 	return wgpuTextureReference(m_raw);
 }
 void Texture::release() {
+	WEBGPU_CPP_CALL(Texture, release);
 	return wgpuTextureRelease(m_raw);
 }
 
 
 // Methods of TextureView
 void TextureView::setLabel(char const * label) {
+	WEBGPU_CPP_CALL(TextureView, setLabel);
 	return wgpuTextureViewSetLabel(m_raw, label);
 }
 void TextureView::reference() {
+	WEBGPU_CPP_CALL(TextureView, reference);
 	return wgpuTextureViewReference(m_raw);
 }
 void TextureView::release() {
+	WEBGPU_CPP_CALL(TextureView, release);
 	return wgpuTextureViewRelease(m_raw);
 }
 
@@ -2644,5 +3013,6 @@ Device Adapter::requestDevice(const DeviceDescriptor& descriptor) {
 #undef ENUM
 #undef ENUM_ENTRY
 #undef END
+#undef WEBGPU_CPP_CALL
 
 } // namespace wgpu